@@ -108,7 +108,7 @@ int main(int argc,  char **argv)
         mainFilter->AddGradientDirection(i, directions[i]);
 
     std::vector <InputImageType::Pointer> inputData;
-    inputData = anima::getImagesFromHigherDimensionImage<Image4DType,InputImageType>(input);
+    inputData = anima::getImageViewsFromHigherDimensionImage<Image4DType,InputImageType>(input);
 
     for (unsigned int i = 0;i < inputData.size();++i)
         mainFilter->SetInput(i,inputData[i]);
@@ -6,7 +6,7 @@
 #include <animaMCMEstimatorImageFilter.h>
 #include <animaGradientFileReader.h>
 #include <animaVectorOperations.h>
-#include <animaReadWriteFunctions.h>
+#include <animaImageWriteService.h>
 
 //Update progression of the process
 void eventCallback (itk::Object* caller, const itk::EventObject& event, void* clientData)
@@ -32,6 +32,7 @@ int main(int argc,  char **argv)
     TCLAP::ValueArg<std::string> outSigmaArg("", "out-sig", "Output estimated noise sigma square image", false, "", "noise sigma square output image", cmd);
     TCLAP::ValueArg<std::string> outMoseArg("", "out-mose", "Output model selection map", false, "", "model selection output image", cmd);
     TCLAP::ValueArg<std::string> inMoseArg("I", "in-mose", "Input model selection map (overrides model selection step)", false, "", "model selection input image", cmd);
+    TCLAP::ValueArg<std::string> compressionArg("", "compression", "Output images compression: none, fast or standard (default: standard)", false, "standard", "output compression", cmd);
 
     // Optional arguments
     TCLAP::ValueArg<std::string> computationMaskArg("m", "mask", "Computation mask", false, "", "computation mask", cmd);
@@ -70,12 +71,18 @@ int main(int argc,  char **argv)
     try
     {
         cmd.parse(argc,argv);
+        anima::ImageWriteService::GetInstance().SetCompressionMode(anima::getImageCompressionModeFromString(compressionArg.getValue()));
     }
     catch (TCLAP::ArgException& e)
     {
         std::cerr << "Error: " << e.error() << "for argument " << e.argId() << std::endl;
         return(1);
     }
+    catch (itk::ExceptionObject &e)
+    {
+        std::cerr << e << std::endl;
+        return(1);
+    }
 
     typedef anima::MCMEstimatorImageFilter <float, double> FilterType;
     typedef FilterType::InputImageType InputImageType;
@@ -191,39 +198,50 @@ int main(int argc,  char **argv)
     tmpTimer.Stop();
 
     std::cout << "\nEstimation done in " << tmpTimer.GetTotal() << " s" << std::endl;
-    std::cout << "Writing MCM to: " << outArg.getValue() << std::endl;
-
-    try
-    {
-        filter->WriteMCMOutput(outArg.getValue());
-    }
-    catch (std::exception &e)
-    {
-        std::cerr << "Error writing output " << e.what() << std::endl;
-    }
-
+    // Secondary outputs are encoded in the background while the MCM itself is written
     if (aicArg.getValue() != "")
     {
         std::cout << "Writing AICu image to: " << aicArg.getValue() << std::endl;
-        anima::writeImage(aicArg.getValue(),filter->GetAICcVolume());
+        anima::queueImageForWriting(aicArg.getValue(),filter->GetAICcVolume());
     }
 
     if (outB0Arg.getValue() != "")
     {
         std::cout << "Writing B0 image to: " << outB0Arg.getValue() << std::endl;
-        anima::writeImage(outB0Arg.getValue(),filter->GetB0Volume());
+        anima::queueImageForWriting(outB0Arg.getValue(),filter->GetB0Volume());
     }
 
     if (outSigmaArg.getValue() != "")
     {
         std::cout << "Writing noise sigma square image to: " << outSigmaArg.getValue() << std::endl;
-        anima::writeImage(outSigmaArg.getValue(),filter->GetSigmaSquareVolume());
+        anima::queueImageForWriting(outSigmaArg.getValue(),filter->GetSigmaSquareVolume());
     }
 
     if (outMoseArg.getValue() != "")
     {
         std::cout << "Writing model selection image to: " << outMoseArg.getValue() << std::endl;
-        anima::writeImage(outMoseArg.getValue(),filter->GetMoseVolume());
+        anima::queueImageForWriting(outMoseArg.getValue(),filter->GetMoseVolume());
+    }
+
+    std::cout << "Writing MCM to: " << outArg.getValue() << std::endl;
+
+    try
+    {
+        filter->WriteMCMOutput(outArg.getValue());
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Error writing output " << e.what() << std::endl;
+    }
+
+    try
+    {
+        anima::waitForPendingImageWrites();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Error writing output " << e.what() << std::endl;
+        return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;
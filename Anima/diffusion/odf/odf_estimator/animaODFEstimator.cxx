@@ -24,6 +24,12 @@ int main(int argc, char **argv)
     
 	TCLAP::SwitchArg radialArg("R","radialestimation","Use radial estimation (see Aganj et al) ? (default: no)",cmd,false);
 	TCLAP::ValueArg<double> aganjRegFactorArg("d","adr","Delta threshold for signal regularization, only use if R option activated (see Aganj et al, default : 0.001)",false,0.001,"delta signal regularization",cmd);
+
+    TCLAP::ValueArg<std::string> gfaArg("G","gfa","Output generalized FA image",false,"","GFA image",cmd);
+    TCLAP::ValueArg<std::string> peaksArg("P","peaks","Output ODF peaks image (peak directions scaled by amplitude, 3 components per peak)",false,"","peaks image",cmd);
+    TCLAP::ValueArg<unsigned int> nbPeaksArg("m","nbpeaks","Maximal number of peaks per voxel in peaks image (default: 3)",false,3,"number of peaks",cmd);
+    TCLAP::ValueArg<double> peakRatioArg("r","peakratio","Minimal ratio of a peak amplitude to the largest one (default: 0.1)",false,0.1,"peak ratio",cmd);
+    TCLAP::ValueArg<unsigned int> blockSizeArg("b","blocksize","Number of voxels fitted at once (default: 256)",false,256,"block size",cmd);
 	
     TCLAP::ValueArg<unsigned int> nbpArg("p","numberofthreads","Number of threads to run on (default: all cores)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
     
@@ -58,6 +64,14 @@ int main(int argc, char **argv)
     if (normalizeArg.isSet())
         mainFilter->SetFileNameSphereTesselation(normSphereArg.getValue());
     
+    mainFilter->SetBlockSize(blockSizeArg.getValue());
+    mainFilter->SetComputeGFA(gfaArg.getValue() != "");
+    if (peaksArg.getValue() != "")
+    {
+        mainFilter->SetNumberOfPeaks(nbPeaksArg.getValue());
+        mainFilter->SetMinimalPeakRatio(peakRatioArg.getValue());
+    }
+
     anima::setMultipleImageFilterInputsFromFileName<InputImageType,MainFilterType>(inArg.getValue(), mainFilter);
     
     typedef anima::GradientFileReader < std::vector < double >, double > GFReaderType;
@@ -83,6 +97,12 @@ int main(int argc, char **argv)
 	std::cout << "Execution Time: " << tmpTime.GetTotal() << std::endl;
 	
     anima::writeImage <MainFilterType::TOutputImage> (resArg.getValue(),mainFilter->GetOutput());
+
+    if (gfaArg.getValue() != "")
+        anima::writeImage <MainFilterType::GFAImageType> (gfaArg.getValue(),mainFilter->GetGFAImage());
+
+    if ((peaksArg.getValue() != "")&&(nbPeaksArg.getValue() > 0))
+        anima::writeImage <MainFilterType::TOutputImage> (peaksArg.getValue(),mainFilter->GetPeaksImage());
 	
 	return EXIT_SUCCESS;
 }
@@ -6,9 +6,17 @@
 #include <itkImage.h>
 #include <vector>
 
+#include <animaODFPeakExtractor.h>
+
 namespace anima
 {
 
+/**
+ * @brief Estimation of ODFs in real spherical harmonics (Descoteaux et al. MRM 2007, Aganj et al. MRM 2010).
+ * Voxels are fitted by blocks (one matrix product per block). In the same pass, the filter may compute
+ * generalized FA and ODF peaks images (peak directions scaled by their amplitudes, three components per peak,
+ * zero for missing peaks), obtained through anima::ODFPeakExtractor.
+ */
 template <typename TInputPixelType, typename TOutputPixelType>
 class ODFEstimatorImageFilter :
         public itk::ImageToImageFilter< itk::Image<TInputPixelType, 3> , itk::VectorImage <TOutputPixelType, 3> >
@@ -31,6 +39,8 @@ public:
 
     typedef typename TInputImage::Pointer InputImagePointer;
     typedef typename TOutputImage::Pointer OutputImagePointer;
+    typedef itk::Image <TOutputPixelType, 3> GFAImageType;
+    typedef typename GFAImageType::Pointer GFAImagePointer;
 
     /** Superclass typedefs. */
     typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
@@ -49,6 +59,18 @@ public:
     itkSetMacro(UseAganjEstimation,bool);
     itkSetMacro(DeltaAganjRegularization, double);
 
+    //! Number of voxels fitted at once
+    itkSetMacro(BlockSize,unsigned int);
+
+    itkSetMacro(ComputeGFA,bool);
+    itkGetMacro(GFAImage,GFAImageType *);
+
+    //! Number of peaks in the peaks image, zero to disable peak extraction
+    itkSetMacro(NumberOfPeaks,unsigned int);
+    //! Peaks below this ratio of the largest ODF peak are discarded
+    itkSetMacro(MinimalPeakRatio,double);
+    itkGetMacro(PeaksImage,TOutputImage *);
+
 protected:
     ODFEstimatorImageFilter()
     {
@@ -64,9 +86,16 @@ protected:
         m_SharpnessRatio = 0.255;
 
         m_Normalize = false;
-        m_SphereSHSampling.clear();
+        m_NormalizationVector.clear();
 
         m_UseAganjEstimation = false;
+
+        m_BlockSize = 256;
+        m_ComputeGFA = false;
+        m_GFAImage = NULL;
+        m_NumberOfPeaks = 0;
+        m_MinimalPeakRatio = 0.1;
+        m_PeaksImage = NULL;
     }
 
     virtual ~ODFEstimatorImageFilter() {}
@@ -75,6 +104,9 @@ protected:
     void BeforeThreadedGenerateData() ITK_OVERRIDE;
     void ThreadedGenerateData(const OutputImageRegionType &outputRegionForThread, itk::ThreadIdType threadId) ITK_OVERRIDE;
 
+    //! Fits the first numVoxels columns of signalBlock (gradients x voxels) into coefficientsBlock (SH x voxels)
+    void FitBlock(const vnl_matrix <double> &signalBlock, unsigned int numVoxels, vnl_matrix <double> &coefficientsBlock);
+
 private:
     ODFEstimatorImageFilter(const Self&); //purposely not implemented
     void operator=(const Self&); //purposely not implemented
@@ -103,7 +135,8 @@ private:
 
     bool m_Normalize;
     std::string m_FileNameSphereTesselation;
-    std::vector < std::vector <double> > m_SphereSHSampling;
+    //! Sum of SH basis values over the normalization sphere, its dot product with coefficients gives the ODF integral
+    std::vector <double> m_NormalizationVector;
 
     double m_Lambda;
     double m_SharpnessRatio; // See Descoteaux et al. TMI 2009, article plus appendix
@@ -111,6 +144,16 @@ private:
     bool m_UseAganjEstimation;
     double m_DeltaAganjRegularization;
     unsigned int m_LOrder;
+
+    unsigned int m_BlockSize;
+
+    bool m_ComputeGFA;
+    GFAImagePointer m_GFAImage;
+
+    unsigned int m_NumberOfPeaks;
+    double m_MinimalPeakRatio;
+    anima::ODFPeakExtractor m_PeakExtractor;
+    OutputImagePointer m_PeaksImage;
 };
 
 } // end of namespace anima
@@ -7,6 +7,7 @@
 #include <itkImageRegionIterator.h>
 #include <boost/math/special_functions/legendre.hpp>
 #include <fstream>
+#include <algorithm>
 
 #include <animaVectorOperations.h>
 
@@ -165,11 +166,11 @@ ODFEstimatorImageFilter<TInputPixelType,TOutputPixelType>
     {
         std::ifstream sphereIn(m_FileNameSphereTesselation.c_str());
 
-        m_SphereSHSampling.clear();
+        m_NormalizationVector.resize(vectorLength);
+        std::fill(m_NormalizationVector.begin(),m_NormalizationVector.end(),0.0);
 
         std::vector <double> dirTmp(3,0);
         std::vector <double> sphericalCoords;
-        std::vector <double> shData;
 
         while (!sphereIn.eof())
         {
@@ -181,18 +182,81 @@ ODFEstimatorImageFilter<TInputPixelType,TOutputPixelType>
 
             sscanf(tmpStr,"%lf %lf %lf",&dirTmp[0],&dirTmp[1],&dirTmp[2]);
             anima::TransformCartesianToSphericalCoordinates(dirTmp,sphericalCoords);
-            shData.clear();
 
+            posValue = 0;
             for (int k = 0;k <= (int)m_LOrder;k += 2)
                 for (int m = -k;m <= k;++m)
-                    shData.push_back(tmpBasis.getNthSHValueAtPosition(k,m,sphericalCoords[0],sphericalCoords[1]));
-
-            m_SphereSHSampling.push_back(shData);
+                {
+                    m_NormalizationVector[posValue] += tmpBasis.getNthSHValueAtPosition(k,m,sphericalCoords[0],sphericalCoords[1]);
+                    ++posValue;
+                }
         }
         sphereIn.close();
     }
     else
         m_Normalize = false;
+
+    TOutputImage *output = this->GetOutput();
+
+    if (m_ComputeGFA)
+    {
+        m_GFAImage = GFAImageType::New();
+        m_GFAImage->Initialize();
+        m_GFAImage->SetOrigin(output->GetOrigin());
+        m_GFAImage->SetSpacing(output->GetSpacing());
+        m_GFAImage->SetDirection(output->GetDirection());
+        m_GFAImage->SetRegions(output->GetLargestPossibleRegion());
+
+        m_GFAImage->Allocate();
+        m_GFAImage->FillBuffer(0.0);
+    }
+
+    if (m_NumberOfPeaks > 0)
+    {
+        m_PeakExtractor.SetLOrder(m_LOrder);
+        m_PeakExtractor.SetMaximalNumberOfPeaks(m_NumberOfPeaks);
+        m_PeakExtractor.SetMinimalPeakRatio(m_MinimalPeakRatio);
+        m_PeakExtractor.Initialize();
+
+        m_PeaksImage = TOutputImage::New();
+        m_PeaksImage->Initialize();
+        m_PeaksImage->SetOrigin(output->GetOrigin());
+        m_PeaksImage->SetSpacing(output->GetSpacing());
+        m_PeaksImage->SetDirection(output->GetDirection());
+        m_PeaksImage->SetRegions(output->GetLargestPossibleRegion());
+        m_PeaksImage->SetNumberOfComponentsPerPixel(3 * m_NumberOfPeaks);
+
+        m_PeaksImage->Allocate();
+
+        itk::VariableLengthVector <TOutputPixelType> zeroPeaks(3 * m_NumberOfPeaks);
+        zeroPeaks.Fill(0.0);
+        m_PeaksImage->FillBuffer(zeroPeaks);
+    }
+}
+
+template <typename TInputPixelType, typename TOutputPixelType>
+void
+ODFEstimatorImageFilter<TInputPixelType,TOutputPixelType>
+::FitBlock(const vnl_matrix <double> &signalBlock, unsigned int numVoxels, vnl_matrix <double> &coefficientsBlock)
+{
+    unsigned int vectorLength = m_TMatrix.rows();
+    unsigned int numGrads = m_TMatrix.cols();
+
+    // Matrix product on the numVoxels first columns, inner loop running along voxels
+    for (unsigned int i = 0;i < vectorLength;++i)
+    {
+        double *coefficientsRow = coefficientsBlock[i];
+        for (unsigned int k = 0;k < numVoxels;++k)
+            coefficientsRow[k] = 0;
+
+        for (unsigned int j = 0;j < numGrads;++j)
+        {
+            double tValue = m_TMatrix(i,j);
+            const double *signalRow = signalBlock[j];
+            for (unsigned int k = 0;k < numVoxels;++k)
+                coefficientsRow[k] += tValue * signalRow[k];
+        }
+    }
 }
 
 template <typename TInputPixelType, typename TOutputPixelType>
@@ -202,96 +266,169 @@ ODFEstimatorImageFilter<TInputPixelType,TOutputPixelType>
 {
     typedef itk::ImageRegionConstIterator <TInputImage> InputIteratorType;
     typedef itk::ImageRegionIterator <TOutputImage> OutputIteratorType;
+    typedef itk::ImageRegionIterator <GFAImageType> GFAIteratorType;
 
     unsigned int vectorLength = (m_LOrder + 1)*(m_LOrder + 2)/2;
     unsigned int numGrads = m_GradientIndexes.size();
     unsigned int numB0 = m_B0Indexes.size();
 
     OutputIteratorType resIt(this->GetOutput(),outputRegionForThread);
-    InputIteratorType b0It(this->GetInput(0),outputRegionForThread);
+
+    GFAIteratorType gfaIt;
+    if (m_ComputeGFA)
+        gfaIt = GFAIteratorType(m_GFAImage,outputRegionForThread);
+
+    OutputIteratorType peaksIt;
+    if (m_NumberOfPeaks > 0)
+        peaksIt = OutputIteratorType(m_PeaksImage,outputRegionForThread);
 
     std::vector<InputIteratorType> diffusionIt(this->GetNumberOfIndexedInputs());
     for (unsigned int i = 0;i < this->GetNumberOfIndexedInputs();++i)
         diffusionIt[i] = InputIteratorType(this->GetInput(i),outputRegionForThread);
 
     itk::VariableLengthVector <TOutputPixelType> outputData(vectorLength);
+    itk::VariableLengthVector <TOutputPixelType> peaksData(3 * m_NumberOfPeaks);
     std::vector <double> tmpData(numGrads,0);
-    while (!diffusionIt[0].IsAtEnd())
-    {
-        double b0Value = 0;
-        for (unsigned int i = 0;i < numB0;++i)
-        {
-            b0Value += diffusionIt[m_B0Indexes[i]].Get();
-            ++diffusionIt[m_B0Indexes[i]];
-        }
+    std::vector <double> coefficients(vectorLength,0);
 
-        b0Value /= numB0;
+    // Block work variables: voxels are gathered until blockSize valid ones are found
+    unsigned int blockSize = std::max(m_BlockSize,(unsigned int)1);
+    vnl_matrix <double> signalBlock(numGrads,blockSize);
+    vnl_matrix <double> coefficientsBlock(vectorLength,blockSize);
+    std::vector <double> blockB0Values(blockSize,0);
+    std::vector <bool> voxelIsValid;
 
-        for (unsigned int i = 0;i < numGrads;++i)
-        {
-            tmpData[i] = diffusionIt[m_GradientIndexes[i]].Get();
-            ++diffusionIt[m_GradientIndexes[i]];
-        }
+    std::vector <anima::ODFPeakExtractor::DirectionType> peakDirections;
+    std::vector <double> peakAmplitudes, peakWorkValues;
 
-        for (unsigned int i = 0;i < vectorLength;++i)
-            outputData[i] = 0;
+    while (!diffusionIt[0].IsAtEnd())
+    {
+        voxelIsValid.clear();
+        unsigned int numValid = 0;
 
-        if ((isZero(tmpData))||(b0Value <= 0))
+        while ((!diffusionIt[0].IsAtEnd())&&(numValid < blockSize))
         {
-            resIt.Set(outputData);
-            ++resIt;
-            continue;
-        }
+            double b0Value = 0;
+            for (unsigned int i = 0;i < numB0;++i)
+            {
+                b0Value += diffusionIt[m_B0Indexes[i]].Get();
+                ++diffusionIt[m_B0Indexes[i]];
+            }
+
+            b0Value /= numB0;
 
-        if (m_UseAganjEstimation)
-        {
             for (unsigned int i = 0;i < numGrads;++i)
             {
-                double e = tmpData[i] / b0Value;
-
-                if (e < 0)
-                    tmpData[i] = m_DeltaAganjRegularization / 2.0;
-                else if (e < m_DeltaAganjRegularization)
-                    tmpData[i] = m_DeltaAganjRegularization / 2.0 + e * e / (2.0 * m_DeltaAganjRegularization);
-                else if (e < 1.0 - m_DeltaAganjRegularization)
-                    tmpData[i] = e;
-                else if (e < 1)
-                    tmpData[i] = 1.0 - m_DeltaAganjRegularization / 2.0 - (1.0 - e) * (1.0 - e) / (2.0 * m_DeltaAganjRegularization);
-                else
-                    tmpData[i] = 1.0 - m_DeltaAganjRegularization / 2.0;
+                tmpData[i] = diffusionIt[m_GradientIndexes[i]].Get();
+                ++diffusionIt[m_GradientIndexes[i]];
+            }
 
-                tmpData[i] = std::log(-std::log(tmpData[i]));
+            if ((isZero(tmpData))||(b0Value <= 0))
+            {
+                voxelIsValid.push_back(false);
+                continue;
             }
+
+            if (m_UseAganjEstimation)
+            {
+                for (unsigned int i = 0;i < numGrads;++i)
+                {
+                    double e = tmpData[i] / b0Value;
+
+                    if (e < 0)
+                        tmpData[i] = m_DeltaAganjRegularization / 2.0;
+                    else if (e < m_DeltaAganjRegularization)
+                        tmpData[i] = m_DeltaAganjRegularization / 2.0 + e * e / (2.0 * m_DeltaAganjRegularization);
+                    else if (e < 1.0 - m_DeltaAganjRegularization)
+                        tmpData[i] = e;
+                    else if (e < 1)
+                        tmpData[i] = 1.0 - m_DeltaAganjRegularization / 2.0 - (1.0 - e) * (1.0 - e) / (2.0 * m_DeltaAganjRegularization);
+                    else
+                        tmpData[i] = 1.0 - m_DeltaAganjRegularization / 2.0;
+
+                    tmpData[i] = std::log(-std::log(tmpData[i]));
+                }
+            }
+
+            for (unsigned int i = 0;i < numGrads;++i)
+                signalBlock(i,numValid) = tmpData[i];
+
+            blockB0Values[numValid] = b0Value;
+            voxelIsValid.push_back(true);
+            ++numValid;
         }
 
-        if (b0Value > 0)
+        this->FitBlock(signalBlock,numValid,coefficientsBlock);
+
+        unsigned int validPos = 0;
+        for (unsigned int v = 0;v < voxelIsValid.size();++v)
         {
-            for (unsigned int i = 0;i < vectorLength;++i)
-                for (unsigned int j = 0;j < numGrads;++j)
-                    outputData[i] += m_TMatrix(i,j)*tmpData[j];
+            outputData.Fill(0.0);
+            peaksData.Fill(0.0);
+            double gfaValue = 0;
 
-            if (!m_UseAganjEstimation)
+            if (voxelIsValid[v])
             {
                 for (unsigned int i = 0;i < vectorLength;++i)
-                    outputData[i] /= b0Value;
+                    coefficients[i] = coefficientsBlock(i,validPos);
+
+                if (!m_UseAganjEstimation)
+                {
+                    for (unsigned int i = 0;i < vectorLength;++i)
+                        coefficients[i] /= blockB0Values[validPos];
+                }
+                else
+                    coefficients[0] = 1/(2*sqrt(M_PI));
+
+                ++validPos;
+
+                if (m_Normalize)
+                {
+                    double integralODF = 0;
+                    for (unsigned int i = 0;i < vectorLength;++i)
+                        integralODF += m_NormalizationVector[i]*coefficients[i];
+
+                    for (unsigned int i = 0;i < vectorLength;++i)
+                        coefficients[i] /= integralODF;
+                }
+
+                for (unsigned int i = 0;i < vectorLength;++i)
+                    outputData[i] = coefficients[i];
+
+                if (m_ComputeGFA)
+                {
+                    double sumSquares = 0;
+                    for (unsigned int i = 0;i < vectorLength;++i)
+                        sumSquares += coefficients[i]*coefficients[i];
+
+                    if (sumSquares > 0)
+                        gfaValue = sqrt(1 - coefficients[0]*coefficients[0]/sumSquares);
+                }
+
+                if (m_NumberOfPeaks > 0)
+                {
+                    unsigned int numPeaks = m_PeakExtractor.ExtractPeaks(coefficients,peakDirections,peakAmplitudes,peakWorkValues);
+                    for (unsigned int i = 0;i < numPeaks;++i)
+                        for (unsigned int j = 0;j < 3;++j)
+                            peaksData[3 * i + j] = peakAmplitudes[i] * peakDirections[i][j];
+                }
             }
-            else
-                outputData[0] = 1/(2*sqrt(M_PI));
-        }
 
-        if (m_Normalize)
-        {
-            long double integralODF = 0;
-            for (unsigned int i = 0;i < m_SphereSHSampling.size();++i)
-                for (unsigned int j = 0;j < vectorLength;++j)
-                    integralODF += m_SphereSHSampling[i][j]*outputData[j];
+            resIt.Set(outputData);
+            ++resIt;
 
-            for (unsigned int i = 0;i < vectorLength;++i)
-                outputData[i] /= integralODF;
-        }
+            if (m_ComputeGFA)
+            {
+                gfaIt.Set(gfaValue);
+                ++gfaIt;
+            }
 
-        resIt.Set(outputData);
-        ++resIt;
+            if (m_NumberOfPeaks > 0)
+            {
+                peaksIt.Set(peaksData);
+                ++peaksIt;
+            }
+        }
     }
 }
     
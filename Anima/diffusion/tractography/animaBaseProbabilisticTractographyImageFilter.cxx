@@ -61,6 +61,7 @@ BaseProbabilisticTractographyImageFilter::BaseProbabilisticTractographyImageFilt
     m_InitialColinearityDirection = Center;
     m_InitialDirectionMode = Weight;
 
+    m_Seed = time(0);
     m_Generators.clear();
 
     m_HighestProcessedSeed = 0;
@@ -96,23 +97,17 @@ void BaseProbabilisticTractographyImageFilter::Update()
 
     trackerArguments tmpStr;
     tmpStr.trackerPtr = this;
-    tmpStr.resultFibersFromThreads.resize(this->GetNumberOfThreads());
-    tmpStr.resultWeightsFromThreads.resize(this->GetNumberOfThreads());
-
-    for (unsigned int i = 0;i < this->GetNumberOfThreads();++i)
-    {
-        tmpStr.resultFibersFromThreads[i] = resultFibers;
-        tmpStr.resultWeightsFromThreads[i] = resultWeights;
-    }
+    tmpStr.resultFibersFromChunks.resize(numSteps);
+    tmpStr.resultWeightsFromChunks.resize(numSteps);
 
     this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
     this->GetMultiThreader()->SetSingleMethod(this->ThreadTracker,&tmpStr);
     this->GetMultiThreader()->SingleMethodExecute();
 
-    for (unsigned int j = 0;j < this->GetNumberOfThreads();++j)
+    for (unsigned int j = 0;j < numSteps;++j)
     {
-        resultFibers.insert(resultFibers.end(),tmpStr.resultFibersFromThreads[j].begin(),tmpStr.resultFibersFromThreads[j].end());
-        resultWeights.insert(resultWeights.end(),tmpStr.resultWeightsFromThreads[j].begin(),tmpStr.resultWeightsFromThreads[j].end());
+        resultFibers.insert(resultFibers.end(),tmpStr.resultFibersFromChunks[j].begin(),tmpStr.resultFibersFromChunks[j].end());
+        resultWeights.insert(resultWeights.end(),tmpStr.resultWeightsFromChunks[j].begin(),tmpStr.resultWeightsFromChunks[j].end());
     }
 
     std::cout << "\nKept " << resultFibers.size() << " fibers after filtering" << std::endl;
@@ -121,14 +116,9 @@ void BaseProbabilisticTractographyImageFilter::Update()
 
 void BaseProbabilisticTractographyImageFilter::PrepareTractography()
 {
-    // Initialize random generator
+    // Initialize random generators, their streams are set for each seed point
     m_Generators.resize(this->GetNumberOfThreads());
 
-    std::mt19937 motherGenerator(time(0));
-
-    for (unsigned int i = 0;i < this->GetNumberOfThreads();++i)
-        m_Generators[i] = std::mt19937(motherGenerator());
-
     // If needed, compute DWI gravity center
     bool is2d = m_InputImages[0]->GetLargestPossibleRegion().GetSize()[2] == 1;
     if (is2d && (m_InitialColinearityDirection == Top))
@@ -243,13 +233,13 @@ ITK_THREAD_RETURN_TYPE BaseProbabilisticTractographyImageFilter::ThreadTracker(v
     unsigned int nbThread = threadArgs->ThreadID;
 
     trackerArguments *tmpArg = (trackerArguments *)threadArgs->UserData;
-    tmpArg->trackerPtr->ThreadTrack(nbThread,tmpArg->resultFibersFromThreads[nbThread],tmpArg->resultWeightsFromThreads[nbThread]);
+    tmpArg->trackerPtr->ThreadTrack(nbThread,tmpArg->resultFibersFromChunks,tmpArg->resultWeightsFromChunks);
 
     return NULL;
 }
 
-void BaseProbabilisticTractographyImageFilter::ThreadTrack(unsigned int numThread, FiberProcessVectorType &resultFibers,
-                                                           ListType &resultWeights)
+void BaseProbabilisticTractographyImageFilter::ThreadTrack(unsigned int numThread, std::vector <FiberProcessVectorType> &resultFibersFromChunks,
+                                                           std::vector <ListType> &resultWeightsFromChunks)
 {
     bool continueLoop = true;
     unsigned int highestToleratedSeedIndex = m_PointsToProcess.size();
@@ -278,7 +268,8 @@ void BaseProbabilisticTractographyImageFilter::ThreadTrack(unsigned int numThrea
 
         m_LockHighestProcessedSeed.Unlock();
 
-        this->ThreadedTrackComputer(numThread,resultFibers,resultWeights,startPoint,endPoint);
+        unsigned int chunkIndex = startPoint / stepData;
+        this->ThreadedTrackComputer(numThread,resultFibersFromChunks[chunkIndex],resultWeightsFromChunks[chunkIndex],startPoint,endPoint);
 
         m_LockHighestProcessedSeed.Lock();
         m_ProgressReport->CompletedPixel();
@@ -304,6 +295,8 @@ void BaseProbabilisticTractographyImageFilter::ThreadedTrackComputer(unsigned in
 
     for (unsigned int i = startSeedIndex;i < endSeedIndex;++i)
     {
+        // Random stream only depends on the seed point, not on the thread processing it
+        m_Generators[numThread].SetStream(m_Seed,i);
         m_SeedMask->TransformPhysicalPointToContinuousIndex(m_PointsToProcess[i][0],startIndex);
 
         // TO DO FOR DIRECTIONAL INTEGRATION: write generic function to extract local fiber orientations from model
@@ -848,7 +841,7 @@ BaseProbabilisticTractographyImageFilter::ComputeFiber(FiberType &fiber, DWIInte
 }
 
 unsigned int
-BaseProbabilisticTractographyImageFilter::UpdateClassesMemberships(FiberWorkType &fiberData, DirectionVectorType &directions, std::mt19937 &random_generator)
+BaseProbabilisticTractographyImageFilter::UpdateClassesMemberships(FiberWorkType &fiberData, DirectionVectorType &directions, RandomGeneratorType &random_generator)
 {
     const unsigned int p = PointType::PointDimension;
     typedef anima::KMeansFilter <PointType,p> KMeansFilterType;
@@ -13,6 +13,8 @@
 #include <vector>
 #include <random>
 
+#include <animaCounterBasedRandomGenerator.h>
+
 #include "AnimaTractographyExport.h"
 
 namespace anima
@@ -64,10 +66,14 @@ public:
     typedef std::vector <FiberType> FiberProcessVectorType;
     typedef std::vector <unsigned int> MembershipType;
 
+    //! Random generator, re-keyed for each seed point so that results do not depend on the number of threads
+    typedef anima::CounterBasedRandomGenerator RandomGeneratorType;
+
+    //! Results are stored per chunk of seed points, and concatenated in seed order
     typedef struct {
         BaseProbabilisticTractographyImageFilter *trackerPtr;
-        std::vector <FiberProcessVectorType> resultFibersFromThreads;
-        std::vector <ListType> resultWeightsFromThreads;
+        std::vector <FiberProcessVectorType> resultFibersFromChunks;
+        std::vector <ListType> resultWeightsFromChunks;
     } trackerArguments;
 
     struct pair_comparator
@@ -171,6 +177,9 @@ public:
     itkSetMacro(ModelDimension, unsigned int)
     itkGetMacro(ModelDimension, unsigned int)
 
+    itkSetMacro(Seed, unsigned int)
+    itkGetMacro(Seed, unsigned int)
+
     void Update() ITK_OVERRIDE;
 
     void createVTKOutput(FiberProcessVectorType &filteredFibers, ListType &filteredWeights);
@@ -184,7 +193,8 @@ protected:
     static ITK_THREAD_RETURN_TYPE ThreadTracker(void *arg);
 
     //! Doing the thread work dispatch
-    void ThreadTrack(unsigned int numThread, FiberProcessVectorType &resultFibers, ListType &resultWeights);
+    void ThreadTrack(unsigned int numThread, std::vector <FiberProcessVectorType> &resultFibersFromChunks,
+                     std::vector <ListType> &resultWeightsFromChunks);
 
     //! Doing the real tracking by calling ComputeFiber and merging its results
     void ThreadedTrackComputer(unsigned int numThread, FiberProcessVectorType &resultFibers,
@@ -199,7 +209,7 @@ protected:
     virtual void PrepareTractography();
 
     //! This ugly guy is the heart of multi-modal probabilistic tractography, making decisions on split and merges of particles
-    unsigned int UpdateClassesMemberships(FiberWorkType &fiberData, DirectionVectorType &directions, std::mt19937 &random_generator);
+    unsigned int UpdateClassesMemberships(FiberWorkType &fiberData, DirectionVectorType &directions, RandomGeneratorType &random_generator);
 
     //! This guy takes the result of computefiber and merges the classes, each one becomes one fiber
     // Returns in outputMerged several fibers, as of now if there are active particles it returns only the merge of those, and returns true.
@@ -212,7 +222,7 @@ protected:
     //! Propose new direction for a particle, given the old direction, and a model (model dependent, not implemented here)
     virtual Vector3DType ProposeNewDirection(Vector3DType &oldDirection, VectorType &modelValue,
                                              Vector3DType &sampling_direction, double &log_prior, double &log_proposal,
-                                             std::mt19937 &random_generator, unsigned int threadId) = 0;
+                                             RandomGeneratorType &random_generator, unsigned int threadId) = 0;
 
     //! Update particle weight based on an underlying model and the chosen direction (model dependent, not implemented here)
     virtual double ComputeLogWeightUpdate(double b0Value, double noiseValue, Vector3DType &newDirection, Vector3DType &sampling_direction,
@@ -258,7 +268,9 @@ private:
     MaskImagePointer m_CutMask;
     MaskImagePointer m_ForbiddenMask;
 
-    std::vector <std::mt19937> m_Generators;
+    //! Random generators key, and one generator per thread
+    unsigned int m_Seed;
+    std::vector <RandomGeneratorType> m_Generators;
 
     DirectionVectorType m_DiffusionGradients;
     ListType m_BValuesList;
@@ -5,6 +5,9 @@
 #include <animaODFMaximaCostFunction.h>
 #include <animaNewuoaOptimizer.h>
 
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkMultiThreader.h>
+
 #include <animaVectorOperations.h>
 #include <animaMatrixOperations.h>
 #include <animaDistributionSampling.h>
@@ -31,6 +34,12 @@ ODFProbabilisticTractographyImageFilter::ODFProbabilisticTractographyImageFilter
 
     m_ODFSHBasis = NULL;
 
+    m_UsePeakLookup = false;
+    m_MaximalNumberOfPeaks = 3;
+    m_NumberOfLikelihoodSamples = 6;
+    m_LikelihoodAngularStep = 5.0;
+    m_PeakMatchingAngle = 30.0;
+
     this->SetModelDimension(15);
 }
 
@@ -59,8 +68,9 @@ void ODFProbabilisticTractographyImageFilter::PrepareTractography()
 
     unsigned int posValue = 0;
     unsigned int numGrads = this->GetDiffusionGradients().size();
+    unsigned int shDimension = this->GetODFSHDimension();
 
-    vnl_matrix <double> BMatrix(numGrads,this->GetModelDimension());
+    vnl_matrix <double> BMatrix(numGrads,shDimension);
     Vector3DType sphDiffGradient;
 
     unsigned int pos = 0;
@@ -82,10 +92,10 @@ void ODFProbabilisticTractographyImageFilter::PrepareTractography()
     }
 
     unsigned int realNumGrads = pos;
-    BMatrix.set_size(realNumGrads,this->GetModelDimension());
+    BMatrix.set_size(realNumGrads,shDimension);
 
-    std::vector <double> LVector(this->GetModelDimension(),0);
-    std::vector <double> PVector(this->GetModelDimension(),0);
+    std::vector <double> LVector(shDimension,0);
+    std::vector <double> PVector(shDimension,0);
 
     posValue = 0;
     for (unsigned int k = 0;k <= m_ODFSHOrder;k += 2)
@@ -113,37 +123,310 @@ void ODFProbabilisticTractographyImageFilter::PrepareTractography()
     }
 
     vnl_matrix <double> tmpMat = BMatrix.transpose() * BMatrix;
-    for (unsigned int i = 0;i < this->GetModelDimension();++i)
+    for (unsigned int i = 0;i < shDimension;++i)
         tmpMat(i,i) += m_Lambda*LVector[i];
 
     vnl_matrix_inverse <double> tmpInv(tmpMat);
 
     m_SignalCoefsMatrix = tmpInv.inverse() * BMatrix.transpose();
-    m_TMatrix.set_size(this->GetModelDimension(),realNumGrads);
+    m_TMatrix.set_size(shDimension,realNumGrads);
 
-    for (unsigned int i = 0;i < this->GetModelDimension();++i)
+    for (unsigned int i = 0;i < shDimension;++i)
         for (unsigned int j = 0;j < realNumGrads;++j)
             m_TMatrix(i,j) = m_SignalCoefsMatrix(i,j) * PVector[i];
+
+    m_PeakExtractor.SetLOrder(m_ODFSHOrder);
+    m_PeakExtractor.SetMaximalNumberOfPeaks(m_MaximalNumberOfPeaks);
+    m_PeakExtractor.Initialize();
+
+    if (!m_UsePeakLookup)
+    {
+        this->SetModelDimension(shDimension);
+        m_PeakField = NULL;
+        return;
+    }
+
+    // Peak lookup mode: precompute the peak field, model values are then interpolated field values
+    this->SetModelDimension(3 + m_MaximalNumberOfPeaks * this->GetPeakFieldStride());
+
+    InputImageType *refImage = this->GetInputImage(0);
+    if (m_PeaksImage)
+    {
+        // Peaks are read voxel-wise: the peaks image has to lie on the diffusion images grid
+        bool peaksMatchReference = (m_PeaksImage->GetLargestPossibleRegion().GetSize() == refImage->GetLargestPossibleRegion().GetSize());
+        peaksMatchReference &= (m_PeaksImage->GetNumberOfComponentsPerPixel() % 3 == 0);
+
+        const double geometryTolerance = 1.0e-4;
+        for (unsigned int i = 0;i < InputImageType::ImageDimension;++i)
+        {
+            double refSpacing = refImage->GetSpacing()[i];
+            if (std::abs(m_PeaksImage->GetSpacing()[i] - refSpacing) > geometryTolerance * refSpacing)
+                peaksMatchReference = false;
+
+            if (std::abs(m_PeaksImage->GetOrigin()[i] - refImage->GetOrigin()[i]) > geometryTolerance * refSpacing)
+                peaksMatchReference = false;
+
+            for (unsigned int j = 0;j < InputImageType::ImageDimension;++j)
+            {
+                if (std::abs(m_PeaksImage->GetDirection()(i,j) - refImage->GetDirection()(i,j)) > geometryTolerance)
+                    peaksMatchReference = false;
+            }
+        }
+
+        if (!peaksMatchReference)
+            throw itk::ExceptionObject(__FILE__, __LINE__,"Peaks image does not match diffusion images",ITK_LOCATION);
+    }
+
+    m_PeakField = PeakFieldImageType::New();
+    m_PeakField->Initialize();
+    m_PeakField->SetOrigin(refImage->GetOrigin());
+    m_PeakField->SetSpacing(refImage->GetSpacing());
+    m_PeakField->SetDirection(refImage->GetDirection());
+    m_PeakField->SetRegions(refImage->GetLargestPossibleRegion());
+    m_PeakField->SetNumberOfComponentsPerPixel(this->GetModelDimension());
+    m_PeakField->Allocate();
+
+    PeakFieldImageType::PixelType zeroValue(this->GetModelDimension());
+    zeroValue.Fill(0.0);
+    m_PeakField->FillBuffer(zeroValue);
+
+    std::cout << "Computing peak field... " << std::endl;
+    this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
+    this->GetMultiThreader()->SetSingleMethod(this->ThreadPeakFieldComputer,this);
+    this->GetMultiThreader()->SingleMethodExecute();
+}
+
+ITK_THREAD_RETURN_TYPE ODFProbabilisticTractographyImageFilter::ThreadPeakFieldComputer(void *arg)
+{
+    itk::MultiThreader::ThreadInfoStruct *threadArgs = (itk::MultiThreader::ThreadInfoStruct *)arg;
+    unsigned int nbThread = threadArgs->ThreadID;
+    unsigned int numTotalThreads = threadArgs->NumberOfThreads;
+
+    Self *trackerPtr = (Self *)threadArgs->UserData;
+    trackerPtr->ComputePeakFieldPart(nbThread,numTotalThreads);
+
+    return NULL;
+}
+
+void ODFProbabilisticTractographyImageFilter::ComputePeakFieldPart(unsigned int threadId, unsigned int numThreads)
+{
+    // Split along the slowest non flat dimension
+    PeakFieldImageType::RegionType region = m_PeakField->GetLargestPossibleRegion();
+    unsigned int splitDimension = InputImageType::ImageDimension - 1;
+    while ((splitDimension > 0)&&(region.GetSize()[splitDimension] == 1))
+        --splitDimension;
+
+    unsigned int splitSize = region.GetSize()[splitDimension];
+    unsigned int startSplit = threadId * splitSize / numThreads;
+    unsigned int endSplit = (threadId + 1) * splitSize / numThreads;
+    if (startSplit == endSplit)
+        return;
+
+    region.SetIndex(splitDimension,region.GetIndex()[splitDimension] + startSplit);
+    region.SetSize(splitDimension,endSplit - startSplit);
+
+    typedef itk::ImageRegionIteratorWithIndex <PeakFieldImageType> FieldIteratorType;
+    FieldIteratorType fieldIt(m_PeakField,region);
+
+    bool is2d = (this->GetInputImage(0)->GetLargestPossibleRegion().GetSize()[2] == 1);
+    unsigned int numInputs = this->GetInputImages().size();
+    unsigned int shDimension = this->GetODFSHDimension();
+    unsigned int stride = this->GetPeakFieldStride();
+    unsigned int numPeaksImage = (m_PeaksImage) ? m_PeaksImage->GetNumberOfComponentsPerPixel() / 3 : 0;
+    double noiseValue = 20;
+
+    VectorType dwiValue(numInputs), modelValue(shDimension);
+    PeakFieldImageType::PixelType fieldValue(this->GetModelDimension());
+    ListType transformedSignal, rescaledModel(shDimension,0);
+    ListType peakAmplitudes, workValues;
+    std::vector <anima::ODFPeakExtractor::DirectionType> peakDirections;
+    Vector3DType peak, firstAxis, secondAxis, rotatedPeak, sphDirection;
+
+    unsigned int realNumGrads = m_TMatrix.columns();
+
+    while (!fieldIt.IsAtEnd())
+    {
+        PeakFieldImageType::IndexType index = fieldIt.GetIndex();
+        for (unsigned int i = 0;i < numInputs;++i)
+            dwiValue[i] = this->GetInputImage(i)->GetPixel(index);
+
+        fieldValue.Fill(0.0);
+        double b0Value = this->EstimateODFFromSignal(dwiValue,modelValue);
+
+        if (b0Value <= 0)
+        {
+            ++fieldIt;
+            continue;
+        }
+
+        fieldValue[0] = b0Value;
+        fieldValue[1] = this->GetGeneralizedFractionalAnisotropy(modelValue);
+
+        // Unrotated log-likelihood is needed in every voxel since it is interpolated over all neighbors
+        this->ComputeAganjSignal(dwiValue,b0Value,transformedSignal);
+        for (unsigned int i = 0;i < shDimension;++i)
+        {
+            rescaledModel[i] = 0;
+            for (unsigned int j = 0;j < realNumGrads;++j)
+                rescaledModel[i] += m_SignalCoefsMatrix(i,j) * transformedSignal[j];
+        }
+
+        peak.Fill(0.0);
+        peak[2] = 1.0;
+        fieldValue[2] = this->ComputeLogLikelihood(b0Value,noiseValue,peak,peak,rescaledModel,dwiValue);
+
+        // Particles are stopped in those voxels (same criteria as CheckModelProperties), no need for peaks there
+        if ((b0Value < 50.0)||(fieldValue[1] < m_GFAThreshold))
+        {
+            fieldIt.Set(fieldValue);
+            ++fieldIt;
+            continue;
+        }
+
+        unsigned int numPeaks = 0;
+        if (m_PeaksImage)
+        {
+            PeakFieldImageType::PixelType peaksValue = m_PeaksImage->GetPixel(index);
+            peakDirections.clear();
+            peakAmplitudes.clear();
+            for (unsigned int i = 0;i < numPeaksImage;++i)
+            {
+                anima::ODFPeakExtractor::DirectionType tmpDir;
+                for (unsigned int j = 0;j < 3;++j)
+                    tmpDir[j] = peaksValue[3 * i + j];
+
+                double amplitude = tmpDir.two_norm();
+                if (amplitude <= 0)
+                    continue;
+
+                peakDirections.push_back(tmpDir / amplitude);
+                peakAmplitudes.push_back(amplitude);
+            }
+
+            numPeaks = peakDirections.size();
+        }
+        else
+            numPeaks = m_PeakExtractor.ExtractPeaks(modelValue,peakDirections,peakAmplitudes,workValues);
+
+        unsigned int pos = 0;
+        for (unsigned int i = 0;(i < numPeaks)&&(pos < m_MaximalNumberOfPeaks);++i)
+        {
+            if (peakAmplitudes[i] <= m_MinimalDiffusionProbability)
+                continue;
+
+            for (unsigned int j = 0;j < 3;++j)
+                peak[j] = peakDirections[i][j];
+
+            if (is2d)
+            {
+                peak[2] = 0;
+                double norm = peak.GetNorm();
+                if (norm < 0.5)
+                    continue;
+
+                peak /= norm;
+            }
+
+            anima::TransformCartesianToSphericalCoordinates(peak,sphDirection);
+
+            // 0.5 is for Watson kappa
+            double kappa = 0.5 * m_CurvatureScale * m_ODFSHBasis->getCurvatureAtPosition(modelValue,sphDirection[0],sphDirection[1]);
+            if ((std::isnan(kappa))||(kappa <= 0)||(kappa >= 1000))
+                continue;
+
+            unsigned int peakPos = 3 + pos * stride;
+            for (unsigned int j = 0;j < 3;++j)
+                fieldValue[peakPos + j] = peak[j];
+
+            fieldValue[peakPos + 3] = peakAmplitudes[i];
+            fieldValue[peakPos + 4] = kappa;
+
+            // Two orthogonal rotation axes around the peak, likelihoods are averaged over both
+            unsigned int minCoord = 0;
+            for (unsigned int j = 1;j < 3;++j)
+            {
+                if (std::abs(peak[j]) < std::abs(peak[minCoord]))
+                    minCoord = j;
+            }
+
+            firstAxis.Fill(0.0);
+            if (is2d)
+            {
+                firstAxis[0] = - peak[1];
+                firstAxis[1] = peak[0];
+            }
+            else
+            {
+                firstAxis[minCoord] = 1.0;
+                firstAxis -= peak * anima::ComputeScalarProduct(firstAxis,peak);
+                firstAxis.Normalize();
+            }
+
+            anima::ComputeCrossProduct(peak,firstAxis,secondAxis);
+
+            for (unsigned int k = 0;k < m_NumberOfLikelihoodSamples;++k)
+            {
+                double angle = (k + 1.0) * m_LikelihoodAngularStep * M_PI / 180.0;
+                double logLikelihood = 0;
+
+                rotatedPeak = peak * std::cos(angle) + firstAxis * std::sin(angle);
+                logLikelihood += this->ComputeLogLikelihood(b0Value,noiseValue,rotatedPeak,peak,rescaledModel,dwiValue);
+
+                if (!is2d)
+                {
+                    rotatedPeak = peak * std::cos(angle) + secondAxis * std::sin(angle);
+                    logLikelihood += this->ComputeLogLikelihood(b0Value,noiseValue,rotatedPeak,peak,rescaledModel,dwiValue);
+                    logLikelihood /= 2.0;
+                }
+
+                fieldValue[peakPos + 5 + k] = logLikelihood;
+            }
+
+            ++pos;
+        }
+
+        fieldIt.Set(fieldValue);
+        ++fieldIt;
+    }
 }
 
 ODFProbabilisticTractographyImageFilter::Vector3DType
 ODFProbabilisticTractographyImageFilter::ProposeNewDirection(Vector3DType &oldDirection, VectorType &modelValue,
                                                              Vector3DType &sampling_direction, double &log_prior,
-                                                             double &log_proposal, std::mt19937 &random_generator,
+                                                             double &log_proposal, RandomGeneratorType &random_generator,
                                                              unsigned int threadId)
 {
     Vector3DType resVec(0.0);
     bool is2d = (this->GetInputImage(0)->GetLargestPossibleRegion().GetSize()[2] == 1);
 
     DirectionVectorType maximaODF;
-    unsigned int numDirs = this->FindODFMaxima(modelValue,maximaODF,m_MinimalDiffusionProbability,is2d);
-    ListType mixtureWeights(numDirs,0);
-    ListType kappaValues(numDirs,0);
+    ListType mixtureWeights;
+    ListType kappaValues;
+    unsigned int numDirs = 0;
 
-    double chosenKappa = 0;
+    if (m_UsePeakLookup)
+        numDirs = this->GetPeaksFromModel(modelValue,maximaODF,mixtureWeights,kappaValues);
+    else
+    {
+        numDirs = this->FindODFMaxima(modelValue,maximaODF,m_MinimalDiffusionProbability,is2d);
+        mixtureWeights.resize(numDirs);
+        kappaValues.resize(numDirs);
+
+        Vector3DType sphDirection;
+        for (unsigned int i = 0;i < numDirs;++i)
+        {
+            anima::TransformCartesianToSphericalCoordinates(maximaODF[i],sphDirection);
+            mixtureWeights[i] = m_ODFSHBasis->getValueAtPosition(modelValue,sphDirection[0],sphDirection[1]);
 
-    Vector3DType sphDirection;
+            // 0.5 is for Watson kappa
+            kappaValues[i] = 0.5 * m_CurvatureScale * m_ODFSHBasis->getCurvatureAtPosition(modelValue,sphDirection[0],sphDirection[1]);
 
+            if ((std::isnan(kappaValues[i]))||(kappaValues[i] <= 0)||(kappaValues[i] >= 1000))
+                mixtureWeights[i] = 0;
+        }
+    }
+
+    double chosenKappa = 0;
     double sumWeights = 0;
 
     for (unsigned int i = 0;i < numDirs;++i)
@@ -151,15 +434,6 @@ ODFProbabilisticTractographyImageFilter::ProposeNewDirection(Vector3DType &oldDi
         if (anima::ComputeScalarProduct(oldDirection, maximaODF[i]) < 0)
             maximaODF[i] *= -1;
 
-        anima::TransformCartesianToSphericalCoordinates(maximaODF[i],sphDirection);
-        mixtureWeights[i] = m_ODFSHBasis->getValueAtPosition(modelValue,sphDirection[0],sphDirection[1]);
-
-        // 0.5 is for Watson kappa
-        kappaValues[i] = 0.5 * m_CurvatureScale * m_ODFSHBasis->getCurvatureAtPosition(modelValue,sphDirection[0],sphDirection[1]);
-
-        if ((std::isnan(kappaValues[i]))||(kappaValues[i] <= 0)||(kappaValues[i] >= 1000))
-            mixtureWeights[i] = 0;
-
         sumWeights += mixtureWeights[i];
     }
 
@@ -222,7 +496,15 @@ ODFProbabilisticTractographyImageFilter::Vector3DType ODFProbabilisticTractograp
     bool is2d = (this->GetInputImage(0)->GetLargestPossibleRegion().GetSize()[2] == 1);
 
     DirectionVectorType maximaODF;
-    unsigned int numDirs = this->FindODFMaxima(modelValue,maximaODF,m_MinimalDiffusionProbability,is2d);
+    unsigned int numDirs = 0;
+    if (m_UsePeakLookup)
+    {
+        ListType amplitudes, kappaValues;
+        numDirs = this->GetPeaksFromModel(modelValue,maximaODF,amplitudes,kappaValues);
+    }
+    else
+        numDirs = this->FindODFMaxima(modelValue,maximaODF,m_MinimalDiffusionProbability,is2d);
+
     if (numDirs == 0)
         return colinearDir;
 
@@ -278,6 +560,10 @@ bool ODFProbabilisticTractographyImageFilter::CheckModelProperties(double estima
     if (estimatedB0Value < 50.0)
         return false;
 
+    // Peak field values hold GFA at position 1
+    if (m_UsePeakLookup)
+        return (modelValue[1] >= m_GFAThreshold);
+
     bool isModelNull = true;
     for (unsigned int j = 0;j < this->GetModelDimension();++j)
     {
@@ -302,17 +588,37 @@ double ODFProbabilisticTractographyImageFilter::ComputeLogWeightUpdate(double b0
                                                                        VectorType &modelValue, VectorType &dwiValue,
                                                                        double &log_prior, double &log_proposal, unsigned int threadId)
 {
-    Matrix3DType rotationMatrix = anima::GetRotationMatrixFromVectors(sampling_direction,newDirection);
-    rotationMatrix = rotationMatrix.GetTranspose();
+    double logLikelihood = 0;
 
-    unsigned int numGrads = this->GetDiffusionGradients().size();
-    Vector3DType rotatedGradient(0.0);
-    Vector3DType sphRotatedGradient;
-    std::vector <double> rescaledModel(this->GetModelDimension(),0);
+    if (m_UsePeakLookup)
+        logLikelihood = this->LookupLogLikelihood(newDirection,sampling_direction,modelValue);
+    else
+    {
+        // Compute scale model to get signal simulation
+        unsigned int shDimension = this->GetODFSHDimension();
+        unsigned int realNumGrads = m_TMatrix.columns();
+        ListType tmpData;
+        this->ComputeAganjSignal(dwiValue,b0Value,tmpData);
+
+        ListType rescaledModel(shDimension,0);
+        for (unsigned int i = 0;i < shDimension;++i)
+        {
+            for (unsigned int j = 0;j < realNumGrads;++j)
+                rescaledModel[i] += m_SignalCoefsMatrix(i,j)*tmpData[j];
+        }
 
-    // Compute scale model to get signal simulation
-    unsigned int realNumGrads = m_TMatrix.columns();
-    std::vector <double> tmpData(realNumGrads,0);
+        logLikelihood = this->ComputeLogLikelihood(b0Value,noiseValue,newDirection,sampling_direction,rescaledModel,dwiValue);
+    }
+
+    double resVal = logLikelihood + log_prior - log_proposal;
+
+    return resVal;
+}
+
+void ODFProbabilisticTractographyImageFilter::ComputeAganjSignal(const VectorType &dwiValue, double b0Value, ListType &transformedSignal)
+{
+    unsigned int numGrads = this->GetDiffusionGradients().size();
+    transformedSignal.resize(m_TMatrix.columns());
 
     unsigned int pos = 0;
     for (unsigned int i = 0;i < numGrads;++i)
@@ -323,31 +629,37 @@ double ODFProbabilisticTractographyImageFilter::ComputeLogWeightUpdate(double b0
         double e = dwiValue[i] / b0Value;
 
         if (e < 0)
-            tmpData[pos] = m_DeltaAganjRegularization / 2.0;
+            transformedSignal[pos] = m_DeltaAganjRegularization / 2.0;
         else if (e < m_DeltaAganjRegularization)
-            tmpData[pos] = m_DeltaAganjRegularization / 2.0 + e * e / (2.0 * m_DeltaAganjRegularization);
+            transformedSignal[pos] = m_DeltaAganjRegularization / 2.0 + e * e / (2.0 * m_DeltaAganjRegularization);
         else if (e < 1.0 - m_DeltaAganjRegularization)
-            tmpData[pos] = e;
+            transformedSignal[pos] = e;
         else if (e < 1)
-            tmpData[pos] = 1.0 - m_DeltaAganjRegularization / 2.0 - (1.0 - e) * (1.0 - e) / (2.0 * m_DeltaAganjRegularization);
+            transformedSignal[pos] = 1.0 - m_DeltaAganjRegularization / 2.0 - (1.0 - e) * (1.0 - e) / (2.0 * m_DeltaAganjRegularization);
         else
-            tmpData[pos] = 1.0 - m_DeltaAganjRegularization / 2.0;
+            transformedSignal[pos] = 1.0 - m_DeltaAganjRegularization / 2.0;
 
-        tmpData[pos] = std::log(-std::log(tmpData[pos]));
+        transformedSignal[pos] = std::log(-std::log(transformedSignal[pos]));
         ++pos;
     }
+}
 
-    for (unsigned int i = 0;i < this->GetModelDimension();++i)
-    {
-        for (unsigned int j = 0;j < realNumGrads;++j)
-            rescaledModel[i] += m_SignalCoefsMatrix(i,j)*tmpData[j];
-    }
+double ODFProbabilisticTractographyImageFilter::ComputeLogLikelihood(double b0Value, double noiseValue, const Vector3DType &newDirection,
+                                                                     const Vector3DType &sampling_direction, const ListType &rescaledModel,
+                                                                     const VectorType &dwiValue)
+{
+    Matrix3DType rotationMatrix = anima::GetRotationMatrixFromVectors(sampling_direction,newDirection);
+    rotationMatrix = rotationMatrix.GetTranspose();
+
+    unsigned int numGrads = this->GetDiffusionGradients().size();
+    anima::ODFPeakExtractor::DirectionType rotatedGradient;
 
     double logLikelihood = 0;
 
     for (unsigned int i = 0;i < numGrads;++i)
     {
-        if (anima::ComputeNorm(this->GetDiffusionGradient(i)) == 0)
+        double gradientNorm = anima::ComputeNorm(this->GetDiffusionGradient(i));
+        if (gradientNorm == 0)
             continue;
 
         for (unsigned int j = 0;j < InputImageType::ImageDimension;++j)
@@ -355,15 +667,15 @@ double ODFProbabilisticTractographyImageFilter::ComputeLogWeightUpdate(double b0
             rotatedGradient[j] = 0;
             for (unsigned int k = 0;k < InputImageType::ImageDimension;++k)
                 rotatedGradient[j] += rotationMatrix(j,k) * this->GetDiffusionGradient(i)[k];
-        }
 
-        anima::TransformCartesianToSphericalCoordinates(rotatedGradient,sphRotatedGradient);
+            rotatedGradient[j] /= gradientNorm;
+        }
 
-        double signalValue = m_ODFSHBasis->getValueAtPosition(rescaledModel,sphRotatedGradient[0],sphRotatedGradient[1]);
+        // Same values as the SH basis, without trigonometric calls
+        double signalValue = m_PeakExtractor.EvaluateODF(rescaledModel,rotatedGradient);
 
         // Aganj et al formulation
         signalValue = b0Value * exp(-exp(signalValue));
-        //std::cout << signalValue << " " << dwiValue[i] << std::endl;
 
         double tmpVal = - 0.5 * log(noiseValue * 2 * M_PI);
         double residual = dwiValue[i] - signalValue;
@@ -372,10 +684,7 @@ double ODFProbabilisticTractographyImageFilter::ComputeLogWeightUpdate(double b0
         logLikelihood += tmpVal;
     }
 
-    double resVal = logLikelihood / numGrads;
-    resVal += log_prior - log_proposal;
-
-    return resVal;
+    return logLikelihood / numGrads;
 }
 
 //! Returns ODF maxima ordered by probability of diffusion, only those with probability superior to minVal are given
@@ -523,63 +832,278 @@ unsigned int ODFProbabilisticTractographyImageFilter::FindODFMaxima(const Vector
 double ODFProbabilisticTractographyImageFilter::ComputeModelEstimation(DWIInterpolatorPointerVectorType &dwiInterpolators, ContinuousIndexType &index,
                                                                        VectorType &dwiValue, double &noiseValue, VectorType &modelValue)
 {
+    // Hard coded noise value for now
+    noiseValue = 20;
+
+    // Peak lookup mode does not need interpolated DWI values
+    if (m_UsePeakLookup)
+        return this->InterpolatePeakField(index,modelValue);
+
     unsigned int numInputs = dwiInterpolators.size();
     dwiValue.SetSize(numInputs);
 
     for (unsigned int i = 0;i < numInputs;++i)
         dwiValue[i] = dwiInterpolators[i]->EvaluateAtContinuousIndex(index);
 
+    return this->EstimateODFFromSignal(dwiValue,modelValue);
+}
+
+double ODFProbabilisticTractographyImageFilter::EstimateODFFromSignal(const VectorType &dwiValue, VectorType &modelValue)
+{
     double b0Value = dwiValue[0];
 
-    modelValue.SetSize(this->GetModelDimension());
+    unsigned int shDimension = this->GetODFSHDimension();
+    modelValue.SetSize(shDimension);
     modelValue.Fill(0.0);
 
-    // Hard coded noise value for now
-    noiseValue = 20;
     if (b0Value <= 0)
         return 0;
 
+    ListType tmpData;
+    this->ComputeAganjSignal(dwiValue,b0Value,tmpData);
     unsigned int realNumGrads = m_TMatrix.columns();
-    std::vector <double> tmpData(realNumGrads,0);
 
-    unsigned int pos = 0;
-    for (unsigned int i = 0;i < numInputs;++i)
+    modelValue[0] = 1.0 / (2.0 * sqrt(M_PI));
+
+    for (unsigned int i = 1;i < shDimension;++i)
     {
-        if (anima::ComputeNorm(this->GetDiffusionGradient(i)) == 0)
+        for (unsigned int j = 0;j < realNumGrads;++j)
+            modelValue[i] += m_TMatrix(i,j)*tmpData[j];
+    }
+
+    return b0Value;
+}
+
+double ODFProbabilisticTractographyImageFilter::InterpolatePeakField(const ContinuousIndexType &index, VectorType &modelValue)
+{
+    const unsigned int numCorners = 1 << InputImageType::ImageDimension;
+    unsigned int stride = this->GetPeakFieldStride();
+
+    modelValue.SetSize(this->GetModelDimension());
+    modelValue.Fill(0.0);
+
+    PeakFieldImageType::RegionType region = m_PeakField->GetLargestPossibleRegion();
+    PeakFieldImageType::IndexType baseIndex, cornerIndex;
+    double distances[InputImageType::ImageDimension];
+    for (unsigned int j = 0;j < InputImageType::ImageDimension;++j)
+    {
+        baseIndex[j] = std::floor(index[j]);
+        distances[j] = index[j] - baseIndex[j];
+    }
+
+    // Corners sorted by decreasing weight, the heaviest ones define peak slots
+    double cornerWeights[numCorners];
+    PeakFieldImageType::IndexType cornerIndexes[numCorners];
+    unsigned int numUsedCorners = 0;
+
+    for (unsigned int i = 0;i < numCorners;++i)
+    {
+        double weight = 1.0;
+        for (unsigned int j = 0;j < InputImageType::ImageDimension;++j)
+        {
+            unsigned int upper = (i >> j) & 1;
+            cornerIndex[j] = baseIndex[j] + upper;
+            weight *= upper ? distances[j] : 1.0 - distances[j];
+
+            int lastIndex = region.GetIndex()[j] + region.GetSize()[j] - 1;
+            if (cornerIndex[j] > lastIndex)
+                cornerIndex[j] = lastIndex;
+            if (cornerIndex[j] < region.GetIndex()[j])
+                cornerIndex[j] = region.GetIndex()[j];
+        }
+
+        if (weight <= 0)
             continue;
 
-        double e = dwiValue[i] / b0Value;
+        unsigned int pos = numUsedCorners;
+        while ((pos > 0)&&(cornerWeights[pos - 1] < weight))
+        {
+            cornerWeights[pos] = cornerWeights[pos - 1];
+            cornerIndexes[pos] = cornerIndexes[pos - 1];
+            --pos;
+        }
 
-        if (e < 0)
-            tmpData[pos] = m_DeltaAganjRegularization / 2.0;
-        else if (e < m_DeltaAganjRegularization)
-            tmpData[pos] = m_DeltaAganjRegularization / 2.0 + e * e / (2.0 * m_DeltaAganjRegularization);
-        else if (e < 1.0 - m_DeltaAganjRegularization)
-            tmpData[pos] = e;
-        else if (e < 1)
-            tmpData[pos] = 1.0 - m_DeltaAganjRegularization / 2.0 - (1.0 - e) * (1.0 - e) / (2.0 * m_DeltaAganjRegularization);
-        else
-            tmpData[pos] = 1.0 - m_DeltaAganjRegularization / 2.0;
+        cornerWeights[pos] = weight;
+        cornerIndexes[pos] = cornerIndex;
+        ++numUsedCorners;
+    }
 
-        tmpData[pos] = std::log(-std::log(tmpData[pos]));
-        ++pos;
+    double cosMatchingAngle = std::cos(m_PeakMatchingAngle * M_PI / 180.0);
+    ListType slotWeights(m_MaximalNumberOfPeaks,0);
+    unsigned int numSlots = 0;
+    double likelihoodWeight = 0;
+
+    for (unsigned int i = 0;i < numUsedCorners;++i)
+    {
+        double weight = cornerWeights[i];
+        PeakFieldImageType::PixelType cornerValue = m_PeakField->GetPixel(cornerIndexes[i]);
+
+        for (unsigned int j = 0;j < 2;++j)
+            modelValue[j] += weight * cornerValue[j];
+
+        // Unrotated log-likelihood is only defined where the signal is
+        if (cornerValue[0] > 0)
+        {
+            modelValue[2] += weight * cornerValue[2];
+            likelihoodWeight += weight;
+        }
+
+        for (unsigned int k = 0;k < m_MaximalNumberOfPeaks;++k)
+        {
+            unsigned int peakPos = 3 + k * stride;
+            if (cornerValue[peakPos + 3] <= 0)
+                continue;
+
+            // Match to the closest slot orientation, flipping the peak if needed
+            int bestSlot = -1;
+            double bestScalarProduct = cosMatchingAngle;
+            double sign = 1.0;
+            for (unsigned int l = 0;l < numSlots;++l)
+            {
+                unsigned int slotPos = 3 + l * stride;
+                double scalarProduct = 0, slotNorm = 0;
+                for (unsigned int j = 0;j < 3;++j)
+                {
+                    scalarProduct += modelValue[slotPos + j] * cornerValue[peakPos + j];
+                    slotNorm += modelValue[slotPos + j] * modelValue[slotPos + j];
+                }
+
+                scalarProduct /= std::sqrt(slotNorm);
+                if (std::abs(scalarProduct) >= bestScalarProduct)
+                {
+                    bestSlot = l;
+                    bestScalarProduct = std::abs(scalarProduct);
+                    sign = (scalarProduct < 0) ? -1.0 : 1.0;
+                }
+            }
+
+            if (bestSlot < 0)
+            {
+                if (numSlots == m_MaximalNumberOfPeaks)
+                    continue;
+
+                bestSlot = numSlots;
+                sign = 1.0;
+                ++numSlots;
+            }
+
+            unsigned int slotPos = 3 + bestSlot * stride;
+            for (unsigned int j = 0;j < 3;++j)
+                modelValue[slotPos + j] += sign * weight * cornerValue[peakPos + j];
+
+            for (unsigned int j = 3;j < stride;++j)
+                modelValue[slotPos + j] += weight * cornerValue[peakPos + j];
+
+            slotWeights[bestSlot] += weight;
+        }
     }
 
-    modelValue[0] = 1.0 / (2.0 * sqrt(M_PI));
+    if (likelihoodWeight > 0)
+        modelValue[2] /= likelihoodWeight;
 
-    for (unsigned int i = 1;i < this->GetModelDimension();++i)
+    // Amplitudes are left weighted by the total weight (missing peaks count as zero), other values are averaged on matched peaks
+    for (unsigned int l = 0;l < numSlots;++l)
     {
-        for (unsigned int j = 0;j < realNumGrads;++j)
-            modelValue[i] += m_TMatrix(i,j)*tmpData[j];
+        unsigned int slotPos = 3 + l * stride;
+        double norm = 0;
+        for (unsigned int j = 0;j < 3;++j)
+            norm += modelValue[slotPos + j] * modelValue[slotPos + j];
+
+        norm = std::sqrt(norm);
+        for (unsigned int j = 0;j < 3;++j)
+            modelValue[slotPos + j] /= norm;
+
+        for (unsigned int j = 4;j < stride;++j)
+            modelValue[slotPos + j] /= slotWeights[l];
     }
 
-    return b0Value;
+    return modelValue[0];
+}
+
+unsigned int ODFProbabilisticTractographyImageFilter::GetPeaksFromModel(const VectorType &modelValue, DirectionVectorType &peaks,
+                                                                        ListType &amplitudes, ListType &kappaValues)
+{
+    unsigned int stride = this->GetPeakFieldStride();
+    peaks.clear();
+    amplitudes.clear();
+    kappaValues.clear();
+
+    Vector3DType peak;
+    for (unsigned int k = 0;k < m_MaximalNumberOfPeaks;++k)
+    {
+        unsigned int peakPos = 3 + k * stride;
+        double amplitude = modelValue[peakPos + 3];
+        if ((amplitude <= 0)||(modelValue[peakPos + 4] <= 0))
+            continue;
+
+        for (unsigned int j = 0;j < 3;++j)
+            peak[j] = modelValue[peakPos + j];
+
+        // Insertion by decreasing amplitude
+        unsigned int pos = amplitudes.size();
+        peaks.push_back(peak);
+        amplitudes.push_back(amplitude);
+        kappaValues.push_back(modelValue[peakPos + 4]);
+
+        while ((pos > 0)&&(amplitudes[pos - 1] < amplitude))
+        {
+            std::swap(peaks[pos],peaks[pos - 1]);
+            std::swap(amplitudes[pos],amplitudes[pos - 1]);
+            std::swap(kappaValues[pos],kappaValues[pos - 1]);
+            --pos;
+        }
+    }
+
+    return peaks.size();
+}
+
+double ODFProbabilisticTractographyImageFilter::LookupLogLikelihood(const Vector3DType &newDirection, const Vector3DType &sampling_direction,
+                                                                    const VectorType &modelValue)
+{
+    unsigned int stride = this->GetPeakFieldStride();
+
+    // Likelihood of the unrotated ODF
+    double logLikelihood = modelValue[2];
+
+    int closestPeak = -1;
+    double bestScalarProduct = 0;
+    for (unsigned int k = 0;k < m_MaximalNumberOfPeaks;++k)
+    {
+        unsigned int peakPos = 3 + k * stride;
+        if (modelValue[peakPos + 3] <= 0)
+            continue;
+
+        double scalarProduct = 0;
+        for (unsigned int j = 0;j < 3;++j)
+            scalarProduct += modelValue[peakPos + j] * sampling_direction[j];
+
+        if (std::abs(scalarProduct) > bestScalarProduct)
+        {
+            bestScalarProduct = std::abs(scalarProduct);
+            closestPeak = k;
+        }
+    }
+
+    if (closestPeak < 0)
+        return logLikelihood;
+
+    unsigned int tablePos = 3 + closestPeak * stride + 5;
+    double anglePosition = anima::ComputeOrientationAngle(sampling_direction,newDirection) / m_LikelihoodAngularStep;
+    unsigned int lowerSample = std::floor(anglePosition);
+
+    if (lowerSample >= m_NumberOfLikelihoodSamples)
+        return modelValue[tablePos + m_NumberOfLikelihoodSamples - 1];
+
+    double lowerValue = (lowerSample == 0) ? logLikelihood : modelValue[tablePos + lowerSample - 1];
+    double upperValue = modelValue[tablePos + lowerSample];
+
+    return lowerValue + (anglePosition - lowerSample) * (upperValue - lowerValue);
 }
 
 double ODFProbabilisticTractographyImageFilter::GetGeneralizedFractionalAnisotropy(VectorType &modelValue)
 {
     double sumSquares = 0;
-    for (unsigned int i = 0;i < this->GetModelDimension();++i)
+    for (unsigned int i = 0;i < modelValue.GetSize();++i)
         sumSquares += modelValue[i]*modelValue[i];
 
     return std::sqrt(1.0 - modelValue[0]*modelValue[0]/sumSquares);
@@ -2,12 +2,21 @@
 
 #include <animaBaseProbabilisticTractographyImageFilter.h>
 #include <animaODFSphericalHarmonicBasis.h>
+#include <animaODFPeakExtractor.h>
 
 #include "AnimaTractographyExport.h"
 
 namespace anima
 {
 
+/**
+ * @brief Particle filter tractography on ODFs estimated from interpolated DWI data (Aganj et al. estimation).
+ * In peak lookup mode, a per-voxel peak field is computed before tracking: ODF peaks (directions, amplitudes,
+ * Watson concentrations from ODF curvature) and, for each peak, log-likelihoods of the observed signal for
+ * ODF rotations of increasing angle around that peak. Tracking then only interpolates this field (peaks being
+ * matched by orientation between voxels), samples proposals from the peaks Watson mixture and looks up
+ * the likelihood table, instead of estimating and evaluating the ODF at each particle step.
+ */
 class ANIMATRACTOGRAPHY_EXPORT ODFProbabilisticTractographyImageFilter : public anima::BaseProbabilisticTractographyImageFilter
 {
 public:
@@ -27,12 +36,23 @@ public:
         double x, y, z;
     };
 
+    //! Peak field: b0, GFA, log-likelihood of the unrotated ODF, then for each peak: direction, amplitude, kappa and likelihood table
+    typedef itk::VectorImage <ImageScalarType,3> PeakFieldImageType;
+    typedef PeakFieldImageType::Pointer PeakFieldImagePointer;
+
     void SetODFSHOrder(unsigned int num);
     itkSetMacro(Lambda,double);
     itkSetMacro(GFAThreshold,double);
     itkSetMacro(CurvatureScale,double);
     itkSetMacro(MinimalDiffusionProbability,double);
 
+    itkSetMacro(UsePeakLookup,bool);
+    itkSetMacro(MaximalNumberOfPeaks,unsigned int);
+
+    //! Optional peaks image (peak directions scaled by amplitudes, as output by animaODFEstimator) used in peak lookup mode
+    itkSetObjectMacro(PeaksImage,PeakFieldImageType);
+    itkGetObjectMacro(PeakField,PeakFieldImageType);
+
 protected:
     ODFProbabilisticTractographyImageFilter();
     virtual ~ODFProbabilisticTractographyImageFilter();
@@ -42,7 +62,7 @@ protected:
 
     virtual Vector3DType ProposeNewDirection(Vector3DType &oldDirection, VectorType &modelValue,
                                           Vector3DType &sampling_direction, double &log_prior,
-                                          double &log_proposal, std::mt19937 &random_generator, unsigned int threadId) ITK_OVERRIDE;
+                                          double &log_proposal, RandomGeneratorType &random_generator, unsigned int threadId) ITK_OVERRIDE;
 
     virtual double ComputeLogWeightUpdate(double b0Value, double noiseValue, Vector3DType &newDirection, Vector3DType &sampling_direction,
                                           VectorType &modelValue, VectorType &dwiValue,
@@ -59,6 +79,33 @@ protected:
     unsigned int FindODFMaxima(const VectorType &modelValue, DirectionVectorType &maxima, double minVal, bool is2d);
     double GetGeneralizedFractionalAnisotropy(VectorType &modelValue);
 
+    unsigned int GetODFSHDimension() {return (m_ODFSHOrder + 1)*(m_ODFSHOrder + 2)/2;}
+
+    //! Regularized signal transform from Aganj et al, only on non b0 images
+    void ComputeAganjSignal(const VectorType &dwiValue, double b0Value, ListType &transformedSignal);
+
+    //! ODF estimation from DWI values, returns b0 value
+    double EstimateODFFromSignal(const VectorType &dwiValue, VectorType &modelValue);
+
+    //! Log-likelihood of DWI values (normalized by the number of images) for the rescaled ODF model rotated from sampling_direction to newDirection
+    double ComputeLogLikelihood(double b0Value, double noiseValue, const Vector3DType &newDirection, const Vector3DType &sampling_direction,
+                                const ListType &rescaledModel, const VectorType &dwiValue);
+
+    //! Multithread util function for peak field computation
+    static ITK_THREAD_RETURN_TYPE ThreadPeakFieldComputer(void *arg);
+    void ComputePeakFieldPart(unsigned int threadId, unsigned int numThreads);
+
+    unsigned int GetPeakFieldStride() {return 5 + m_NumberOfLikelihoodSamples;}
+
+    //! Peak field interpolation at a continuous index with orientation matching of peaks, returns b0 value
+    double InterpolatePeakField(const ContinuousIndexType &index, VectorType &modelValue);
+
+    //! Valid peaks of an interpolated peak field value, ordered by decreasing amplitude
+    unsigned int GetPeaksFromModel(const VectorType &modelValue, DirectionVectorType &peaks, ListType &amplitudes, ListType &kappaValues);
+
+    //! Log-likelihood from the peak field table of the peak closest to sampling_direction
+    double LookupLogLikelihood(const Vector3DType &newDirection, const Vector3DType &sampling_direction, const VectorType &modelValue);
+
 private:
     double m_GFAThreshold;
 
@@ -76,6 +123,17 @@ private:
     vnl_matrix <double> m_TMatrix;
     double m_Lambda;
     double m_DeltaAganjRegularization;
+
+    //! Peak lookup mode variables
+    bool m_UsePeakLookup;
+    unsigned int m_MaximalNumberOfPeaks;
+    unsigned int m_NumberOfLikelihoodSamples;
+    double m_LikelihoodAngularStep;
+    double m_PeakMatchingAngle;
+
+    anima::ODFPeakExtractor m_PeakExtractor;
+    PeakFieldImagePointer m_PeaksImage;
+    PeakFieldImagePointer m_PeakField;
 };
 
 } // end of namespace anima
@@ -71,6 +71,7 @@ int main(int argc,  char*  argv[])
     
     TCLAP::SwitchArg averageClustersArg("M","average-clusters","Output only cluster mean",cmd,false);
     
+    TCLAP::ValueArg<unsigned int> seedArg("","seed","Random generator seed, fibers are reproducible for a given seed whatever the number of threads (default: current time)",false,0,"random seed",cmd);
     TCLAP::ValueArg<unsigned int> nbThreadsArg("T","nb-threads","Number of threads to run on (default: all available)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
     
     try
@@ -208,6 +209,9 @@ int main(int argc,  char*  argv[])
     dtiTracker->SetMAPMergeFibers(averageClustersArg.isSet());
     dtiTracker->SetNumberOfThreads(nbThreadsArg.getValue());
 
+    if (seedArg.isSet())
+        dtiTracker->SetSeed(seedArg.getValue());
+
     itk::CStyleCommand::Pointer callback = itk::CStyleCommand::New();
     callback->SetCallback(eventCallback);
     dtiTracker->AddObserver(itk::ProgressEvent(), callback);
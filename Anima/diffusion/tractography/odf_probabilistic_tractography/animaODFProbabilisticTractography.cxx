@@ -57,6 +57,10 @@ int main(int argc,  char*  argv[])
     TCLAP::ValueArg<unsigned int> odfOrderArg("K","odf-order","ODF order (default: 4)",false,4,"ODF order",cmd);
     TCLAP::ValueArg<double> curvScaleArg("","cs","Scale for ODF curvature to get vMF kappa (default: 6)",false,6.0,"scale for ODF curvature",cmd);
 
+    TCLAP::SwitchArg peakLookupArg("L","peak-lookup","Track on a precomputed peak field instead of estimating ODFs at each step",cmd,false);
+    TCLAP::ValueArg<std::string> peaksArg("","peaks","Peaks image (from animaODFEstimator) used for the peak field in peak lookup mode (default: peaks extracted from ODFs)",false,"","peaks image",cmd);
+    TCLAP::ValueArg<unsigned int> nbPeaksArg("","nb-peaks","Maximal number of peaks per voxel in peak lookup mode (default: 3)",false,3,"number of peaks",cmd);
+
     TCLAP::ValueArg<double> distThrArg("","dist-thr","Hausdorff distance threshold for mergine clusters (default: 0.5)",false,0.5,"merging threshold",cmd);
     TCLAP::ValueArg<double> kappaThrArg("","kappa-thr","Kappa threshold for splitting clusters (default: 30)",false,30.0,"splitting threshold",cmd);
 
@@ -64,6 +68,7 @@ int main(int argc,  char*  argv[])
 
     TCLAP::SwitchArg averageClustersArg("M","average-clusters","Output only cluster mean",cmd,false);
 
+    TCLAP::ValueArg<unsigned int> seedArg("","seed","Random generator seed, fibers are reproducible for a given seed whatever the number of threads (default: current time)",false,0,"random seed",cmd);
     TCLAP::ValueArg<unsigned int> nbThreadsArg("T","nb-threads","Number of threads to run on (default: all available)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
 
     try
@@ -82,6 +87,8 @@ int main(int argc,  char*  argv[])
     typedef MainFilterType::MaskImageType MaskImageType;
     typedef itk::ImageFileReader <MaskImageType> MaskReaderType;
     typedef MainFilterType::Vector3DType Vector3DType;
+    typedef MainFilterType::PeakFieldImageType PeaksImageType;
+    typedef itk::ImageFileReader <PeaksImageType> PeaksReaderType;
     
     MainFilterType::Pointer odfTracker = MainFilterType::New();
 
@@ -166,9 +173,23 @@ int main(int argc,  char*  argv[])
     odfTracker->SetKappaSplitThreshold(kappaThrArg.getValue());
     odfTracker->SetClusterDistance(clusterDistArg.getValue());
     odfTracker->SetCurvatureScale(curvScaleArg.getValue());
+
+    odfTracker->SetUsePeakLookup(peakLookupArg.isSet());
+    odfTracker->SetMaximalNumberOfPeaks(nbPeaksArg.getValue());
+    if (peakLookupArg.isSet() && (peaksArg.getValue() != ""))
+    {
+        PeaksReaderType::Pointer peaksReader = PeaksReaderType::New();
+        peaksReader->SetFileName(peaksArg.getValue());
+        peaksReader->Update();
+
+        odfTracker->SetPeaksImage(peaksReader->GetOutput());
+    }
     
     odfTracker->SetComputeLocalColors(fibersArg.getValue().find(".fds") == std::string::npos);
     odfTracker->SetMAPMergeFibers(averageClustersArg.getValue());
+
+    if (seedArg.isSet())
+        odfTracker->SetSeed(seedArg.getValue());
     
     itk::CStyleCommand::Pointer callback = itk::CStyleCommand::New();
     callback->SetCallback(eventCallback);
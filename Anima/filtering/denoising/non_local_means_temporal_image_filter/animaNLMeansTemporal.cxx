@@ -107,6 +107,15 @@ int main(int ac, const char** av)
                                                 "Patch search neighborhood size",
                                                 cmd);
 
+    TCLAP::SwitchArg jointWeightsArg("J","joint","Compute patch weights jointly over feature volumes and use them for all volumes (default: false)",cmd,false);
+
+    TCLAP::MultiArg<unsigned int> featureVolumesArg("f",
+                                                    "featureVolume",
+                                                    "Volume index used for candidate pruning and joint weights, may be repeated (e.g. b0 images) -> default: all volumes",
+                                                    false,
+                                                    "feature volume index",
+                                                    cmd);
+
     try
     {
         cmd.parse(ac,av);
@@ -183,6 +192,11 @@ int main(int ac, const char** av)
             if (weightMethod.getValue())
                 filter->SetWeightMethod(FilterType::RICIAN);
 
+            if (jointWeightsArg.isSet())
+                filter->SetTemporalWeightsMode(FilterType::JOINT_WEIGHTS);
+
+            filter->SetFeatureVolumes(featureVolumesArg.getValue());
+
             filter->SetNumberOfThreads(nbpArg.getValue());
 
             filter->Update();
@@ -220,6 +234,11 @@ int main(int ac, const char** av)
             if (weightMethod.getValue())
                 filter->SetWeightMethod(FilterType::RICIAN);
 
+            if (jointWeightsArg.isSet())
+                filter->SetTemporalWeightsMode(FilterType::JOINT_WEIGHTS);
+
+            filter->SetFeatureVolumes(featureVolumesArg.getValue());
+
             filter->SetNumberOfThreads(nbpArg.getValue());
 
             filter->AddObserver(itk::ProgressEvent(), callback );
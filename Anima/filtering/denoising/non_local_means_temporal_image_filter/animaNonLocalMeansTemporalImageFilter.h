@@ -6,11 +6,21 @@
 #include <itkImage.h>
 #include <itkVector.h>
 #include <itkObject.h>
+#include <itkMultiThreader.h>
 
+#include <vector>
 
 namespace anima
 {
 
+/**
+ * @brief Non local means denoising of a series of volumes (last image dimension), directly on the whole buffer.
+ *
+ * Candidate patches are pruned once per voxel, using patch mean and variance maps averaged over feature volumes
+ * (default: all volumes). In JOINT_WEIGHTS mode, patch distances are computed over all feature volumes at once
+ * (e.g. all b0 images of a DWI series) and the resulting weights are used to denoise all volumes. In
+ * PER_VOLUME_WEIGHTS mode, each volume gets its own patch weights among the shared candidates.
+ */
 template <class TInputImage >
 class NonLocalMeansTemporalImageFilter :
     public itk::ImageToImageFilter < TInputImage, TInputImage >
@@ -55,6 +65,8 @@ public:
                         TInputImage::ImageDimension);
     itkStaticConstMacro(OutputImageDimension, unsigned int,
                         TInputImage::ImageDimension);
+    itkStaticConstMacro(SpatialDimension, unsigned int,
+                        TInputImage::ImageDimension - 1);
 
 
     /** Noise used to determine weightes */
@@ -63,6 +75,12 @@ public:
         EXP, RICIAN
     };
 
+    /** Patch weights computation across volumes */
+    enum TEMPORAL_WEIGHTS
+    {
+        PER_VOLUME_WEIGHTS, JOINT_WEIGHTS
+    };
+
     itkSetMacro(PatchHalfSize, unsigned int);
     itkSetMacro(SearchNeighborhood, unsigned int);
     itkSetMacro(SearchStepSize, unsigned int);
@@ -71,6 +89,10 @@ public:
     itkSetMacro(MeanMinThreshold, double);
     itkSetMacro(VarMinThreshold, double);
     itkSetMacro(WeightMethod, WEIGHT);
+    itkSetMacro(TemporalWeightsMode, TEMPORAL_WEIGHTS);
+
+    //! Volumes used for candidate pruning and joint weights (default: all volumes)
+    void SetFeatureVolumes(const std::vector <unsigned int> &volumes) {m_FeatureVolumes = volumes;}
 
 protected:
     NonLocalMeansTemporalImageFilter() :
@@ -81,7 +103,8 @@ protected:
         m_PatchHalfSize(1),
         m_SearchStepSize(1),
         m_SearchNeighborhood(5),
-        m_WeightMethod(EXP)
+        m_WeightMethod(EXP),
+        m_TemporalWeightsMode(PER_VOLUME_WEIGHTS)
     {}
 
     NonLocalMeansTemporalImageFilter(const Self&);//purposely not implemented
@@ -89,11 +112,20 @@ protected:
 
     virtual ~NonLocalMeansTemporalImageFilter() {}
 
-
     //void PrintSelf(std::ostream& os, Indent indent) const;
     //DataObject::Pointer MakeOutput(unsigned int idx);
     void GenerateData() ITK_OVERRIDE;
 
+    //! Noise variance of each volume, estimated from local pseudo-residuals
+    void ComputeAverageLocalVariances();
+
+    //! Patch mean and variance maps averaged over feature volumes
+    void ComputeFeatureMeanAndVarMaps();
+
+    //! Threads split the spatial voxels, each one processing all volumes of its voxels
+    static ITK_THREAD_RETURN_TYPE ThreadedDenoiseCallback(void *arg);
+    void DenoiseVoxels(unsigned int threadId, unsigned int numThreads);
+
 private:
 
     double m_MeanMinThreshold;
@@ -105,6 +137,19 @@ private:
     unsigned int m_SearchStepSize;
     unsigned int m_SearchNeighborhood;
     WEIGHT m_WeightMethod;
+    TEMPORAL_WEIGHTS m_TemporalWeightsMode;
+
+    std::vector <unsigned int> m_FeatureVolumes;
+
+    //! Buffer layout: spatial voxel offset + volume index * volume stride
+    unsigned int m_NumberOfVolumes;
+    unsigned int m_VolumeStride;
+
+    std::vector <double> m_NoiseCovariances;
+    double m_FeatureNoiseCovariance;
+
+    std::vector <double> m_FeatureMeanMap;
+    std::vector <double> m_FeatureVarMap;
 };
 
 
@@ -2,12 +2,10 @@
 
 #include "animaNonLocalMeansTemporalImageFilter.h"
 
-#include <animaNonLocalMeansImageFilter.h>
-#include <itkImageRegionIterator.h>
-#include <itkImageRegionIteratorWithIndex.h>
-#include <itkImageRegionConstIterator.h>
-#include <itkImageRegionConstIteratorWithIndex.h>
-#include <itkExtractImageFilter.h>
+#include <itkProgressReporter.h>
+
+#include <algorithm>
+#include <cmath>
 
 namespace anima
 {
@@ -18,76 +16,408 @@ void
 NonLocalMeansTemporalImageFilter < TInputImage >
 ::GenerateData()
 {
-    typedef itk::Image<InputPixelType, InputImageDimension - 1> ImageToComputeType;
-    typedef itk::ExtractImageFilter< InputImageType, ImageToComputeType > ExtractImageFilterType;
-
     this->AllocateOutputs();
 
-    unsigned int nbTemporalImage = this->GetInput()->GetLargestPossibleRegion().GetSize()[InputImageDimension - 1];
+    const InputImageType *input = this->GetInput();
+    m_NumberOfVolumes = input->GetLargestPossibleRegion().GetSize()[InputImageDimension - 1];
+    m_VolumeStride = input->GetOffsetTable()[InputImageDimension - 1];
 
-    typename InputImageType::RegionType extractRegion;
-    typename InputImageType::SizeType extractSize;
-    typename InputImageType::IndexType extractIndex;
+    std::vector <unsigned int> featureVolumes;
+    for (unsigned int i = 0;i < m_FeatureVolumes.size();++i)
+    {
+        if (m_FeatureVolumes[i] < m_NumberOfVolumes)
+            featureVolumes.push_back(m_FeatureVolumes[i]);
+    }
 
-    for (unsigned int d = 0; d < InputImageDimension - 1; ++d)
+    if (featureVolumes.size() == 0)
     {
-        extractSize[d] = this->GetInput()->GetLargestPossibleRegion().GetSize()[d];
-        extractIndex[d] = 0;
+        for (unsigned int i = 0;i < m_NumberOfVolumes;++i)
+            featureVolumes.push_back(i);
     }
 
-    extractSize[InputImageDimension - 1] = 0;
-    extractRegion.SetSize(extractSize);
+    m_FeatureVolumes = featureVolumes;
+
+    this->ComputeAverageLocalVariances();
+    this->ComputeFeatureMeanAndVarMaps();
+
+    typename itk::ImageSource <TInputImage>::ThreadStruct str;
+    str.Filter = this;
+
+    this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
+    this->GetMultiThreader()->SetSingleMethod(this->ThreadedDenoiseCallback,&str);
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    m_FeatureMeanMap.clear();
+    m_FeatureVarMap.clear();
+}
+
+template < class TInputImage>
+void
+NonLocalMeansTemporalImageFilter < TInputImage >
+::ComputeAverageLocalVariances()
+{
+    const InputImageType *input = this->GetInput();
+    const InputPixelType *inputBuffer = input->GetBufferPointer();
+    typename InputImageType::SizeType imageSize = input->GetLargestPossibleRegion().GetSize();
+    const typename InputImageType::OffsetValueType *offsetTable = input->GetOffsetTable();
+
+    unsigned int numLocalPixels = 2 * SpatialDimension;
+    int localNeighborhood = 1;
 
-    typedef itk::ImageRegionIterator <OutputImageType> FillIteratorType;
-    FillIteratorType fillItr(this->GetOutput(), this->GetOutput()->GetLargestPossibleRegion());
+    m_NoiseCovariances.resize(m_NumberOfVolumes);
+    std::fill(m_NoiseCovariances.begin(),m_NoiseCovariances.end(),0.0);
 
-    //support progress methods/callbacks
-    itk::ProgressReporter progress(this, 0, nbTemporalImage);
+    InputImageIndexType spatialIndex;
+    spatialIndex.Fill(0);
 
-    for (unsigned int i = 0; i < nbTemporalImage; ++i)
+    for (unsigned int i = 0;i < m_VolumeStride;++i)
     {
-        extractIndex[InputImageDimension - 1] = i;
-        extractRegion.SetIndex(extractIndex);
+        for (unsigned int v = 0;v < m_NumberOfVolumes;++v)
+        {
+            const InputPixelType *voxelPtr = inputBuffer + i + v * m_VolumeStride;
+            double averageLocalSignal = 0;
+
+            for (unsigned int d = 0;d < SpatialDimension;++d)
+            {
+                int lowerShift = std::min(localNeighborhood,(int)spatialIndex[d]);
+                int upperShift = std::min(localNeighborhood,(int)(imageSize[d] - 1 - spatialIndex[d]));
+
+                averageLocalSignal += *(voxelPtr - lowerShift * offsetTable[d]);
+                averageLocalSignal += *(voxelPtr + upperShift * offsetTable[d]);
+            }
+
+            averageLocalSignal /= numLocalPixels;
+            double diffSignal = std::sqrt(numLocalPixels / (numLocalPixels + 1.0)) * (*voxelPtr - averageLocalSignal);
+
+            m_NoiseCovariances[v] += diffSignal * diffSignal;
+        }
+
+        for (unsigned int d = 0;d < SpatialDimension;++d)
+        {
+            ++spatialIndex[d];
+            if ((unsigned int)spatialIndex[d] < imageSize[d])
+                break;
+
+            spatialIndex[d] = 0;
+        }
+    }
 
-        typename ExtractImageFilterType::Pointer extractFilter = ExtractImageFilterType::New();
-        extractFilter->SetInput(this->GetInput());
+    m_FeatureNoiseCovariance = 0;
+    for (unsigned int v = 0;v < m_NumberOfVolumes;++v)
+        m_NoiseCovariances[v] /= m_VolumeStride;
 
-        extractFilter->SetExtractionRegion(extractRegion);
-        extractFilter->SetDirectionCollapseToGuess();
-        extractFilter->Update();
+    for (unsigned int i = 0;i < m_FeatureVolumes.size();++i)
+        m_FeatureNoiseCovariance += m_NoiseCovariances[m_FeatureVolumes[i]];
 
-        typedef anima::NonLocalMeansImageFilter<ImageToComputeType> NLMEansFilterType;
-        typename NLMEansFilterType::Pointer nLMeansFilter = NLMEansFilterType::New();
+    m_FeatureNoiseCovariance /= m_FeatureVolumes.size();
+}
 
+template < class TInputImage>
+void
+NonLocalMeansTemporalImageFilter < TInputImage >
+::ComputeFeatureMeanAndVarMaps()
+{
+    const InputImageType *input = this->GetInput();
+    const InputPixelType *inputBuffer = input->GetBufferPointer();
+    typename InputImageType::SizeType imageSize = input->GetLargestPossibleRegion().GetSize();
+    const typename InputImageType::OffsetValueType *offsetTable = input->GetOffsetTable();
 
-        nLMeansFilter->SetInput(extractFilter->GetOutput());
-        nLMeansFilter->SetWeightThreshold(m_WeightThreshold);
-        nLMeansFilter->SetPatchHalfSize(m_PatchHalfSize);
-        nLMeansFilter->SetSearchStepSize(m_SearchStepSize);
-        nLMeansFilter->SetSearchNeighborhood(m_SearchNeighborhood);
-        nLMeansFilter->SetBetaParameter(m_BetaParameter);
-        nLMeansFilter->SetMeanMinThreshold(m_MeanMinThreshold);
-        nLMeansFilter->SetVarMinThreshold(m_VarMinThreshold);
-        if (m_WeightMethod == EXP)
-                nLMeansFilter->SetWeightMethod(NLMEansFilterType::EXP);
-        else nLMeansFilter->SetWeightMethod(NLMEansFilterType::RICIAN);
+    m_FeatureMeanMap.resize(m_VolumeStride);
+    m_FeatureVarMap.resize(m_VolumeStride);
+    std::fill(m_FeatureMeanMap.begin(),m_FeatureMeanMap.end(),0.0);
+    std::fill(m_FeatureVarMap.begin(),m_FeatureVarMap.end(),0.0);
 
-        nLMeansFilter->SetNumberOfThreads(this->GetNumberOfThreads());
+    std::vector <double> sums(m_VolumeStride), squaredSums(m_VolumeStride);
+    std::vector <double> lineValues, lineSquaredValues;
 
-        nLMeansFilter->Update();
+    unsigned int neighborhoodSize = 1;
+    for (unsigned int d = 0;d < SpatialDimension;++d)
+        neighborhoodSize *= 2 * m_PatchHalfSize + 1;
 
-        typedef itk::ImageRegionConstIterator <ImageToComputeType> ResIteratorType;
-        ResIteratorType resItr(nLMeansFilter->GetOutput(), nLMeansFilter->GetOutput()->GetLargestPossibleRegion());
+    int halfSize = m_PatchHalfSize;
 
-        while (!resItr.IsAtEnd())
+    for (unsigned int f = 0;f < m_FeatureVolumes.size();++f)
+    {
+        const InputPixelType *volumeBuffer = inputBuffer + m_FeatureVolumes[f] * m_VolumeStride;
+        for (unsigned int i = 0;i < m_VolumeStride;++i)
         {
-            fillItr.Set(resItr.Get());
-            ++fillItr;
-            ++resItr;
+            sums[i] = volumeBuffer[i];
+            squaredSums[i] = sums[i] * sums[i];
         }
-        progress.CompletedPixel();
+
+        // Separable box sums over the patch, borders are replicated (zero flux Neumann condition)
+        for (unsigned int d = 0;d < SpatialDimension;++d)
+        {
+            int lineSize = imageSize[d];
+            unsigned int stride = offsetTable[d];
+            lineValues.resize(lineSize);
+            lineSquaredValues.resize(lineSize);
+
+            for (unsigned int i = 0;i < m_VolumeStride;++i)
+            {
+                // Only process line starts along dimension d
+                if ((i / stride) % lineSize != 0)
+                    continue;
+
+                for (int j = 0;j < lineSize;++j)
+                {
+                    lineValues[j] = sums[i + j * stride];
+                    lineSquaredValues[j] = squaredSums[i + j * stride];
+                }
+
+                for (int j = 0;j < lineSize;++j)
+                {
+                    double sumValue = 0, squaredSumValue = 0;
+                    for (int k = j - halfSize;k <= j + halfSize;++k)
+                    {
+                        int clampedK = std::max(0,std::min(lineSize - 1,k));
+                        sumValue += lineValues[clampedK];
+                        squaredSumValue += lineSquaredValues[clampedK];
+                    }
+
+                    sums[i + j * stride] = sumValue;
+                    squaredSums[i + j * stride] = squaredSumValue;
+                }
+            }
+        }
+
+        for (unsigned int i = 0;i < m_VolumeStride;++i)
+        {
+            double mean = sums[i] / neighborhoodSize;
+            m_FeatureMeanMap[i] += mean;
+            m_FeatureVarMap[i] += (squaredSums[i] / neighborhoodSize - mean * mean) * (neighborhoodSize / (neighborhoodSize - 1.0));
+        }
+    }
+
+    for (unsigned int i = 0;i < m_VolumeStride;++i)
+    {
+        m_FeatureMeanMap[i] /= m_FeatureVolumes.size();
+        m_FeatureVarMap[i] /= m_FeatureVolumes.size();
     }
+}
+
+template < class TInputImage>
+ITK_THREAD_RETURN_TYPE
+NonLocalMeansTemporalImageFilter < TInputImage >
+::ThreadedDenoiseCallback(void *arg)
+{
+    itk::MultiThreader::ThreadInfoStruct *threadInfo = (itk::MultiThreader::ThreadInfoStruct *)(arg);
+    typedef typename itk::ImageSource <TInputImage>::ThreadStruct ThreadStruct;
+    ThreadStruct *str = (ThreadStruct *)(threadInfo->UserData);
+
+    Self *filterPtr = dynamic_cast <Self *> (str->Filter.GetPointer());
+    filterPtr->DenoiseVoxels(threadInfo->ThreadID,threadInfo->NumberOfThreads);
 
+    return ITK_THREAD_RETURN_VALUE;
+}
+
+template < class TInputImage>
+void
+NonLocalMeansTemporalImageFilter < TInputImage >
+::DenoiseVoxels(unsigned int threadId, unsigned int numThreads)
+{
+    const InputImageType *input = this->GetInput();
+    const InputPixelType *inputBuffer = input->GetBufferPointer();
+    InputPixelType *outputBuffer = this->GetOutput()->GetBufferPointer();
+    typename InputImageType::SizeType imageSize = input->GetLargestPossibleRegion().GetSize();
+    const typename InputImageType::OffsetValueType *offsetTable = input->GetOffsetTable();
+
+    unsigned int startVoxel = (unsigned int)((unsigned long)threadId * m_VolumeStride / numThreads);
+    unsigned int endVoxel = (unsigned int)((unsigned long)(threadId + 1) * m_VolumeStride / numThreads);
+
+    itk::ProgressReporter progress(this, threadId, endVoxel - startVoxel);
+
+    int maxAbsDisp = std::floor((float)(m_SearchNeighborhood / m_SearchStepSize)) * m_SearchStepSize;
+    int halfSize = m_PatchHalfSize;
+    bool jointWeights = (m_TemporalWeightsMode == JOINT_WEIGHTS);
+    unsigned int numFeatures = m_FeatureVolumes.size();
+
+    // Per volume weighted sums, sums of weights and maximal weights
+    std::vector <double> averages(m_NumberOfVolumes), weightSums(m_NumberOfVolumes), maxWeights(m_NumberOfVolumes);
+    std::vector <int> patchOffsets;
+
+    InputImageIndexType dataIndex, blockIndex, dispStart, dispEnd, candidateIndex;
+    unsigned int blockSize[SpatialDimension];
+
+    for (unsigned int i = startVoxel;i < endVoxel;++i)
+    {
+        unsigned int remainder = i;
+        for (int d = SpatialDimension - 1;d >= 0;--d)
+        {
+            dataIndex[d] = remainder / offsetTable[d];
+            remainder -= dataIndex[d] * offsetTable[d];
+        }
+
+        // Reference patch, cropped to the image, and search window
+        for (unsigned int d = 0;d < SpatialDimension;++d)
+        {
+            int maxIndex = imageSize[d] - 1;
+            blockIndex[d] = std::max(0,(int)dataIndex[d] - halfSize);
+            blockSize[d] = std::min(maxIndex,(int)dataIndex[d] + halfSize) - blockIndex[d] + 1;
+
+            dispStart[d] = std::max(0,(int)dataIndex[d] - maxAbsDisp);
+            dispEnd[d] = std::min(maxIndex,(int)dataIndex[d] + maxAbsDisp);
+        }
+
+        patchOffsets.clear();
+        InputImageIndexType patchIndex;
+        patchIndex.Fill(0);
+        bool patchDone = false;
+        while (!patchDone)
+        {
+            int offset = 0;
+            for (unsigned int d = 0;d < SpatialDimension;++d)
+                offset += (blockIndex[d] + patchIndex[d] - dataIndex[d]) * offsetTable[d];
+
+            patchOffsets.push_back(offset);
+
+            patchDone = true;
+            for (unsigned int d = 0;d < SpatialDimension;++d)
+            {
+                ++patchIndex[d];
+                if ((unsigned int)patchIndex[d] < blockSize[d])
+                {
+                    patchDone = false;
+                    break;
+                }
+
+                patchIndex[d] = 0;
+            }
+        }
+
+        unsigned int numPatchVoxels = patchOffsets.size();
+        double refMeanValue = m_FeatureMeanMap[i];
+        double refVarValue = m_FeatureVarMap[i];
+
+        std::fill(averages.begin(),averages.end(),0.0);
+        std::fill(weightSums.begin(),weightSums.end(),0.0);
+        std::fill(maxWeights.begin(),maxWeights.end(),0.0);
+
+        candidateIndex = dispStart;
+        bool searchDone = false;
+        while (!searchDone)
+        {
+            bool movingRegionIsValid = true;
+            bool isCentralIndex = true;
+            int candidateOffset = 0;
+            for (unsigned int d = 0;d < SpatialDimension;++d)
+            {
+                int movingIndex = blockIndex[d] + candidateIndex[d] - dataIndex[d];
+                if ((movingIndex < 0) || (movingIndex + blockSize[d] > imageSize[d]))
+                    movingRegionIsValid = false;
+
+                if (candidateIndex[d] != dataIndex[d])
+                    isCentralIndex = false;
+
+                candidateOffset += candidateIndex[d] * offsetTable[d];
+            }
+
+            if (movingRegionIsValid && !isCentralIndex)
+            {
+                // Candidate pruning, shared by all volumes
+                double meanRate = refMeanValue / m_FeatureMeanMap[candidateOffset];
+                double varianceRate = refVarValue / m_FeatureVarMap[candidateOffset];
+
+                if ((meanRate > m_MeanMinThreshold) && (meanRate < (1.0 / m_MeanMinThreshold)) &&
+                        (varianceRate > m_VarMinThreshold) && (varianceRate < (1.0 / m_VarMinThreshold)))
+                {
+                    if (jointWeights)
+                    {
+                        double distance = 0;
+                        for (unsigned int f = 0;f < numFeatures;++f)
+                        {
+                            const InputPixelType *refPtr = inputBuffer + i + m_FeatureVolumes[f] * m_VolumeStride;
+                            const InputPixelType *movingPtr = inputBuffer + candidateOffset + m_FeatureVolumes[f] * m_VolumeStride;
+
+                            for (unsigned int p = 0;p < numPatchVoxels;++p)
+                            {
+                                double diffValue = (double)refPtr[patchOffsets[p]] - (double)movingPtr[patchOffsets[p]];
+                                distance += diffValue * diffValue;
+                            }
+                        }
+
+                        double weightValue = std::exp(- distance / (2.0 * m_BetaParameter * m_FeatureNoiseCovariance * numPatchVoxels * numFeatures));
+                        if (weightValue > m_WeightThreshold)
+                        {
+                            for (unsigned int v = 0;v < m_NumberOfVolumes;++v)
+                            {
+                                double sampleValue = inputBuffer[candidateOffset + v * m_VolumeStride];
+                                if (m_WeightMethod == RICIAN)
+                                    sampleValue *= sampleValue;
+
+                                averages[v] += weightValue * sampleValue;
+                                weightSums[v] += weightValue;
+                                maxWeights[v] = std::max(maxWeights[v],weightValue);
+                            }
+                        }
+                    }
+                    else
+                    {
+                        for (unsigned int v = 0;v < m_NumberOfVolumes;++v)
+                        {
+                            const InputPixelType *refPtr = inputBuffer + i + v * m_VolumeStride;
+                            const InputPixelType *movingPtr = inputBuffer + candidateOffset + v * m_VolumeStride;
+
+                            double distance = 0;
+                            for (unsigned int p = 0;p < numPatchVoxels;++p)
+                            {
+                                double diffValue = (double)refPtr[patchOffsets[p]] - (double)movingPtr[patchOffsets[p]];
+                                distance += diffValue * diffValue;
+                            }
+
+                            double weightValue = std::exp(- distance / (2.0 * m_BetaParameter * m_NoiseCovariances[v] * numPatchVoxels));
+                            if (weightValue <= m_WeightThreshold)
+                                continue;
+
+                            double sampleValue = movingPtr[0];
+                            if (m_WeightMethod == RICIAN)
+                                sampleValue *= sampleValue;
+
+                            averages[v] += weightValue * sampleValue;
+                            weightSums[v] += weightValue;
+                            maxWeights[v] = std::max(maxWeights[v],weightValue);
+                        }
+                    }
+                }
+            }
+
+            searchDone = true;
+            for (unsigned int d = 0;d < SpatialDimension;++d)
+            {
+                candidateIndex[d] += m_SearchStepSize;
+                if (candidateIndex[d] <= dispEnd[d])
+                {
+                    searchDone = false;
+                    break;
+                }
+
+                candidateIndex[d] = dispStart[d];
+            }
+        }
+
+        for (unsigned int v = 0;v < m_NumberOfVolumes;++v)
+        {
+            double inputValue = inputBuffer[i + v * m_VolumeStride];
+            double outputValue = inputValue;
+
+            if (weightSums[v] != 0)
+            {
+                if (m_WeightMethod == EXP)
+                    outputValue = (averages[v] + maxWeights[v] * inputValue) / (weightSums[v] + maxWeights[v]);
+                else
+                {
+                    double t = (averages[v] + inputValue * inputValue * maxWeights[v]) / (weightSums[v] + maxWeights[v])
+                            - 2.0 * m_NoiseCovariances[v];
+
+                    outputValue = std::sqrt(std::max(0.0,t));
+                }
+            }
+
+            outputBuffer[i + v * m_VolumeStride] = outputValue;
+        }
+
+        progress.CompletedPixel();
+    }
 }
 
 }//end of namespace anima
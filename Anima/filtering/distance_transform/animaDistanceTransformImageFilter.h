@@ -0,0 +1,95 @@
+#pragma once
+
+#include <itkImageToImageFilter.h>
+#include <itkImage.h>
+#include <vector>
+
+namespace anima
+{
+
+/**
+ * @brief Exact euclidean distance transform with nearest label (Voronoi) map
+ *
+ * Separable lower envelope of parabolas algorithm (Felzenszwalb and Huttenlocher), processed dimension
+ * by dimension, lines being distributed among threads. Non zero input voxels are features, their value
+ * being propagated in the Voronoi map (output 1). Image spacing is taken into account if required.
+ * In signed mode, the input is considered as a binary object: outside distances are positive, inside ones
+ * are negative (unless InsideIsPositive is set).
+ */
+template <typename TInputImage, typename TOutputImage>
+class DistanceTransformImageFilter :
+        public itk::ImageToImageFilter <TInputImage, TOutputImage>
+{
+public:
+    /** Standard class typedefs. */
+    typedef DistanceTransformImageFilter Self;
+    typedef itk::ImageToImageFilter <TInputImage, TOutputImage> Superclass;
+    typedef itk::SmartPointer <Self> Pointer;
+    typedef itk::SmartPointer <const Self> ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self)
+
+    /** Run-time type information (and related methods) */
+    itkTypeMacro(DistanceTransformImageFilter, itk::ImageToImageFilter)
+
+    typedef TInputImage InputImageType;
+    typedef TOutputImage OutputImageType;
+    typedef TInputImage VoronoiImageType;
+    typedef typename InputImageType::PixelType InputPixelType;
+    typedef typename OutputImageType::PixelType OutputPixelType;
+    typedef typename Superclass::DataObjectPointerArraySizeType DataObjectPointerArraySizeType;
+
+    itkStaticConstMacro(ImageDimension, unsigned int, TInputImage::ImageDimension);
+
+    itkSetMacro(UseImageSpacing, bool)
+    itkSetMacro(SquaredDistance, bool)
+    itkSetMacro(SignedDistance, bool)
+    itkSetMacro(InsideIsPositive, bool)
+
+    //! Nearest feature label map
+    VoronoiImageType *GetVoronoiMap() {return dynamic_cast <VoronoiImageType *> (this->itk::ProcessObject::GetOutput(1));}
+
+    using Superclass::MakeOutput;
+    itk::DataObject::Pointer MakeOutput(DataObjectPointerArraySizeType idx) ITK_OVERRIDE;
+
+protected:
+    DistanceTransformImageFilter();
+    virtual ~DistanceTransformImageFilter() {}
+
+    void GenerateInputRequestedRegion() ITK_OVERRIDE;
+    void EnlargeOutputRequestedRegion(itk::DataObject *output) ITK_OVERRIDE;
+    void GenerateData() ITK_OVERRIDE;
+
+    //! Initializes squared distances and labels from features (non zero voxels or zero voxels if invert is set)
+    void InitializeBuffers(OutputPixelType *distanceBuffer, InputPixelType *labelBuffer, bool invertFeatures);
+
+    //! Runs the separable passes on buffers, multi-threaded over lines
+    void ComputeSquaredDistances(OutputPixelType *distanceBuffer, InputPixelType *labelBuffer);
+
+    static ITK_THREAD_RETURN_TYPE ThreadedPassCallback(void *arg);
+    void ProcessLines(unsigned int threadId, unsigned int numThreads);
+
+    //! Lower envelope of parabolas on one line
+    void ProcessLine(OutputPixelType *distances, InputPixelType *labels, unsigned int lineSize, unsigned int lineStride,
+                     double spacing, std::vector <double> &lineValues, std::vector <InputPixelType> &lineLabels,
+                     std::vector <unsigned int> &parabolaLocations, std::vector <double> &parabolaBounds);
+
+private:
+    DistanceTransformImageFilter(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+
+    bool m_UseImageSpacing;
+    bool m_SquaredDistance;
+    bool m_SignedDistance;
+    bool m_InsideIsPositive;
+
+    // Internal state for threaded passes
+    OutputPixelType *m_CurrentDistanceBuffer;
+    InputPixelType *m_CurrentLabelBuffer;
+    unsigned int m_CurrentDimension;
+};
+
+} // end namespace anima
+
+#include "animaDistanceTransformImageFilter.hxx"
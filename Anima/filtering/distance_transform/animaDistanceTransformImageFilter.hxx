@@ -0,0 +1,290 @@
+#pragma once
+#include "animaDistanceTransformImageFilter.h"
+
+#include <itkImageRegionConstIterator.h>
+#include <itkNumericTraits.h>
+
+#include <cmath>
+#include <limits>
+
+namespace anima
+{
+
+template <typename TInputImage, typename TOutputImage>
+DistanceTransformImageFilter <TInputImage, TOutputImage>
+::DistanceTransformImageFilter()
+{
+    m_UseImageSpacing = true;
+    m_SquaredDistance = false;
+    m_SignedDistance = false;
+    m_InsideIsPositive = false;
+
+    m_CurrentDistanceBuffer = 0;
+    m_CurrentLabelBuffer = 0;
+    m_CurrentDimension = 0;
+
+    this->SetNumberOfRequiredOutputs(2);
+    this->SetNthOutput(0,this->MakeOutput(0));
+    this->SetNthOutput(1,this->MakeOutput(1));
+}
+
+template <typename TInputImage, typename TOutputImage>
+itk::DataObject::Pointer
+DistanceTransformImageFilter <TInputImage, TOutputImage>
+::MakeOutput(DataObjectPointerArraySizeType idx)
+{
+    if (idx == 1)
+        return VoronoiImageType::New().GetPointer();
+
+    return OutputImageType::New().GetPointer();
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+DistanceTransformImageFilter <TInputImage, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+    Superclass::GenerateInputRequestedRegion();
+
+    // Distances are global: the whole input is needed
+    InputImageType *input = const_cast <InputImageType *> (this->GetInput());
+    if (input)
+        input->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+DistanceTransformImageFilter <TInputImage, TOutputImage>
+::EnlargeOutputRequestedRegion(itk::DataObject *output)
+{
+    Superclass::EnlargeOutputRequestedRegion(output);
+    output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+DistanceTransformImageFilter <TInputImage, TOutputImage>
+::GenerateData()
+{
+    this->AllocateOutputs();
+
+    OutputImageType *distanceImage = this->GetOutput();
+    VoronoiImageType *voronoiImage = this->GetVoronoiMap();
+
+    voronoiImage->SetRegions(distanceImage->GetLargestPossibleRegion());
+    voronoiImage->CopyInformation(distanceImage);
+    voronoiImage->Allocate();
+
+    unsigned int numVoxels = distanceImage->GetLargestPossibleRegion().GetNumberOfPixels();
+    OutputPixelType *distanceBuffer = distanceImage->GetBufferPointer();
+
+    this->InitializeBuffers(distanceBuffer,voronoiImage->GetBufferPointer(),false);
+    this->ComputeSquaredDistances(distanceBuffer,voronoiImage->GetBufferPointer());
+
+    const OutputPixelType infiniteValue = itk::NumericTraits <OutputPixelType>::max();
+    if (!m_SignedDistance)
+    {
+        if (!m_SquaredDistance)
+        {
+            for (unsigned int i = 0;i < numVoxels;++i)
+            {
+                if (distanceBuffer[i] != infiniteValue)
+                    distanceBuffer[i] = std::sqrt(distanceBuffer[i]);
+            }
+        }
+
+        return;
+    }
+
+    // Signed mode: distances to the background computed inside the object
+    std::vector <OutputPixelType> insideDistances(numVoxels);
+    std::vector <InputPixelType> insideLabels(numVoxels);
+
+    this->InitializeBuffers(insideDistances.data(),insideLabels.data(),true);
+    this->ComputeSquaredDistances(insideDistances.data(),insideLabels.data());
+
+    double insideSign = m_InsideIsPositive ? 1.0 : -1.0;
+    for (unsigned int i = 0;i < numVoxels;++i)
+    {
+        // Voxels on the object have a zero outside distance
+        if (distanceBuffer[i] != 0)
+        {
+            if (!m_SquaredDistance && (distanceBuffer[i] != infiniteValue))
+                distanceBuffer[i] = std::sqrt(distanceBuffer[i]);
+
+            distanceBuffer[i] *= - insideSign;
+            continue;
+        }
+
+        double insideValue = insideDistances[i];
+        if (insideValue == infiniteValue)
+            distanceBuffer[i] = insideSign * infiniteValue;
+        else
+            distanceBuffer[i] = insideSign * (m_SquaredDistance ? insideValue : std::sqrt(insideValue));
+    }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+DistanceTransformImageFilter <TInputImage, TOutputImage>
+::InitializeBuffers(OutputPixelType *distanceBuffer, InputPixelType *labelBuffer, bool invertFeatures)
+{
+    itk::ImageRegionConstIterator <InputImageType> inputItr(this->GetInput(),this->GetOutput()->GetLargestPossibleRegion());
+    const OutputPixelType infiniteValue = itk::NumericTraits <OutputPixelType>::max();
+
+    unsigned int pos = 0;
+    while (!inputItr.IsAtEnd())
+    {
+        InputPixelType inputValue = inputItr.Get();
+        bool isFeature = (inputValue != itk::NumericTraits <InputPixelType>::ZeroValue());
+        if (invertFeatures)
+            isFeature = !isFeature;
+
+        distanceBuffer[pos] = isFeature ? itk::NumericTraits <OutputPixelType>::ZeroValue() : infiniteValue;
+        labelBuffer[pos] = inputValue;
+
+        ++inputItr;
+        ++pos;
+    }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+DistanceTransformImageFilter <TInputImage, TOutputImage>
+::ComputeSquaredDistances(OutputPixelType *distanceBuffer, InputPixelType *labelBuffer)
+{
+    m_CurrentDistanceBuffer = distanceBuffer;
+    m_CurrentLabelBuffer = labelBuffer;
+
+    typename itk::ImageSource <TOutputImage>::ThreadStruct str;
+    str.Filter = this;
+
+    this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
+
+    // One pass per dimension, each one being separable into independent lines
+    for (unsigned int d = 0;d < ImageDimension;++d)
+    {
+        if (this->GetOutput()->GetLargestPossibleRegion().GetSize()[d] <= 1)
+            continue;
+
+        m_CurrentDimension = d;
+        this->GetMultiThreader()->SetSingleMethod(this->ThreadedPassCallback,&str);
+        this->GetMultiThreader()->SingleMethodExecute();
+    }
+}
+
+template <typename TInputImage, typename TOutputImage>
+ITK_THREAD_RETURN_TYPE
+DistanceTransformImageFilter <TInputImage, TOutputImage>
+::ThreadedPassCallback(void *arg)
+{
+    itk::MultiThreader::ThreadInfoStruct *threadInfo = (itk::MultiThreader::ThreadInfoStruct *)(arg);
+    typedef typename itk::ImageSource <TOutputImage>::ThreadStruct ThreadStruct;
+    ThreadStruct *str = (ThreadStruct *)(threadInfo->UserData);
+
+    Self *filterPtr = dynamic_cast <Self *> (str->Filter.GetPointer());
+    filterPtr->ProcessLines(threadInfo->ThreadID,threadInfo->NumberOfThreads);
+
+    return ITK_THREAD_RETURN_VALUE;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+DistanceTransformImageFilter <TInputImage, TOutputImage>
+::ProcessLines(unsigned int threadId, unsigned int numThreads)
+{
+    typename OutputImageType::SizeType imageSize = this->GetOutput()->GetLargestPossibleRegion().GetSize();
+
+    unsigned int lineSize = imageSize[m_CurrentDimension];
+    unsigned int lineStride = 1;
+    for (unsigned int i = 0;i < m_CurrentDimension;++i)
+        lineStride *= imageSize[i];
+
+    unsigned int numLines = this->GetOutput()->GetLargestPossibleRegion().GetNumberOfPixels() / lineSize;
+
+    unsigned int startLine = (unsigned int)((unsigned long)threadId * numLines / numThreads);
+    unsigned int endLine = (unsigned int)((unsigned long)(threadId + 1) * numLines / numThreads);
+
+    double spacing = 1.0;
+    if (m_UseImageSpacing)
+        spacing = this->GetOutput()->GetSpacing()[m_CurrentDimension];
+
+    // Scratch buffers are allocated once for all lines of the thread
+    std::vector <double> lineValues(lineSize);
+    std::vector <InputPixelType> lineLabels(lineSize);
+    std::vector <unsigned int> parabolaLocations(lineSize);
+    std::vector <double> parabolaBounds(lineSize + 1);
+
+    for (unsigned int l = startLine;l < endLine;++l)
+    {
+        // Line l starts at the l-th position of the hyperplane orthogonal to the current dimension
+        unsigned int lineStart = (l / lineStride) * lineStride * lineSize + (l % lineStride);
+        this->ProcessLine(m_CurrentDistanceBuffer + lineStart,m_CurrentLabelBuffer + lineStart,lineSize,lineStride,spacing,
+                          lineValues,lineLabels,parabolaLocations,parabolaBounds);
+    }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+DistanceTransformImageFilter <TInputImage, TOutputImage>
+::ProcessLine(OutputPixelType *distances, InputPixelType *labels, unsigned int lineSize, unsigned int lineStride,
+              double spacing, std::vector <double> &lineValues, std::vector <InputPixelType> &lineLabels,
+              std::vector <unsigned int> &parabolaLocations, std::vector <double> &parabolaBounds)
+{
+    const OutputPixelType infiniteValue = itk::NumericTraits <OutputPixelType>::max();
+    const double infinity = std::numeric_limits <double>::infinity();
+
+    for (unsigned int i = 0;i < lineSize;++i)
+    {
+        OutputPixelType value = distances[i * lineStride];
+        lineValues[i] = (value == infiniteValue) ? infinity : value;
+        lineLabels[i] = labels[i * lineStride];
+    }
+
+    // Lower envelope of parabolas rooted at finite values
+    int k = -1;
+    for (unsigned int q = 0;q < lineSize;++q)
+    {
+        if (lineValues[q] == infinity)
+            continue;
+
+        double posQ = q * spacing;
+        double offsetQ = lineValues[q] + posQ * posQ;
+        double intersection = - infinity;
+
+        while (k >= 0)
+        {
+            double posP = parabolaLocations[k] * spacing;
+            intersection = (offsetQ - lineValues[parabolaLocations[k]] - posP * posP) / (2.0 * (posQ - posP));
+
+            if (intersection <= parabolaBounds[k])
+                --k;
+            else
+                break;
+        }
+
+        ++k;
+        parabolaLocations[k] = q;
+        parabolaBounds[k] = (k == 0) ? - infinity : intersection;
+        parabolaBounds[k + 1] = infinity;
+    }
+
+    // No feature on this line: it stays at infinity
+    if (k < 0)
+        return;
+
+    k = 0;
+    for (unsigned int i = 0;i < lineSize;++i)
+    {
+        double position = i * spacing;
+        while (parabolaBounds[k + 1] < position)
+            ++k;
+
+        unsigned int closestLocation = parabolaLocations[k];
+        double diff = position - closestLocation * spacing;
+        distances[i * lineStride] = static_cast <OutputPixelType> (diff * diff + lineValues[closestLocation]);
+        labels[i * lineStride] = lineLabels[closestLocation];
+    }
+}
+
+} // end namespace anima
@@ -5,6 +5,9 @@
 #include <itkVectorLinearInterpolateNearestNeighborExtrapolateImageFunction.h>
 #include <itkImage.h>
 
+#include <vnl/vnl_matrix_fixed.h>
+#include <vnl/vnl_vector_fixed.h>
+
 namespace anima
 {
 
@@ -13,6 +16,10 @@ namespace anima
  *
  * The Jacobian matrix is computed as a linear least squares problem based on multiple directional derivatives around each pixel
  * The output vector in each voxel is of size Dimension^2 and is stored on rows first.
+ * For a neighborhood of 1, spacing aware central differences (one-sided on the image border) are used instead, corrected
+ * by the image direction. For larger neighborhoods, the least squares solution is precomputed once for interior voxels.
+ * Outputs 1 and 2 hold the determinant and log-determinant of the Jacobian (with identity added) when
+ * ComputeDeterminant is set, obtained in the same pass. Non positive determinants are floored at 1.0e-6 before taking the log.
  */
 template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
 class JacobianMatrixImageFilter :
@@ -37,6 +44,9 @@ public:
     typedef typename InputImageType::PixelType InputPixelType;
     typedef typename OutputImageType::PixelType OutputPixelType;
 
+    typedef itk::Image <TOutputPixelType, Dimension> DeterminantImageType;
+    typedef typename DeterminantImageType::Pointer DeterminantImagePointer;
+
     typedef typename InputImageType::Pointer InputImagePointer;
     typedef typename OutputImageType::Pointer OutputImagePointer;
 
@@ -47,19 +57,51 @@ public:
 
     itkSetMacro(NoIdentity, bool)
     itkSetMacro(Neighborhood, unsigned int)
+    itkSetMacro(ComputeDeterminant, bool)
+
+    DeterminantImageType *GetDeterminantImage();
+    DeterminantImageType *GetLogDeterminantImage();
 
 protected:
     JacobianMatrixImageFilter()
     {
         m_NoIdentity = false;
         m_Neighborhood = 1;
+        m_ComputeDeterminant = false;
+
+        this->SetNumberOfRequiredOutputs(3);
+        this->SetNthOutput(0, this->MakeOutput(0));
+        this->SetNthOutput(1, this->MakeOutput(1));
+        this->SetNthOutput(2, this->MakeOutput(2));
     }
 
     virtual ~JacobianMatrixImageFilter() {}
 
+    typedef itk::ProcessObject::DataObjectPointerArraySizeType DataObjectPointerArraySizeType;
+    using Superclass::MakeOutput;
+    itk::DataObject::Pointer MakeOutput(DataObjectPointerArraySizeType idx) ITK_OVERRIDE;
+
+    //! Neighbors are read directly from the input buffer, the whole input is needed
+    void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+    //! Determinant outputs are only allocated when requested
+    void AllocateOutputs() ITK_OVERRIDE;
+
     void BeforeThreadedGenerateData() ITK_OVERRIDE;
     void ThreadedGenerateData(const OutputImageRegionType &outputRegionForThread, itk::ThreadIdType threadId) ITK_OVERRIDE;
 
+    typedef vnl_matrix_fixed <double, Dimension, Dimension> MatrixType;
+    typedef vnl_vector_fixed <double, Dimension> VectorType;
+
+    //! Finite differences along image axes, one-sided on the largest region border
+    void ComputeFiniteDifferencesJacobian(const IndexType &index, const InputPixelType *pixelPtr, MatrixType &jacobian);
+
+    //! Precomputed least squares solution, valid only when the whole neighborhood is inside the image
+    void ComputeInteriorLeastSquaresJacobian(const InputPixelType *pixelPtr, MatrixType &jacobian);
+
+    //! General least squares solution on a cropped neighborhood, used on the image border
+    void ComputeBorderLeastSquaresJacobian(const IndexType &index, MatrixType &jacobian);
+
 private:
     JacobianMatrixImageFilter(const Self&); //purposely not implemented
     void operator=(const Self&); //purposely not implemented
@@ -70,7 +112,17 @@ private:
     //! Neighborhood from which to compute Jacobian matrix
     unsigned int m_Neighborhood;
 
+    //! Also output determinant and log-determinant images
+    bool m_ComputeDeterminant;
+
     InterpolatorPointer m_FieldInterpolator;
+
+    //! Inverse of direction times spacing, maps index derivatives to physical ones
+    MatrixType m_IndexToPhysicalDerivative;
+
+    //! Interior neighborhood: buffer offsets of half the neighbors and their least squares coefficients
+    std::vector <int> m_NeighborOffsets;
+    std::vector <VectorType> m_NeighborCoefficients;
 };
 
 } // end namespace anima
@@ -5,10 +5,71 @@
 #include <itkImageRegionIterator.h>
 
 #include <vnl_qr.h>
+#include <vnl/vnl_det.h>
+#include <vnl/vnl_inverse.h>
 
 namespace anima
 {
 
+template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
+itk::DataObject::Pointer
+JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
+::MakeOutput(DataObjectPointerArraySizeType idx)
+{
+    if (idx == 0)
+        return OutputImageType::New().GetPointer();
+
+    return DeterminantImageType::New().GetPointer();
+}
+
+template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
+typename JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>::DeterminantImageType *
+JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
+::GetDeterminantImage()
+{
+    return dynamic_cast <DeterminantImageType *> (this->itk::ProcessObject::GetOutput(1));
+}
+
+template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
+typename JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>::DeterminantImageType *
+JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
+::GetLogDeterminantImage()
+{
+    return dynamic_cast <DeterminantImageType *> (this->itk::ProcessObject::GetOutput(2));
+}
+
+template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
+void
+JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
+::GenerateInputRequestedRegion()
+{
+    this->Superclass::GenerateInputRequestedRegion();
+
+    InputImageType *input = const_cast <InputImageType *> (this->GetInput());
+    if (input)
+        input->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
+void
+JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
+::AllocateOutputs()
+{
+    OutputImageType *output = this->GetOutput();
+    output->SetBufferedRegion(output->GetRequestedRegion());
+    output->Allocate();
+
+    if (!m_ComputeDeterminant)
+        return;
+
+    DeterminantImageType *detImages[2] = {this->GetDeterminantImage(), this->GetLogDeterminantImage()};
+    for (unsigned int i = 0;i < 2;++i)
+    {
+        detImages[i]->SetBufferedRegion(detImages[i]->GetRequestedRegion());
+        detImages[i]->Allocate();
+    }
+}
+
 template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
 void
 JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
@@ -16,8 +77,96 @@ JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
 {
     this->Superclass::BeforeThreadedGenerateData();
 
+    const InputImageType *input = this->GetInput();
     m_FieldInterpolator = InterpolatorType::New();
-    m_FieldInterpolator->SetInputImage(this->GetInput());
+    m_FieldInterpolator->SetInputImage(input);
+
+    MatrixType indexToPhysical;
+    for (unsigned int i = 0;i < Dimension;++i)
+    {
+        for (unsigned int j = 0;j < Dimension;++j)
+            indexToPhysical(i,j) = input->GetDirection()(i,j) * input->GetSpacing()[j];
+    }
+
+    m_IndexToPhysicalDerivative = vnl_inverse(indexToPhysical);
+
+    m_NeighborOffsets.clear();
+    m_NeighborCoefficients.clear();
+
+    if (m_Neighborhood <= 1)
+        return;
+
+    // Interior least squares system: a neighbor and its opposite give a single equation, so only half of them are kept
+    // (first non zero offset coordinate positive). The normal matrix only depends on the geometry, solve it once.
+    const typename InputImageType::OffsetValueType *offsetTable = input->GetOffsetTable();
+    int neighborhood = m_Neighborhood;
+    IndexType neighborOffset;
+    neighborOffset.Fill(- neighborhood);
+
+    MatrixType normalMatrix;
+    normalMatrix.fill(0.0);
+    VectorType unitVector;
+
+    bool neighborhoodDone = false;
+    while (!neighborhoodDone)
+    {
+        int firstNonZero = 0;
+        for (unsigned int i = 0;i < Dimension;++i)
+        {
+            if (neighborOffset[i] != 0)
+            {
+                firstNonZero = neighborOffset[i];
+                break;
+            }
+        }
+
+        if (firstNonZero > 0)
+        {
+            // Physical vector from the neighbor to its opposite
+            double pointDist = 0;
+            for (unsigned int i = 0;i < Dimension;++i)
+            {
+                unitVector[i] = 0;
+                for (unsigned int j = 0;j < Dimension;++j)
+                    unitVector[i] -= 2.0 * indexToPhysical(i,j) * neighborOffset[j];
+
+                pointDist += unitVector[i] * unitVector[i];
+            }
+
+            pointDist = std::sqrt(pointDist);
+            unitVector /= pointDist;
+
+            for (unsigned int i = 0;i < Dimension;++i)
+            {
+                for (unsigned int j = 0;j < Dimension;++j)
+                    normalMatrix(i,j) += unitVector[i] * unitVector[j];
+            }
+
+            int bufferOffset = 0;
+            for (unsigned int i = 0;i < Dimension;++i)
+                bufferOffset += neighborOffset[i] * offsetTable[i];
+
+            m_NeighborOffsets.push_back(bufferOffset);
+            m_NeighborCoefficients.push_back(unitVector / pointDist);
+        }
+
+        neighborhoodDone = true;
+        for (unsigned int i = 0;i < Dimension;++i)
+        {
+            ++neighborOffset[i];
+            if (neighborOffset[i] <= neighborhood)
+            {
+                neighborhoodDone = false;
+                break;
+            }
+
+            neighborOffset[i] = - neighborhood;
+        }
+    }
+
+    MatrixType normalMatrixInverse = vnl_inverse(normalMatrix);
+    for (unsigned int i = 0;i < m_NeighborCoefficients.size();++i)
+        m_NeighborCoefficients[i] = normalMatrixInverse * m_NeighborCoefficients[i];
 }
 
 template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
@@ -27,164 +176,288 @@ JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
 {
     typedef itk::ImageRegionConstIteratorWithIndex <InputImageType> InputIteratorType;
     typedef itk::ImageRegionIterator <OutputImageType> OutputIteratorType;
+    typedef itk::ImageRegionIterator <DeterminantImageType> DeterminantIteratorType;
+
+    const InputImageType *input = this->GetInput();
+    const InputPixelType *inputBuffer = input->GetBufferPointer();
 
-    InputIteratorType inputItr(this->GetInput(),outputRegionForThread);
+    InputIteratorType inputItr(input,outputRegionForThread);
     OutputIteratorType outputItr(this->GetOutput(),outputRegionForThread);
 
+    DeterminantIteratorType detItr, logDetItr;
+    if (m_ComputeDeterminant)
+    {
+        detItr = DeterminantIteratorType(this->GetDeterminantImage(),outputRegionForThread);
+        logDetItr = DeterminantIteratorType(this->GetLogDeterminantImage(),outputRegionForThread);
+    }
+
+    RegionType largestRegion = input->GetLargestPossibleRegion();
+    int neighborhood = m_Neighborhood;
+    const double minimalDeterminant = 1.0e-6;
+
     IndexType currentIndex;
+    MatrixType jacobian;
+    OutputPixelType outputValue;
+
+    while (!inputItr.IsAtEnd())
+    {
+        currentIndex = inputItr.GetIndex();
+        const InputPixelType *pixelPtr = inputBuffer + input->ComputeOffset(currentIndex);
+
+        if (m_Neighborhood <= 1)
+            this->ComputeFiniteDifferencesJacobian(currentIndex,pixelPtr,jacobian);
+        else
+        {
+            bool isInterior = true;
+            for (unsigned int i = 0;i < Dimension;++i)
+            {
+                int lowerBound = largestRegion.GetIndex()[i];
+                int upperBound = lowerBound + largestRegion.GetSize()[i] - 1;
+                if ((currentIndex[i] - neighborhood < lowerBound)||(currentIndex[i] + neighborhood > upperBound))
+                {
+                    isInterior = false;
+                    break;
+                }
+            }
+
+            if (isInterior)
+                this->ComputeInteriorLeastSquaresJacobian(pixelPtr,jacobian);
+            else
+                this->ComputeBorderLeastSquaresJacobian(currentIndex,jacobian);
+        }
+
+        for (unsigned int i = 0;i < Dimension;++i)
+        {
+            for (unsigned int j = 0;j < Dimension;++j)
+                outputValue[i * Dimension + j] = jacobian(i,j);
+
+            if (!m_NoIdentity)
+                outputValue[i * (Dimension + 1)] += 1.0;
+        }
+
+        outputItr.Set(outputValue);
+
+        if (m_ComputeDeterminant)
+        {
+            for (unsigned int i = 0;i < Dimension;++i)
+                jacobian(i,i) += 1.0;
+
+            double detValue = vnl_det(jacobian);
+            detItr.Set(detValue);
+            logDetItr.Set(std::log(std::max(detValue,minimalDeterminant)));
+
+            ++detItr;
+            ++logDetItr;
+        }
+
+        ++inputItr;
+        ++outputItr;
+    }
+}
+
+template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
+void
+JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
+::ComputeFiniteDifferencesJacobian(const IndexType &index, const InputPixelType *pixelPtr, MatrixType &jacobian)
+{
+    const InputImageType *input = this->GetInput();
+    const typename InputImageType::OffsetValueType *offsetTable = input->GetOffsetTable();
+    RegionType largestRegion = input->GetLargestPossibleRegion();
+
+    // Derivatives with respect to index coordinates: central differences inside, one-sided on the border
+    MatrixType indexJacobian;
+    for (unsigned int j = 0;j < Dimension;++j)
+    {
+        int lowerBound = largestRegion.GetIndex()[j];
+        int upperBound = lowerBound + largestRegion.GetSize()[j] - 1;
+        int lowerShift = (index[j] > lowerBound) ? 1 : 0;
+        int upperShift = (index[j] < upperBound) ? 1 : 0;
+
+        if (lowerShift + upperShift == 0)
+        {
+            for (unsigned int i = 0;i < Dimension;++i)
+                indexJacobian(i,j) = 0;
+
+            continue;
+        }
+
+        const InputPixelType &upperValue = *(pixelPtr + upperShift * offsetTable[j]);
+        const InputPixelType &lowerValue = *(pixelPtr - lowerShift * offsetTable[j]);
+
+        for (unsigned int i = 0;i < Dimension;++i)
+            indexJacobian(i,j) = (upperValue[i] - lowerValue[i]) / (lowerShift + upperShift);
+    }
+
+    jacobian = indexJacobian * m_IndexToPhysicalDerivative;
+}
+
+template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
+void
+JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
+::ComputeInteriorLeastSquaresJacobian(const InputPixelType *pixelPtr, MatrixType &jacobian)
+{
+    jacobian.fill(0.0);
+
+    for (unsigned int k = 0;k < m_NeighborOffsets.size();++k)
+    {
+        const InputPixelType &pixelBeforeValue = *(pixelPtr + m_NeighborOffsets[k]);
+        const InputPixelType &pixelAfterValue = *(pixelPtr - m_NeighborOffsets[k]);
+        const VectorType &coefficients = m_NeighborCoefficients[k];
+
+        for (unsigned int i = 0;i < Dimension;++i)
+        {
+            double diffValue = pixelAfterValue[i] - pixelBeforeValue[i];
+            for (unsigned int j = 0;j < Dimension;++j)
+                jacobian(i,j) += coefficients[j] * diffValue;
+        }
+    }
+}
+
+template <typename TPixelType, typename TOutputPixelType, unsigned int Dimension>
+void
+JacobianMatrixImageFilter <TPixelType, TOutputPixelType, Dimension>
+::ComputeBorderLeastSquaresJacobian(const IndexType &currentIndex, MatrixType &jacobian)
+{
+    typedef itk::ImageRegionConstIteratorWithIndex <InputImageType> InputIteratorType;
+
     IndexType internalIndex, internalIndexOpposite;
     vnl_matrix <double> dataMatrix;
     vnl_vector <double> dataVector, outputVector;
     RegionType inputRegion;
     RegionType largestRegion = this->GetInput()->GetLargestPossibleRegion();
     InputPixelType pixelBeforeValue, pixelAfterValue;
-    OutputPixelType outputValue;
     PointType pointBefore, pointAfter, unitVector;
     std::vector < std::pair <IndexType,IndexType> > doubleDataTestVector;
 
-    while (!inputItr.IsAtEnd())
+    // Construct region to explore, first determine which index is most adapted to split explored region in two
+    unsigned int halfSplitIndex = 0;
+    unsigned int largestGap = 0;
+    for (unsigned int i = 0;i < Dimension;++i)
     {
-        currentIndex = inputItr.GetIndex();
+        int largestIndex = largestRegion.GetIndex()[i];
+        int testedIndex = currentIndex[i] - m_Neighborhood;
+        unsigned int baseIndex = std::max(largestIndex,testedIndex);
+        unsigned int maxValue = largestIndex + largestRegion.GetSize()[i] - 1;
+        unsigned int upperIndex = std::min(maxValue,(unsigned int)(currentIndex[i] + m_Neighborhood));
 
-        // Construct region to explore, first determine which index is most adapted to split explored region in two
-        unsigned int halfSplitIndex = 0;
-        unsigned int largestGap = 0;
-        for (unsigned int i = 0;i < Dimension;++i)
+        if ((upperIndex - currentIndex[i] == m_Neighborhood)||(currentIndex[i] - baseIndex == m_Neighborhood))
         {
-            int largestIndex = largestRegion.GetIndex()[i];
-            int testedIndex = currentIndex[i] - m_Neighborhood;
-            unsigned int baseIndex = std::max(largestIndex,testedIndex);
-            unsigned int maxValue = largestIndex + largestRegion.GetSize()[i] - 1;
-            unsigned int upperIndex = std::min(maxValue,(unsigned int)(currentIndex[i] + m_Neighborhood));
-
-            if ((upperIndex - currentIndex[i] == m_Neighborhood)||(currentIndex[i] - baseIndex == m_Neighborhood))
-            {
-                halfSplitIndex = i;
-                break;
-            }
-
-            unsigned int maxGap = std::max(upperIndex - currentIndex[i],currentIndex[i] - baseIndex);
-            if (largestGap < maxGap)
-            {
-                largestGap = maxGap;
-                halfSplitIndex = i;
-            }
+            halfSplitIndex = i;
+            break;
         }
 
-        // Then build the region
-        for (unsigned int i = 0;i < Dimension;++i)
+        unsigned int maxGap = std::max(upperIndex - currentIndex[i],currentIndex[i] - baseIndex);
+        if (largestGap < maxGap)
         {
-            int largestIndex = largestRegion.GetIndex()[i];
-            int testedIndex = currentIndex[i] - m_Neighborhood;
-            unsigned int baseIndex = std::max(largestIndex,testedIndex);
-            unsigned int maxValue = largestIndex + largestRegion.GetSize()[i] - 1;
-            unsigned int upperIndex = std::min(maxValue,(unsigned int)(currentIndex[i] + m_Neighborhood));
+            largestGap = maxGap;
+            halfSplitIndex = i;
+        }
+    }
+
+    // Then build the region
+    for (unsigned int i = 0;i < Dimension;++i)
+    {
+        int largestIndex = largestRegion.GetIndex()[i];
+        int testedIndex = currentIndex[i] - m_Neighborhood;
+        unsigned int baseIndex = std::max(largestIndex,testedIndex);
+        unsigned int maxValue = largestIndex + largestRegion.GetSize()[i] - 1;
+        unsigned int upperIndex = std::min(maxValue,(unsigned int)(currentIndex[i] + m_Neighborhood));
 
-            if (i == halfSplitIndex)
+        if (i == halfSplitIndex)
+        {
+            if (upperIndex - currentIndex[i] > currentIndex[i] - baseIndex)
             {
-                if (upperIndex - currentIndex[i] > currentIndex[i] - baseIndex)
-                {
-                    inputRegion.SetIndex(i,currentIndex[i]);
-                    inputRegion.SetSize(i,upperIndex - currentIndex[i] + 1);
-                }
-                else
-                {
-                    inputRegion.SetIndex(i,baseIndex);
-                    inputRegion.SetSize(i,currentIndex[i] - baseIndex + 1);
-                }
+                inputRegion.SetIndex(i,currentIndex[i]);
+                inputRegion.SetSize(i,upperIndex - currentIndex[i] + 1);
             }
             else
             {
                 inputRegion.SetIndex(i,baseIndex);
-                inputRegion.SetSize(i,upperIndex - baseIndex + 1);
+                inputRegion.SetSize(i,currentIndex[i] - baseIndex + 1);
             }
         }
+        else
+        {
+            inputRegion.SetIndex(i,baseIndex);
+            inputRegion.SetSize(i,upperIndex - baseIndex + 1);
+        }
+    }
 
-        dataMatrix.set_size((inputRegion.GetNumberOfPixels() - 1) * Dimension,Dimension * Dimension);
-        dataMatrix.fill(0.0);
-        dataVector.set_size(Dimension * (inputRegion.GetNumberOfPixels() - 1));
+    dataMatrix.set_size((inputRegion.GetNumberOfPixels() - 1) * Dimension,Dimension * Dimension);
+    dataMatrix.fill(0.0);
+    dataVector.set_size(Dimension * (inputRegion.GetNumberOfPixels() - 1));
 
-        InputIteratorType internalItr(this->GetInput(),inputRegion);
-        unsigned int pos = 0;
-        doubleDataTestVector.clear();
-        while (!internalItr.IsAtEnd())
+    InputIteratorType internalItr(this->GetInput(),inputRegion);
+    unsigned int pos = 0;
+    while (!internalItr.IsAtEnd())
+    {
+        internalIndex = internalItr.GetIndex();
+        if (internalIndex == currentIndex)
         {
-            internalIndex = internalItr.GetIndex();
-            if (internalIndex == currentIndex)
-            {
-                ++internalItr;
-                continue;
-            }
+            ++internalItr;
+            continue;
+        }
 
-            if (internalIndex[halfSplitIndex] == currentIndex[halfSplitIndex])
+        if (internalIndex[halfSplitIndex] == currentIndex[halfSplitIndex])
+        {
+            bool skipVoxel = false;
+            for (unsigned int i = 0;i < doubleDataTestVector.size();++i)
             {
-                bool skipVoxel = false;
-                for (unsigned int i = 0;i < doubleDataTestVector.size();++i)
-                {
-                    if ((internalIndex == doubleDataTestVector[i].first)||(internalIndex == doubleDataTestVector[i].second))
-                    {
-                        skipVoxel = true;
-                        break;
-                    }
-                }
-
-                if (skipVoxel)
+                if ((internalIndex == doubleDataTestVector[i].first)||(internalIndex == doubleDataTestVector[i].second))
                 {
-                    ++internalItr;
-                    continue;
+                    skipVoxel = true;
+                    break;
                 }
             }
 
-            for (unsigned int i = 0;i < Dimension;++i)
-                internalIndexOpposite[i] = 2 * currentIndex[i] - internalIndex[i];
-
-            if (internalIndex[halfSplitIndex] == currentIndex[halfSplitIndex])
-                doubleDataTestVector.push_back(std::make_pair(internalIndex,internalIndexOpposite));
-
-            pixelBeforeValue = internalItr.Get();
-            pixelAfterValue = m_FieldInterpolator->EvaluateAtIndex(internalIndexOpposite);
-
-            this->GetInput()->TransformIndexToPhysicalPoint(internalIndex,pointBefore);
-            this->GetInput()->TransformIndexToPhysicalPoint(internalIndexOpposite,pointAfter);
-
-            double pointDist = 0;
-            for (unsigned int i = 0;i < Dimension;++i)
+            if (skipVoxel)
             {
-                unitVector[i] = pointAfter[i] - pointBefore[i];
-                pointDist += unitVector[i] * unitVector[i];
+                ++internalItr;
+                continue;
             }
-            pointDist = std::sqrt(pointDist);
-            for (unsigned int i = 0;i < Dimension;++i)
-                unitVector[i] /= pointDist;
+        }
 
-            for (unsigned int i = 0;i < Dimension;++i)
-            {
-                double diffValue = (pixelAfterValue[i] - pixelBeforeValue[i]) / pointDist;
-                dataVector[pos * Dimension + i] = diffValue;
+        for (unsigned int i = 0;i < Dimension;++i)
+            internalIndexOpposite[i] = 2 * currentIndex[i] - internalIndex[i];
 
-                for (unsigned int j = 0;j < Dimension;++j)
-                    dataMatrix(pos * Dimension + i,i * Dimension + j) = unitVector[j];
-            }
+        if (internalIndex[halfSplitIndex] == currentIndex[halfSplitIndex])
+            doubleDataTestVector.push_back(std::make_pair(internalIndex,internalIndexOpposite));
 
-            ++pos;
-            ++internalItr;
-        }
+        pixelBeforeValue = internalItr.Get();
+        pixelAfterValue = m_FieldInterpolator->EvaluateAtIndex(internalIndexOpposite);
 
-        outputVector = vnl_qr <double> (dataMatrix).solve(dataVector);
+        this->GetInput()->TransformIndexToPhysicalPoint(internalIndex,pointBefore);
+        this->GetInput()->TransformIndexToPhysicalPoint(internalIndexOpposite,pointAfter);
 
-        for (unsigned int i = 0;i < outputValue.GetVectorDimension();++i)
-            outputValue[i] = outputVector[i];
+        double pointDist = 0;
+        for (unsigned int i = 0;i < Dimension;++i)
+        {
+            unitVector[i] = pointAfter[i] - pointBefore[i];
+            pointDist += unitVector[i] * unitVector[i];
+        }
+        pointDist = std::sqrt(pointDist);
+        for (unsigned int i = 0;i < Dimension;++i)
+            unitVector[i] /= pointDist;
 
-        if (!m_NoIdentity)
+        for (unsigned int i = 0;i < Dimension;++i)
         {
-            for (unsigned int i = 0;i < Dimension;++i)
-                outputValue[i * (Dimension + 1)] += 1.0;
+            double diffValue = (pixelAfterValue[i] - pixelBeforeValue[i]) / pointDist;
+            dataVector[pos * Dimension + i] = diffValue;
+
+            for (unsigned int j = 0;j < Dimension;++j)
+                dataMatrix(pos * Dimension + i,i * Dimension + j) = unitVector[j];
         }
 
-        outputItr.Set(outputValue);
+        ++pos;
+        ++internalItr;
+    }
 
-        ++inputItr;
-        ++outputItr;
+    outputVector = vnl_qr <double> (dataMatrix).solve(dataVector);
+
+    for (unsigned int i = 0;i < Dimension;++i)
+    {
+        for (unsigned int j = 0;j < Dimension;++j)
+            jacobian(i,j) = outputVector[i * Dimension + j];
     }
 }
 
@@ -18,6 +18,7 @@ int main(int argc, char **argv)
     TCLAP::ValueArg<double> refValArg("r","ref-val","Reference value on which relative noise is applied (default: computed from image)",false,0,"reference value",cmd);
     TCLAP::SwitchArg avg4dMeanValArg("A","average-4d-mean","Automatically computed mean value of tissue is over all 4D volume",cmd,false);
 
+    TCLAP::ValueArg<unsigned int> seedArg("S","seed","Random generator seed, results are reproducible for a given seed whatever the number of threads (default: current time)",false,0,"seed",cmd);
     TCLAP::ValueArg<unsigned int> nbpArg("p","numberofthreads","Number of threads to run on (default : all cores)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
 
     try
@@ -63,6 +64,9 @@ int main(int argc, char **argv)
             mainFilter->SetRelStdDevGaussianNoise(relStd);
             mainFilter->SetBackgroundThreshold(backThrArg.getValue());
 
+            if (seedArg.isSet())
+                mainFilter->SetSeed(seedArg.getValue());
+
             // If a reference value is specified, ignore average flag
             if (refValArg.getValue() == 0)
                 mainFilter->SetAverageMeanValOnAllVolumes(avg4dMeanValArg.isSet());
@@ -92,6 +96,9 @@ int main(int argc, char **argv)
             mainFilter->SetAverageMeanValOnAllVolumes(true);
             mainFilter->SetBackgroundThreshold(backThrArg.getValue());
 
+            if (seedArg.isSet())
+                mainFilter->SetSeed(seedArg.getValue());
+
             mainFilter->Update();
 
             anima::writeImage <ImageType> (outArg.getValue(),mainFilter->GetOutput());
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <iostream>
-#include <random>
 #include <itkImageToImageFilter.h>
 #include <itkVectorImage.h>
 #include <itkImage.h>
@@ -56,6 +55,9 @@ public:
 
     itkSetMacro(BackgroundThreshold, double)
 
+    itkSetMacro(Seed, unsigned int)
+    itkGetMacro(Seed, unsigned int)
+
 protected:
     GaussianNoiseGeneratorImageFilter()
     {
@@ -65,6 +67,8 @@ protected:
         m_BackgroundThreshold = 10;
         m_MeanVals.clear();
         m_AverageMeanValOnAllVolumes = false;
+
+        m_Seed = time(0);
     }
 
     virtual ~GaussianNoiseGeneratorImageFilter()
@@ -86,7 +90,8 @@ private:
     double m_BackgroundThreshold;
     bool m_AverageMeanValOnAllVolumes;
 
-    std::vector <std::mt19937> m_Generators;
+    //! Random generator key, noise at each voxel is drawn from the stream indexed by the voxel offset
+    unsigned int m_Seed;
 };
 
 } // end namespace anima
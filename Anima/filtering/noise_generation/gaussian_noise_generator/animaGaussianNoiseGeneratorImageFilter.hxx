@@ -95,13 +95,6 @@ GaussianNoiseGeneratorImageFilter<Dimension>
         std::cout << "Reference image value: " << m_MeanVals[0] << ", noise stdev: "
         << m_RelStdDevGaussianNoise * m_MeanVals[0] << std::endl;
     }
-
-    m_Generators.clear();
-
-    std::mt19937 motherGenerator(time(0));
-
-    for (int i = 0;i < this->GetNumberOfThreads();++i)
-        m_Generators.push_back(std::mt19937(motherGenerator()));
 }
 
 template <unsigned int Dimension>
@@ -139,7 +132,8 @@ GaussianNoiseGeneratorImageFilter<Dimension>
     typedef itk::ImageRegionConstIteratorWithIndex< TInputImage > InIteratorType;
     typedef itk::ImageRegionIteratorWithIndex< OutputImageType > OutRegionIteratorType;
 
-    OutRegionIteratorType outIterator(this->GetOutput(), region);
+    OutputImageType *outputImage = this->GetOutput();
+    OutRegionIteratorType outIterator(outputImage, region);
     InIteratorType inputIterator (this->GetInput(), region);
     double mean = 0;
 
@@ -147,7 +141,9 @@ GaussianNoiseGeneratorImageFilter<Dimension>
     {
         double refData = inputIterator.Get();
 
-        double gaussNoise = anima::SampleFromGaussianDistribution(mean, variance, m_Generators[threadId]);
+        // One random stream per voxel: results do not depend on the region split between threads
+        anima::CounterBasedRandomGenerator generator(m_Seed, outputImage->ComputeOffset(outIterator.GetIndex()));
+        double gaussNoise = anima::SampleFromGaussianDistribution(mean, variance, generator);
         double data = refData + gaussNoise;
 
         if ((std::isnan(data))||(!std::isfinite(data)))
@@ -19,6 +19,7 @@ int main(int argc, char **argv)
     TCLAP::SwitchArg avg4dMeanValArg("A","average-4d-mean","Automatically computed mean value of tissue is over all 4D volume",cmd,false);
 
     TCLAP::ValueArg<unsigned int> numCoilsArg("c","num-coils","Number of coils (default : 1 = Rician noise)",false,1,"number of coils",cmd);
+    TCLAP::ValueArg<unsigned int> seedArg("S","seed","Random generator seed, results are reproducible for a given seed whatever the number of threads (default: current time)",false,0,"seed",cmd);
     TCLAP::ValueArg<unsigned int> nbpArg("p","numberofthreads","Number of threads to run on (default : all cores)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
 
     try
@@ -66,6 +67,9 @@ int main(int argc, char **argv)
             mainFilter->SetRelStdDevGaussianNoise(relStd);
             mainFilter->SetNumberOfCoils(numCoilsArg.getValue());
 
+            if (seedArg.isSet())
+                mainFilter->SetSeed(seedArg.getValue());
+
             // If a reference value is specified, ignore average flag
             if (refValArg.getValue() == 0)
                 mainFilter->SetAverageMeanValOnAllVolumes(avg4dMeanValArg.isSet());
@@ -94,6 +98,9 @@ int main(int argc, char **argv)
             mainFilter->SetRefVal(refValArg.getValue());
             mainFilter->SetRelStdDevGaussianNoise(relStd);
             mainFilter->SetNumberOfCoils(numCoilsArg.getValue());
+
+            if (seedArg.isSet())
+                mainFilter->SetSeed(seedArg.getValue());
             mainFilter->SetAverageMeanValOnAllVolumes(true);
 
             mainFilter->Update();
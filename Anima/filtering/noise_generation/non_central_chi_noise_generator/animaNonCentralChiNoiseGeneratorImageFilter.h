@@ -5,7 +5,6 @@
 #include <itkVectorImage.h>
 #include <itkImage.h>
 
-#include <random>
 #include <time.h>
 
 namespace anima
@@ -58,6 +57,9 @@ public:
     itkSetMacro(RelStdDevGaussianNoise, double);
     itkGetMacro(RelStdDevGaussianNoise, double);
 
+    itkSetMacro(Seed, unsigned int);
+    itkGetMacro(Seed, unsigned int);
+
 protected:
     NonCentralChiNoiseGeneratorImageFilter()
     {
@@ -69,6 +71,8 @@ protected:
         m_BackgroundThreshold = 10;
         m_MeanVals.clear();
         m_AverageMeanValOnAllVolumes = false;
+
+        m_Seed = time(0);
     }
 
     virtual ~NonCentralChiNoiseGeneratorImageFilter()
@@ -77,7 +81,6 @@ protected:
 
     void BeforeThreadedGenerateData() ITK_OVERRIDE;
     void ThreadedGenerateData(const OutputImageRegionType &outputRegionForThread, itk::ThreadIdType threadId) ITK_OVERRIDE;
-    void TreatRegionWithNoiseVariance(const OutputImageRegionType &region, double &variance, itk::ThreadIdType threadId);
 
 private:
     NonCentralChiNoiseGeneratorImageFilter(const Self&); //purposely not implemented
@@ -95,7 +98,8 @@ private:
     //! Number of coils parameter, 1 = Rician noise
     unsigned int m_NumberOfCoils;
 
-    std::vector <std::mt19937> m_Generators;
+    //! Random generator key, noise at each voxel is drawn from the stream indexed by the voxel offset
+    unsigned int m_Seed;
 };
 } // end of namespace anima
 
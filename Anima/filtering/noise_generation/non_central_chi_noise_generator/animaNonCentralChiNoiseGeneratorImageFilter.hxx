@@ -8,6 +8,8 @@
 #include <itkImageRegionIteratorWithIndex.h>
 #include <itkImageRegionConstIterator.h>
 #include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkImageLinearIteratorWithIndex.h>
+#include <itkImageLinearConstIteratorWithIndex.h>
 #include <itkTimeProbe.h>
 
 namespace anima
@@ -98,13 +100,6 @@ NonCentralChiNoiseGeneratorImageFilter<Dimension>
         std::cout << "Reference image value: " << m_MeanVals[0] << ", noise stdev: "
                     << m_RelStdDevGaussianNoise * m_MeanVals[0] << std::endl;
     }
-
-    m_Generators.clear();
-
-    std::mt19937 motherGenerator(time(0));
-
-    for (int i = 0;i < this->GetNumberOfThreads();++i)
-        m_Generators.push_back(std::mt19937(motherGenerator()));
 }
 
 template <unsigned int Dimension>
@@ -112,73 +107,60 @@ void
 NonCentralChiNoiseGeneratorImageFilter<Dimension>
 ::ThreadedGenerateData (const OutputImageRegionType &outputRegionForThread, itk::ThreadIdType threadId)
 {
-    if ((Dimension < 4)||(m_AverageMeanValOnAllVolumes))
-    {
-        double varVal = m_RelStdDevGaussianNoise * m_MeanVals[0];
-        varVal /= sqrt((double)m_NumberOfCoils);
-
-        this->TreatRegionWithNoiseVariance(outputRegionForThread,varVal,threadId);
-    }
-    else
-    {
-        OutputImageRegionType region = outputRegionForThread;
-        region.SetSize(3,1);
-        unsigned int maxIndex4d = outputRegionForThread.GetIndex()[3] + outputRegionForThread.GetSize()[3];
+    // Noise standard deviation table, one value per volume unless mean values are averaged
+    double coilsFactor = 1.0 / std::sqrt((double)m_NumberOfCoils);
+    std::vector <double> noiseStdDevs(m_MeanVals.size());
+    for (unsigned int i = 0;i < m_MeanVals.size();++i)
+        noiseStdDevs[i] = m_RelStdDevGaussianNoise * m_MeanVals[i] * coilsFactor;
 
-        for (unsigned int i = outputRegionForThread.GetIndex()[3];i < maxIndex4d;++i)
-        {
-            region.SetIndex(3,i);
-            double varVal = m_RelStdDevGaussianNoise * m_MeanVals[i];
-            varVal /= sqrt((double)m_NumberOfCoils);
+    double backgroundStdDev = m_BackgroundVariance * coilsFactor;
 
-            this->TreatRegionWithNoiseVariance(region,varVal,threadId);
-        }
-    }
-}
+    // The 2L-1 pure noise components sum up to sigma^2 chi2(2L-1) = 2 sigma^2 Gamma((2L-1)/2),
+    // only the component carrying the signal is drawn as a Gaussian
+    double centralShape = m_NumberOfCoils - 0.5;
 
-template <unsigned int Dimension>
-void
-NonCentralChiNoiseGeneratorImageFilter<Dimension>
-::TreatRegionWithNoiseVariance(const OutputImageRegionType &region, double &variance, itk::ThreadIdType threadId)
-{
-    typedef itk::ImageRegionConstIteratorWithIndex< TInputImage > InIteratorType;
-    typedef itk::ImageRegionIteratorWithIndex< OutputImageType > OutRegionIteratorType;
+    typedef itk::ImageLinearConstIteratorWithIndex <InputImageType> InIteratorType;
+    typedef itk::ImageLinearIteratorWithIndex <OutputImageType> OutIteratorType;
 
-    OutRegionIteratorType outIterator(this->GetOutput(), region);
-    InIteratorType inputIterator (this->GetInput(), region);
-    double mean = 0;
+    OutputImageType *outputImage = this->GetOutput();
+    InIteratorType inputIterator(this->GetInput(), outputRegionForThread);
+    OutIteratorType outIterator(outputImage, outputRegionForThread);
+    inputIterator.SetDirection(0);
+    outIterator.SetDirection(0);
 
     while (!outIterator.IsAtEnd())
     {
-        double refData = inputIterator.Get();
+        typename OutputImageType::IndexType lineIndex = outIterator.GetIndex();
 
-        double v = variance;
+        double volumeStdDev = noiseStdDevs[0];
+        if (noiseStdDevs.size() > 1)
+            volumeStdDev = noiseStdDevs[lineIndex[Dimension - 1]];
 
-        if (refData < m_BackgroundThreshold)
-            v = m_BackgroundVariance / sqrt((double)m_NumberOfCoils);
+        // One random stream per voxel: results do not depend on the region split between threads
+        uint64_t voxelOffset = outputImage->ComputeOffset(lineIndex);
 
-        double gaussNoise = anima::SampleFromGaussianDistribution(mean, v, m_Generators[threadId]);
-        double dataReal = refData + gaussNoise;
+        while (!outIterator.IsAtEndOfLine())
+        {
+            double refData = inputIterator.Get();
+            double stdDev = (refData < m_BackgroundThreshold) ? backgroundStdDev : volumeStdDev;
 
-        if ((std::isnan(dataReal))||(!std::isfinite(dataReal)))
-            dataReal = refData;
+            anima::CounterBasedRandomGenerator generator(m_Seed, voxelOffset);
+            double dataReal = refData + stdDev * generator.GetGaussianValue();
+            double sumVals = dataReal * dataReal + 2.0 * stdDev * stdDev * generator.GetGammaValue(centralShape);
 
-        double sumVals = dataReal * dataReal;
+            double outputValue = std::sqrt(sumVals);
+            if ((std::isnan(outputValue))||(!std::isfinite(outputValue)))
+                outputValue = refData;
 
-        for (unsigned int i = 0;i < 2 * m_NumberOfCoils - 1;++i)
-        {
-            double dataIm = anima::SampleFromGaussianDistribution(mean, v, m_Generators[threadId]);
+            outIterator.Set(outputValue);
 
-            if ((std::isnan(dataIm))||(!std::isfinite(dataIm)))
-                dataIm = 0;
-
-            sumVals += dataIm * dataIm;
+            ++inputIterator;
+            ++outIterator;
+            ++voxelOffset;
         }
 
-        outIterator.Set(sqrt(sumVals));
-
-        ++inputIterator;
-        ++outIterator;
+        inputIterator.NextLine();
+        outIterator.NextLine();
     }
 }
 
@@ -270,10 +270,18 @@ template <typename TInputImage> void ImageDataSplitter<TInputImage>::Update()
     for (unsigned int i = 0;i < m_FileNames.size();++i)
     {
         std::cout << "Processing image file " << m_FileNames[i] << "..." << std::endl;
+
+        // Only the block with its margin is requested: readers able to stream (NRRD raw, uncompressed NIfTI,
+        // MetaImage) load that region only, others load the whole image
         InputReaderPointer tmpImReader = InputReaderType::New();
         tmpImReader->SetFileName(m_FileNames[i]);
+        tmpImReader->SetUseStreaming(true);
+        tmpImReader->UpdateOutputInformation();
+        tmpImReader->GetOutput()->SetRequestedRegion(m_BlockRegionWithMargin);
         tmpImReader->Update();
 
+        TInputPointer readImage = tmpImReader->GetOutput();
+
         m_Images.push_back(TInputImage::New());
         m_Images[i]->Initialize();
         m_Images[i]->SetRegions(tmpRegion);
@@ -281,12 +289,19 @@ template <typename TInputImage> void ImageDataSplitter<TInputImage>::Update()
         m_Images[i]->SetDirection(m_MaskImage->GetDirection());
         m_Images[i]->SetSpacing(m_MaskImage->GetSpacing());
 
-        m_Images[i]->SetNumberOfComponentsPerPixel(tmpImReader->GetOutput()->GetNumberOfComponentsPerPixel());
+        m_Images[i]->SetNumberOfComponentsPerPixel(readImage->GetNumberOfComponentsPerPixel());
+
+        if (readImage->GetBufferedRegion() == m_BlockRegionWithMargin)
+        {
+            // Region was streamed, its buffer is reused as is
+            m_Images[i]->SetPixelContainer(readImage->GetPixelContainer());
+            continue;
+        }
 
         m_Images[i]->Allocate();
 
         itk::ImageRegionIterator <TInputImage> cropImIt(m_Images[i],tmpRegion);
-        itk::ImageRegionConstIterator <TInputImage> reImIt(tmpImReader->GetOutput(),m_BlockRegionWithMargin);
+        itk::ImageRegionConstIterator <TInputImage> reImIt(readImage,m_BlockRegionWithMargin);
 
         while (!cropImIt.IsAtEnd())
         {
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <animaReadWriteFunctions.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace anima
+{
+
+/**
+ * @brief Process wide asynchronous image writing service. Images are queued and encoded by
+ * background workers while computation continues, several images being compressed in parallel.
+ * Queued images share their pixel buffer with the caller (no copy) and are disconnected from
+ * the pipeline: they should therefore not be modified until WaitForPendingWrites() returns.
+ * WaitForPendingWrites() has to be called before exiting a tool, it re-throws the first error
+ * encountered by the workers.
+ */
+class ImageWriteService
+{
+public:
+    static ImageWriteService &GetInstance()
+    {
+        static ImageWriteService instance;
+        return instance;
+    }
+
+    ~ImageWriteService();
+
+    //! Set the number of background workers (0 means automatic), only effective before first queued image
+    void SetNumberOfWorkers(unsigned int nbWorkers);
+    unsigned int GetNumberOfWorkers() {return m_NumberOfWorkers;}
+
+    void SetCompressionMode(ImageCompressionMode mode) {m_CompressionMode = mode;}
+    ImageCompressionMode GetCompressionMode() {return m_CompressionMode;}
+
+    //! Queue an image for writing, the image pixel buffer is kept alive until written
+    template <class ImageType> void QueueImage(const std::string &filename, ImageType *img);
+
+    //! Wait for all queued images to be written, throws if any of them failed
+    void WaitForPendingWrites();
+
+private:
+    ImageWriteService();
+    ImageWriteService(const ImageWriteService &) = delete;
+    void operator=(const ImageWriteService &) = delete;
+
+    void StartWorkers();
+    void StopWorkers();
+    void WorkerLoop();
+
+    std::deque < std::function <void()> > m_PendingJobs;
+    std::vector <std::thread> m_Workers;
+
+    std::mutex m_QueueMutex;
+    std::condition_variable m_JobAvailableCondition;
+    std::condition_variable m_JobsDoneCondition;
+
+    unsigned int m_NumberOfWorkers;
+    unsigned int m_NumberOfRunningJobs;
+    bool m_StopRequested;
+
+    ImageCompressionMode m_CompressionMode;
+    std::exception_ptr m_FirstError;
+};
+
+//! Queue an image for asynchronous writing with the global write service
+template <class ImageType>
+void
+queueImageForWriting(const std::string &filename, ImageType *img)
+{
+    ImageWriteService::GetInstance().QueueImage(filename,img);
+}
+
+//! Wait for all images queued in the global write service, re-throws writing errors
+inline void
+waitForPendingImageWrites()
+{
+    ImageWriteService::GetInstance().WaitForPendingWrites();
+}
+
+} // end namespace anima
+
+#include "animaImageWriteService.hxx"
@@ -0,0 +1,147 @@
+#pragma once
+#include "animaImageWriteService.h"
+
+#include <algorithm>
+
+namespace anima
+{
+
+inline ImageWriteService::ImageWriteService()
+{
+    m_NumberOfWorkers = 0;
+    m_NumberOfRunningJobs = 0;
+    m_StopRequested = false;
+    m_CompressionMode = StandardCompression;
+}
+
+inline ImageWriteService::~ImageWriteService()
+{
+    // Never throw from here, pending images are still written
+    try
+    {
+        this->WaitForPendingWrites();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Error writing image: " << e.what() << std::endl;
+    }
+
+    this->StopWorkers();
+}
+
+inline void
+ImageWriteService::SetNumberOfWorkers(unsigned int nbWorkers)
+{
+    std::lock_guard <std::mutex> lock(m_QueueMutex);
+    if (m_Workers.size() == 0)
+        m_NumberOfWorkers = nbWorkers;
+}
+
+template <class ImageType>
+void
+ImageWriteService::QueueImage(const std::string &filename, ImageType *img)
+{
+    // Shallow copy sharing the pixel buffer so that the writer does not trigger upstream pipeline updates
+    typename ImageType::Pointer imageCopy = ImageType::New();
+    imageCopy->Graft(img);
+
+    ImageCompressionMode compression = m_CompressionMode;
+    std::function <void()> job = [filename,imageCopy,compression]()
+    {
+        anima::writeImage <ImageType> (filename,imageCopy.GetPointer(),compression);
+    };
+
+    {
+        std::lock_guard <std::mutex> lock(m_QueueMutex);
+        if (m_Workers.size() == 0)
+            this->StartWorkers();
+
+        m_PendingJobs.push_back(job);
+    }
+
+    m_JobAvailableCondition.notify_one();
+}
+
+inline void
+ImageWriteService::WaitForPendingWrites()
+{
+    std::unique_lock <std::mutex> lock(m_QueueMutex);
+    m_JobsDoneCondition.wait(lock, [this] {return m_PendingJobs.empty() && (m_NumberOfRunningJobs == 0);});
+
+    if (m_FirstError)
+    {
+        std::exception_ptr error = m_FirstError;
+        m_FirstError = std::exception_ptr();
+        std::rethrow_exception(error);
+    }
+}
+
+inline void
+ImageWriteService::StartWorkers()
+{
+    // Called with queue mutex locked
+    unsigned int nbWorkers = m_NumberOfWorkers;
+    if (nbWorkers == 0)
+        nbWorkers = std::max(1u,std::min(4u,std::thread::hardware_concurrency()));
+
+    m_StopRequested = false;
+    for (unsigned int i = 0;i < nbWorkers;++i)
+        m_Workers.push_back(std::thread(&ImageWriteService::WorkerLoop,this));
+}
+
+inline void
+ImageWriteService::StopWorkers()
+{
+    {
+        std::lock_guard <std::mutex> lock(m_QueueMutex);
+        m_StopRequested = true;
+    }
+
+    m_JobAvailableCondition.notify_all();
+    for (unsigned int i = 0;i < m_Workers.size();++i)
+        m_Workers[i].join();
+
+    m_Workers.clear();
+}
+
+inline void
+ImageWriteService::WorkerLoop()
+{
+    while (true)
+    {
+        std::function <void()> job;
+
+        {
+            std::unique_lock <std::mutex> lock(m_QueueMutex);
+            m_JobAvailableCondition.wait(lock, [this] {return m_StopRequested || !m_PendingJobs.empty();});
+
+            if (m_PendingJobs.empty())
+                return;
+
+            job = m_PendingJobs.front();
+            m_PendingJobs.pop_front();
+            ++m_NumberOfRunningJobs;
+        }
+
+        std::exception_ptr error;
+        try
+        {
+            job();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard <std::mutex> lock(m_QueueMutex);
+            --m_NumberOfRunningJobs;
+            if (error && !m_FirstError)
+                m_FirstError = error;
+        }
+
+        m_JobsDoneCondition.notify_all();
+    }
+}
+
+} // end namespace anima
@@ -4,9 +4,35 @@
 #include <itkImageFileWriter.h>
 #include <itkExtractImageFilter.h>
 
+#include <animaVolumeViewImageContainer.h>
+
 namespace anima
 {
 
+//! Compression modes available when writing images
+enum ImageCompressionMode
+{
+    NoCompression = 0,
+    FastCompression,
+    StandardCompression
+};
+
+//! Get compression mode from its command line name (none, fast or standard)
+inline ImageCompressionMode
+getImageCompressionModeFromString(const std::string &modeName)
+{
+    if (modeName == "none")
+        return NoCompression;
+    if (modeName == "fast")
+        return FastCompression;
+    if (modeName == "standard")
+        return StandardCompression;
+
+    std::string errStr = "Unknown compression mode: ";
+    errStr += modeName;
+    throw itk::ExceptionObject(__FILE__, __LINE__,errStr,ITK_LOCATION);
+}
+
 template <class ImageType>
 typename itk::SmartPointer<ImageType>
 readImage(std::string filename)
@@ -25,11 +51,18 @@ readImage(std::string filename)
 
 template <class OutputImageType>
 void
-writeImage(std::string filename, OutputImageType* img)
+writeImage(std::string filename, OutputImageType* img, ImageCompressionMode compression = StandardCompression)
 {
     typedef itk::ImageFileWriter<OutputImageType> WriterType;
     typename WriterType::Pointer writer = WriterType::New();
-    writer->SetUseCompression(true);
+    writer->SetUseCompression(compression != NoCompression);
+
+#if ITK_VERSION_MAJOR > 5 || (ITK_VERSION_MAJOR == 5 && ITK_VERSION_MINOR >= 1)
+    // Compression level is only available from ITK 5.1, otherwise fast falls back on default level
+    if (compression == FastCompression)
+        writer->SetCompressionLevel(1);
+#endif
+
     writer->SetFileName(filename);
     writer->SetInput(img);
 
@@ -73,6 +106,62 @@ getImagesFromHigherDimensionImage(InputImageType *inputImage)
     return outputData;
 }
 
+//! Get a vector of read-only views on the volumes of a higher dimensional image, sharing its buffer (no copy)
+template <class InputImageType, class OutputImageType>
+std::vector < itk::SmartPointer <OutputImageType> >
+getImageViewsFromHigherDimensionImage(InputImageType *inputImage)
+{
+    const unsigned int highDimImage = InputImageType::ImageDimension;
+    const unsigned int lowerDimImage = OutputImageType::ImageDimension;
+
+    if (highDimImage != lowerDimImage + 1)
+        throw itk::ExceptionObject(__FILE__, __LINE__, "Trying to divide an image that doesn't have one more dimension",ITK_LOCATION);
+
+    typename InputImageType::RegionType largeRegion = inputImage->GetLargestPossibleRegion();
+    if (inputImage->GetBufferedRegion() != largeRegion)
+        return anima::getImagesFromHigherDimensionImage<InputImageType,OutputImageType>(inputImage);
+
+    typedef typename OutputImageType::PixelType PixelType;
+    typedef anima::VolumeViewImageContainer <itk::SizeValueType, PixelType> ContainerType;
+
+    typename OutputImageType::RegionType volumeRegion;
+    typename OutputImageType::SpacingType volumeSpacing;
+    typename OutputImageType::PointType volumeOrigin;
+    typename OutputImageType::DirectionType volumeDirection;
+
+    for (unsigned int i = 0;i < lowerDimImage;++i)
+    {
+        volumeRegion.SetIndex(i,largeRegion.GetIndex(i));
+        volumeRegion.SetSize(i,largeRegion.GetSize(i));
+        volumeSpacing[i] = inputImage->GetSpacing()[i];
+        volumeOrigin[i] = inputImage->GetOrigin()[i];
+
+        for (unsigned int j = 0;j < lowerDimImage;++j)
+            volumeDirection(i,j) = inputImage->GetDirection()(i,j);
+    }
+
+    unsigned int ndim = largeRegion.GetSize(lowerDimImage);
+    itk::SizeValueType volumeSize = volumeRegion.GetNumberOfPixels();
+    PixelType *bufferPointer = inputImage->GetBufferPointer();
+
+    std::vector < itk::SmartPointer <OutputImageType> > outputData(ndim);
+    for (unsigned int i = 0;i < ndim;++i)
+    {
+        typename ContainerType::Pointer viewContainer = ContainerType::New();
+        viewContainer->SetViewedBuffer(inputImage,bufferPointer + i * volumeSize,volumeSize);
+
+        outputData[i] = OutputImageType::New();
+        outputData[i]->Initialize();
+        outputData[i]->SetRegions(volumeRegion);
+        outputData[i]->SetSpacing(volumeSpacing);
+        outputData[i]->SetOrigin(volumeOrigin);
+        outputData[i]->SetDirection(volumeDirection);
+        outputData[i]->SetPixelContainer(viewContainer);
+    }
+
+    return outputData;
+}
+
 //! Set inputs of an image to image filter from a file name containing either a list of files or a higher dimensional image
 template <class InputImageType, class ImageFilterType>
 unsigned int
@@ -149,7 +238,7 @@ setMultipleImageFilterInputsFromFileName(std::string &fileName,
         imageReader->Update();
 
         std::vector <typename InputImageType::Pointer> inputData;
-        inputData = anima::getImagesFromHigherDimensionImage<HigherDimImageType,InputImageType>(imageReader->GetOutput());
+        inputData = anima::getImageViewsFromHigherDimensionImage<HigherDimImageType,InputImageType>(imageReader->GetOutput());
 
         for (unsigned int i = 0;i < inputData.size();++i)
             filter->SetInput(i,inputData[i]);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <itkImportImageContainer.h>
+#include <itkDataObject.h>
+
+namespace anima
+{
+
+/**
+ * @brief Pixel container viewing a contiguous part of another image buffer (e.g. one volume of a 4D image)
+ * without copying it. The viewed image is kept alive as long as the view exists. Images using this container
+ * share their memory with the viewed image and should therefore be considered read-only.
+ */
+template <typename TElementIdentifier, typename TElement>
+class VolumeViewImageContainer :
+        public itk::ImportImageContainer <TElementIdentifier, TElement>
+{
+public:
+    /** Standard class typedefs. */
+    typedef VolumeViewImageContainer Self;
+    typedef itk::ImportImageContainer <TElementIdentifier, TElement> Superclass;
+    typedef itk::SmartPointer<Self> Pointer;
+    typedef itk::SmartPointer<const Self> ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self)
+
+    /** Run-time type information (and related methods) */
+    itkTypeMacro(VolumeViewImageContainer, itk::ImportImageContainer)
+
+    //! Set viewed buffer: parent data object holding the buffer, pointer to first viewed element and number of elements
+    void SetViewedBuffer(itk::DataObject *parent, TElement *firstElement, TElementIdentifier size)
+    {
+        m_ViewedObject = parent;
+        this->SetImportPointer(firstElement,size,false);
+    }
+
+protected:
+    VolumeViewImageContainer() {}
+    virtual ~VolumeViewImageContainer() {}
+
+private:
+    VolumeViewImageContainer(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+
+    itk::DataObject::ConstPointer m_ViewedObject;
+};
+
+} // end namespace anima
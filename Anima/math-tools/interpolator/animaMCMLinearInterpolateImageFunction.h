@@ -0,0 +1,154 @@
+#pragma once
+
+#include <itkInterpolateImageFunction.h>
+#include <itkVariableLengthVector.h>
+#include <vnl/vnl_vector_fixed.h>
+
+#include <animaMCMImage.h>
+
+#include <vector>
+
+namespace anima
+{
+
+/**
+ * @brief Linear interpolation of multi-compartment model images.
+ *
+ * Isotropic compartments (free water, etc.) are averaged: their weights are linearly interpolated and their
+ * parameters are averaged using the interpolated compartment weights. Fascicle compartments of all non zero
+ * corners are pooled and reduced to the number of fascicles of the description model: clusters are seeded
+ * by weighted farthest point sampling on orientations, refined by a few weighted k-means iterations, and the
+ * fascicle tensors of each cluster are averaged. Fascicle compartment vectors are assumed to be tensors
+ * (as for stick, zeppelin and tensor compartments), output vectors are thus projected back on each
+ * compartment type when set in a model.
+ */
+template <class TInputImage, class TCoordRep = double>
+class MCMLinearInterpolateImageFunction :
+        public itk::InterpolateImageFunction<TInputImage,TCoordRep>
+{
+public:
+    /** Standard class typedefs. */
+    typedef MCMLinearInterpolateImageFunction Self;
+    typedef itk::InterpolateImageFunction<TInputImage,TCoordRep> Superclass;
+    typedef itk::SmartPointer<Self> Pointer;
+    typedef itk::SmartPointer<const Self> ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self);
+
+    /** Run-time type information (and related methods). */
+    itkTypeMacro(MCMLinearInterpolateImageFunction, InterpolateImageFunction);
+
+    /** InputImageType typedef support. */
+    typedef typename Superclass::InputImageType InputImageType;
+    typedef typename TInputImage::PixelType PixelType;
+    typedef typename Superclass::RealType RealType;
+
+    /** Dimension underlying input image. */
+    itkStaticConstMacro(ImageDimension, unsigned int,Superclass::ImageDimension);
+
+    /** Index typedef support. */
+    typedef typename Superclass::IndexType IndexType;
+    typedef typename Superclass::IndexValueType IndexValueType;
+
+    /** ContinuousIndex typedef support. */
+    typedef typename Superclass::ContinuousIndexType ContinuousIndexType;
+
+    typedef typename Superclass::OutputType OutputType;
+    typedef typename TInputImage::InternalPixelType InternalPixelType;
+    typedef typename TInputImage::OffsetValueType OffsetValueType;
+
+    typedef anima::MCMImage <InternalPixelType, ImageDimension> MCMImageType;
+    typedef typename MCMImageType::MCMPointer MCMPointer;
+
+    static const unsigned int TensorVectorSize = 6;
+    typedef vnl_vector_fixed <double,TensorVectorSize> TensorVectorType;
+    typedef vnl_vector_fixed <double,3> DirectionType;
+
+    //! Work variables for fascicle pooling and reduction, one per thread
+    struct WorkspaceType
+    {
+        std::vector <double> sampleWeights;
+        std::vector <TensorVectorType> sampleTensors;
+        std::vector <DirectionType> sampleDirections;
+        std::vector <unsigned int> sampleLabels;
+        std::vector <double> sampleDistances;
+
+        std::vector <double> clusterWeights;
+        std::vector <TensorVectorType> clusterTensors;
+        std::vector <DirectionType> clusterDirections;
+        std::vector <unsigned int> clusterOrder;
+    };
+
+    /** Set the input image (must be an MCM image with its description model) and precompute buffer access data:
+     * corner offsets, non-zero model mask and compartment layout. Must be called again if the image buffer is modified afterwards. */
+    virtual void SetInputImage(const InputImageType *ptr) ITK_OVERRIDE;
+
+    //! Number of weighted k-means iterations when reducing pooled fascicles
+    itkSetMacro(NumberOfReductionIterations, unsigned int)
+    itkGetConstMacro(NumberOfReductionIterations, unsigned int)
+
+    /** Evaluate the function at a ContinuousIndex position. Allocates its own workspace, use the
+     * workspace version in multithreaded loops. Same bounds assumption as itk::LinearInterpolateImageFunction. */
+    virtual OutputType EvaluateAtContinuousIndex(const ContinuousIndexType & index) const ITK_OVERRIDE;
+
+    /** Allocation free evaluation: writes the interpolated model in output, which must already hold
+     * as many elements as the input image has components. Returns false if the interpolated model is zero (background). */
+    template <class TOutputVectorType>
+    bool EvaluateAtContinuousIndex(const ContinuousIndexType & index, TOutputVectorType &output,
+                                   WorkspaceType &workspace) const;
+
+protected:
+    MCMLinearInterpolateImageFunction();
+    virtual ~MCMLinearInterpolateImageFunction() {}
+    void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+    virtual bool IsInsideBuffer(const ContinuousIndexType & index) const ITK_OVERRIDE
+    {
+        for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+            /* Test for negative of a positive so we can catch NaN's. */
+            if ( ! (index[j] >= this->m_StartIndex[j] &&
+                    index[j] <= this->m_EndIndex[j] ) )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //! Principal direction of a tensor given as a vector (lower triangular order, not scaled)
+    void ComputePrincipalDirection(const TensorVectorType &tensor, DirectionType &direction) const;
+
+    //! Reduces pooled fascicles to at most the number of model fascicles, clusters are sorted by decreasing weight
+    void ReduceFascicles(WorkspaceType &workspace) const;
+
+private:
+    MCMLinearInterpolateImageFunction(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+
+    /** Number of neighbors used in the interpolation */
+    static const unsigned long m_Neighbors;
+
+    unsigned int m_NumberOfReductionIterations;
+
+    //! Raw input buffer, pixel components are contiguous
+    const InternalPixelType *m_InputBuffer;
+    unsigned int m_NumberOfComponents;
+
+    //! Buffer offsets (in pixels) of the 2^D corners relative to the lower corner
+    OffsetValueType m_NeighborOffsets[1 << ImageDimension];
+
+    //! One bit per voxel, false where all model components are zero
+    std::vector <bool> m_NonZeroModels;
+
+    //! Compartment layout in model vectors: weights first, then compartment vectors (isotropic ones first)
+    unsigned int m_NumberOfCompartments;
+    unsigned int m_NumberOfIsotropicCompartments;
+    std::vector <unsigned int> m_CompartmentPositions;
+    std::vector <unsigned int> m_CompartmentSizes;
+};
+
+} // end namespace anima
+
+#include "animaMCMLinearInterpolateImageFunction.hxx"
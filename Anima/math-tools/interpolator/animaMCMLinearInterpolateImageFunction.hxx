@@ -0,0 +1,490 @@
+#pragma once
+
+#include "animaMCMLinearInterpolateImageFunction.h"
+#include <animaBaseTensorTools.h>
+
+#include <itkMatrix.h>
+#include <algorithm>
+
+namespace anima
+{
+
+/**
+     * Define the number of neighbors
+     */
+template<class TInputImage, class TCoordRep>
+const unsigned long
+MCMLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::m_Neighbors = 1 << TInputImage::ImageDimension;
+
+template<class TInputImage, class TCoordRep>
+const unsigned int
+MCMLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::TensorVectorSize;
+
+/**
+     * Constructor
+     */
+template<class TInputImage, class TCoordRep>
+MCMLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::MCMLinearInterpolateImageFunction()
+{
+    m_NumberOfReductionIterations = 3;
+
+    m_InputBuffer = 0;
+    m_NumberOfComponents = 0;
+    for (unsigned int i = 0;i < m_Neighbors;++i)
+        m_NeighborOffsets[i] = 0;
+
+    m_NumberOfCompartments = 0;
+    m_NumberOfIsotropicCompartments = 0;
+}
+
+/**
+     * PrintSelf
+     */
+template<class TInputImage, class TCoordRep>
+void
+MCMLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+    this->Superclass::PrintSelf(os,indent);
+    os << indent << "Number of reduction iterations: " << m_NumberOfReductionIterations << std::endl;
+}
+
+template<class TInputImage, class TCoordRep>
+void
+MCMLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::SetInputImage(const InputImageType *ptr)
+{
+    this->Superclass::SetInputImage(ptr);
+
+    m_InputBuffer = 0;
+    m_NumberOfComponents = 0;
+    m_NonZeroModels.clear();
+    m_NumberOfCompartments = 0;
+    m_NumberOfIsotropicCompartments = 0;
+    m_CompartmentPositions.clear();
+    m_CompartmentSizes.clear();
+
+    if (!ptr)
+        return;
+
+    const MCMImageType *mcmImage = dynamic_cast <const MCMImageType *> (ptr);
+    if (!mcmImage)
+        itkExceptionMacro("MCM interpolation requires an MCM image as input");
+
+    MCMPointer &descriptionModel = const_cast <MCMImageType *> (mcmImage)->GetDescriptionModel();
+    if (!descriptionModel)
+        itkExceptionMacro("Input MCM image has no description model");
+
+    m_NumberOfCompartments = descriptionModel->GetNumberOfCompartments();
+    m_NumberOfIsotropicCompartments = descriptionModel->GetNumberOfIsotropicCompartments();
+    m_CompartmentPositions.resize(m_NumberOfCompartments);
+    m_CompartmentSizes.resize(m_NumberOfCompartments);
+
+    unsigned int pos = m_NumberOfCompartments;
+    for (unsigned int i = 0;i < m_NumberOfCompartments;++i)
+    {
+        m_CompartmentPositions[i] = pos;
+        m_CompartmentSizes[i] = descriptionModel->GetCompartment(i)->GetCompartmentSize();
+
+        if ((i >= m_NumberOfIsotropicCompartments)&&(m_CompartmentSizes[i] != TensorVectorSize))
+            itkExceptionMacro("MCM interpolation only handles fascicle compartments described by tensors");
+
+        pos += m_CompartmentSizes[i];
+    }
+
+    m_InputBuffer = ptr->GetBufferPointer();
+    m_NumberOfComponents = ptr->GetNumberOfComponentsPerPixel();
+
+    if (m_NumberOfComponents != pos)
+        itkExceptionMacro("Input MCM image vector size does not match its description model");
+
+    const OffsetValueType *offsetTable = ptr->GetOffsetTable();
+    for (unsigned int counter = 0;counter < m_Neighbors;++counter)
+    {
+        m_NeighborOffsets[counter] = 0;
+        unsigned int upper = counter;
+        for (unsigned int dim = 0;dim < ImageDimension;++dim)
+        {
+            if (upper & 1)
+                m_NeighborOffsets[counter] += offsetTable[dim];
+
+            upper >>= 1;
+        }
+    }
+
+    unsigned int numVoxels = ptr->GetBufferedRegion().GetNumberOfPixels();
+    m_NonZeroModels.resize(numVoxels);
+
+    const InternalPixelType *voxelPtr = m_InputBuffer;
+    for (unsigned int i = 0;i < numVoxels;++i)
+    {
+        // Compartment weights are enough to tell background models
+        bool nonZero = false;
+        for (unsigned int j = 0;j < m_NumberOfCompartments;++j)
+        {
+            if (voxelPtr[j] != 0)
+            {
+                nonZero = true;
+                break;
+            }
+        }
+
+        m_NonZeroModels[i] = nonZero;
+        voxelPtr += m_NumberOfComponents;
+    }
+}
+
+/**
+     * Evaluate at image index position
+     */
+template<class TInputImage, class TCoordRep>
+typename MCMLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::OutputType
+MCMLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::EvaluateAtContinuousIndex(const ContinuousIndexType& index) const
+{
+    OutputType output(m_NumberOfComponents);
+    WorkspaceType workspace;
+    this->EvaluateAtContinuousIndex(index,output,workspace);
+
+    return output;
+}
+
+template<class TInputImage, class TCoordRep>
+template<class TOutputVectorType>
+bool
+MCMLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::EvaluateAtContinuousIndex(const ContinuousIndexType& index, TOutputVectorType &output,
+                            WorkspaceType &workspace) const
+{
+    IndexType baseIndex, closestIndex;
+    double distance[ImageDimension], oppDistance[ImageDimension];
+
+    bool useClosest = true;
+
+    for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+    {
+        baseIndex[dim] = itk::Math::Floor< IndexValueType >( index[dim] );
+        distance[dim] = index[dim] - static_cast< double >( baseIndex[dim] );
+        oppDistance[dim] = 1.0 - distance[dim];
+
+        if (useClosest)
+        {
+            if (distance[dim] < 0.5)
+                closestIndex[dim] = baseIndex[dim];
+            else
+                closestIndex[dim] = baseIndex[dim] + 1;
+
+            if ((distance[dim] > 1.0e-8)&&(oppDistance[dim] > 1.0e-8))
+                useClosest = false;
+        }
+    }
+
+    const InputImageType *image = this->GetInputImage();
+
+    if (useClosest)
+    {
+        OffsetValueType closestOffset = image->ComputeOffset(closestIndex);
+        const InternalPixelType *closestPtr = m_InputBuffer + closestOffset * m_NumberOfComponents;
+        for (unsigned int i = 0;i < m_NumberOfComponents;++i)
+            output[i] = closestPtr[i];
+
+        return m_NonZeroModels[closestOffset];
+    }
+
+    for (unsigned int i = 0;i < m_NumberOfComponents;++i)
+        output[i] = 0;
+
+    workspace.sampleWeights.clear();
+    workspace.sampleTensors.clear();
+
+    OffsetValueType baseOffset = image->ComputeOffset(baseIndex);
+    double totalOverlap = 0;
+
+    for( unsigned int counter = 0; counter < m_Neighbors; ++counter)
+    {
+        double overlap = 1.0;          // fraction overlap
+        unsigned int upper = counter;  // each bit indicates upper/lower neighbour
+
+        // get overlap fraction
+        for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+        {
+            if ( upper & 1 )
+                overlap *= distance[dim];
+            else
+                overlap *= oppDistance[dim];
+
+            upper >>= 1;
+        }
+
+        // get neighbor value only if overlap is not zero (upper neighbors may be outside the buffer otherwise)
+        if (overlap == 0)
+            continue;
+
+        OffsetValueType neighOffset = baseOffset + m_NeighborOffsets[counter];
+        if (!m_NonZeroModels[neighOffset])
+            continue;
+
+        const InternalPixelType *neighPtr = m_InputBuffer + neighOffset * m_NumberOfComponents;
+
+        // Isotropic compartments: weights are interpolated, parameters accumulated weighted by compartment weights
+        for (unsigned int i = 0;i < m_NumberOfIsotropicCompartments;++i)
+        {
+            double compartmentWeight = overlap * neighPtr[i];
+            if (compartmentWeight <= 0)
+                continue;
+
+            output[i] += compartmentWeight;
+            for (unsigned int j = 0;j < m_CompartmentSizes[i];++j)
+                output[m_CompartmentPositions[i] + j] += compartmentWeight * neighPtr[m_CompartmentPositions[i] + j];
+        }
+
+        // Fascicles are pooled for reduction
+        for (unsigned int i = m_NumberOfIsotropicCompartments;i < m_NumberOfCompartments;++i)
+        {
+            double compartmentWeight = overlap * neighPtr[i];
+            if (compartmentWeight <= 0)
+                continue;
+
+            TensorVectorType fascicleTensor;
+            for (unsigned int j = 0;j < TensorVectorSize;++j)
+                fascicleTensor[j] = neighPtr[m_CompartmentPositions[i] + j];
+
+            workspace.sampleWeights.push_back(compartmentWeight);
+            workspace.sampleTensors.push_back(fascicleTensor);
+        }
+
+        totalOverlap += overlap;
+    }
+
+    if (totalOverlap <= 0.5)
+    {
+        for (unsigned int i = 0;i < m_NumberOfComponents;++i)
+            output[i] = 0;
+
+        return false;
+    }
+
+    for (unsigned int i = 0;i < m_NumberOfIsotropicCompartments;++i)
+    {
+        if (output[i] <= 0)
+            continue;
+
+        for (unsigned int j = 0;j < m_CompartmentSizes[i];++j)
+            output[m_CompartmentPositions[i] + j] /= output[i];
+
+        output[i] /= totalOverlap;
+    }
+
+    this->ReduceFascicles(workspace);
+
+    unsigned int numClusters = workspace.clusterOrder.size();
+    for (unsigned int k = 0;k < numClusters;++k)
+    {
+        unsigned int clusterIndex = workspace.clusterOrder[k];
+        unsigned int compartmentIndex = m_NumberOfIsotropicCompartments + k;
+
+        output[compartmentIndex] = workspace.clusterWeights[clusterIndex] / totalOverlap;
+        for (unsigned int j = 0;j < TensorVectorSize;++j)
+            output[m_CompartmentPositions[compartmentIndex] + j] = workspace.clusterTensors[clusterIndex][j];
+    }
+
+    return true;
+}
+
+template<class TInputImage, class TCoordRep>
+void
+MCMLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::ComputePrincipalDirection(const TensorVectorType &tensor, DirectionType &direction) const
+{
+    typedef itk::Matrix <double,3,3> MatrixType;
+    MatrixType tensorMatrix, eigenVectors;
+    DirectionType eigenValues;
+
+    unsigned int pos = 0;
+    for (unsigned int i = 0;i < 3;++i)
+    {
+        for (unsigned int j = 0;j <= i;++j)
+        {
+            tensorMatrix(i,j) = tensor[pos];
+            tensorMatrix(j,i) = tensor[pos];
+            ++pos;
+        }
+    }
+
+    anima::ComputeSymmetric3x3EigenAnalysis(tensorMatrix,eigenValues,eigenVectors);
+
+    // Eigen values are sorted in ascending order, eigen vectors are rows
+    for (unsigned int i = 0;i < 3;++i)
+        direction[i] = eigenVectors(2,i);
+}
+
+template<class TInputImage, class TCoordRep>
+void
+MCMLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::ReduceFascicles(WorkspaceType &workspace) const
+{
+    unsigned int numSamples = workspace.sampleWeights.size();
+    unsigned int numFascicles = m_NumberOfCompartments - m_NumberOfIsotropicCompartments;
+
+    workspace.clusterOrder.clear();
+    if ((numSamples == 0)||(numFascicles == 0))
+        return;
+
+    workspace.clusterWeights.resize(numFascicles);
+    workspace.clusterTensors.resize(numFascicles);
+    workspace.clusterDirections.resize(numFascicles);
+
+    if (numSamples <= numFascicles)
+    {
+        // Nothing to reduce, samples are the clusters
+        for (unsigned int i = 0;i < numSamples;++i)
+        {
+            workspace.clusterWeights[i] = workspace.sampleWeights[i];
+            workspace.clusterTensors[i] = workspace.sampleTensors[i];
+            workspace.clusterOrder.push_back(i);
+        }
+    }
+    else
+    {
+        workspace.sampleDirections.resize(numSamples);
+        workspace.sampleLabels.resize(numSamples);
+        workspace.sampleDistances.resize(numSamples);
+
+        unsigned int heaviestSample = 0;
+        for (unsigned int i = 0;i < numSamples;++i)
+        {
+            this->ComputePrincipalDirection(workspace.sampleTensors[i],workspace.sampleDirections[i]);
+            if (workspace.sampleWeights[i] > workspace.sampleWeights[heaviestSample])
+                heaviestSample = i;
+        }
+
+        // Seeding: heaviest fascicle first, then weighted farthest orientations (1 - cos^2)
+        workspace.clusterDirections[0] = workspace.sampleDirections[heaviestSample];
+        unsigned int numClusters = 1;
+        for (unsigned int i = 0;i < numSamples;++i)
+        {
+            double cosValue = dot_product(workspace.sampleDirections[i],workspace.clusterDirections[0]);
+            workspace.sampleDistances[i] = 1.0 - cosValue * cosValue;
+        }
+
+        while (numClusters < numFascicles)
+        {
+            unsigned int farthestSample = 0;
+            double farthestScore = 0;
+            for (unsigned int i = 0;i < numSamples;++i)
+            {
+                double score = workspace.sampleWeights[i] * workspace.sampleDistances[i];
+                if (score > farthestScore)
+                {
+                    farthestScore = score;
+                    farthestSample = i;
+                }
+            }
+
+            // All remaining fascicles are aligned with existing clusters
+            if (farthestScore <= 1.0e-8)
+                break;
+
+            workspace.clusterDirections[numClusters] = workspace.sampleDirections[farthestSample];
+            for (unsigned int i = 0;i < numSamples;++i)
+            {
+                double cosValue = dot_product(workspace.sampleDirections[i],workspace.clusterDirections[numClusters]);
+                workspace.sampleDistances[i] = std::min(workspace.sampleDistances[i],1.0 - cosValue * cosValue);
+            }
+
+            ++numClusters;
+        }
+
+        // Weighted k-means on axes: cluster axes are principal directions of weighted scatter matrices
+        for (unsigned int iter = 0;iter <= m_NumberOfReductionIterations;++iter)
+        {
+            bool labelsChanged = false;
+            for (unsigned int i = 0;i < numSamples;++i)
+            {
+                unsigned int bestCluster = 0;
+                double bestSquaredCos = -1;
+                for (unsigned int k = 0;k < numClusters;++k)
+                {
+                    double cosValue = dot_product(workspace.sampleDirections[i],workspace.clusterDirections[k]);
+                    if (cosValue * cosValue > bestSquaredCos)
+                    {
+                        bestSquaredCos = cosValue * cosValue;
+                        bestCluster = k;
+                    }
+                }
+
+                if ((iter == 0)||(workspace.sampleLabels[i] != bestCluster))
+                    labelsChanged = true;
+
+                workspace.sampleLabels[i] = bestCluster;
+            }
+
+            if ((!labelsChanged)||(iter == m_NumberOfReductionIterations))
+                break;
+
+            for (unsigned int k = 0;k < numClusters;++k)
+                workspace.clusterTensors[k].fill(0.0);
+
+            for (unsigned int i = 0;i < numSamples;++i)
+            {
+                const DirectionType &sampleDirection = workspace.sampleDirections[i];
+                TensorVectorType &scatter = workspace.clusterTensors[workspace.sampleLabels[i]];
+
+                unsigned int pos = 0;
+                for (unsigned int j = 0;j < 3;++j)
+                {
+                    for (unsigned int l = 0;l <= j;++l)
+                    {
+                        scatter[pos] += workspace.sampleWeights[i] * sampleDirection[j] * sampleDirection[l];
+                        ++pos;
+                    }
+                }
+            }
+
+            for (unsigned int k = 0;k < numClusters;++k)
+                this->ComputePrincipalDirection(workspace.clusterTensors[k],workspace.clusterDirections[k]);
+        }
+
+        for (unsigned int k = 0;k < numClusters;++k)
+        {
+            workspace.clusterWeights[k] = 0;
+            workspace.clusterTensors[k].fill(0.0);
+        }
+
+        for (unsigned int i = 0;i < numSamples;++i)
+        {
+            unsigned int label = workspace.sampleLabels[i];
+            workspace.clusterWeights[label] += workspace.sampleWeights[i];
+            workspace.clusterTensors[label] += workspace.sampleWeights[i] * workspace.sampleTensors[i];
+        }
+
+        for (unsigned int k = 0;k < numClusters;++k)
+        {
+            if (workspace.clusterWeights[k] <= 0)
+                continue;
+
+            workspace.clusterTensors[k] /= workspace.clusterWeights[k];
+            workspace.clusterOrder.push_back(k);
+        }
+    }
+
+    // Few clusters, insertion sort by decreasing weight
+    for (unsigned int i = 1;i < workspace.clusterOrder.size();++i)
+    {
+        unsigned int currentCluster = workspace.clusterOrder[i];
+        unsigned int j = i;
+        while ((j > 0)&&(workspace.clusterWeights[workspace.clusterOrder[j - 1]] < workspace.clusterWeights[currentCluster]))
+        {
+            workspace.clusterOrder[j] = workspace.clusterOrder[j - 1];
+            --j;
+        }
+
+        workspace.clusterOrder[j] = currentCluster;
+    }
+}
+
+} // end namespace anima
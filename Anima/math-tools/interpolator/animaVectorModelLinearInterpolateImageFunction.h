@@ -3,6 +3,8 @@
 #include <itkInterpolateImageFunction.h>
 #include <itkVariableLengthVector.h>
 
+#include <vector>
+
 namespace anima
 {
 
@@ -41,6 +43,12 @@ public:
 
     typedef typename Superclass::OutputType OutputType;
     typedef itk::VariableLengthVector <typename TInputImage::IOPixelType> VectorPixelType;
+    typedef typename TInputImage::InternalPixelType InternalPixelType;
+    typedef typename TInputImage::OffsetValueType OffsetValueType;
+
+    /** Set the input image and precompute buffer access data: corner offsets and non-zero model mask.
+     * Must be called again if the image buffer is modified afterwards. */
+    virtual void SetInputImage(const InputImageType *ptr) ITK_OVERRIDE;
 
     /** Evaluate the function at a ContinuousIndex position
          *
@@ -52,6 +60,12 @@ public:
          * calling the method. */
     virtual OutputType EvaluateAtContinuousIndex(const ContinuousIndexType & index) const ITK_OVERRIDE;
 
+    /** Allocation free evaluation: writes the interpolated model in output, which must already hold
+     * as many elements as the input image has components (any vector type with operator[]).
+     * Returns false if the interpolated model is zero (background). Same bounds assumption as above. */
+    template <class TOutputVectorType>
+    bool EvaluateAtContinuousIndex(const ContinuousIndexType & index, TOutputVectorType &output) const;
+
 protected:
     VectorModelLinearInterpolateImageFunction();
     virtual ~VectorModelLinearInterpolateImageFunction() {}
@@ -71,24 +85,6 @@ protected:
         return true;
     }
 
-    template <class T> inline bool isZero(itk::VariableLengthVector <T> &value) const
-    {
-        for (unsigned int i = 0;i < value.GetNumberOfElements();++i)
-        {
-            if (value[i] != 0)
-                return false;
-        }
-
-        return true;
-    }
-
-    // Fake method for compilation purposes, should never go in there
-    template <class T> inline bool isZero(T &data) const
-    {
-        itkExceptionMacro("Access to unauthorized zero test method");
-        return true;
-    }
-
     //! Utility function to initialize output images pixel to zero for vector images
     template <class T> inline void InitializeZeroPixel(itk::VariableLengthVector <T> &zeroPixel) const
     {
@@ -102,28 +98,22 @@ protected:
         zeroPixel = itk::NumericTraits <T>::ZeroValue();
     }
 
-    //! Utility function to initialize output images pixel to zero for vector images
-    template <class T1, class T2>
-    void AddValue(itk::VariableLengthVector <T1> &input, double weight,
-                  itk::VariableLengthVector <T2> &output) const
-    {
-        unsigned int vecDim = input.GetNumberOfElements();
-        for (unsigned int i = 0;i < vecDim;++i)
-            output[i] += weight * input[i];
-    }
-
-    //! Utility function to initialize output images pixel to zero for all images except vector images
-    template <class T1, class T2> void AddValue(T1 &input, double weight, T2 &output) const
-    {
-        itkExceptionMacro("Acces to unauthorized method, check your implementation");
-    }
-
 private:
     VectorModelLinearInterpolateImageFunction(const Self&); //purposely not implemented
     void operator=(const Self&); //purposely not implemented
 
     /** Number of neighbors used in the interpolation */
     static const unsigned long m_Neighbors;
+
+    //! Raw input buffer, pixel components are contiguous
+    const InternalPixelType *m_InputBuffer;
+    unsigned int m_NumberOfComponents;
+
+    //! Buffer offsets (in pixels) of the 2^D corners relative to the lower corner
+    OffsetValueType m_NeighborOffsets[1 << ImageDimension];
+
+    //! One bit per voxel, false where all model components are zero
+    std::vector <bool> m_NonZeroModels;
 };
 
 } // end namespace itk
@@ -22,7 +22,10 @@ template<class TInputImage, class TCoordRep>
 VectorModelLinearInterpolateImageFunction< TInputImage, TCoordRep >
 ::VectorModelLinearInterpolateImageFunction()
 {
-
+    m_InputBuffer = 0;
+    m_NumberOfComponents = 0;
+    for (unsigned int i = 0;i < m_Neighbors;++i)
+        m_NeighborOffsets[i] = 0;
 }
 
 /**
@@ -36,6 +39,57 @@ VectorModelLinearInterpolateImageFunction< TInputImage, TCoordRep >
     this->Superclass::PrintSelf(os,indent);
 }
 
+template<class TInputImage, class TCoordRep>
+void
+VectorModelLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::SetInputImage(const InputImageType *ptr)
+{
+    this->Superclass::SetInputImage(ptr);
+
+    m_InputBuffer = 0;
+    m_NumberOfComponents = 0;
+    m_NonZeroModels.clear();
+
+    if (!ptr)
+        return;
+
+    m_InputBuffer = ptr->GetBufferPointer();
+    m_NumberOfComponents = ptr->GetNumberOfComponentsPerPixel();
+
+    const OffsetValueType *offsetTable = ptr->GetOffsetTable();
+    for (unsigned int counter = 0;counter < m_Neighbors;++counter)
+    {
+        m_NeighborOffsets[counter] = 0;
+        unsigned int upper = counter;
+        for (unsigned int dim = 0;dim < ImageDimension;++dim)
+        {
+            if (upper & 1)
+                m_NeighborOffsets[counter] += offsetTable[dim];
+
+            upper >>= 1;
+        }
+    }
+
+    unsigned int numVoxels = ptr->GetBufferedRegion().GetNumberOfPixels();
+    m_NonZeroModels.resize(numVoxels);
+
+    const InternalPixelType *voxelPtr = m_InputBuffer;
+    for (unsigned int i = 0;i < numVoxels;++i)
+    {
+        bool nonZero = false;
+        for (unsigned int j = 0;j < m_NumberOfComponents;++j)
+        {
+            if (voxelPtr[j] != 0)
+            {
+                nonZero = true;
+                break;
+            }
+        }
+
+        m_NonZeroModels[i] = nonZero;
+        voxelPtr += m_NumberOfComponents;
+    }
+}
 
 /**
      * Evaluate at image index position
@@ -45,6 +99,18 @@ typename VectorModelLinearInterpolateImageFunction< TInputImage, TCoordRep >
 ::OutputType
 VectorModelLinearInterpolateImageFunction< TInputImage, TCoordRep >
 ::EvaluateAtContinuousIndex(const ContinuousIndexType& index) const
+{
+    OutputType output(m_NumberOfComponents);
+    this->EvaluateAtContinuousIndex(index,output);
+
+    return output;
+}
+
+template<class TInputImage, class TCoordRep>
+template<class TOutputVectorType>
+bool
+VectorModelLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::EvaluateAtContinuousIndex(const ContinuousIndexType& index, TOutputVectorType &output) const
 {
     IndexType baseIndex, closestIndex;
     double distance[ImageDimension], oppDistance[ImageDimension];
@@ -69,60 +135,67 @@ VectorModelLinearInterpolateImageFunction< TInputImage, TCoordRep >
         }
     }
 
+    const InputImageType *image = this->GetInputImage();
+
     if (useClosest)
-        return static_cast<OutputType>( this->GetInputImage()->GetPixel( closestIndex ) );
+    {
+        OffsetValueType closestOffset = image->ComputeOffset(closestIndex);
+        const InternalPixelType *closestPtr = m_InputBuffer + closestOffset * m_NumberOfComponents;
+        for (unsigned int i = 0;i < m_NumberOfComponents;++i)
+            output[i] = closestPtr[i];
+
+        return m_NonZeroModels[closestOffset];
+    }
 
-    unsigned int vectorDim = this->GetInputImage()->GetNumberOfComponentsPerPixel();
-    OutputType output(vectorDim);
-    this->InitializeZeroPixel(output);
+    for (unsigned int i = 0;i < m_NumberOfComponents;++i)
+        output[i] = 0;
 
+    OffsetValueType baseOffset = image->ComputeOffset(baseIndex);
     double totalOverlap = 0;
 
     for( unsigned int counter = 0; counter < m_Neighbors; ++counter)
     {
         double overlap = 1.0;          // fraction overlap
         unsigned int upper = counter;  // each bit indicates upper/lower neighbour
-        IndexType neighIndex;
 
-        // get neighbor index and overlap fraction
+        // get overlap fraction
         for (unsigned int dim = 0; dim < ImageDimension; ++dim)
         {
-
             if ( upper & 1 )
-            {
-                neighIndex[dim] = baseIndex[dim] + 1;
                 overlap *= distance[dim];
-            }
             else
-            {
-                neighIndex[dim] = baseIndex[dim];
                 overlap *= oppDistance[dim];
-            }
 
             upper >>= 1;
-
         }
 
-        // get neighbor value only if overlap is not zero
-        if( overlap )
-        {
-            VectorPixelType input = static_cast <VectorPixelType> (this->GetInputImage()->GetPixel(neighIndex));
+        // get neighbor value only if overlap is not zero (upper neighbors may be outside the buffer otherwise)
+        if (overlap == 0)
+            continue;
 
-            if (!isZero(input))
-            {
-                this->AddValue(input,overlap,output);
-                totalOverlap += overlap;
-            }
-        }
+        OffsetValueType neighOffset = baseOffset + m_NeighborOffsets[counter];
+        if (!m_NonZeroModels[neighOffset])
+            continue;
 
+        const InternalPixelType *neighPtr = m_InputBuffer + neighOffset * m_NumberOfComponents;
+        for (unsigned int i = 0;i < m_NumberOfComponents;++i)
+            output[i] += overlap * neighPtr[i];
+
+        totalOverlap += overlap;
     }
 
     if (totalOverlap > 0.5)
-        output /= totalOverlap;
-    else
-        this->InitializeZeroPixel(output);
+    {
+        for (unsigned int i = 0;i < m_NumberOfComponents;++i)
+            output[i] /= totalOverlap;
 
-    return output;
+        return true;
+    }
+
+    for (unsigned int i = 0;i < m_NumberOfComponents;++i)
+        output[i] = 0;
+
+    return false;
 }
 
-} // end namespace itk
+} // end namespace anima
@@ -45,6 +45,20 @@ template <class T1, class T2, unsigned int NDim>
 void RotateSymmetricMatrix(itk::Matrix <T1,NDim,NDim> &tensor, itk::Matrix <T2,NDim,NDim> &rotationMatrix,
                            itk::Matrix <T2,NDim,NDim> &rotated_tensor);
 
+/**
+ * Linear operator on vector representations (scaled or not, see GetVectorRepresentation) of symmetric matrices,
+ * equivalent to RotateSymmetricMatrix with rotationMatrix. Lets one reorient many tensors (or their moments) at once.
+ */
+template <class T1, class T2>
+void GetTensorRotationOperator(const vnl_matrix <T1> &rotationMatrix, vnl_matrix <T2> &rotationOperator, bool scale = false);
+
+/**
+ * Closed form eigen analysis of a 3x3 symmetric matrix. Same output conventions as itk::SymmetricEigenAnalysis:
+ * ascending eigenvalues, eigenvectors stored as rows of eigenVectors
+ */
+template <class MatrixType, class VectorType, class EigenVectorsType>
+void ComputeSymmetric3x3EigenAnalysis(const MatrixType &matrix, VectorType &eigenValues, EigenVectorsType &eigenVectors);
+
 template <class T1> double ovlScore(vnl_diag_matrix <T1> &eigsX, vnl_matrix <T1> &eigVecsX,
                                     vnl_diag_matrix <T1> &eigsY, vnl_matrix <T1> &eigVecsY);
 
@@ -294,6 +294,234 @@ void RotateSymmetricMatrix(itk::Matrix <T1,NDim,NDim> &tensor, itk::Matrix <T2,N
     anima::RotateSymmetricMatrix(tensor,rotationMatrix,rotated_tensor,NDim);
 }
 
+template <class T1, class T2>
+void GetTensorRotationOperator(const vnl_matrix <T1> &rotationMatrix, vnl_matrix <T2> &rotationOperator, bool scale)
+{
+    unsigned int tensorDim = rotationMatrix.rows();
+    unsigned int vecDim = tensorDim * (tensorDim + 1) / 2;
+    rotationOperator.set_size(vecDim,vecDim);
+
+    double sqrt2 = std::sqrt(2.0);
+
+    unsigned int pos = 0;
+    for (unsigned int i = 0;i < tensorDim;++i)
+        for (unsigned int j = 0;j <= i;++j)
+        {
+            unsigned int inputPos = 0;
+            for (unsigned int a = 0;a < tensorDim;++a)
+                for (unsigned int b = 0;b <= a;++b)
+                {
+                    double factor = rotationMatrix(b,i) * rotationMatrix(a,j);
+                    if (b != a)
+                        factor += rotationMatrix(a,i) * rotationMatrix(b,j);
+
+                    if (scale)
+                    {
+                        if (i != j)
+                            factor *= sqrt2;
+
+                        if (a != b)
+                            factor /= sqrt2;
+                    }
+
+                    rotationOperator(pos,inputPos) = factor;
+                    ++inputPos;
+                }
+
+            ++pos;
+        }
+}
+
+template <class MatrixType, class VectorType, class EigenVectorsType>
+void
+ComputeSymmetric3x3EigenAnalysis(const MatrixType &matrix, VectorType &eigenValues, EigenVectorsType &eigenVectors)
+{
+    const unsigned int tensorDimension = 3;
+
+    // Work on a copy scaled to unit maximal coefficient to avoid over/underflows
+    double workMatrix[tensorDimension][tensorDimension];
+    double scale = 0;
+    for (unsigned int i = 0;i < tensorDimension;++i)
+        for (unsigned int j = 0;j < tensorDimension;++j)
+        {
+            workMatrix[i][j] = matrix(i,j);
+            scale = std::max(scale,std::abs(workMatrix[i][j]));
+        }
+
+    double values[tensorDimension];
+    double vectors[tensorDimension][tensorDimension];
+    for (unsigned int i = 0;i < tensorDimension;++i)
+    {
+        values[i] = 0;
+        for (unsigned int j = 0;j < tensorDimension;++j)
+            vectors[i][j] = (i == j);
+    }
+
+    if (scale > 0)
+    {
+        for (unsigned int i = 0;i < tensorDimension;++i)
+            for (unsigned int j = 0;j < tensorDimension;++j)
+                workMatrix[i][j] /= scale;
+
+        double meanDiagonal = (workMatrix[0][0] + workMatrix[1][1] + workMatrix[2][2]) / 3.0;
+        double offDiagonalNorm = workMatrix[0][1] * workMatrix[0][1] + workMatrix[0][2] * workMatrix[0][2] + workMatrix[1][2] * workMatrix[1][2];
+        double deviationNorm = 2.0 * offDiagonalNorm;
+        for (unsigned int i = 0;i < tensorDimension;++i)
+            deviationNorm += (workMatrix[i][i] - meanDiagonal) * (workMatrix[i][i] - meanDiagonal);
+
+        double p = std::sqrt(deviationNorm / 6.0);
+
+        for (unsigned int i = 0;i < tensorDimension;++i)
+            values[i] = meanDiagonal;
+
+        if (p > 1.0e-12)
+        {
+            // Trigonometric solution of the characteristic polynomial of (A - q I) / p
+            double b[tensorDimension][tensorDimension];
+            for (unsigned int i = 0;i < tensorDimension;++i)
+                for (unsigned int j = 0;j < tensorDimension;++j)
+                    b[i][j] = (workMatrix[i][j] - (i == j) * meanDiagonal) / p;
+
+            double halfDet = (b[0][0] * (b[1][1] * b[2][2] - b[1][2] * b[2][1])
+                    - b[0][1] * (b[1][0] * b[2][2] - b[1][2] * b[2][0])
+                    + b[0][2] * (b[1][0] * b[2][1] - b[1][1] * b[2][0])) / 2.0;
+
+            halfDet = std::min(1.0,std::max(-1.0,halfDet));
+            double phi = std::acos(halfDet) / 3.0;
+
+            double largestValue = meanDiagonal + 2.0 * p * std::cos(phi);
+            double smallestValue = meanDiagonal + 2.0 * p * std::cos(phi + 2.0 * M_PI / 3.0);
+            double middleValue = 3.0 * meanDiagonal - largestValue - smallestValue;
+
+            // Eigenvector of the most isolated eigenvalue: best conditioned cross product of rows of (A - lambda I)
+            double isolatedValue = smallestValue;
+            if (largestValue - middleValue >= middleValue - smallestValue)
+                isolatedValue = largestValue;
+
+            double rows[tensorDimension][tensorDimension];
+            for (unsigned int i = 0;i < tensorDimension;++i)
+                for (unsigned int j = 0;j < tensorDimension;++j)
+                    rows[i][j] = workMatrix[i][j] - (i == j) * isolatedValue;
+
+            double isolatedVector[tensorDimension];
+            double bestNorm = -1;
+            for (unsigned int i = 0;i < tensorDimension;++i)
+            {
+                unsigned int firstRow = (i + 1) % tensorDimension;
+                unsigned int secondRow = (i + 2) % tensorDimension;
+                double crossProduct[tensorDimension];
+                for (unsigned int j = 0;j < tensorDimension;++j)
+                {
+                    unsigned int j1 = (j + 1) % tensorDimension;
+                    unsigned int j2 = (j + 2) % tensorDimension;
+                    crossProduct[j] = rows[firstRow][j1] * rows[secondRow][j2] - rows[firstRow][j2] * rows[secondRow][j1];
+                }
+
+                double norm = crossProduct[0] * crossProduct[0] + crossProduct[1] * crossProduct[1] + crossProduct[2] * crossProduct[2];
+                if (norm > bestNorm)
+                {
+                    bestNorm = norm;
+                    std::copy(crossProduct,crossProduct + tensorDimension,isolatedVector);
+                }
+            }
+
+            bestNorm = std::sqrt(bestNorm);
+            if (bestNorm > 0)
+            {
+                for (unsigned int j = 0;j < tensorDimension;++j)
+                    isolatedVector[j] /= bestNorm;
+
+                // Orthonormal basis (u,w) of the orthogonal plane, where A reduces to a 2x2 symmetric matrix
+                unsigned int smallestAxis = 0;
+                for (unsigned int j = 1;j < tensorDimension;++j)
+                {
+                    if (std::abs(isolatedVector[j]) < std::abs(isolatedVector[smallestAxis]))
+                        smallestAxis = j;
+                }
+
+                double u[tensorDimension], w[tensorDimension];
+                double axis[tensorDimension] = {0,0,0};
+                axis[smallestAxis] = 1;
+                double norm = 0;
+                for (unsigned int j = 0;j < tensorDimension;++j)
+                {
+                    unsigned int j1 = (j + 1) % tensorDimension;
+                    unsigned int j2 = (j + 2) % tensorDimension;
+                    u[j] = isolatedVector[j1] * axis[j2] - isolatedVector[j2] * axis[j1];
+                    norm += u[j] * u[j];
+                }
+
+                norm = std::sqrt(norm);
+                for (unsigned int j = 0;j < tensorDimension;++j)
+                    u[j] /= norm;
+
+                for (unsigned int j = 0;j < tensorDimension;++j)
+                {
+                    unsigned int j1 = (j + 1) % tensorDimension;
+                    unsigned int j2 = (j + 2) % tensorDimension;
+                    w[j] = isolatedVector[j1] * u[j2] - isolatedVector[j2] * u[j1];
+                }
+
+                double Au[tensorDimension], Aw[tensorDimension];
+                double uAu = 0, uAw = 0, wAw = 0, vAv = 0;
+                for (unsigned int i = 0;i < tensorDimension;++i)
+                {
+                    Au[i] = 0;
+                    Aw[i] = 0;
+                    double Av = 0;
+                    for (unsigned int j = 0;j < tensorDimension;++j)
+                    {
+                        Au[i] += workMatrix[i][j] * u[j];
+                        Aw[i] += workMatrix[i][j] * w[j];
+                        Av += workMatrix[i][j] * isolatedVector[j];
+                    }
+
+                    uAu += u[i] * Au[i];
+                    uAw += u[i] * Aw[i];
+                    wAw += w[i] * Aw[i];
+                    vAv += isolatedVector[i] * Av;
+                }
+
+                double theta = 0.5 * std::atan2(2.0 * uAw, uAu - wAw);
+                double cosTheta = std::cos(theta);
+                double sinTheta = std::sin(theta);
+
+                values[0] = vAv;
+                values[1] = uAu * cosTheta * cosTheta + 2.0 * uAw * cosTheta * sinTheta + wAw * sinTheta * sinTheta;
+                values[2] = uAu * sinTheta * sinTheta - 2.0 * uAw * cosTheta * sinTheta + wAw * cosTheta * cosTheta;
+                for (unsigned int j = 0;j < tensorDimension;++j)
+                {
+                    vectors[0][j] = isolatedVector[j];
+                    vectors[1][j] = cosTheta * u[j] + sinTheta * w[j];
+                    vectors[2][j] = - sinTheta * u[j] + cosTheta * w[j];
+                }
+
+                // Sort by ascending eigenvalues, as itk::SymmetricEigenAnalysis does
+                for (unsigned int i = 0;i < tensorDimension - 1;++i)
+                    for (unsigned int j = i + 1;j < tensorDimension;++j)
+                    {
+                        if (values[j] < values[i])
+                        {
+                            std::swap(values[i],values[j]);
+                            for (unsigned int k = 0;k < tensorDimension;++k)
+                                std::swap(vectors[i][k],vectors[j][k]);
+                        }
+                    }
+            }
+        }
+
+        for (unsigned int i = 0;i < tensorDimension;++i)
+            values[i] *= scale;
+    }
+
+    for (unsigned int i = 0;i < tensorDimension;++i)
+    {
+        eigenValues[i] = values[i];
+        for (unsigned int j = 0;j < tensorDimension;++j)
+            eigenVectors(i,j) = vectors[i][j];
+    }
+}
+
 template <class T1>
 double
 ovlScore(vnl_diag_matrix <T1> &eigsX, vnl_matrix <T1> &eigVecsX,
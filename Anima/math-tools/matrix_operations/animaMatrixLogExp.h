@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <vnl/vnl_matrix.h>
+#include <vnl/vnl_matrix_fixed.h>
 #include <math.h>
 
 #include <itkTransform.h>
@@ -16,7 +17,7 @@ namespace anima
 template <class T> vnl_matrix <T> GetSquareRoot(const vnl_matrix <T> & m, const double precision, vnl_matrix <T> & resultM);
 
 //! Final part of the computation of the log. Estimates the log with a Pade approximation for a matrix m such that \|m-Id\| <= 0.5.
-template <class T> vnl_matrix <T> GetPadeLogarithm(const vnl_matrix <double> & m,const int numApprox);
+template <class T> vnl_matrix <T> GetPadeLogarithm(const vnl_matrix <T> & m,const int numApprox);
 
 //! Computation of the matrix logarithm. Algo: inverse scaling and squaring, variant proposed by Cheng et al., SIAM Matrix Anal., 2001.
 template <class T> vnl_matrix <T> GetLogarithm(const vnl_matrix <T> & m, const double precision=0.00000000001, const int numApprox=1);
@@ -24,6 +25,48 @@ template <class T> vnl_matrix <T> GetLogarithm(const vnl_matrix <T> & m, const d
 //! Computation of the matrix exponential. Algo: classical scaling and squaring, as in Matlab. See Higham, SIAM Matr. Anal., 2004.
 template <class T> vnl_matrix <T> GetExponential(const vnl_matrix <T> & m, const int numApprox=1);
 
+/* Fixed size versions of the above, for small matrices (e.g. homogeneous 4x4 transforms): same implementation, with all
+ * temporaries on the stack and closed form determinants and inverses. */
+
+//! Gets the square root of matrix m (Denman-Beavers iterations), fixed size version
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetSquareRoot(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m, const double precision,
+                                                           vnl_matrix_fixed <T,NDimensions,NDimensions> & resultM);
+
+//! Pade approximation of the logarithm for a matrix such that \|m-Id\| <= 0.5, fixed size version
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetPadeLogarithm(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m, const int numApprox);
+
+//! Matrix logarithm by inverse scaling and squaring, fixed size version
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetLogarithm(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m,
+                                                          const double precision=0.00000000001, const int numApprox=1);
+
+//! Matrix exponential by scaling and squaring, fixed size version
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetExponential(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m, const int numApprox=1);
+
+/**
+ * Closed form logarithm of a 3D rigid transform given as a 4x4 homogeneous matrix (Rodrigues formula for the rotation,
+ * inverse of the left Jacobian of SO(3) for the translation). Falls back on GetLogarithm for other sizes.
+ */
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetRigidLogarithm(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m);
+
+//! Closed form exponential of a 4x4 homogeneous rigid transform logarithm. Falls back on GetExponential for other sizes.
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetRigidExponential(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m);
+
+//! Batched logarithms, rigid closed forms are used if useRigidTransforms is true
+template <class T, unsigned int NDimensions>
+void GetLogarithm(const std::vector < vnl_matrix_fixed <T,NDimensions,NDimensions> > & matrices,
+                  std::vector < vnl_matrix_fixed <T,NDimensions,NDimensions> > & logMatrices, bool useRigidTransforms = false);
+
+//! Batched exponentials, rigid closed forms are used if useRigidTransforms is true
+template <class T, unsigned int NDimensions>
+void GetExponential(const std::vector < vnl_matrix_fixed <T,NDimensions,NDimensions> > & logMatrices,
+                    std::vector < vnl_matrix_fixed <T,NDimensions,NDimensions> > & matrices, bool useRigidTransforms = false);
+
 //! Class to compute many log-vectors in a multi-threaded way
 template <class TInputScalarType, class TOutputScalarType, unsigned int NDimensions, unsigned int NDegreesOfFreedom>
 class MatrixLoggerFilter
@@ -1,120 +1,221 @@
 #pragma once
 
 #include "animaMatrixLogExp.h"
-#include <iostream>
+#include <cmath>
 #include <vnl/algo/vnl_determinant.h>
 #include <vnl/algo/vnl_real_eigensystem.h>
 #include <vnl/algo/vnl_matrix_inverse.h>
 #include <vnl/vnl_inverse.h>
+#include <vnl/vnl_det.h>
+#include <vnl/vnl_vector_fixed.h>
+#include <vnl/vnl_cross.h>
 
 namespace anima
 {
-template <class T> vnl_matrix <T> GetSquareRoot(const vnl_matrix <T> & m, const double precision, vnl_matrix <T> & resultM)
+/* Shared implementations, templated on the matrix type (vnl_matrix or vnl_matrix_fixed). Only determinants and
+ * inverses differ: closed forms are used for fixed size matrices, generic algorithms otherwise. */
+
+template <class T> T GetMatrixDeterminant(const vnl_matrix <T> & m)
 {
-    // declarations
+    return vnl_determinant(m);
+}
 
-    double energy;
-    unsigned int D = m.rows();
+template <class T, unsigned int NDimensions> T GetMatrixDeterminant(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m)
+{
+    return vnl_det(m);
+}
 
-    vnl_matrix <T> Mk1(D,D), Mk(D,D), Yk1(D,D), Yk(D,D), interm(D,D), invMk(D,D), Id(D,D);
-    int niter=1;
-    int niterMax=60;
+template <class T> vnl_matrix <T> GetMatrixInverse(const vnl_matrix <T> & m)
+{
+    vnl_matrix_inverse <T> inverter(m);
+    return inverter.inverse();
+}
 
-    // initializations
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetMatrixInverse(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m)
+{
+    return vnl_inverse(m);
+}
 
-    Mk=m; Yk=m; Id=m;
+template <class TMatrixType> TMatrixType ComputeSquareRoot(const TMatrixType & m, const double precision, TMatrixType & resultM)
+{
+    typedef typename TMatrixType::element_type T;
+
+    TMatrixType Mk = m, Yk = m, Mk1 = m, invMk = m, interm = m, Id = m;
     Id.set_identity();
 
-    interm=Yk*Yk-m;
-    energy=interm.frobenius_norm();
+    unsigned int niter = 0;
+    unsigned int niterMax = 60;
 
-    //T n = m.Norm();
-    T n = D;
+    interm = Yk * Yk - m;
+    double energy = interm.frobenius_norm();
 
-    // loop
+    T n = m.rows();
 
-    while( (niter <= niterMax) && (energy > precision) )
+    // Denman-Beavers iterations
+    while ((niter < niterMax) && (energy > precision))
     {
-        T gamma=(T)fabs(pow(vnl_determinant(Mk),-1.0/(2.0*n)));
-        vnl_matrix_inverse <T> inverter(Mk);
-        invMk= inverter.inverse();
-        Mk1=(Id+ (Mk*(gamma*gamma)+invMk*(1./(gamma*gamma))  )*0.5  )*0.5;
-        Yk1=Yk*(Id+invMk*(1./(gamma*gamma)) )*0.5*gamma;
-
-        Yk=Yk1; Mk = Mk1;
-
-        niter++;
+        T gamma = (T)fabs(pow(GetMatrixDeterminant(Mk),-1.0/(2.0*n)));
+        invMk = GetMatrixInverse(Mk);
+        Mk1 = (Id + (Mk * (gamma * gamma) + invMk * (1.0 / (gamma * gamma))) * 0.5) * 0.5;
+        Yk = Yk * (Id + invMk * (1.0 / (gamma * gamma))) * (0.5 * gamma);
+        Mk = Mk1;
 
-        interm=Yk*Yk-m;
-        energy=interm.frobenius_norm();
-    }
+        ++niter;
 
-    if (niter == niterMax)
-    {
-        std::cout <<"\nWarning, max number of iteration reached in sqrt computation. Final energy is:" << energy << ".\n";
+        interm = Yk * Yk - m;
+        energy = interm.frobenius_norm();
     }
 
-    // std::cout << "niter="<<niter<<".\n";
-
-    resultM=Mk;
+    resultM = Mk;
 
     return Yk;
 }
 
-template <class T> vnl_matrix <T> GetPadeLogarithm(const vnl_matrix <T> & m,const int numApprox)
+template <class TMatrixType> TMatrixType ComputePadeLogarithm(const TMatrixType & m, const int numApprox)
 {
-    unsigned int D = m.rows();
+    typedef typename TMatrixType::element_type T;
 
-    vnl_matrix <T> log=m;
-    vnl_matrix <T> Id(D,D);
+    TMatrixType Id = m, diff = m, interm2 = m, interm3 = m, sqr = m, cube = m;
     Id.set_identity();
-    vnl_matrix <T> diff(D,D),interm2(D,D),interm3(D,D),sqr(D,D),cube(D,D);
 
-    diff=Id-m;
-    T energy=diff.frobenius_norm();
+    diff = Id - m;
+    T energy = diff.frobenius_norm();
 
+    // Matrix not close enough to Id for the Pade approximation, returning the original matrix
     if (energy > 0.5)
-    {
-        std::cout <<"Warning, matrix is not close enough to Id to call Pade approximation. Frobenius Distance=" << energy <<". Returning original matrix.\n";
-        return log;
-    }
+        return m;
 
     switch (numApprox)
     {
-
         case 1:
-            interm2=diff*(-1.);
-            interm3=(Id-diff*0.5);
+            interm2 = diff * (-1.0);
+            interm3 = Id - diff * 0.5;
             break;
 
         case 2:
-            sqr=diff*diff;
+            sqr = diff * diff;
 
-            interm2=diff*(-1.0)+sqr*(0.5);
-            interm3=(Id-diff+sqr);
+            interm2 = diff * (-1.0) + sqr * 0.5;
+            interm3 = Id - diff + sqr * (1.0 / 6.0);
             break;
 
         case 3:
-            sqr=diff*diff;
-            cube=sqr*diff;
+        default:
+            sqr = diff * diff;
+            cube = sqr * diff;
+
+            interm2 = diff * (-1.0) + sqr - cube * (11.0 / 60.0);
+            interm3 = Id - diff * 1.5 + sqr * 0.6 + cube * (-0.05);
+            break;
+    }
+
+    return interm2 * GetMatrixInverse(interm3);
+}
+
+template <class TMatrixType> TMatrixType ComputeLogarithm(const TMatrixType & m, const double precision, const int numApprox)
+{
+    typedef typename TMatrixType::element_type T;
+
+    T factor = 1.0;
+    TMatrixType Id = m, Yi = m, Yi1 = m, resultM = m, matrixSum = m, logMatrix = m;
+    Id.set_identity();
+    matrixSum.fill(0);
+
+    unsigned int niterMax = 60;
+    unsigned int niter = 0;
+
+    T energy = (Yi - Id).frobenius_norm();
+
+    // Inverse scaling: square roots until close enough to Id
+    while ((energy > 0.5) && (niter < niterMax))
+    {
+        Yi1 = ComputeSquareRoot(Yi,precision,resultM);
+
+        if ((!std::isfinite(resultM(0,0))) || (!std::isfinite(Yi1(0,0))))
+        {
+            logMatrix.fill(0);
+            return logMatrix;
+        }
+
+        matrixSum += (Id - resultM) * factor;
+
+        Yi = Yi1;
+        energy = (Yi - Id).frobenius_norm();
+
+        factor *= 2.0;
+        ++niter;
+    }
+
+    logMatrix = ComputePadeLogarithm(Yi,numApprox);
+    if (!std::isfinite(logMatrix(0,0)))
+    {
+        logMatrix.fill(0);
+        return logMatrix;
+    }
+
+    return logMatrix * factor + matrixSum;
+}
+
+template <class TMatrixType> TMatrixType ComputeExponential(const TMatrixType & m, const int numApprox)
+{
+    typedef typename TMatrixType::element_type T;
+
+    TMatrixType Id = m, interm = m, interm2 = m, interm3 = m, sqr = m, cube = m;
+    Id.set_identity();
 
-            interm2=diff*(-1.0)+sqr+cube*(11.0/60.0);
-            interm3=(Id-diff*(1.5)+sqr*0.6+cube*(-0.05));
+    T norm = m.frobenius_norm();
+    int k = 0;
+
+    if (norm > 1)
+        k = 1 + (int) std::ceil(std::log(norm) / std::log(2.0));
+    else if (norm > 0.5)
+        k = 1;
+
+    T factor = std::pow(2.0,(double) k);
+    interm = m / factor;
+
+    switch (numApprox)
+    {
+        case 1:
+            interm2 = Id + interm * 0.5;
+            interm3 = Id - interm * 0.5;
             break;
 
+        case 2:
+            sqr = interm * interm;
+
+            interm2 = Id + interm * 0.5 + sqr * (1.0 / 12.0);
+            interm3 = Id - interm * 0.5 + sqr * (1.0 / 12.0);
+            break;
 
+        case 3:
         default:
-            sqr=diff*diff;
-            cube=sqr*diff;
-            std::cout <<"\n\ndefault is taken in log Pade\n\n";
-            interm2=diff*(-1.0)+sqr+cube*(11.0/60.0);
-            interm3=(Id-diff*(1.5)+sqr*0.6+cube*(-0.05));
+            sqr = interm * interm;
+            cube = sqr * interm;
+
+            interm2 = Id + interm * 0.5 + sqr * (1.0 / 10.0) + cube * (1.0 / 120.0);
+            interm3 = Id - interm * 0.5 + sqr * (1.0 / 10.0) - cube * (1.0 / 120.0);
             break;
     }
 
-    log=interm2 * vnl_inverse(interm3);
+    interm = interm2 * GetMatrixInverse(interm3);
+
+    // Squaring
+    for (int i = 1;i <= k;++i)
+        interm *= interm;
 
-    return log;
+    return interm;
+}
+
+template <class T> vnl_matrix <T> GetSquareRoot(const vnl_matrix <T> & m, const double precision, vnl_matrix <T> & resultM)
+{
+    return ComputeSquareRoot(m,precision,resultM);
+}
+
+template <class T> vnl_matrix <T> GetPadeLogarithm(const vnl_matrix <T> & m,const int numApprox)
+{
+    return ComputePadeLogarithm(m,numApprox);
 }
 
 /*
@@ -143,129 +244,214 @@ template <class T> vnl_matrix <T> GetLogarithm(const vnl_matrix <T> & m, const d
 
 template <class T> vnl_matrix <T> GetLogarithm(const vnl_matrix <T> & m, const double precision, const int numApprox)
 {
-    unsigned int D = m.rows();
-    //typedef double T;
+    return ComputeLogarithm(m,precision,numApprox);
+}
 
-    T factor=1.0;
-    vnl_matrix <double> log=m;
-    T energy;
-    vnl_matrix <double> Id(D,D);
-    Id.set_identity();
-    vnl_matrix <double> interm(D,D),Yi(D,D),Yi1(D,D),resultM(D,D);
-    vnl_matrix <double> matrix_sum=m;
+template <class T> vnl_matrix <T> GetExponential(const vnl_matrix <T> & m, const int numApprox)
+{
+    return ComputeExponential(m,numApprox);
+}
 
-    int niterMax=60; int niter=1;
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetSquareRoot(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m, const double precision,
+                                                           vnl_matrix_fixed <T,NDimensions,NDimensions> & resultM)
+{
+    return ComputeSquareRoot(m,precision,resultM);
+}
 
-    Yi=m;
-    interm=Yi-Id;
-    energy=interm.frobenius_norm();
-    matrix_sum.fill(0);
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetPadeLogarithm(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m, const int numApprox)
+{
+    return ComputePadeLogarithm(m,numApprox);
+}
 
-    while ( (energy > 0.5) && (niter <= niterMax))
-    {
-        // std::cout <<"\nniter=" << niter <<", energy="<<energy<<".\n";
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetLogarithm(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m,
+                                                          const double precision, const int numApprox)
+{
+    return ComputeLogarithm(m,precision,numApprox);
+}
 
-        Yi1=GetSquareRoot(Yi,precision,resultM);
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetExponential(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m, const int numApprox)
+{
+    return ComputeExponential(m,numApprox);
+}
+
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetRigidLogarithm(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m)
+{
+    typedef vnl_matrix_fixed <T,NDimensions,NDimensions> MatrixType;
+
+    if (NDimensions != 4)
+        return GetLogarithm(m);
 
-        if ((!std::isfinite(resultM(0,0))) || (!std::isfinite(Yi(0,0))))
+    // Rotation angle and axis: R - R^T = 2 sin(theta) [k]_x, the angle is obtained from both sine and cosine for accuracy
+    vnl_vector_fixed <double,3> antiSymVector;
+    antiSymVector[0] = m(2,1) - m(1,2);
+    antiSymVector[1] = m(0,2) - m(2,0);
+    antiSymVector[2] = m(1,0) - m(0,1);
+
+    double cosTheta = std::max(-1.0,std::min(1.0,(m(0,0) + m(1,1) + m(2,2) - 1.0) / 2.0));
+    double sinTheta = antiSymVector.magnitude() / 2.0;
+    double theta = std::atan2(sinTheta,cosTheta);
+    double thetaSq = theta * theta;
+
+    vnl_vector_fixed <double,3> rotationVector;
+    if (cosTheta > -0.9)
+    {
+        // theta / sin(theta), with its Taylor expansion near 0
+        double thetaRatio = (theta < 1.0e-2) ? 1.0 + thetaSq / 6.0 + 7.0 * thetaSq * thetaSq / 360.0 : theta / sinTheta;
+        rotationVector = antiSymVector * (0.5 * thetaRatio);
+    }
+    else
+    {
+        // Close to pi, the axis is obtained from the symmetric part: (R + R^T) / 2 - cos(theta) Id = (1 - cos(theta)) k k^T
+        unsigned int maxIndex = 0;
+        for (unsigned int i = 1;i < 3;++i)
         {
-            log.fill(0);
-            return log;
+            if (m(i,i) > m(maxIndex,maxIndex))
+                maxIndex = i;
         }
 
-        matrix_sum+= (Id-resultM)*factor;
+        double oneMinusCos = 1.0 - cosTheta;
+        double axisMaxValue = std::sqrt(std::max(0.0,(m(maxIndex,maxIndex) - cosTheta) / oneMinusCos));
 
-        Yi=Yi1;
-        interm=Yi-Id;
-        energy=interm.frobenius_norm();
+        vnl_vector_fixed <double,3> axis;
+        for (unsigned int i = 0;i < 3;++i)
+        {
+            if (i == maxIndex)
+                axis[i] = axisMaxValue;
+            else
+                axis[i] = (m(i,maxIndex) + m(maxIndex,i)) / (2.0 * oneMinusCos * axisMaxValue);
+        }
 
-        factor*=2.0;
-        niter++;
-    }
+        if (dot_product(axis,antiSymVector) < 0)
+            axis *= -1.0;
 
-    log=GetPadeLogarithm(Yi,numApprox);
-    if (!std::isfinite(log(0,0)))
-    {
-        log.fill(0);
-        return log;
+        rotationVector = axis * theta;
     }
 
-    return log*factor+matrix_sum;
-}
+    MatrixType logMatrix;
+    logMatrix.fill(0);
 
+    logMatrix(0,1) = - rotationVector[2];
+    logMatrix(0,2) = rotationVector[1];
+    logMatrix(1,2) = - rotationVector[0];
+    logMatrix(1,0) = rotationVector[2];
+    logMatrix(2,0) = - rotationVector[1];
+    logMatrix(2,1) = rotationVector[0];
 
-template <class T> vnl_matrix <T> GetExponential(const vnl_matrix <T> & m, const int numApprox)
+    // Translation log: V^-1 t, with V^-1 = Id - W / 2 + c W^2, W being the rotation log
+    // Half angle form of c = (1 - theta sin(theta) / (2 (1 - cos(theta)))) / theta^2, avoiding cancellation in 1 - cos(theta)
+    double cFactor = (theta < 1.0e-2) ? 1.0 / 12.0 + thetaSq / 720.0 + thetaSq * thetaSq / 30240.0 :
+                                        (1.0 - (theta / 2.0) / std::tan(theta / 2.0)) / thetaSq;
+
+    vnl_vector_fixed <double,3> translation, crossTranslation, doubleCrossTranslation;
+    for (unsigned int i = 0;i < 3;++i)
+        translation[i] = m(i,3);
+
+    crossTranslation = vnl_cross_3d(rotationVector,translation);
+    doubleCrossTranslation = vnl_cross_3d(rotationVector,crossTranslation);
+
+    for (unsigned int i = 0;i < 3;++i)
+        logMatrix(i,3) = translation[i] - 0.5 * crossTranslation[i] + cFactor * doubleCrossTranslation[i];
+
+    return logMatrix;
+}
+
+template <class T, unsigned int NDimensions>
+vnl_matrix_fixed <T,NDimensions,NDimensions> GetRigidExponential(const vnl_matrix_fixed <T,NDimensions,NDimensions> & m)
 {
-    unsigned int D = m.rows();
+    typedef vnl_matrix_fixed <T,NDimensions,NDimensions> MatrixType;
 
-    T factor;
-    vnl_matrix <T> exp=m;
-    vnl_matrix <T> Id(D,D); Id.set_identity();
-    vnl_matrix <T> interm(D,D),interm2(D,D),interm3(D,D),sqr(D,D),cube(D,D);
+    if (NDimensions != 4)
+        return GetExponential(m);
 
-    T norm=m.frobenius_norm();
-    int k;
+    vnl_vector_fixed <double,3> rotationVector;
+    rotationVector[0] = (m(2,1) - m(1,2)) / 2.0;
+    rotationVector[1] = (m(0,2) - m(2,0)) / 2.0;
+    rotationVector[2] = (m(1,0) - m(0,1)) / 2.0;
 
-    if(norm > 1)
-    {
-        k=1 + (int) ceil(log(m.frobenius_norm())/log(2.0));
-    }
-    else if(norm >0.5)
+    double thetaSq = rotationVector.squared_magnitude();
+    double theta = std::sqrt(thetaSq);
+
+    // Rodrigues coefficients and their Taylor expansions near 0
+    double aFactor, bFactor, cFactor;
+    if (theta < 1.0e-2)
     {
-        k=1;
+        aFactor = 1.0 - thetaSq / 6.0 + thetaSq * thetaSq / 120.0;
+        bFactor = 0.5 - thetaSq / 24.0 + thetaSq * thetaSq / 720.0;
+        cFactor = 1.0 / 6.0 - thetaSq / 120.0 + thetaSq * thetaSq / 5040.0;
     }
     else
     {
-        k=0;
+        double halfSine = std::sin(theta / 2.0);
+        aFactor = std::sin(theta) / theta;
+        bFactor = 2.0 * halfSine * halfSine / thetaSq;
+        cFactor = (theta - std::sin(theta)) / (thetaSq * theta);
     }
 
-    //std::cout << "\n The famous k=" << ceil(log(m.GetVnlMatrix().frobenius_norm())/log(2.0)) << ". In effect norm=" << m.GetVnlMatrix().frobenius_norm()<< ".\n";
-
-    factor=pow(2.0,(double) k);
-    interm=m/factor;
+    MatrixType expMatrix;
+    expMatrix.set_identity();
 
-
-    switch(numApprox)
+    vnl_vector_fixed <double,3> unitVector, crossVector, doubleCrossVector;
+    for (unsigned int j = 0;j < 3;++j)
     {
-        case 1:
-            interm2=Id+interm*0.5;
-            interm3=Id-interm*0.5;
-            break;
-
-        case 2:
-            sqr=interm*interm;
+        // Columns of R = Id + a W + b W^2
+        unitVector.fill(0);
+        unitVector[j] = 1.0;
+        crossVector = vnl_cross_3d(rotationVector,unitVector);
+        doubleCrossVector = vnl_cross_3d(rotationVector,crossVector);
+
+        for (unsigned int i = 0;i < 3;++i)
+            expMatrix(i,j) += aFactor * crossVector[i] + bFactor * doubleCrossVector[i];
+    }
 
-            interm2=Id+interm*0.5+sqr*(1.0/12.0);
-            interm3=Id-interm*0.5+sqr*(1.0/12.0);
-            break;
+    vnl_vector_fixed <double,3> translation;
+    for (unsigned int i = 0;i < 3;++i)
+        translation[i] = m(i,3);
 
-        case 3:
-            sqr=interm*interm;
-            cube=sqr*interm;
+    crossVector = vnl_cross_3d(rotationVector,translation);
+    doubleCrossVector = vnl_cross_3d(rotationVector,crossVector);
 
-            interm2=Id+interm*0.5+sqr*(1.0/10.0)+cube*(1.0/120.0);
-            interm3=Id-interm*0.5+sqr*(1.0/10.0)-cube*(1.0/120.0);;
-            break;
+    // Translation: V u, with V = Id + b W + c W^2
+    for (unsigned int i = 0;i < 3;++i)
+        expMatrix(i,3) = translation[i] + bFactor * crossVector[i] + cFactor * doubleCrossVector[i];
 
-        default:
-            std::cout <<"\n\ndefault is taken in exp Pade\n\n";
+    return expMatrix;
+}
 
-            sqr=interm*interm;
-            cube=sqr*interm;
+template <class T, unsigned int NDimensions>
+void GetLogarithm(const std::vector < vnl_matrix_fixed <T,NDimensions,NDimensions> > & matrices,
+                  std::vector < vnl_matrix_fixed <T,NDimensions,NDimensions> > & logMatrices, bool useRigidTransforms)
+{
+    unsigned int numMatrices = matrices.size();
+    logMatrices.resize(numMatrices);
 
-            interm2=Id+interm*0.5+sqr*(1.0/10.0)+cube*(1.0/120.0);
-            interm3=Id-interm*0.5+sqr*(1.0/10.0)-cube*(1.0/120.0);;
-            break;
+    for (unsigned int i = 0;i < numMatrices;++i)
+    {
+        if (useRigidTransforms)
+            logMatrices[i] = GetRigidLogarithm(matrices[i]);
+        else
+            logMatrices[i] = GetLogarithm(matrices[i]);
     }
+}
 
-    interm=interm2 * vnl_inverse(interm3);
-
-    for(int i=1;i<=k;i++)
-        interm*=interm;
-
-    exp=interm;
+template <class T, unsigned int NDimensions>
+void GetExponential(const std::vector < vnl_matrix_fixed <T,NDimensions,NDimensions> > & logMatrices,
+                    std::vector < vnl_matrix_fixed <T,NDimensions,NDimensions> > & matrices, bool useRigidTransforms)
+{
+    unsigned int numMatrices = logMatrices.size();
+    matrices.resize(numMatrices);
 
-    return exp;
+    for (unsigned int i = 0;i < numMatrices;++i)
+    {
+        if (useRigidTransforms)
+            matrices[i] = GetRigidExponential(logMatrices[i]);
+        else
+            matrices[i] = GetExponential(logMatrices[i]);
+    }
 }
 
 // Multi-threaded matrix logger
@@ -327,7 +513,8 @@ InternalLogger(unsigned int threadId, unsigned int numThreads)
 
     typename BaseInputMatrixTransformType::MatrixType affinePart;
     itk::Vector <TInputScalarType,NDimensions> offsetPart;
-    vnl_matrix <TInputScalarType> tmpMatrix(NDimensions+1,NDimensions+1,0), logMatrix(NDimensions+1,NDimensions+1,0);
+    vnl_matrix_fixed <TInputScalarType,NDimensions+1,NDimensions+1> tmpMatrix, logMatrix;
+    tmpMatrix.fill(0);
     tmpMatrix(NDimensions,NDimensions) = 1;
 
     for (unsigned int i = startTrsf; i < endTrsf; ++i)
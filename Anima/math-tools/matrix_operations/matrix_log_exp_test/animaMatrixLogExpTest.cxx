@@ -0,0 +1,193 @@
+#include <animaMatrixLogExp.h>
+
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_matrix_fixed.h>
+#include <vnl/vnl_det.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/* Accuracy tests of the fixed size and rigid closed form matrix log / exp against the generic vnl_matrix versions,
+ * on random homogeneous 4x4 rigid and affine transforms (fixed seed). */
+
+typedef vnl_matrix <double> MatrixType;
+typedef vnl_matrix_fixed <double,4,4> FixedMatrixType;
+
+double MaximumDifference(const MatrixType &first, const MatrixType &second)
+{
+    double maxDiff = 0;
+    for (unsigned int i = 0;i < first.rows();++i)
+    {
+        for (unsigned int j = 0;j < first.cols();++j)
+            maxDiff = std::max(maxDiff,std::abs(first(i,j) - second(i,j)));
+    }
+
+    return maxDiff;
+}
+
+bool CheckDifference(const std::string &testName, const MatrixType &first, const MatrixType &second,
+                     double tolerance, double &worstDifference)
+{
+    double diff = MaximumDifference(first,second);
+    worstDifference = std::max(worstDifference,diff);
+
+    if ((diff <= tolerance) && std::isfinite(diff))
+        return true;
+
+    std::cerr << testName << ": difference " << diff << " above tolerance " << tolerance << std::endl;
+    return false;
+}
+
+//! Homogeneous rigid transform from a rotation angle, a unit axis and a translation
+FixedMatrixType ComputeRigidMatrix(double angle, const double *axis, const double *translation)
+{
+    FixedMatrixType rigidMatrix;
+    rigidMatrix.set_identity();
+
+    double cosAngle = std::cos(angle);
+    double sinAngle = std::sin(angle);
+
+    for (unsigned int i = 0;i < 3;++i)
+    {
+        for (unsigned int j = 0;j < 3;++j)
+            rigidMatrix(i,j) = (1.0 - cosAngle) * axis[i] * axis[j] + ((i == j) ? cosAngle : 0.0);
+
+        rigidMatrix(i,3) = translation[i];
+    }
+
+    rigidMatrix(0,1) -= sinAngle * axis[2];
+    rigidMatrix(1,0) += sinAngle * axis[2];
+    rigidMatrix(0,2) += sinAngle * axis[1];
+    rigidMatrix(2,0) -= sinAngle * axis[1];
+    rigidMatrix(1,2) -= sinAngle * axis[0];
+    rigidMatrix(2,1) += sinAngle * axis[0];
+
+    return rigidMatrix;
+}
+
+FixedMatrixType SampleRigidMatrix(double angle, std::mt19937 &generator)
+{
+    std::normal_distribution <double> normalDistribution(0.0,1.0);
+    std::uniform_real_distribution <double> translationDistribution(-20.0,20.0);
+
+    double axis[3], translation[3];
+    double axisNorm = 0;
+    for (unsigned int i = 0;i < 3;++i)
+    {
+        axis[i] = normalDistribution(generator);
+        axisNorm += axis[i] * axis[i];
+        translation[i] = translationDistribution(generator);
+    }
+
+    axisNorm = std::sqrt(axisNorm);
+    for (unsigned int i = 0;i < 3;++i)
+        axis[i] /= axisNorm;
+
+    return ComputeRigidMatrix(angle,axis,translation);
+}
+
+int main()
+{
+    const unsigned int numRandomSamples = 500;
+
+    // Closed form rigid log / exp are exact, generic ones are Pade approximations after (inverse) scaling and squaring
+    const double rigidRoundTripTolerance = 1.0e-10;
+    const double rigidLogarithmTolerance = 1.0e-6;
+    const double rigidExponentialTolerance = 1.0e-8;
+    // Fixed size and generic versions run the same algorithm, only inverses and determinants differ
+    const double fixedSizeTolerance = 1.0e-8;
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution <double> angleDistribution(0.0,M_PI - 1.0e-2);
+    std::uniform_real_distribution <double> perturbationDistribution(-0.3,0.3);
+
+    // Rotation angles near 0 and pi test the Taylor expansions and the symmetric part axis estimate
+    std::vector <double> angles;
+    angles.push_back(0.0);
+    angles.push_back(1.0e-8);
+    angles.push_back(1.0e-4);
+    angles.push_back(5.0e-3);
+    angles.push_back(1.5e-2);
+    angles.push_back(M_PI / 2.0);
+    angles.push_back(2.9);
+    angles.push_back(M_PI - 1.0e-2);
+    angles.push_back(M_PI - 1.0e-4);
+    for (unsigned int i = 0;i < numRandomSamples;++i)
+        angles.push_back(angleDistribution(generator));
+
+    unsigned int numFailures = 0;
+    double worstRoundTrip = 0, worstRigidLog = 0, worstRigidExp = 0;
+
+    for (unsigned int i = 0;i < angles.size();++i)
+    {
+        FixedMatrixType rigidMatrix = SampleRigidMatrix(angles[i],generator);
+        FixedMatrixType rigidLog = anima::GetRigidLogarithm(rigidMatrix);
+        FixedMatrixType rigidExp = anima::GetRigidExponential(rigidLog);
+
+        if (!CheckDifference("Rigid exp(log(M)) = M",rigidExp.as_ref(),rigidMatrix.as_ref(),rigidRoundTripTolerance,worstRoundTrip))
+            ++numFailures;
+
+        MatrixType genericMatrix = rigidMatrix.as_ref();
+        MatrixType genericLog = anima::GetLogarithm(genericMatrix,0.00000000001,3);
+        if (!CheckDifference("Rigid logarithm",rigidLog.as_ref(),genericLog,rigidLogarithmTolerance,worstRigidLog))
+            ++numFailures;
+
+        MatrixType genericRigidLog = rigidLog.as_ref();
+        MatrixType genericExp = anima::GetExponential(genericRigidLog,3);
+        if (!CheckDifference("Rigid exponential",rigidExp.as_ref(),genericExp,rigidExponentialTolerance,worstRigidExp))
+            ++numFailures;
+    }
+
+    double worstFixedLog = 0, worstFixedExp = 0, worstFixedSqrt = 0;
+
+    for (unsigned int i = 0;i < numRandomSamples;++i)
+    {
+        // Affine transform: rigid part times a random perturbation of the identity
+        FixedMatrixType linearPart;
+        linearPart.set_identity();
+        for (unsigned int j = 0;j < 3;++j)
+        {
+            for (unsigned int k = 0;k < 3;++k)
+                linearPart(j,k) += perturbationDistribution(generator);
+        }
+
+        FixedMatrixType affineMatrix = SampleRigidMatrix(angleDistribution(generator),generator) * linearPart;
+        MatrixType genericMatrix = affineMatrix.as_ref();
+
+        if (vnl_det(affineMatrix) <= 0)
+            continue;
+
+        FixedMatrixType fixedLog = anima::GetLogarithm(affineMatrix);
+        MatrixType genericLog = anima::GetLogarithm(genericMatrix);
+        if (!CheckDifference("Fixed size logarithm",fixedLog.as_ref(),genericLog,fixedSizeTolerance,worstFixedLog))
+            ++numFailures;
+
+        FixedMatrixType fixedExp = anima::GetExponential(fixedLog);
+        MatrixType genericExp = anima::GetExponential(genericLog);
+        if (!CheckDifference("Fixed size exponential",fixedExp.as_ref(),genericExp,fixedSizeTolerance,worstFixedExp))
+            ++numFailures;
+
+        FixedMatrixType fixedResult;
+        MatrixType genericResult;
+        FixedMatrixType fixedSqrt = anima::GetSquareRoot(affineMatrix,0.00000000001,fixedResult);
+        MatrixType genericSqrt = anima::GetSquareRoot(genericMatrix,0.00000000001,genericResult);
+        if (!CheckDifference("Fixed size square root",fixedSqrt.as_ref(),genericSqrt,fixedSizeTolerance,worstFixedSqrt))
+            ++numFailures;
+    }
+
+    std::cout << "Worst differences: rigid roundtrip " << worstRoundTrip << ", rigid log " << worstRigidLog
+              << ", rigid exp " << worstRigidExp << ", fixed log " << worstFixedLog << ", fixed exp " << worstFixedExp
+              << ", fixed sqrt " << worstFixedSqrt << std::endl;
+
+    if (numFailures != 0)
+    {
+        std::cerr << numFailures << " checks failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
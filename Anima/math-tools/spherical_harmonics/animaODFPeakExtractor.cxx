@@ -0,0 +1,91 @@
+#include "animaODFPeakExtractor.h"
+
+#include <cmath>
+
+namespace anima
+{
+
+ODFPeakExtractor::ODFPeakExtractor()
+{
+    m_LOrder = 4;
+    m_NumberOfSphereSamples = 1000;
+    m_MaximalNumberOfPeaks = 3;
+    m_MinimalPeakRatio = 0.1;
+    m_MinimalSeparationAngle = 15.0;
+    m_NumberOfNewtonIterations = 5;
+
+    m_DerivativeStep = 0.005;
+    m_MaximalNewtonStep = 0.1;
+}
+
+void ODFPeakExtractor::Initialize()
+{
+    unsigned int vectorLength = (m_LOrder + 1) * (m_LOrder + 2) / 2;
+
+    m_SHFactors.resize(vectorLength);
+    for (int k = 0;k <= (int)m_LOrder;k += 2)
+    {
+        for (int m = -k;m <= k;++m)
+        {
+            int absm = std::abs(m);
+            double factor = std::sqrt((2 * k + 1) * std::tgamma(k - absm + 1) / (4 * M_PI * std::tgamma(k + absm + 1)));
+
+            // Real basis as in ODFSphericalHarmonicBasis: sqrt(2) Im(Y) for m > 0, sqrt(2) Re(Y) for m < 0
+            if (m != 0)
+                factor *= std::sqrt(2.0);
+
+            if ((m < 0)&&(absm % 2 != 0))
+                factor *= -1;
+
+            m_SHFactors[k * (k + 1) / 2 + m] = factor;
+        }
+    }
+
+    // Fibonacci sampling of the upper hemisphere (ODFs are antipodally symmetric)
+    unsigned int numSamples = m_NumberOfSphereSamples;
+    m_SphereSamples.resize(numSamples);
+    double goldenAngle = M_PI * (3.0 - std::sqrt(5.0));
+    for (unsigned int i = 0;i < numSamples;++i)
+    {
+        double z = (i + 0.5) / numSamples;
+        double radius = std::sqrt(1.0 - z * z);
+        double phi = i * goldenAngle;
+
+        m_SphereSamples[i][0] = radius * std::cos(phi);
+        m_SphereSamples[i][1] = radius * std::sin(phi);
+        m_SphereSamples[i][2] = z;
+    }
+
+    // SH values at samples, obtained by evaluating the basis functions one at a time
+    m_SphereSHValues.set_size(numSamples,vectorLength);
+    std::vector <double> unitCoefficients(vectorLength,0.0);
+    for (unsigned int j = 0;j < vectorLength;++j)
+    {
+        unitCoefficients[j] = 1.0;
+        for (unsigned int i = 0;i < numSamples;++i)
+            m_SphereSHValues(i,j) = this->EvaluateODF(unitCoefficients,m_SphereSamples[i]);
+
+        unitCoefficients[j] = 0.0;
+    }
+
+    // Neighborhoods of about two sampling steps, the hemisphere having an area of 2 pi
+    double samplingStep = std::sqrt(2.0 * M_PI / numSamples);
+    double cosNeighborhood = std::cos(2.0 * samplingStep);
+    m_MaximalNewtonStep = samplingStep;
+
+    m_SampleNeighbors.resize(numSamples);
+    for (unsigned int i = 0;i < numSamples;++i)
+    {
+        m_SampleNeighbors[i].clear();
+        for (unsigned int j = 0;j < numSamples;++j)
+        {
+            if (i == j)
+                continue;
+
+            if (std::abs(dot_product(m_SphereSamples[i],m_SphereSamples[j])) >= cosNeighborhood)
+                m_SampleNeighbors[i].push_back(j);
+        }
+    }
+}
+
+} // end of namespace anima
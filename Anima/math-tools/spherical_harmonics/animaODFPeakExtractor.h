@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_vector_fixed.h>
+#include <vector>
+
+#include "AnimaSHToolsExport.h"
+
+namespace anima
+{
+
+/**
+ * @brief Extraction of ODF maxima from their real spherical harmonics coefficients (same basis as ODFSphericalHarmonicBasis).
+ * ODF values are looked up on a dense hemisphere sampling (one matrix vector product per ODF), sampled local maxima
+ * are then refined by Newton iterations on the SH expansion in the tangent plane. Once initialized, extraction
+ * methods are const and may be called concurrently with one work vector per thread.
+ */
+class ANIMASHTOOLS_EXPORT ODFPeakExtractor
+{
+public:
+    typedef vnl_vector_fixed <double,3> DirectionType;
+
+    ODFPeakExtractor();
+    virtual ~ODFPeakExtractor() {}
+
+    void SetLOrder(unsigned int val) {m_LOrder = val;}
+    unsigned int GetLOrder() {return m_LOrder;}
+
+    //! Number of sampled directions on the hemisphere
+    void SetNumberOfSphereSamples(unsigned int val) {m_NumberOfSphereSamples = val;}
+
+    //! Maximal number of returned peaks, zero for no limit
+    void SetMaximalNumberOfPeaks(unsigned int val) {m_MaximalNumberOfPeaks = val;}
+    unsigned int GetMaximalNumberOfPeaks() {return m_MaximalNumberOfPeaks;}
+
+    //! Peaks with amplitude below this ratio of the largest peak amplitude are discarded
+    void SetMinimalPeakRatio(double val) {m_MinimalPeakRatio = val;}
+
+    //! Peaks closer than this angle (in degrees) to a larger peak are discarded
+    void SetMinimalSeparationAngle(double val) {m_MinimalSeparationAngle = val;}
+
+    void SetNumberOfNewtonIterations(unsigned int val) {m_NumberOfNewtonIterations = val;}
+
+    //! Precomputes sphere samples, their SH values and neighborhoods. Required before any extraction
+    void Initialize();
+
+    //! ODF value at a unit direction, using a fast Legendre recurrence
+    template <class T> double EvaluateODF(const T &coefficients, const DirectionType &direction) const;
+
+    /**
+     * Extracts peaks sorted by decreasing amplitude, returns their number. Directions are unit vectors
+     * (any sign), workValues is resized as needed and can be reused between calls.
+     */
+    template <class T> unsigned int ExtractPeaks(const T &coefficients, std::vector <DirectionType> &directions,
+                                                 std::vector <double> &amplitudes, std::vector <double> &workValues) const;
+
+protected:
+    //! Newton refinement of a local maximum, direction and amplitude are updated in place
+    template <class T> void RefinePeak(const T &coefficients, DirectionType &direction, double &amplitude) const;
+
+private:
+    unsigned int m_LOrder;
+    unsigned int m_NumberOfSphereSamples;
+    unsigned int m_MaximalNumberOfPeaks;
+    double m_MinimalPeakRatio;
+    double m_MinimalSeparationAngle;
+    unsigned int m_NumberOfNewtonIterations;
+
+    //! Hemisphere sampling directions and SH values at those (one row per direction)
+    std::vector <DirectionType> m_SphereSamples;
+    vnl_matrix <double> m_SphereSHValues;
+
+    //! For each sample, indexes of samples in its angular neighborhood (accounting for antipodal symmetry)
+    std::vector < std::vector <unsigned int> > m_SampleNeighbors;
+
+    //! Angular step for numerical derivatives in Newton refinement, and maximal Newton step
+    double m_DerivativeStep;
+    double m_MaximalNewtonStep;
+
+    //! Normalization factors of real SH basis functions, same order as coefficients
+    std::vector <double> m_SHFactors;
+};
+
+} // end of namespace anima
+
+#include "animaODFPeakExtractor.hxx"
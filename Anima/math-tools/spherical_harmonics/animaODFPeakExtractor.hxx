@@ -0,0 +1,268 @@
+#pragma once
+#include "animaODFPeakExtractor.h"
+
+#include <cmath>
+#include <vnl/vnl_cross.h>
+
+namespace anima
+{
+
+template <class T>
+double
+ODFPeakExtractor::
+EvaluateODF(const T &coefficients, const DirectionType &direction) const
+{
+    // Associated Legendre functions divided by sin(theta)^m, multiplied by (x + iy)^m = sin(theta)^m exp(i m phi)
+    // to avoid any trigonometric call or pole singularity
+    double resVal = 0;
+    double z = direction[2];
+    double cosMPhi = 1.0;
+    double sinMPhi = 0.0;
+    double diagonalLegendre = 1.0;
+
+    for (int m = 0;m <= (int)m_LOrder;++m)
+    {
+        if (m > 0)
+        {
+            double tmpCos = cosMPhi * direction[0] - sinMPhi * direction[1];
+            sinMPhi = cosMPhi * direction[1] + sinMPhi * direction[0];
+            cosMPhi = tmpCos;
+
+            // Condon-Shortley phase included
+            diagonalLegendre *= - (2.0 * m - 1.0);
+        }
+
+        double previousLegendre = 0;
+        double currentLegendre = diagonalLegendre;
+
+        for (int l = m;l <= (int)m_LOrder;++l)
+        {
+            if (l > m)
+            {
+                double nextLegendre = ((2.0 * l - 1.0) * z * currentLegendre - (l + m - 1.0) * previousLegendre) / (l - m);
+                previousLegendre = currentLegendre;
+                currentLegendre = nextLegendre;
+            }
+
+            if (l % 2 != 0)
+                continue;
+
+            unsigned int center = l * (l + 1) / 2;
+            if (m == 0)
+                resVal += m_SHFactors[center] * coefficients[center] * currentLegendre;
+            else
+            {
+                resVal += m_SHFactors[center + m] * coefficients[center + m] * currentLegendre * sinMPhi;
+                resVal += m_SHFactors[center - m] * coefficients[center - m] * currentLegendre * cosMPhi;
+            }
+        }
+    }
+
+    return resVal;
+}
+
+template <class T>
+unsigned int
+ODFPeakExtractor::
+ExtractPeaks(const T &coefficients, std::vector <DirectionType> &directions,
+             std::vector <double> &amplitudes, std::vector <double> &workValues) const
+{
+    unsigned int numSamples = m_SphereSamples.size();
+    unsigned int vectorLength = m_SphereSHValues.cols();
+
+    directions.clear();
+    amplitudes.clear();
+
+    workValues.resize(numSamples);
+    for (unsigned int i = 0;i < numSamples;++i)
+    {
+        const double *shValues = m_SphereSHValues[i];
+        double odfValue = 0;
+        for (unsigned int j = 0;j < vectorLength;++j)
+            odfValue += shValues[j] * coefficients[j];
+
+        workValues[i] = odfValue;
+    }
+
+    // Sampled local maxima, ties are given to the lowest index
+    for (unsigned int i = 0;i < numSamples;++i)
+    {
+        double odfValue = workValues[i];
+        if (odfValue <= 0)
+            continue;
+
+        bool isMaximum = true;
+        const std::vector <unsigned int> &neighbors = m_SampleNeighbors[i];
+        for (unsigned int j = 0;j < neighbors.size();++j)
+        {
+            double neighborValue = workValues[neighbors[j]];
+            if ((neighborValue > odfValue)||((neighborValue == odfValue)&&(neighbors[j] < i)))
+            {
+                isMaximum = false;
+                break;
+            }
+        }
+
+        if (!isMaximum)
+            continue;
+
+        directions.push_back(m_SphereSamples[i]);
+        amplitudes.push_back(odfValue);
+    }
+
+    unsigned int numCandidates = directions.size();
+    for (unsigned int i = 0;i < numCandidates;++i)
+        this->RefinePeak(coefficients,directions[i],amplitudes[i]);
+
+    // Few candidates, insertion sort by decreasing amplitude
+    for (unsigned int i = 1;i < numCandidates;++i)
+    {
+        DirectionType currentDirection = directions[i];
+        double currentAmplitude = amplitudes[i];
+        unsigned int j = i;
+        while ((j > 0)&&(amplitudes[j - 1] < currentAmplitude))
+        {
+            directions[j] = directions[j - 1];
+            amplitudes[j] = amplitudes[j - 1];
+            --j;
+        }
+
+        directions[j] = currentDirection;
+        amplitudes[j] = currentAmplitude;
+    }
+
+    double cosSeparation = std::cos(m_MinimalSeparationAngle * M_PI / 180.0);
+    unsigned int numPeaks = 0;
+    for (unsigned int i = 0;i < numCandidates;++i)
+    {
+        if ((m_MaximalNumberOfPeaks > 0)&&(numPeaks == m_MaximalNumberOfPeaks))
+            break;
+
+        if (amplitudes[i] < m_MinimalPeakRatio * amplitudes[0])
+            break;
+
+        bool isSeparated = true;
+        for (unsigned int j = 0;j < numPeaks;++j)
+        {
+            if (std::abs(dot_product(directions[i],directions[j])) > cosSeparation)
+            {
+                isSeparated = false;
+                break;
+            }
+        }
+
+        if (!isSeparated)
+            continue;
+
+        directions[numPeaks] = directions[i];
+        amplitudes[numPeaks] = amplitudes[i];
+        ++numPeaks;
+    }
+
+    directions.resize(numPeaks);
+    amplitudes.resize(numPeaks);
+
+    return numPeaks;
+}
+
+template <class T>
+void
+ODFPeakExtractor::
+RefinePeak(const T &coefficients, DirectionType &direction, double &amplitude) const
+{
+    // Local tangent frame, directions are parameterized as normalize(direction + a u + b v)
+    DirectionType uVector, vVector, tmpDirection;
+    double h = m_DerivativeStep;
+
+    for (unsigned int iter = 0;iter < m_NumberOfNewtonIterations;++iter)
+    {
+        unsigned int minIndex = 0;
+        for (unsigned int i = 1;i < 3;++i)
+        {
+            if (std::abs(direction[i]) < std::abs(direction[minIndex]))
+                minIndex = i;
+        }
+
+        DirectionType axis(0.0);
+        axis[minIndex] = 1.0;
+        uVector = vnl_cross_3d(direction,axis);
+        uVector.normalize();
+        vVector = vnl_cross_3d(direction,uVector);
+
+        double values[3][3];
+        for (int i = -1;i <= 1;++i)
+        {
+            for (int j = -1;j <= 1;++j)
+            {
+                if ((i == 0)&&(j == 0))
+                {
+                    values[1][1] = amplitude;
+                    continue;
+                }
+
+                tmpDirection = direction + (i * h) * uVector + (j * h) * vVector;
+                tmpDirection.normalize();
+                values[i + 1][j + 1] = this->EvaluateODF(coefficients,tmpDirection);
+            }
+        }
+
+        double gradientA = (values[2][1] - values[0][1]) / (2.0 * h);
+        double gradientB = (values[1][2] - values[1][0]) / (2.0 * h);
+        double hessianAA = (values[2][1] - 2.0 * amplitude + values[0][1]) / (h * h);
+        double hessianBB = (values[1][2] - 2.0 * amplitude + values[1][0]) / (h * h);
+        double hessianAB = (values[2][2] - values[2][0] - values[0][2] + values[0][0]) / (4.0 * h * h);
+
+        double gradientNorm = std::sqrt(gradientA * gradientA + gradientB * gradientB);
+        if (gradientNorm <= 0)
+            break;
+
+        double stepA, stepB;
+        double determinant = hessianAA * hessianBB - hessianAB * hessianAB;
+        if ((hessianAA < 0)&&(determinant > 0))
+        {
+            // Newton step towards the maximum
+            stepA = - (hessianBB * gradientA - hessianAB * gradientB) / determinant;
+            stepB = - (hessianAA * gradientB - hessianAB * gradientA) / determinant;
+        }
+        else
+        {
+            // Not locally concave, gradient ascent
+            stepA = m_MaximalNewtonStep * gradientA / gradientNorm;
+            stepB = m_MaximalNewtonStep * gradientB / gradientNorm;
+        }
+
+        double stepNorm = std::sqrt(stepA * stepA + stepB * stepB);
+        if (stepNorm > m_MaximalNewtonStep)
+        {
+            stepA *= m_MaximalNewtonStep / stepNorm;
+            stepB *= m_MaximalNewtonStep / stepNorm;
+            stepNorm = m_MaximalNewtonStep;
+        }
+
+        bool improved = false;
+        for (unsigned int i = 0;(i < 4)&&(!improved);++i)
+        {
+            tmpDirection = direction + stepA * uVector + stepB * vVector;
+            tmpDirection.normalize();
+            double newAmplitude = this->EvaluateODF(coefficients,tmpDirection);
+
+            if (newAmplitude >= amplitude)
+            {
+                direction = tmpDirection;
+                amplitude = newAmplitude;
+                improved = true;
+            }
+            else
+            {
+                stepA /= 2.0;
+                stepB /= 2.0;
+                stepNorm /= 2.0;
+            }
+        }
+
+        if ((!improved)||(stepNorm < 1.0e-6))
+            break;
+    }
+}
+
+} // end of namespace anima
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+#include <stdint.h>
+
+namespace anima
+{
+
+/**
+ * @brief Counter-based random number generator (Philox 4x32 with 10 rounds, Salmon et al., SC 2011).
+ *
+ * Each number only depends on a key (the user seed), a stream index (e.g. voxel, seed point or particle
+ * index) and its position in that stream. Work can therefore be split among any number of threads with
+ * identical results, a generator being created for each stream when needed (construction is free).
+ * Satisfies the C++11 UniformRandomBitGenerator requirements, hence may be used with the standard
+ * distributions as well as with the anima sampling functions, which use the batch methods below.
+ */
+class CounterBasedRandomGenerator
+{
+public:
+    typedef uint32_t result_type;
+
+    CounterBasedRandomGenerator(uint64_t seed = 0, uint64_t streamIndex = 0)
+    {
+        this->SetStream(seed,streamIndex);
+    }
+
+    //! Restarts the generator at the beginning of a stream
+    void SetStream(uint64_t seed, uint64_t streamIndex)
+    {
+        m_Key[0] = (uint32_t)seed;
+        m_Key[1] = (uint32_t)(seed >> 32);
+
+        m_Counter[0] = 0;
+        m_Counter[1] = 0;
+        m_Counter[2] = (uint32_t)streamIndex;
+        m_Counter[3] = (uint32_t)(streamIndex >> 32);
+
+        m_BlockPosition = 4;
+        m_HasCachedGaussian = false;
+        m_CachedGaussian = 0;
+    }
+
+    static constexpr result_type min() {return 0;}
+    static constexpr result_type max() {return std::numeric_limits <result_type>::max();}
+
+    result_type operator()()
+    {
+        if (m_BlockPosition == 4)
+            this->GenerateBlock();
+
+        return m_Block[m_BlockPosition++];
+    }
+
+    //! Uniform value in [0,1) with 53 random bits
+    double GetUniformValue()
+    {
+        uint64_t highBits = (*this)() >> 5;
+        uint64_t lowBits = (*this)() >> 6;
+
+        return (highBits * 67108864.0 + lowBits) * (1.0 / 9007199254740992.0);
+    }
+
+    //! Standard normal value (Box-Muller, both values of a pair are used)
+    double GetGaussianValue()
+    {
+        if (m_HasCachedGaussian)
+        {
+            m_HasCachedGaussian = false;
+            return m_CachedGaussian;
+        }
+
+        double radius = std::sqrt(-2.0 * std::log(1.0 - this->GetUniformValue()));
+        double angle = 2.0 * M_PI * this->GetUniformValue();
+
+        m_CachedGaussian = radius * std::sin(angle);
+        m_HasCachedGaussian = true;
+
+        return radius * std::cos(angle);
+    }
+
+    //! Gamma value of unit scale (Marsaglia and Tsang, 2000)
+    double GetGammaValue(double shape)
+    {
+        if (shape <= 0)
+            return 0;
+
+        // Boost for shapes below one: G(a) = G(a+1) U^(1/a)
+        double boostFactor = 1.0;
+        if (shape < 1.0)
+        {
+            boostFactor = std::pow(1.0 - this->GetUniformValue(),1.0 / shape);
+            shape += 1.0;
+        }
+
+        double d = shape - 1.0 / 3.0;
+        double c = 1.0 / std::sqrt(9.0 * d);
+
+        while (true)
+        {
+            double x, v;
+            do
+            {
+                x = this->GetGaussianValue();
+                v = 1.0 + c * x;
+            }
+            while (v <= 0);
+
+            v = v * v * v;
+            double u = this->GetUniformValue();
+
+            if (u < 1.0 - 0.0331 * x * x * x * x)
+                return boostFactor * d * v;
+
+            if (std::log(u) < 0.5 * x * x + d * (1.0 - v + std::log(v)))
+                return boostFactor * d * v;
+        }
+    }
+
+    double GetBetaValue(double alpha, double beta)
+    {
+        double x = this->GetGammaValue(alpha);
+        double y = this->GetGammaValue(beta);
+
+        if (x + y <= 0)
+            return 0;
+
+        return x / (x + y);
+    }
+
+    void FillUniformValues(double *values, unsigned int numValues)
+    {
+        for (unsigned int i = 0;i < numValues;++i)
+            values[i] = this->GetUniformValue();
+    }
+
+    void FillGaussianValues(double *values, unsigned int numValues)
+    {
+        for (unsigned int i = 0;i < numValues;++i)
+            values[i] = this->GetGaussianValue();
+    }
+
+private:
+    void GenerateBlock()
+    {
+        const uint32_t multiplier0 = 0xD2511F53;
+        const uint32_t multiplier1 = 0xCD9E8D57;
+
+        uint32_t counter[4] = {m_Counter[0], m_Counter[1], m_Counter[2], m_Counter[3]};
+        uint32_t key[2] = {m_Key[0], m_Key[1]};
+
+        for (unsigned int i = 0;i < 10;++i)
+        {
+            uint64_t product0 = (uint64_t)multiplier0 * counter[0];
+            uint64_t product1 = (uint64_t)multiplier1 * counter[2];
+
+            uint32_t newCounter0 = (uint32_t)(product1 >> 32) ^ counter[1] ^ key[0];
+            uint32_t newCounter2 = (uint32_t)(product0 >> 32) ^ counter[3] ^ key[1];
+
+            counter[0] = newCounter0;
+            counter[1] = (uint32_t)product1;
+            counter[2] = newCounter2;
+            counter[3] = (uint32_t)product0;
+
+            key[0] += 0x9E3779B9;
+            key[1] += 0xBB67AE85;
+        }
+
+        for (unsigned int i = 0;i < 4;++i)
+            m_Block[i] = counter[i];
+
+        m_BlockPosition = 0;
+
+        // 64 bits block counter, the stream index occupies the two upper words
+        if (++m_Counter[0] == 0)
+            ++m_Counter[1];
+    }
+
+    uint32_t m_Key[2];
+    uint32_t m_Counter[4];
+    uint32_t m_Block[4];
+    unsigned int m_BlockPosition;
+
+    bool m_HasCachedGaussian;
+    double m_CachedGaussian;
+};
+
+} // end namespace anima
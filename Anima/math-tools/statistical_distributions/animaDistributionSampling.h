@@ -1,54 +1,106 @@
 #pragma once
 
 #include <random>
+#include <vector>
 #include <vnl/vnl_matrix.h>
 #include <vnl/vnl_vector_fixed.h>
 
 #include <itkPoint.h>
 #include <itkVector.h>
 
+#include <animaCounterBasedRandomGenerator.h>
+
+/**
+ * Sampling functions are templated over the random generator: any C++11 uniform random bit generator
+ * (e.g. std::mt19937) may be used. Overloads for anima::CounterBasedRandomGenerator use its native
+ * uniform and Gaussian draws, without constructing standard distribution objects on each call.
+ * Batch versions fill a caller-sized vector of samples and factor out per-call setup.
+ */
+
 namespace anima
 {
 
+template <class T, class RNGType>
+double SampleFromUniformDistribution(const T &a, const T &b, RNGType &generator);
+
 template <class T>
-double SampleFromUniformDistribution(const T &a, const T &b, std::mt19937 &generator);
+double SampleFromUniformDistribution(const T &a, const T &b, CounterBasedRandomGenerator &generator);
+
+template <class T, class RNGType>
+void SampleFromUniformDistribution(const T &a, const T &b, std::vector <T> &samples, RNGType &generator);
+
+template <class VectorType, class RNGType>
+void SampleFromUniformDistributionOn2Sphere(RNGType &generator, VectorType &resVec);
 
-template <class VectorType>
-void SampleFromUniformDistributionOn2Sphere(std::mt19937 &generator, VectorType &resVec);
+template <class T, class RNGType>
+unsigned int SampleFromBernoulliDistribution(const T &p, RNGType &generator);
+
+template <class T, class RNGType>
+double SampleFromGaussianDistribution(const T &mean, const T &std, RNGType &generator);
 
 template <class T>
-unsigned int SampleFromBernoulliDistribution(const T &p, std::mt19937 &generator);
+double SampleFromGaussianDistribution(const T &mean, const T &std, CounterBasedRandomGenerator &generator);
+
+template <class T, class RNGType>
+void SampleFromGaussianDistribution(const T &mean, const T &std, std::vector <T> &samples, RNGType &generator);
 
 template <class T>
-double SampleFromGaussianDistribution(const T &mean, const T &std, std::mt19937 &generator);
+void SampleFromGaussianDistribution(const T &mean, const T &std, std::vector <T> &samples, CounterBasedRandomGenerator &generator);
 
-template <class VectorType, class ScalarType>
+template <class T, class RNGType>
+double SampleFromGammaDistribution(const T &shape, const T &scale, RNGType &generator);
+
+template <class T>
+double SampleFromGammaDistribution(const T &shape, const T &scale, CounterBasedRandomGenerator &generator);
+
+template <class T, class RNGType>
+void SampleFromGammaDistribution(const T &shape, const T &scale, std::vector <T> &samples, RNGType &generator);
+
+template <class T, class RNGType>
+double SampleFromBetaDistribution(const T &alpha, const T &beta, RNGType &generator);
+
+template <class T, class RNGType>
+void SampleFromBetaDistribution(const T &alpha, const T &beta, std::vector <T> &samples, RNGType &generator);
+
+template <class VectorType, class ScalarType, class RNGType>
 void SampleFromMultivariateGaussianDistribution(const VectorType &mean, const vnl_matrix <ScalarType> &mat, VectorType &resVec,
-                                                std::mt19937 &generator, bool isMatCovariance = true);
+                                                RNGType &generator, bool isMatCovariance = true);
 
 // From Ulrich 1984
-template <class VectorType, class ScalarType>
-void SampleFromVMFDistribution(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, std::mt19937 &generator);
+template <class VectorType, class ScalarType, class RNGType>
+void SampleFromVMFDistribution(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, RNGType &generator);
+
+template <class VectorType, class ScalarType, class RNGType>
+void SampleFromVMFDistribution(const ScalarType &kappa, const VectorType &meanDirection, std::vector <VectorType> &samples, RNGType &generator);
 
 // From Wenzel 2012
-template <class VectorType, class ScalarType>
-void SampleFromVMFDistributionNumericallyStable(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, std::mt19937 &generator);
+template <class VectorType, class ScalarType, class RNGType>
+void SampleFromVMFDistributionNumericallyStable(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, RNGType &generator);
+
+template <class VectorType, class ScalarType, class RNGType>
+void SampleFromVMFDistributionNumericallyStable(const ScalarType &kappa, const VectorType &meanDirection, std::vector <VectorType> &samples,
+                                                RNGType &generator);
+
+template <class ScalarType, class VectorType, class RNGType>
+void
+SampleFromWatsonDistribution(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, unsigned int DataDimension, RNGType &generator);
 
-template <class ScalarType, class VectorType>
+template <class ScalarType, class VectorType, class RNGType>
 void
-SampleFromWatsonDistribution(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, unsigned int DataDimension, std::mt19937 &generator);
+SampleFromWatsonDistribution(const ScalarType &kappa, const VectorType &meanDirection, std::vector <VectorType> &samples, unsigned int DataDimension,
+                             RNGType &generator);
 
-template <class ScalarType, unsigned int DataDimension>
+template <class ScalarType, unsigned int DataDimension, class RNGType>
 void
-SampleFromWatsonDistribution(const ScalarType &kappa, const vnl_vector_fixed < ScalarType, DataDimension > &meanDirection, vnl_vector_fixed < ScalarType, DataDimension > &resVec, std::mt19937 &generator);
+SampleFromWatsonDistribution(const ScalarType &kappa, const vnl_vector_fixed < ScalarType, DataDimension > &meanDirection, vnl_vector_fixed < ScalarType, DataDimension > &resVec, RNGType &generator);
 
-template <class ScalarType, unsigned int DataDimension>
+template <class ScalarType, unsigned int DataDimension, class RNGType>
 void
-SampleFromWatsonDistribution(const ScalarType &kappa, const itk::Point < ScalarType, DataDimension > &meanDirection, itk::Point < ScalarType, DataDimension > &resVec, std::mt19937 &generator);
+SampleFromWatsonDistribution(const ScalarType &kappa, const itk::Point < ScalarType, DataDimension > &meanDirection, itk::Point < ScalarType, DataDimension > &resVec, RNGType &generator);
 
-template <class ScalarType, unsigned int DataDimension>
+template <class ScalarType, unsigned int DataDimension, class RNGType>
 void
-SampleFromWatsonDistribution(const ScalarType &kappa, const itk::Vector < ScalarType, DataDimension > &meanDirection, itk::Vector < ScalarType, DataDimension > &resVec, std::mt19937 &generator);
+SampleFromWatsonDistribution(const ScalarType &kappa, const itk::Vector < ScalarType, DataDimension > &meanDirection, itk::Vector < ScalarType, DataDimension > &resVec, RNGType &generator);
 
 } // end of namespace anima
 
@@ -2,7 +2,6 @@
 #include "animaDistributionSampling.h"
 
 #include <cmath>
-#include <boost/math/distributions/beta.hpp>
 
 #include <animaVectorOperations.h>
 #include <animaLogarithmFunctions.h>
@@ -14,23 +13,35 @@
 namespace anima
 {
 
-template <class T>
-double SampleFromUniformDistribution(const T &a, const T &b, std::mt19937 &generator)
+template <class T, class RNGType>
+double SampleFromUniformDistribution(const T &a, const T &b, RNGType &generator)
 {
     // Define distribution U[a,b) [double values]
     std::uniform_real_distribution<T> uniDbl(a,b);
     return uniDbl(generator);
 }
 
-template <class VectorType>
-void SampleFromUniformDistributionOn2Sphere(std::mt19937 &generator, VectorType &resVec)
+template <class T>
+double SampleFromUniformDistribution(const T &a, const T &b, CounterBasedRandomGenerator &generator)
+{
+    return a + (b - a) * generator.GetUniformValue();
+}
+
+template <class T, class RNGType>
+void SampleFromUniformDistribution(const T &a, const T &b, std::vector <T> &samples, RNGType &generator)
+{
+    for (unsigned int i = 0;i < samples.size();++i)
+        samples[i] = SampleFromUniformDistribution(a,b,generator);
+}
+
+template <class VectorType, class RNGType>
+void SampleFromUniformDistributionOn2Sphere(RNGType &generator, VectorType &resVec)
 {
-    std::uniform_real_distribution<double> uniDbl(-1.0,1.0);
     double sqSum = 2;
     while (sqSum > 1)
     {
-        resVec[0] = uniDbl(generator);
-        resVec[1] = uniDbl(generator);
+        resVec[0] = SampleFromUniformDistribution(-1.0,1.0,generator);
+        resVec[1] = SampleFromUniformDistribution(-1.0,1.0,generator);
 
         sqSum = resVec[0] * resVec[0] + resVec[1] * resVec[1];
     }
@@ -41,23 +52,83 @@ void SampleFromUniformDistributionOn2Sphere(std::mt19937 &generator, VectorType
     resVec[2] = 2.0 * sqSum - 1.0;
 }
 
-template <class T>
-unsigned int SampleFromBernoulliDistribution(const T &p, std::mt19937 &generator)
+template <class T, class RNGType>
+unsigned int SampleFromBernoulliDistribution(const T &p, RNGType &generator)
 {
-    std::bernoulli_distribution bernoulli(p);
-    return bernoulli(generator);
+    return (SampleFromUniformDistribution(0.0,1.0,generator) < p);
 }
 
-template <class T>
-double SampleFromGaussianDistribution(const T &mean, const T &std, std::mt19937 &generator)
+template <class T, class RNGType>
+double SampleFromGaussianDistribution(const T &mean, const T &std, RNGType &generator)
 {
     std::normal_distribution<T> normalDist(mean,std);
     return normalDist(generator);
 }
 
-template <class VectorType, class ScalarType>
+template <class T>
+double SampleFromGaussianDistribution(const T &mean, const T &std, CounterBasedRandomGenerator &generator)
+{
+    return mean + std * generator.GetGaussianValue();
+}
+
+template <class T, class RNGType>
+void SampleFromGaussianDistribution(const T &mean, const T &std, std::vector <T> &samples, RNGType &generator)
+{
+    // A single distribution object keeps both values of each generated pair
+    std::normal_distribution<T> normalDist(mean,std);
+    for (unsigned int i = 0;i < samples.size();++i)
+        samples[i] = normalDist(generator);
+}
+
+template <class T>
+void SampleFromGaussianDistribution(const T &mean, const T &std, std::vector <T> &samples, CounterBasedRandomGenerator &generator)
+{
+    for (unsigned int i = 0;i < samples.size();++i)
+        samples[i] = mean + std * generator.GetGaussianValue();
+}
+
+template <class T, class RNGType>
+double SampleFromGammaDistribution(const T &shape, const T &scale, RNGType &generator)
+{
+    std::gamma_distribution<T> gammaDist(shape,scale);
+    return gammaDist(generator);
+}
+
+template <class T>
+double SampleFromGammaDistribution(const T &shape, const T &scale, CounterBasedRandomGenerator &generator)
+{
+    return scale * generator.GetGammaValue(shape);
+}
+
+template <class T, class RNGType>
+void SampleFromGammaDistribution(const T &shape, const T &scale, std::vector <T> &samples, RNGType &generator)
+{
+    for (unsigned int i = 0;i < samples.size();++i)
+        samples[i] = SampleFromGammaDistribution(shape,scale,generator);
+}
+
+template <class T, class RNGType>
+double SampleFromBetaDistribution(const T &alpha, const T &beta, RNGType &generator)
+{
+    double x = SampleFromGammaDistribution(alpha,(T)1.0,generator);
+    double y = SampleFromGammaDistribution(beta,(T)1.0,generator);
+
+    if (x + y <= 0)
+        return 0;
+
+    return x / (x + y);
+}
+
+template <class T, class RNGType>
+void SampleFromBetaDistribution(const T &alpha, const T &beta, std::vector <T> &samples, RNGType &generator)
+{
+    for (unsigned int i = 0;i < samples.size();++i)
+        samples[i] = SampleFromBetaDistribution(alpha,beta,generator);
+}
+
+template <class VectorType, class ScalarType, class RNGType>
 void SampleFromMultivariateGaussianDistribution(const VectorType &mean, const vnl_matrix <ScalarType> &mat, VectorType &resVec,
-                                                std::mt19937 &generator, bool isMatCovariance)
+                                                RNGType &generator, bool isMatCovariance)
 {
     unsigned int vectorSize = mat.rows();
 
@@ -89,16 +160,14 @@ void SampleFromMultivariateGaussianDistribution(const VectorType &mean, const vn
     }
 }
 
-template <class VectorType, class ScalarType>
-void SampleFromVMFDistribution(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, std::mt19937 &generator)
+//! Rotation matrix bringing [0,0,1] onto the mean direction of a von Mises & Fisher distribution
+template <class VectorType>
+vnl_matrix <double> GetVMFSamplingRotation(const VectorType &meanDirection)
 {
     VectorType tmpVec;
 
     for (unsigned int i = 0;i < 3;++i)
-    {
         tmpVec[i] = 0;
-        resVec[i] = 0;
-    }
 
     // Code to compute rotation matrix from vectors, similar to registration code
     tmpVec[2] = 1;
@@ -109,118 +178,115 @@ void SampleFromVMFDistribution(const ScalarType &kappa, const VectorType &meanDi
     if (std::abs(tmpVec[2] - 1.0) > 1.0e-6)
         throw itk::ExceptionObject(__FILE__, __LINE__,"Von Mises & Fisher sampling requires mean direction of norm 1.",ITK_LOCATION);
 
+    return rotationMatrix;
+}
+
+//! Rotates the sample of cosine W and azimuth theta around [0,0,1] using the rotation matrix
+template <class VectorType>
+void RotateVMFSample(const vnl_matrix <double> &rotationMatrix, double W, double theta, VectorType &resVec)
+{
+    double tmpVec[3];
+    tmpVec[0] = std::sqrt(1.0 - W*W) * std::cos(theta);
+    tmpVec[1] = std::sqrt(1.0 - W*W) * std::sin(theta);
+    tmpVec[2] = W;
+
+    for (unsigned int i = 0;i < 3;++i)
+    {
+        resVec[i] = 0;
+        for (unsigned int j = 0;j < 3;++j)
+            resVec[i] += rotationMatrix(i,j) * tmpVec[j];
+    }
+}
+
+//! Cosine of the angle to the mean direction, Ulrich rejection sampler
+template <class ScalarType, class RNGType>
+double SampleVMFCosine(const ScalarType &kappa, RNGType &generator)
+{
     double tmpVal = std::sqrt(kappa * kappa + 1.0);
     double b = (-2.0 * kappa + 2.0 * tmpVal) / 2.0;
     double a = (1.0 + kappa + tmpVal) / 2.0;
     double d = 4.0 * a * b / (1.0 + b) - 2.0 * anima::safe_log(2.0);
 
-    boost::math::beta_distribution<double> betaDist(1.0, 1.0);
-
     double T = 1.0;
     double U = std::exp(d);
     double W = 0;
 
     while (2.0 * anima::safe_log(T) - T + d < anima::safe_log(U))
     {
-        double Z = boost::math::quantile(betaDist, SampleFromUniformDistribution(0.0, 1.0, generator));
+        // Beta(1,1) is the uniform distribution on [0,1]
+        double Z = SampleFromUniformDistribution(0.0, 1.0, generator);
         U = SampleFromUniformDistribution(0.0, 1.0, generator);
         tmpVal = 1.0 - (1.0 - b) * Z;
         T = 2.0 * a * b / tmpVal;
         W = (1.0 - (1.0 + b) * Z) / tmpVal;
     }
 
+    return W;
+}
+
+//! Cosine of the angle to the mean direction, Wenzel inversion sampler
+template <class ScalarType, class RNGType>
+double SampleVMFCosineNumericallyStable(const ScalarType &kappa, RNGType &generator)
+{
+    double xi = SampleFromUniformDistribution(0.0, 1.0, generator);
+    return 1.0 + (anima::safe_log(xi) + anima::safe_log(1.0 - (xi - 1.0) * exp(-2.0 * kappa) / xi)) / kappa;
+}
+
+template <class VectorType, class ScalarType, class RNGType>
+void SampleFromVMFDistribution(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, RNGType &generator)
+{
+    vnl_matrix <double> rotationMatrix = anima::GetVMFSamplingRotation(meanDirection);
+
+    double W = anima::SampleVMFCosine(kappa, generator);
     double theta = anima::SampleFromUniformDistribution(0.0, 2.0 * M_PI, generator);
-    tmpVec[0] = std::sqrt(1.0 - W*W) * std::cos(theta);
-    tmpVec[1] = std::sqrt(1.0 - W*W) * std::sin(theta);
-    tmpVec[2] = W;
 
-    for (unsigned int i = 0;i < 3;++i)
-        for (unsigned int j = 0;j < 3;++j)
-            resVec[i] += rotationMatrix(i,j) * tmpVec[j];
+    anima::RotateVMFSample(rotationMatrix, W, theta, resVec);
 }
 
-template <class VectorType, class ScalarType>
-void SampleFromVMFDistributionNumericallyStable(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, std::mt19937 &generator)
+template <class VectorType, class ScalarType, class RNGType>
+void SampleFromVMFDistribution(const ScalarType &kappa, const VectorType &meanDirection, std::vector <VectorType> &samples, RNGType &generator)
 {
-    VectorType tmpVec;
+    vnl_matrix <double> rotationMatrix = anima::GetVMFSamplingRotation(meanDirection);
 
-    for (unsigned int i = 0;i < 3;++i)
+    for (unsigned int i = 0;i < samples.size();++i)
     {
-        tmpVec[i] = 0;
-        resVec[i] = 0;
-    }
+        double W = anima::SampleVMFCosine(kappa, generator);
+        double theta = anima::SampleFromUniformDistribution(0.0, 2.0 * M_PI, generator);
 
-    // Code to compute rotation matrix from vectors, similar to registration code
-    tmpVec[2] = 1;
-
-    vnl_matrix <double> rotationMatrix = anima::GetRotationMatrixFromVectors(tmpVec,meanDirection).GetVnlMatrix();
-    anima::TransformCartesianToSphericalCoordinates(meanDirection, tmpVec);
+        anima::RotateVMFSample(rotationMatrix, W, theta, samples[i]);
+    }
+}
 
-    if (std::abs(tmpVec[2] - 1.0) > 1.0e-6)
-        throw itk::ExceptionObject(__FILE__, __LINE__,"Von Mises & Fisher sampling requires mean direction of norm 1.",ITK_LOCATION);
+template <class VectorType, class ScalarType, class RNGType>
+void SampleFromVMFDistributionNumericallyStable(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, RNGType &generator)
+{
+    vnl_matrix <double> rotationMatrix = anima::GetVMFSamplingRotation(meanDirection);
 
-    double xi = SampleFromUniformDistribution(0.0, 1.0, generator);
-    double W = 1.0 + (anima::safe_log(xi) + anima::safe_log(1.0 - (xi - 1.0) * exp(-2.0 * kappa) / xi)) / kappa;
+    double W = anima::SampleVMFCosineNumericallyStable(kappa, generator);
     double theta = SampleFromUniformDistribution(0.0, 2.0 * M_PI, generator);
 
-    tmpVec[0] = std::sqrt(1.0 - W*W) * std::cos(theta);
-    tmpVec[1] = std::sqrt(1.0 - W*W) * std::sin(theta);
-    tmpVec[2] = W;
-
-    for (unsigned int i = 0;i < 3;++i)
-        for (unsigned int j = 0;j < 3;++j)
-            resVec[i] += rotationMatrix(i,j) * tmpVec[j];
+    anima::RotateVMFSample(rotationMatrix, W, theta, resVec);
 }
 
-template <class ScalarType, class VectorType>
-void
-SampleFromWatsonDistribution(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, unsigned int DataDimension, std::mt19937 &generator)
+template <class VectorType, class ScalarType, class RNGType>
+void SampleFromVMFDistributionNumericallyStable(const ScalarType &kappa, const VectorType &meanDirection, std::vector <VectorType> &samples,
+                                                RNGType &generator)
 {
-    /**********************************************************************************************//**
-         * \fn template <class ScalarType, class VectorType>
-         * 	   void
-         *     SampleFromWatsonDistribution(const ScalarType &kappa,
-         * 					const VectorType &meanDirection,
-         * 					VectorType &resVec,
-         * 					unsigned int DataDimension,
-         * 					std::mt19937 &generator)
-         *
-         * \brief	Sample from the Watson distribution using the procedure described in
-         * 			Fisher et al., Statistical Analysis of Spherical Data, 1993, p.59.
-         *
-         * \author	Aymeric Stamm
-         * \date	October 2013
-         *
-         * \param	kappa		   	Concentration parameter of the Watson distribution.
-         * \param	meanDirection	Mean direction of the Watson distribution.
-         * \param	resVec			Resulting sample.
-         * \param	DataDimension	Dimension of the sphere + 1.
-         * \param	generator		Pseudo-random number generator.
-         **************************************************************************************************/
+    vnl_matrix <double> rotationMatrix = anima::GetVMFSamplingRotation(meanDirection);
 
-    VectorType tmpVec;
-
-    for (unsigned int i = 0;i < DataDimension;++i)
+    for (unsigned int i = 0;i < samples.size();++i)
     {
-        tmpVec[i] = 0;
-        resVec[i] = 0;
-    }
-
-    // Code to compute rotation matrix from vectors, taken from registration code
-    tmpVec[2] = 1;
-
-    VectorType rotationNormal;
-    anima::ComputeCrossProduct(tmpVec, meanDirection, rotationNormal);
-    anima::Normalize(rotationNormal, rotationNormal);
+        double W = anima::SampleVMFCosineNumericallyStable(kappa, generator);
+        double theta = SampleFromUniformDistribution(0.0, 2.0 * M_PI, generator);
 
-    // Now resuming onto sampling around direction [0,0,1]
-    anima::TransformCartesianToSphericalCoordinates(meanDirection, tmpVec);
-
-    double rotationAngle = tmpVec[0];
-
-    if (std::abs(tmpVec[2] - 1.0) > 1.0e-6)
-        throw itk::ExceptionObject(__FILE__, __LINE__,"The Watson distribution is on the 2-sphere.",ITK_LOCATION);
+        anima::RotateVMFSample(rotationMatrix, W, theta, samples[i]);
+    }
+}
 
+//! Cosine of the angle to the mean direction of a Watson distribution (Fisher et al., 1993, p.59)
+template <class ScalarType, class RNGType>
+double SampleWatsonCosine(const ScalarType &kappa, RNGType &generator)
+{
     double U, V, S;
     if (kappa > 1.0e-6) // Bipolar distribution
     {
@@ -266,16 +332,48 @@ SampleFromWatsonDistribution(const ScalarType &kappa, const VectorType &meanDire
         S = std::cos(SampleFromUniformDistribution(0.0, M_PI, generator));
     }
 
-    double phi = SampleFromUniformDistribution(0.0, 2.0 * M_PI, generator);
+    return S;
+}
+
+//! Rotation axis and angle bringing [0,0,1] onto the mean direction of a Watson distribution
+template <class VectorType>
+void GetWatsonSamplingRotation(const VectorType &meanDirection, unsigned int DataDimension, VectorType &rotationNormal, double &rotationAngle)
+{
+    VectorType tmpVec(meanDirection);
+
+    for (unsigned int i = 0;i < DataDimension;++i)
+        tmpVec[i] = 0;
+
+    // Code to compute rotation matrix from vectors, taken from registration code
+    tmpVec[2] = 1;
+
+    anima::ComputeCrossProduct(tmpVec, meanDirection, rotationNormal);
+    anima::Normalize(rotationNormal, rotationNormal);
+
+    // Now resuming onto sampling around direction [0,0,1]
+    anima::TransformCartesianToSphericalCoordinates(meanDirection, tmpVec);
+
+    rotationAngle = tmpVec[0];
+
+    if (std::abs(tmpVec[2] - 1.0) > 1.0e-6)
+        throw itk::ExceptionObject(__FILE__, __LINE__,"The Watson distribution is on the 2-sphere.",ITK_LOCATION);
+}
+
+//! Rotates a Watson sample of cosine S and azimuth phi around [0,0,1], and checks it lies on the sphere
+template <class ScalarType, class VectorType>
+void RotateWatsonSample(const ScalarType &kappa, const VectorType &meanDirection, const VectorType &rotationNormal, double rotationAngle,
+                        double S, double phi, VectorType &resVec)
+{
+    VectorType tmpVec(meanDirection);
 
     tmpVec[0] = std::sqrt(1.0 - S*S) * std::cos(phi);
     tmpVec[1] = std::sqrt(1.0 - S*S) * std::sin(phi);
     tmpVec[2] = S;
-    
+
     anima::RotateAroundAxis(tmpVec, rotationAngle, rotationNormal, resVec);
-    
+
     double resNorm = anima::ComputeNorm(resVec);
-    
+
     if (std::abs(resNorm - 1.0) > 1.0e-4)
     {
         std::cout << "Sampled direction norm: " << resNorm << std::endl;
@@ -283,21 +381,78 @@ SampleFromWatsonDistribution(const ScalarType &kappa, const VectorType &meanDire
         std::cout << "Concentration parameter: " << kappa << std::endl;
         throw itk::ExceptionObject(__FILE__, __LINE__,"The Watson sampler should generate points on the 2-sphere.",ITK_LOCATION);
     }
-    
+
     anima::Normalize(resVec,resVec);
 }
 
-template <class ScalarType, unsigned int DataDimension>
+template <class ScalarType, class VectorType, class RNGType>
+void
+SampleFromWatsonDistribution(const ScalarType &kappa, const VectorType &meanDirection, VectorType &resVec, unsigned int DataDimension, RNGType &generator)
+{
+    /**********************************************************************************************//**
+         * \fn template <class ScalarType, class VectorType, class RNGType>
+         * 	   void
+         *     SampleFromWatsonDistribution(const ScalarType &kappa,
+         * 					const VectorType &meanDirection,
+         * 					VectorType &resVec,
+         * 					unsigned int DataDimension,
+         * 					RNGType &generator)
+         *
+         * \brief	Sample from the Watson distribution using the procedure described in
+         * 			Fisher et al., Statistical Analysis of Spherical Data, 1993, p.59.
+         *
+         * \author	Aymeric Stamm
+         * \date	October 2013
+         *
+         * \param	kappa		   	Concentration parameter of the Watson distribution.
+         * \param	meanDirection	Mean direction of the Watson distribution.
+         * \param	resVec			Resulting sample.
+         * \param	DataDimension	Dimension of the sphere + 1.
+         * \param	generator		Pseudo-random number generator.
+         **************************************************************************************************/
+
+    for (unsigned int i = 0;i < DataDimension;++i)
+        resVec[i] = 0;
+
+    VectorType rotationNormal(meanDirection);
+    double rotationAngle;
+    anima::GetWatsonSamplingRotation(meanDirection, DataDimension, rotationNormal, rotationAngle);
+
+    double S = anima::SampleWatsonCosine(kappa, generator);
+    double phi = SampleFromUniformDistribution(0.0, 2.0 * M_PI, generator);
+
+    anima::RotateWatsonSample(kappa, meanDirection, rotationNormal, rotationAngle, S, phi, resVec);
+}
+
+template <class ScalarType, class VectorType, class RNGType>
+void
+SampleFromWatsonDistribution(const ScalarType &kappa, const VectorType &meanDirection, std::vector <VectorType> &samples, unsigned int DataDimension,
+                             RNGType &generator)
+{
+    VectorType rotationNormal(meanDirection);
+    double rotationAngle;
+    anima::GetWatsonSamplingRotation(meanDirection, DataDimension, rotationNormal, rotationAngle);
+
+    for (unsigned int i = 0;i < samples.size();++i)
+    {
+        double S = anima::SampleWatsonCosine(kappa, generator);
+        double phi = SampleFromUniformDistribution(0.0, 2.0 * M_PI, generator);
+
+        anima::RotateWatsonSample(kappa, meanDirection, rotationNormal, rotationAngle, S, phi, samples[i]);
+    }
+}
+
+template <class ScalarType, unsigned int DataDimension, class RNGType>
 void
-SampleFromWatsonDistribution(const ScalarType &kappa, const vnl_vector_fixed < ScalarType, DataDimension > &meanDirection, vnl_vector_fixed < ScalarType, DataDimension > &resVec, std::mt19937 &generator)
+SampleFromWatsonDistribution(const ScalarType &kappa, const vnl_vector_fixed < ScalarType, DataDimension > &meanDirection, vnl_vector_fixed < ScalarType, DataDimension > &resVec, RNGType &generator)
 {
     /**********************************************************************************************//**
-         * \fn template <class ScalarType, unsigned int DataDimension>
+         * \fn template <class ScalarType, unsigned int DataDimension, class RNGType>
          * 	   void
          *     SampleFromWatsonDistribution(const ScalarType &kappa,
          * 					const vnl_vector_fixed < ScalarType, DataDimension > &meanDirection,
          * 					vnl_vector_fixed < ScalarType, DataDimension > &resVec,
-         * 					std::mt19937 &generator)
+         * 					RNGType &generator)
          *
          * \brief	Sample from the Watson distribution using the procedure described in
          * 			Fisher et al., Statistical Analysis of Spherical Data, 1993, p.59.
@@ -315,17 +470,17 @@ SampleFromWatsonDistribution(const ScalarType &kappa, const vnl_vector_fixed < S
     SampleFromWatsonDistribution(kappa, meanDirection, resVec, DataDimension, generator);
 }
 
-template <class ScalarType, unsigned int DataDimension>
+template <class ScalarType, unsigned int DataDimension, class RNGType>
 void
-SampleFromWatsonDistribution(const ScalarType &kappa, const itk::Point < ScalarType, DataDimension > &meanDirection, itk::Point < ScalarType, DataDimension > &resVec, std::mt19937 &generator)
+SampleFromWatsonDistribution(const ScalarType &kappa, const itk::Point < ScalarType, DataDimension > &meanDirection, itk::Point < ScalarType, DataDimension > &resVec, RNGType &generator)
 {
     /**********************************************************************************************//**
-         * \fn template <class ScalarType, unsigned int DataDimension>
+         * \fn template <class ScalarType, unsigned int DataDimension, class RNGType>
          * 	   void
          *     SampleFromWatsonDistribution(const ScalarType &kappa,
          * 					const itk::Point < ScalarType, DataDimension > &meanDirection,
          * 					itk::Point < ScalarType, DataDimension > &resVec,
-         * 					std::mt19937 &generator)
+         * 					RNGType &generator)
          *
          * \brief	Sample from the Watson distribution using the procedure described in
          * 			Fisher et al., Statistical Analysis of Spherical Data, 1993, p.59.
@@ -343,17 +498,17 @@ SampleFromWatsonDistribution(const ScalarType &kappa, const itk::Point < ScalarT
     SampleFromWatsonDistribution(kappa, meanDirection, resVec, DataDimension, generator);
 }
 
-template <class ScalarType, unsigned int DataDimension>
+template <class ScalarType, unsigned int DataDimension, class RNGType>
 void
-SampleFromWatsonDistribution(const ScalarType &kappa, const itk::Vector < ScalarType, DataDimension > &meanDirection, itk::Vector < ScalarType, DataDimension > &resVec, std::mt19937 &generator)
+SampleFromWatsonDistribution(const ScalarType &kappa, const itk::Vector < ScalarType, DataDimension > &meanDirection, itk::Vector < ScalarType, DataDimension > &resVec, RNGType &generator)
 {
     /**********************************************************************************************//**
-         * \fn template <class ScalarType, unsigned int DataDimension>
+         * \fn template <class ScalarType, unsigned int DataDimension, class RNGType>
          * 	   void
          *     SampleFromWatsonDistribution(const ScalarType &kappa,
          * 					const itk::Vector < ScalarType, DataDimension > &meanDirection,
          * 					itk::Vector < ScalarType, DataDimension > &resVec,
-         * 					std::mt19937 &generator)
+         * 					RNGType &generator)
          *
          * \brief	Sample from the Watson distribution using the procedure described in
          * 			Fisher et al., Statistical Analysis of Spherical Data, 1993, p.59.
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <itkObject.h>
+#include <itkMultiThreader.h>
+#include <itkImage.h>
+
+#include <vector>
+
+namespace anima
+{
+
+/**
+ * @brief Computes intensity histograms of several images inside the labels of a label image
+ * (one histogram per image and label, labels from 1 to NumberOfLabels, 0 being background),
+ * or on the whole image if no label image is given.
+ * Ranges and bin counts are accumulated by all threads on their own arrays (two passes over the voxels,
+ * one for ranges, one for counts), then summed. Bins have the same width over [min,max] of each histogram,
+ * the maximal value falling in the last bin. Smoothing and mode detection helpers are provided for
+ * histogram based initializations.
+ */
+template <class TInputImage, class TLabelImage = itk::Image <unsigned short, TInputImage::ImageDimension> >
+class ImageHistogramsComputer : public itk::Object
+{
+public:
+    typedef itk::Object Superclass;
+    typedef ImageHistogramsComputer <TInputImage,TLabelImage> Self;
+    typedef itk::SmartPointer<Self> Pointer;
+    typedef itk::SmartPointer<const Self> ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self)
+
+    /** Run-time type information (and related methods) */
+    itkTypeMacro(ImageHistogramsComputer, itk::Object)
+
+    typedef TInputImage InputImageType;
+    typedef typename InputImageType::ConstPointer InputImageConstPointer;
+    typedef typename InputImageType::RegionType RegionType;
+
+    typedef TLabelImage LabelImageType;
+    typedef typename LabelImageType::ConstPointer LabelImageConstPointer;
+
+    typedef std::vector <double> HistogramType;
+
+    void AddInputImage(const InputImageType *image);
+    void ClearInputImages() {m_InputImages.clear();}
+
+    //! Optional label image, histograms are computed on the whole image if not provided
+    void SetLabelImage(const LabelImageType *labels) {m_LabelImage = labels;}
+
+    itkSetMacro(NumberOfLabels, unsigned int)
+    itkGetMacro(NumberOfLabels, unsigned int)
+
+    //! Number of bins of each histogram, used if no bin width is set
+    itkSetMacro(NumberOfBins, unsigned int)
+
+    //! If strictly positive, each histogram gets floor(range / width) + 1 bins
+    itkSetMacro(MaximalBinWidth, double)
+
+    itkSetMacro(NumberOfThreads, unsigned int)
+    itkGetMacro(NumberOfThreads, unsigned int)
+
+    void Update();
+
+    //! Histograms are indexed by input image index and label (from 1 to NumberOfLabels)
+    const HistogramType &GetHistogram(unsigned int imageIndex, unsigned int label);
+    double GetMinimum(unsigned int imageIndex, unsigned int label);
+    double GetMaximum(unsigned int imageIndex, unsigned int label);
+    double GetBinWidth(unsigned int imageIndex, unsigned int label);
+    double GetBinCenter(unsigned int imageIndex, unsigned int label, unsigned int bin);
+    double GetTotalFrequency(unsigned int imageIndex, unsigned int label);
+
+    //! Convolution by a normalized gaussian kernel (truncated at four standard deviations), sigma is in bins
+    static void SmoothHistogram(const HistogramType &histogram, double sigma, HistogramType &smoothedHistogram);
+
+    /**
+     * Linear scan for modes: bins strictly above all others in [i - leftHalfWidth, i + rightHalfWidth]
+     * and above minimalValue. Modes are returned in increasing bin order.
+     */
+    static void FindModes(const HistogramType &histogram, unsigned int leftHalfWidth, unsigned int rightHalfWidth,
+                          double minimalValue, std::vector <unsigned int> &modes);
+
+    static ITK_THREAD_RETURN_TYPE ThreadHistogramsComputer(void *arg);
+
+    //! Range pass (computeRanges true) or counting pass on a sub-region
+    void ComputeRegionData(const RegionType &region, bool computeRanges, std::vector <double> &minimums,
+                           std::vector <double> &maximums, std::vector <double> &counts);
+
+protected:
+    ImageHistogramsComputer() : Superclass()
+    {
+        m_NumberOfLabels = 1;
+        m_NumberOfBins = 256;
+        m_MaximalBinWidth = 0;
+        m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+        m_LabelImage = NULL;
+    }
+
+    virtual ~ImageHistogramsComputer() {}
+
+    struct HistogramsThreadStruct
+    {
+        Pointer Filter;
+        std::vector <RegionType> regions;
+        bool computeRanges;
+        std::vector < std::vector <double> > minimums, maximums, counts;
+    };
+
+    unsigned int GetHistogramIndex(unsigned int imageIndex, unsigned int label);
+    void SplitRegion(unsigned int numPieces, std::vector <RegionType> &regions);
+
+private:
+    ImageHistogramsComputer(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+
+    std::vector <InputImageConstPointer> m_InputImages;
+    LabelImageConstPointer m_LabelImage;
+
+    unsigned int m_NumberOfLabels;
+    unsigned int m_NumberOfBins;
+    double m_MaximalBinWidth;
+    unsigned int m_NumberOfThreads;
+
+    //! Per histogram data, histogram index is imageIndex * NumberOfLabels + label - 1
+    std::vector <HistogramType> m_Histograms;
+    std::vector <double> m_Minimums, m_Maximums, m_BinWidths, m_TotalFrequencies;
+    std::vector <unsigned int> m_BinOffsets;
+};
+
+} // end namespace anima
+
+#include "animaImageHistogramsComputer.hxx"
@@ -0,0 +1,376 @@
+#pragma once
+#include "animaImageHistogramsComputer.h"
+
+#include <itkImageRegionConstIterator.h>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace anima
+{
+
+template <class TInputImage, class TLabelImage>
+void
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::AddInputImage(const InputImageType *image)
+{
+    m_InputImages.push_back(image);
+}
+
+template <class TInputImage, class TLabelImage>
+unsigned int
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::GetHistogramIndex(unsigned int imageIndex, unsigned int label)
+{
+    return imageIndex * m_NumberOfLabels + label - 1;
+}
+
+template <class TInputImage, class TLabelImage>
+const typename ImageHistogramsComputer<TInputImage,TLabelImage>::HistogramType &
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::GetHistogram(unsigned int imageIndex, unsigned int label)
+{
+    return m_Histograms[this->GetHistogramIndex(imageIndex,label)];
+}
+
+template <class TInputImage, class TLabelImage>
+double
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::GetMinimum(unsigned int imageIndex, unsigned int label)
+{
+    return m_Minimums[this->GetHistogramIndex(imageIndex,label)];
+}
+
+template <class TInputImage, class TLabelImage>
+double
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::GetMaximum(unsigned int imageIndex, unsigned int label)
+{
+    return m_Maximums[this->GetHistogramIndex(imageIndex,label)];
+}
+
+template <class TInputImage, class TLabelImage>
+double
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::GetBinWidth(unsigned int imageIndex, unsigned int label)
+{
+    return m_BinWidths[this->GetHistogramIndex(imageIndex,label)];
+}
+
+template <class TInputImage, class TLabelImage>
+double
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::GetBinCenter(unsigned int imageIndex, unsigned int label, unsigned int bin)
+{
+    unsigned int index = this->GetHistogramIndex(imageIndex,label);
+    return m_Minimums[index] + (bin + 0.5) * m_BinWidths[index];
+}
+
+template <class TInputImage, class TLabelImage>
+double
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::GetTotalFrequency(unsigned int imageIndex, unsigned int label)
+{
+    return m_TotalFrequencies[this->GetHistogramIndex(imageIndex,label)];
+}
+
+template <class TInputImage, class TLabelImage>
+void
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::SplitRegion(unsigned int numPieces, std::vector <RegionType> &regions)
+{
+    RegionType region = m_InputImages[0]->GetLargestPossibleRegion();
+
+    // Split along the slowest non flat dimension
+    unsigned int splitDimension = InputImageType::ImageDimension - 1;
+    while ((splitDimension > 0)&&(region.GetSize()[splitDimension] == 1))
+        --splitDimension;
+
+    unsigned int splitSize = region.GetSize()[splitDimension];
+    if (numPieces > splitSize)
+        numPieces = splitSize;
+
+    if (numPieces == 0)
+        numPieces = 1;
+
+    regions.resize(numPieces);
+    for (unsigned int i = 0;i < numPieces;++i)
+    {
+        unsigned int startSplit = i * splitSize / numPieces;
+        unsigned int endSplit = (i + 1) * splitSize / numPieces;
+
+        regions[i] = region;
+        regions[i].SetIndex(splitDimension,region.GetIndex()[splitDimension] + startSplit);
+        regions[i].SetSize(splitDimension,endSplit - startSplit);
+    }
+}
+
+template <class TInputImage, class TLabelImage>
+void
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::Update()
+{
+    unsigned int numImages = m_InputImages.size();
+    if (numImages == 0)
+        itkExceptionMacro(<<"No input image to compute histograms on");
+
+    RegionType region = m_InputImages[0]->GetLargestPossibleRegion();
+    for (unsigned int i = 1;i < numImages;++i)
+    {
+        if (m_InputImages[i]->GetLargestPossibleRegion() != region)
+            itkExceptionMacro(<<"Input images do not have the same region");
+    }
+
+    if (m_LabelImage && (m_LabelImage->GetLargestPossibleRegion().GetSize() != region.GetSize()))
+        itkExceptionMacro(<<"Label image and input images do not have the same size");
+
+    if (m_NumberOfLabels == 0)
+        itkExceptionMacro(<<"At least one label is required");
+
+    unsigned int numHistograms = numImages * m_NumberOfLabels;
+
+    HistogramsThreadStruct *tmpStr = new HistogramsThreadStruct;
+    tmpStr->Filter = this;
+    this->SplitRegion(m_NumberOfThreads,tmpStr->regions);
+
+    unsigned int numThreads = tmpStr->regions.size();
+    tmpStr->minimums.resize(numThreads);
+    tmpStr->maximums.resize(numThreads);
+    tmpStr->counts.resize(numThreads);
+
+    for (unsigned int i = 0;i < numThreads;++i)
+    {
+        tmpStr->minimums[i].resize(numHistograms);
+        std::fill(tmpStr->minimums[i].begin(),tmpStr->minimums[i].end(),std::numeric_limits<double>::max());
+        tmpStr->maximums[i].resize(numHistograms);
+        std::fill(tmpStr->maximums[i].begin(),tmpStr->maximums[i].end(),- std::numeric_limits<double>::max());
+    }
+
+    itk::MultiThreader::Pointer threaderHistograms = itk::MultiThreader::New();
+    threaderHistograms->SetNumberOfThreads(numThreads);
+    threaderHistograms->SetSingleMethod(this->ThreadHistogramsComputer,tmpStr);
+
+    // First pass: ranges
+    tmpStr->computeRanges = true;
+    threaderHistograms->SingleMethodExecute();
+
+    m_Minimums.resize(numHistograms);
+    m_Maximums.resize(numHistograms);
+    m_BinWidths.resize(numHistograms);
+    m_BinOffsets.resize(numHistograms);
+    m_Histograms.resize(numHistograms);
+    m_TotalFrequencies.resize(numHistograms);
+
+    unsigned int totalNumberOfBins = 0;
+    for (unsigned int i = 0;i < numHistograms;++i)
+    {
+        m_Minimums[i] = tmpStr->minimums[0][i];
+        m_Maximums[i] = tmpStr->maximums[0][i];
+        for (unsigned int j = 1;j < numThreads;++j)
+        {
+            m_Minimums[i] = std::min(m_Minimums[i],tmpStr->minimums[j][i]);
+            m_Maximums[i] = std::max(m_Maximums[i],tmpStr->maximums[j][i]);
+        }
+
+        // Empty histogram
+        if (m_Minimums[i] > m_Maximums[i])
+        {
+            m_Minimums[i] = 0;
+            m_Maximums[i] = 0;
+        }
+
+        unsigned int numBins = m_NumberOfBins;
+        if (m_MaximalBinWidth > 0)
+            numBins = std::floor((m_Maximums[i] - m_Minimums[i]) / m_MaximalBinWidth) + 1;
+
+        if (numBins == 0)
+            numBins = 1;
+
+        m_BinWidths[i] = (m_Maximums[i] - m_Minimums[i]) / numBins;
+        m_BinOffsets[i] = totalNumberOfBins;
+        m_Histograms[i].resize(numBins);
+        std::fill(m_Histograms[i].begin(),m_Histograms[i].end(),0.0);
+        totalNumberOfBins += numBins;
+    }
+
+    // Second pass: per thread bin counts
+    for (unsigned int i = 0;i < numThreads;++i)
+    {
+        tmpStr->counts[i].resize(totalNumberOfBins);
+        std::fill(tmpStr->counts[i].begin(),tmpStr->counts[i].end(),0.0);
+    }
+
+    tmpStr->computeRanges = false;
+    threaderHistograms->SingleMethodExecute();
+
+    for (unsigned int i = 0;i < numHistograms;++i)
+    {
+        m_TotalFrequencies[i] = 0;
+        unsigned int numBins = m_Histograms[i].size();
+        for (unsigned int j = 0;j < numThreads;++j)
+        {
+            const double *threadCounts = &(tmpStr->counts[j][m_BinOffsets[i]]);
+            for (unsigned int k = 0;k < numBins;++k)
+                m_Histograms[i][k] += threadCounts[k];
+        }
+
+        for (unsigned int k = 0;k < numBins;++k)
+            m_TotalFrequencies[i] += m_Histograms[i][k];
+    }
+
+    delete tmpStr;
+}
+
+template <class TInputImage, class TLabelImage>
+ITK_THREAD_RETURN_TYPE
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::ThreadHistogramsComputer(void *arg)
+{
+    itk::MultiThreader::ThreadInfoStruct *threadArgs = (itk::MultiThreader::ThreadInfoStruct *)arg;
+
+    unsigned int nbThread = threadArgs->ThreadID;
+
+    HistogramsThreadStruct *tmpStr = (HistogramsThreadStruct *)threadArgs->UserData;
+
+    tmpStr->Filter->ComputeRegionData(tmpStr->regions[nbThread],tmpStr->computeRanges,tmpStr->minimums[nbThread],
+                                      tmpStr->maximums[nbThread],tmpStr->counts[nbThread]);
+
+    return NULL;
+}
+
+template <class TInputImage, class TLabelImage>
+void
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::ComputeRegionData(const RegionType &region, bool computeRanges, std::vector <double> &minimums,
+                    std::vector <double> &maximums, std::vector <double> &counts)
+{
+    typedef itk::ImageRegionConstIterator <InputImageType> InputIteratorType;
+    typedef itk::ImageRegionConstIterator <LabelImageType> LabelIteratorType;
+
+    unsigned int numImages = m_InputImages.size();
+    std::vector <InputIteratorType> inputIterators(numImages);
+    for (unsigned int i = 0;i < numImages;++i)
+        inputIterators[i] = InputIteratorType(m_InputImages[i],region);
+
+    LabelIteratorType labelIt;
+    if (m_LabelImage)
+        labelIt = LabelIteratorType(m_LabelImage,region);
+
+    while (!inputIterators[0].IsAtEnd())
+    {
+        unsigned int label = 1;
+        if (m_LabelImage)
+        {
+            label = labelIt.Get();
+            ++labelIt;
+        }
+
+        bool validLabel = (label > 0)&&(label <= m_NumberOfLabels);
+        for (unsigned int i = 0;i < numImages;++i)
+        {
+            if (validLabel)
+            {
+                double value = inputIterators[i].Get();
+                unsigned int index = this->GetHistogramIndex(i,label);
+
+                if (computeRanges)
+                {
+                    if (value < minimums[index])
+                        minimums[index] = value;
+                    if (value > maximums[index])
+                        maximums[index] = value;
+                }
+                else
+                {
+                    unsigned int numBins = m_Histograms[index].size();
+                    unsigned int bin = 0;
+                    if (m_BinWidths[index] > 0)
+                    {
+                        double binPosition = (value - m_Minimums[index]) / m_BinWidths[index];
+                        if (binPosition > 0)
+                            bin = std::min((unsigned int)std::floor(binPosition),numBins - 1);
+                    }
+
+                    counts[m_BinOffsets[index] + bin] += 1.0;
+                }
+            }
+
+            ++inputIterators[i];
+        }
+    }
+}
+
+template <class TInputImage, class TLabelImage>
+void
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::SmoothHistogram(const HistogramType &histogram, double sigma, HistogramType &smoothedHistogram)
+{
+    unsigned int numBins = histogram.size();
+    smoothedHistogram.resize(numBins);
+
+    if (sigma <= 0)
+    {
+        smoothedHistogram = histogram;
+        return;
+    }
+
+    // Precomputed normalized kernel, half of it is enough
+    int radius = std::ceil(4.0 * sigma);
+    std::vector <double> kernel(radius + 1);
+    double kernelSum = 0;
+    for (int i = 0;i <= radius;++i)
+    {
+        kernel[i] = std::exp(- 0.5 * i * i / (sigma * sigma));
+        kernelSum += (i == 0) ? kernel[i] : 2.0 * kernel[i];
+    }
+
+    for (int i = 0;i <= radius;++i)
+        kernel[i] /= kernelSum;
+
+    for (int i = 0;i < (int)numBins;++i)
+    {
+        int lowerBin = std::max(i - radius,0);
+        int upperBin = std::min(i + radius,(int)numBins - 1);
+
+        double smoothedValue = 0;
+        for (int j = lowerBin;j <= upperBin;++j)
+            smoothedValue += kernel[std::abs(j - i)] * histogram[j];
+
+        smoothedHistogram[i] = smoothedValue;
+    }
+}
+
+template <class TInputImage, class TLabelImage>
+void
+ImageHistogramsComputer<TInputImage,TLabelImage>
+::FindModes(const HistogramType &histogram, unsigned int leftHalfWidth, unsigned int rightHalfWidth,
+            double minimalValue, std::vector <unsigned int> &modes)
+{
+    modes.clear();
+    int numBins = histogram.size();
+
+    for (int i = 0;i < numBins;++i)
+    {
+        if (histogram[i] <= minimalValue)
+            continue;
+
+        int lowerBin = std::max(i - (int)leftHalfWidth,0);
+        int upperBin = std::min(i + (int)rightHalfWidth,numBins - 1);
+
+        bool isMode = true;
+        for (int j = lowerBin;j <= upperBin;++j)
+        {
+            if ((j != i)&&(histogram[i] <= histogram[j]))
+            {
+                isMode = false;
+                break;
+            }
+        }
+
+        if (isMode)
+            modes.push_back(i);
+    }
+}
+
+} // end namespace anima
@@ -126,7 +126,8 @@ DirectionScaleSkewTransform<TScalarType>
 {
     this->ComputeLogRepresentations();
 
-    vnl_matrix <TScalarType> transformMatrix = anima::GetExponential(m_LogTransform);
+    vnl_matrix_fixed <TScalarType,4,4> transformMatrix(m_LogTransform.data_block());
+    transformMatrix = anima::GetExponential(transformMatrix);
 
     MatrixType linearMatrix;
     OffsetType off;
@@ -8,12 +8,26 @@
 namespace anima
 {
 
+template <class TInput, class TScalarType, unsigned int NDimensions> class WeightedPairingsMoments;
+
 // Transformation estimation utilities, many of these tools are implementations of X. Pennec PhD thesis (chap. 8)
 
 template <class TInput, class TScalarType, unsigned int NDimensions>
         void computeLogEuclideanAverage(std::vector < vnl_matrix <TInput> > &inputTransforms, std::vector <TInput> &weights,
                                         typename itk::AffineTransform<TScalarType,NDimensions>::Pointer &resultTransform);
 
+//! Computes the log-Euclidean transform from an already averaged logarithm
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void computeAffineFromLogarithm(const vnl_matrix <TInput> &logMatrix,
+                                typename itk::AffineTransform<TScalarType,NDimensions>::Pointer &resultTransform);
+
+//! Accumulates weighted moments of all pairings, from which LSW translation, rigid and affine transforms are computed
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void computePairingsMoments(std::vector < itk::Point<TInput,NDimensions> > &inputOrigins,
+                            std::vector < itk::Point<TInput,NDimensions> > &inputTransformed,
+                            std::vector <TInput> &weights,
+                            anima::WeightedPairingsMoments <TInput,TScalarType,NDimensions> &moments);
+
 template <class TInput, class TScalarType, unsigned int NDimensions>
 void computeTranslationLSWFromTranslations(std::vector < itk::Point<TInput,NDimensions> > &inputOrigins,
                                            std::vector < itk::Point<TInput,NDimensions> > &inputTransformed,
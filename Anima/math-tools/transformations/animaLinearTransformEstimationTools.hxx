@@ -2,6 +2,7 @@
 #include "animaLinearTransformEstimationTools.h"
 
 #include <animaMatrixLogExp.h>
+#include <animaWeightedPairingsMoments.h>
 
 #include <vnl/vnl_inverse.h>
 #include <itkVector.h>
@@ -13,49 +14,32 @@
 namespace anima
 {
 template <class TInput, class TScalarType, unsigned int NDimensions>
-void computeTranslationLSWFromTranslations(std::vector < itk::Point<TInput,NDimensions> > &inputOrigins,
-                                           std::vector < itk::Point<TInput,NDimensions> > &inputTransformed,
-                                           std::vector <TInput> &weights,
-                                           typename itk::AffineTransform<TScalarType,NDimensions>::Pointer &resultTransform)
+void computePairingsMoments(std::vector < itk::Point<TInput,NDimensions> > &inputOrigins,
+                            std::vector < itk::Point<TInput,NDimensions> > &inputTransformed,
+                            std::vector <TInput> &weights,
+                            anima::WeightedPairingsMoments <TInput,TScalarType,NDimensions> &moments)
 {
     unsigned int nbPts = inputOrigins.size();
-    itk::Point <TInput,NDimensions> barX, barY;
-    // See Pennec PhD
-    vnl_matrix <TInput> AMatrix(4,4,0);
-    vnl_matrix <TInput> tmpMatrix(4,4);
-
-    for (unsigned int j = 0;j < NDimensions;++j)
+    if (nbPts == 0)
     {
-        barX[j] = 0;
-        barY[j] = 0;
+        moments.Reset();
+        return;
     }
 
-    double sumWeights = 0;
+    moments.Reset(inputOrigins[0],inputTransformed[0]);
     for (unsigned int i = 0;i < nbPts;++i)
-    {
-        for (unsigned int j = 0;j < NDimensions;++j)
-        {
-            barX[j] += weights[i] * inputOrigins[i][j];
-            barY[j] += weights[i] * inputTransformed[i][j];
-        }
-
-        sumWeights += weights[i];
-    }
-
-    for (unsigned int j = 0;j < NDimensions;++j)
-    {
-        barX[j] /= sumWeights;
-        barY[j] /= sumWeights;
-    }
-
-    itk::Vector <TScalarType,NDimensions> translationPart;
-    for (unsigned int i = 0;i < NDimensions;++i)
-        translationPart[i] = barY[i] - barX[i];
-
-    resultTransform = itk::AffineTransform<TScalarType,NDimensions>::New();
+        moments.AddPairing(inputOrigins[i],inputTransformed[i],weights[i]);
+}
 
-    resultTransform->SetIdentity();
-    resultTransform->SetOffset(translationPart);
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void computeTranslationLSWFromTranslations(std::vector < itk::Point<TInput,NDimensions> > &inputOrigins,
+                                           std::vector < itk::Point<TInput,NDimensions> > &inputTransformed,
+                                           std::vector <TInput> &weights,
+                                           typename itk::AffineTransform<TScalarType,NDimensions>::Pointer &resultTransform)
+{
+    anima::WeightedPairingsMoments <TInput,TScalarType,NDimensions> moments;
+    anima::computePairingsMoments(inputOrigins,inputTransformed,weights,moments);
+    moments.ComputeTranslation(resultTransform);
 }
 
 template <class TInput, class TScalarType, unsigned int NDimensions>
@@ -64,66 +48,9 @@ void computeRigidLSWFromTranslations(std::vector < itk::Point<TInput,NDimensions
                                      std::vector <TInput> &weights,
                                      typename itk::AffineTransform<TScalarType,NDimensions>::Pointer &resultTransform)
 {
-    unsigned int nbPts = inputOrigins.size();
-    itk::Point <TInput,NDimensions> barX, barY;
-    // See Pennec PhD
-    vnl_matrix <TInput> AMatrix(4,4,0);
-    vnl_matrix <TInput> tmpMatrix(4,4);
-
-    for (unsigned int j = 0;j < NDimensions;++j)
-    {
-        barX[j] = 0;
-        barY[j] = 0;
-    }
-
-    double sumWeights = 0;
-    for (unsigned int i = 0;i < nbPts;++i)
-    {
-        for (unsigned int j = 0;j < NDimensions;++j)
-        {
-            barX[j] += weights[i] * inputOrigins[i][j];
-            barY[j] += weights[i] * inputTransformed[i][j];
-        }
-
-        sumWeights += weights[i];
-    }
-
-    for (unsigned int j = 0;j < NDimensions;++j)
-    {
-        barX[j] /= sumWeights;
-        barY[j] /= sumWeights;
-    }
-
-    itk::Vector <TInput,NDimensions> xVector, yVector;
-    for (unsigned int i = 0;i < nbPts;++i)
-    {
-        xVector = inputOrigins[i] - barX;
-        yVector = inputTransformed[i] - barY;
-        anima::pairingToQuaternion(xVector,yVector,tmpMatrix);
-        AMatrix += weights[i]*tmpMatrix.transpose()*tmpMatrix;
-    }
-
-    itk::SymmetricEigenAnalysis < vnl_matrix <TInput>, vnl_diag_matrix<TInput>, vnl_matrix <TInput> > eigenSystem(4);
-    vnl_matrix <double> eVec(4,4);
-    vnl_diag_matrix <double> eVals(4);
-
-    eigenSystem.SetOrderEigenValues(true);
-    eigenSystem.ComputeEigenValuesAndVectors(AMatrix, eVals, eVec);
-
-    vnl_matrix <TScalarType> rotationMatrix = anima::computeRotationFromQuaternion<TInput,TScalarType>(eVec.get_row(0));
-
-    itk::Vector <TScalarType,NDimensions> translationPart;
-    for (unsigned int i = 0;i < NDimensions;++i)
-    {
-        translationPart[i] = barY[i];
-        for (unsigned int j = 0;j < NDimensions;++j)
-            translationPart[i] -= rotationMatrix(i,j)*barX[j];
-    }
-
-    resultTransform = itk::AffineTransform<TScalarType,NDimensions>::New();
-
-    resultTransform->SetMatrix(rotationMatrix);
-    resultTransform->SetOffset(translationPart);
+    anima::WeightedPairingsMoments <TInput,TScalarType,NDimensions> moments;
+    anima::computePairingsMoments(inputOrigins,inputTransformed,weights,moments);
+    moments.ComputeRigid(resultTransform);
 }
 
 template <class TInput, class TScalarType, unsigned int NDimensions>
@@ -133,7 +60,6 @@ void computeLogEuclideanAverage(std::vector < vnl_matrix <TInput> > &inputTransf
     unsigned int nbPts = inputTransforms.size();
 
     vnl_matrix <TInput> resultMatrix(NDimensions+1,NDimensions+1,0);
-    vnl_matrix <TInput> tmpMatrix;
     double sumWeights = 0;
     for (unsigned int i = 0;i < nbPts;++i)
     {
@@ -143,6 +69,14 @@ void computeLogEuclideanAverage(std::vector < vnl_matrix <TInput> > &inputTransf
 
     resultMatrix /= sumWeights;
 
+    anima::computeAffineFromLogarithm<TInput,TScalarType,NDimensions>(resultMatrix,resultTransform);
+}
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void computeAffineFromLogarithm(const vnl_matrix <TInput> &logMatrix,
+                                typename itk::AffineTransform<TScalarType,NDimensions>::Pointer &resultTransform)
+{
+    vnl_matrix_fixed <TInput,NDimensions+1,NDimensions+1> resultMatrix(logMatrix.data_block());
     resultMatrix = anima::GetExponential(resultMatrix);
 
     resultTransform = itk::AffineTransform<TScalarType,NDimensions>::New();
@@ -167,64 +101,9 @@ void computeAffineLSWFromTranslations(std::vector < itk::Point<TInput,NDimension
                                       std::vector <TInput> &weights,
                                       typename itk::AffineTransform<TScalarType,NDimensions>::Pointer &resultTransform)
 {
-    unsigned int nbPts = inputOrigins.size();
-    itk::Point <TInput,NDimensions> barX, barY;
-    // See Pennec PhD
-    vnl_matrix <TInput> SigmaXXMatrix(NDimensions,NDimensions,0);
-    vnl_matrix <TInput> SigmaYXMatrix(NDimensions,NDimensions,0);
-
-    for (unsigned int j = 0;j < NDimensions;++j)
-    {
-        barX[j] = 0;
-        barY[j] = 0;
-    }
-
-    double sumWeights = 0;
-    for (unsigned int i = 0;i < nbPts;++i)
-    {
-        for (unsigned int j = 0;j < NDimensions;++j)
-        {
-            barX[j] += weights[i] * inputOrigins[i][j];
-            barY[j] += weights[i] * inputTransformed[i][j];
-        }
-
-        sumWeights += weights[i];
-    }
-
-    for (unsigned int j = 0;j < NDimensions;++j)
-    {
-        barX[j] /= sumWeights;
-        barY[j] /= sumWeights;
-    }
-
-    for (unsigned int i = 0;i < nbPts;++i)
-    {
-        for (unsigned int j = 0;j < NDimensions;++j)
-            for (unsigned int k = 0;k < NDimensions;++k)
-            {
-                SigmaXXMatrix(j,k) += weights[i]*(inputOrigins[i][j] - barX[j])*(inputOrigins[i][k] - barX[k]);
-                SigmaYXMatrix(j,k) += weights[i]*(inputTransformed[i][j] - barY[j])*(inputOrigins[i][k] - barX[k]);
-            }
-    }
-
-    vnl_matrix <TInput> affineMatrix = SigmaYXMatrix * vnl_inverse (SigmaXXMatrix);
-
-    vnl_matrix <TScalarType> outMatrix(NDimensions,NDimensions);
-    itk::Vector <TScalarType,NDimensions> translationPart;
-    for (unsigned int i = 0;i < NDimensions;++i)
-    {
-        translationPart[i] = barY[i];
-        for (unsigned int j = 0;j < NDimensions;++j)
-        {
-            outMatrix(i,j) = affineMatrix(i,j);
-            translationPart[i] -= affineMatrix(i,j)*barX[j];
-        }
-    }
-
-    resultTransform = itk::AffineTransform<TScalarType,NDimensions>::New();
-
-    resultTransform->SetMatrix(outMatrix);
-    resultTransform->SetOffset(translationPart);
+    anima::WeightedPairingsMoments <TInput,TScalarType,NDimensions> moments;
+    anima::computePairingsMoments(inputOrigins,inputTransformed,weights,moments);
+    moments.ComputeAffine(resultTransform);
 }
 
 template <class TInput, class TOutput> vnl_matrix <TOutput> computeRotationFromQuaternion(vnl_vector <TInput> eigenVector)
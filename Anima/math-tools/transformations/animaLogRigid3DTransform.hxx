@@ -84,7 +84,8 @@ LogRigid3DTransform<TScalarType>
 {
     this->ComputeLogRepresentations();
 
-    vnl_matrix <TScalarType> transformMatrix = GetExponential(m_LogTransform);
+    vnl_matrix_fixed <TScalarType,4,4> transformMatrix(m_LogTransform.data_block());
+    transformMatrix = anima::GetRigidExponential(transformMatrix);
 
     MatrixType linearMatrix;
     OffsetType off;
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <itkAffineTransform.h>
+#include <itkPoint.h>
+
+#include <vnl/vnl_matrix_fixed.h>
+#include <vnl/vnl_vector_fixed.h>
+
+namespace anima
+{
+
+/**
+ * @brief Weighted first and second order moments of point pairings (origin, transformed), from which least squares
+ * translation, rigid (Pennec PhD, chap. 8) and affine transforms are obtained in closed form.
+ *
+ * Pairings may be added or removed one by one (e.g. when trimming outliers) without going over the whole set again,
+ * and moments accumulated on separate pairing subsets may be merged. Coordinates are accumulated relative to
+ * reference points set by Reset, to limit cancellation when computing centered moments.
+ */
+template <class TInput, class TScalarType, unsigned int NDimensions>
+class WeightedPairingsMoments
+{
+public:
+    typedef itk::Point <TInput,NDimensions> PointType;
+    typedef itk::AffineTransform <TScalarType,NDimensions> OutputTransformType;
+    typedef typename OutputTransformType::Pointer OutputTransformPointer;
+
+    typedef vnl_vector_fixed <double,NDimensions> VectorType;
+    typedef vnl_matrix_fixed <double,NDimensions,NDimensions> MatrixType;
+
+    WeightedPairingsMoments();
+
+    //! Clears moments, keeping reference points
+    void Reset();
+
+    //! Clears moments and sets reference points, ideally close to the pairings centroids
+    void Reset(const PointType &originReference, const PointType &transformedReference);
+
+    void AddPairing(const PointType &origin, const PointType &transformed, double weight);
+    void RemovePairing(const PointType &origin, const PointType &transformed, double weight)
+    {
+        this->AddPairing(origin,transformed,- weight);
+    }
+
+    //! Adds moments of another pairing set, accumulated with the same reference points
+    void Merge(const WeightedPairingsMoments &other);
+
+    double GetSumOfWeights() const {return m_SumWeights;}
+
+    void ComputeTranslation(OutputTransformPointer &resultTransform) const;
+    void ComputeRigid(OutputTransformPointer &resultTransform) const;
+    void ComputeAffine(OutputTransformPointer &resultTransform) const;
+
+private:
+    void ComputeCentroids(VectorType &barX, VectorType &barY) const;
+
+    //! Centered second order moments (not normalized by the sum of weights)
+    void ComputeCenteredMoments(MatrixType &sigmaXX, MatrixType &sigmaYY, MatrixType &sigmaYX) const;
+
+    PointType m_OriginReference, m_TransformedReference;
+
+    double m_SumWeights;
+    VectorType m_SumX, m_SumY;
+    MatrixType m_SumXX, m_SumYY, m_SumYX;
+};
+
+} // end of namespace anima
+
+#include "animaWeightedPairingsMoments.hxx"
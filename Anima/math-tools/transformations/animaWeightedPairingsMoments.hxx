@@ -0,0 +1,232 @@
+#pragma once
+#include "animaWeightedPairingsMoments.h"
+
+#include <animaLinearTransformEstimationTools.h>
+
+#include <itkSymmetricEigenAnalysis.h>
+#include <vnl/vnl_inverse.h>
+
+namespace anima
+{
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+WeightedPairingsMoments <TInput,TScalarType,NDimensions>
+::WeightedPairingsMoments()
+{
+    m_OriginReference.Fill(0);
+    m_TransformedReference.Fill(0);
+
+    this->Reset();
+}
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void
+WeightedPairingsMoments <TInput,TScalarType,NDimensions>
+::Reset()
+{
+    m_SumWeights = 0;
+    m_SumX.fill(0);
+    m_SumY.fill(0);
+    m_SumXX.fill(0);
+    m_SumYY.fill(0);
+    m_SumYX.fill(0);
+}
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void
+WeightedPairingsMoments <TInput,TScalarType,NDimensions>
+::Reset(const PointType &originReference, const PointType &transformedReference)
+{
+    m_OriginReference = originReference;
+    m_TransformedReference = transformedReference;
+
+    this->Reset();
+}
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void
+WeightedPairingsMoments <TInput,TScalarType,NDimensions>
+::AddPairing(const PointType &origin, const PointType &transformed, double weight)
+{
+    VectorType xVector, yVector;
+    for (unsigned int i = 0;i < NDimensions;++i)
+    {
+        xVector[i] = origin[i] - m_OriginReference[i];
+        yVector[i] = transformed[i] - m_TransformedReference[i];
+    }
+
+    m_SumWeights += weight;
+    for (unsigned int i = 0;i < NDimensions;++i)
+    {
+        m_SumX[i] += weight * xVector[i];
+        m_SumY[i] += weight * yVector[i];
+
+        for (unsigned int j = 0;j < NDimensions;++j)
+        {
+            m_SumXX(i,j) += weight * xVector[i] * xVector[j];
+            m_SumYY(i,j) += weight * yVector[i] * yVector[j];
+            m_SumYX(i,j) += weight * yVector[i] * xVector[j];
+        }
+    }
+}
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void
+WeightedPairingsMoments <TInput,TScalarType,NDimensions>
+::Merge(const WeightedPairingsMoments &other)
+{
+    m_SumWeights += other.m_SumWeights;
+    m_SumX += other.m_SumX;
+    m_SumY += other.m_SumY;
+    m_SumXX += other.m_SumXX;
+    m_SumYY += other.m_SumYY;
+    m_SumYX += other.m_SumYX;
+}
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void
+WeightedPairingsMoments <TInput,TScalarType,NDimensions>
+::ComputeCentroids(VectorType &barX, VectorType &barY) const
+{
+    for (unsigned int i = 0;i < NDimensions;++i)
+    {
+        barX[i] = m_SumX[i] / m_SumWeights + m_OriginReference[i];
+        barY[i] = m_SumY[i] / m_SumWeights + m_TransformedReference[i];
+    }
+}
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void
+WeightedPairingsMoments <TInput,TScalarType,NDimensions>
+::ComputeCenteredMoments(MatrixType &sigmaXX, MatrixType &sigmaYY, MatrixType &sigmaYX) const
+{
+    for (unsigned int i = 0;i < NDimensions;++i)
+    {
+        for (unsigned int j = 0;j < NDimensions;++j)
+        {
+            sigmaXX(i,j) = m_SumXX(i,j) - m_SumX[i] * m_SumX[j] / m_SumWeights;
+            sigmaYY(i,j) = m_SumYY(i,j) - m_SumY[i] * m_SumY[j] / m_SumWeights;
+            sigmaYX(i,j) = m_SumYX(i,j) - m_SumY[i] * m_SumX[j] / m_SumWeights;
+        }
+    }
+}
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void
+WeightedPairingsMoments <TInput,TScalarType,NDimensions>
+::ComputeTranslation(OutputTransformPointer &resultTransform) const
+{
+    VectorType barX, barY;
+    this->ComputeCentroids(barX,barY);
+
+    itk::Vector <TScalarType,NDimensions> translationPart;
+    for (unsigned int i = 0;i < NDimensions;++i)
+        translationPart[i] = barY[i] - barX[i];
+
+    resultTransform = OutputTransformType::New();
+
+    resultTransform->SetIdentity();
+    resultTransform->SetOffset(translationPart);
+}
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void
+WeightedPairingsMoments <TInput,TScalarType,NDimensions>
+::ComputeRigid(OutputTransformPointer &resultTransform) const
+{
+    VectorType barX, barY;
+    this->ComputeCentroids(barX,barY);
+
+    MatrixType sigmaXX, sigmaYY, sigmaYX;
+    this->ComputeCenteredMoments(sigmaXX,sigmaYY,sigmaYX);
+
+    // Pennec quaternion matrix A = sum_i w_i Q_i^T Q_i, where Q_i is linear in the centered pairing z_i = (x_i, y_i):
+    // Q_i = sum_m z_i[m] B_m, hence A = sum_{m,n} Cov(z)_{mn} B_m^T B_n
+    const unsigned int pairingDimension = 2 * NDimensions;
+    std::vector < vnl_matrix <double> > basisMatrices(pairingDimension);
+    itk::Vector <double,NDimensions> xVector, yVector;
+    for (unsigned int m = 0;m < pairingDimension;++m)
+    {
+        xVector.Fill(0);
+        yVector.Fill(0);
+        if (m < NDimensions)
+            xVector[m] = 1;
+        else
+            yVector[m - NDimensions] = 1;
+
+        anima::pairingToQuaternion(xVector,yVector,basisMatrices[m]);
+    }
+
+    vnl_matrix <TInput> AMatrix(4,4,0);
+    for (unsigned int m = 0;m < pairingDimension;++m)
+    {
+        for (unsigned int n = 0;n < pairingDimension;++n)
+        {
+            double covValue = 0;
+            if (m < NDimensions)
+                covValue = (n < NDimensions) ? sigmaXX(m,n) : sigmaYX(n - NDimensions,m);
+            else
+                covValue = (n < NDimensions) ? sigmaYX(m - NDimensions,n) : sigmaYY(m - NDimensions,n - NDimensions);
+
+            if (covValue == 0)
+                continue;
+
+            AMatrix += covValue * basisMatrices[m].transpose() * basisMatrices[n];
+        }
+    }
+
+    itk::SymmetricEigenAnalysis < vnl_matrix <TInput>, vnl_diag_matrix<TInput>, vnl_matrix <TInput> > eigenSystem(4);
+    vnl_matrix <double> eVec(4,4);
+    vnl_diag_matrix <double> eVals(4);
+
+    eigenSystem.SetOrderEigenValues(true);
+    eigenSystem.ComputeEigenValuesAndVectors(AMatrix, eVals, eVec);
+
+    vnl_matrix <TScalarType> rotationMatrix = anima::computeRotationFromQuaternion<TInput,TScalarType>(eVec.get_row(0));
+
+    itk::Vector <TScalarType,NDimensions> translationPart;
+    for (unsigned int i = 0;i < NDimensions;++i)
+    {
+        translationPart[i] = barY[i];
+        for (unsigned int j = 0;j < NDimensions;++j)
+            translationPart[i] -= rotationMatrix(i,j)*barX[j];
+    }
+
+    resultTransform = OutputTransformType::New();
+
+    resultTransform->SetMatrix(rotationMatrix);
+    resultTransform->SetOffset(translationPart);
+}
+
+template <class TInput, class TScalarType, unsigned int NDimensions>
+void
+WeightedPairingsMoments <TInput,TScalarType,NDimensions>
+::ComputeAffine(OutputTransformPointer &resultTransform) const
+{
+    VectorType barX, barY;
+    this->ComputeCentroids(barX,barY);
+
+    MatrixType sigmaXX, sigmaYY, sigmaYX;
+    this->ComputeCenteredMoments(sigmaXX,sigmaYY,sigmaYX);
+
+    MatrixType affineMatrix = sigmaYX * vnl_inverse(sigmaXX);
+
+    vnl_matrix <TScalarType> outMatrix(NDimensions,NDimensions);
+    itk::Vector <TScalarType,NDimensions> translationPart;
+    for (unsigned int i = 0;i < NDimensions;++i)
+    {
+        translationPart[i] = barY[i];
+        for (unsigned int j = 0;j < NDimensions;++j)
+        {
+            outMatrix(i,j) = affineMatrix(i,j);
+            translationPart[i] -= affineMatrix(i,j)*barX[j];
+        }
+    }
+
+    resultTransform = OutputTransformType::New();
+
+    resultTransform->SetMatrix(outMatrix);
+    resultTransform->SetOffset(translationPart);
+}
+
+} // end of namespace anima
@@ -0,0 +1,230 @@
+#include "animaMonoExponentialT2Estimator.h"
+#include <animaBesselFunctions.h>
+
+#include <cmath>
+#include <algorithm>
+
+namespace anima
+{
+
+MonoExponentialT2Estimator::MonoExponentialT2Estimator()
+{
+    m_T2LowerBound = 1.0e-4;
+    m_T2UpperBound = 1000;
+    m_M0LowerBound = 1.0e-4;
+    m_M0UpperBound = 5000;
+    m_RelativeTolerance = 1.0e-4;
+
+    m_RicianNoiseSigma = 0;
+    m_NumberOfBiasCorrectionIterations = 3;
+}
+
+void
+MonoExponentialT2Estimator::SetEchoTimes(const std::vector <double> &echoTimes)
+{
+    m_EchoTimes = echoTimes;
+}
+
+void
+MonoExponentialT2Estimator::Estimate(const double *signal, double &t2Value, double &m0Value, double *workBuffer) const
+{
+    unsigned int numEchoes = m_EchoTimes.size();
+
+    double initT2 = this->LogLinearInitialization(signal);
+    t2Value = this->MinimizeProfiledCost(signal,initT2,m0Value);
+
+    if (m_RicianNoiseSigma <= 0)
+        return;
+
+    for (unsigned int i = 0;i < m_NumberOfBiasCorrectionIterations;++i)
+    {
+        // Remove the Rician bias predicted by the current fit from observations, then refit
+        for (unsigned int j = 0;j < numEchoes;++j)
+        {
+            double noiseFreeSignal = m0Value * std::exp(- m_EchoTimes[j] / t2Value);
+            double bias = RicianMean(noiseFreeSignal,m_RicianNoiseSigma) - noiseFreeSignal;
+            workBuffer[j] = signal[j] - bias;
+        }
+
+        t2Value = this->MinimizeProfiledCost(workBuffer,t2Value,m0Value);
+    }
+}
+
+double
+MonoExponentialT2Estimator::RicianMean(double nu, double sigma)
+{
+    if (sigma <= 0)
+        return nu;
+
+    double alpha = nu * nu / (2.0 * sigma * sigma);
+
+    // Asymptotic value, Bessel functions would overflow
+    if (alpha > 500)
+        return std::sqrt(nu * nu + sigma * sigma);
+
+    // Laguerre polynomial L_{1/2}(-alpha), exponentially scaled Bessel functions for stability
+    double halfAlpha = alpha / 2.0;
+    double laguerreValue = (1.0 + alpha) * std::exp(anima::log_bessel_i(0,halfAlpha) - halfAlpha);
+    if (alpha > 0)
+        laguerreValue += alpha * std::exp(anima::log_bessel_i(1,halfAlpha) - halfAlpha);
+
+    return sigma * std::sqrt(M_PI / 2.0) * laguerreValue;
+}
+
+double
+MonoExponentialT2Estimator::LogLinearInitialization(const double *signal) const
+{
+    unsigned int numEchoes = m_EchoTimes.size();
+
+    // Weights equal to squared signals compensate for the log transform of noise
+    double sumWeights = 0, sumWeightsT = 0, sumWeightsL = 0;
+    double sumWeightsTT = 0, sumWeightsTL = 0;
+    for (unsigned int i = 0;i < numEchoes;++i)
+    {
+        if (signal[i] <= 0)
+            continue;
+
+        double weight = signal[i] * signal[i];
+        double logSignal = std::log(signal[i]);
+
+        sumWeights += weight;
+        sumWeightsT += weight * m_EchoTimes[i];
+        sumWeightsL += weight * logSignal;
+        sumWeightsTT += weight * m_EchoTimes[i] * m_EchoTimes[i];
+        sumWeightsTL += weight * m_EchoTimes[i] * logSignal;
+    }
+
+    double denominator = sumWeights * sumWeightsTT - sumWeightsT * sumWeightsT;
+    if (denominator <= 0)
+        return m_T2UpperBound;
+
+    double slope = (sumWeights * sumWeightsTL - sumWeightsT * sumWeightsL) / denominator;
+    if (slope >= 0)
+        return m_T2UpperBound;
+
+    return std::min(m_T2UpperBound,std::max(m_T2LowerBound, - 1.0 / slope));
+}
+
+double
+MonoExponentialT2Estimator::ProfiledCost(double t2Value, const double *signal, double &m0Value) const
+{
+    unsigned int numEchoes = m_EchoTimes.size();
+
+    double sumSignalExp = 0, sumSquaredExp = 0, sumSquaredSignal = 0;
+    for (unsigned int i = 0;i < numEchoes;++i)
+    {
+        double expValue = std::exp(- m_EchoTimes[i] / t2Value);
+        sumSignalExp += signal[i] * expValue;
+        sumSquaredExp += expValue * expValue;
+        sumSquaredSignal += signal[i] * signal[i];
+    }
+
+    if (sumSquaredExp <= 0)
+    {
+        m0Value = m_M0LowerBound;
+        return sumSquaredSignal;
+    }
+
+    // Cost is quadratic in M0: clamping the unconstrained optimum gives the bounded optimum
+    m0Value = std::min(m_M0UpperBound,std::max(m_M0LowerBound,sumSignalExp / sumSquaredExp));
+
+    return sumSquaredSignal - 2.0 * m0Value * sumSignalExp + m0Value * m0Value * sumSquaredExp;
+}
+
+double
+MonoExponentialT2Estimator::MinimizeProfiledCost(const double *signal, double initT2, double &m0Value) const
+{
+    // Brent's method (parabolic interpolation safeguarded by golden section search)
+    const double goldenRatio = 0.3819660112501051;
+    const double epsilon = 1.0e-10;
+    const unsigned int maxIterations = 100;
+
+    double a = m_T2LowerBound;
+    double b = m_T2UpperBound;
+    double x = std::min(b,std::max(a,initT2));
+    double w = x, v = x;
+
+    double tmpM0;
+    double fx = this->ProfiledCost(x,signal,tmpM0);
+    double fw = fx, fv = fx;
+
+    double d = 0, e = 0;
+    for (unsigned int iter = 0;iter < maxIterations;++iter)
+    {
+        double middle = 0.5 * (a + b);
+        double tol1 = m_RelativeTolerance * std::abs(x) + epsilon;
+        double tol2 = 2.0 * tol1;
+
+        if (std::abs(x - middle) <= (tol2 - 0.5 * (b - a)))
+            break;
+
+        bool useGolden = true;
+        if (std::abs(e) > tol1)
+        {
+            // Try parabolic fit
+            double r = (x - w) * (fx - fv);
+            double q = (x - v) * (fx - fw);
+            double p = (x - v) * q - (x - w) * r;
+            q = 2.0 * (q - r);
+            if (q > 0)
+                p = -p;
+            q = std::abs(q);
+
+            double eTmp = e;
+            e = d;
+
+            if ((std::abs(p) < std::abs(0.5 * q * eTmp)) && (p > q * (a - x)) && (p < q * (b - x)))
+            {
+                d = p / q;
+                double u = x + d;
+                if ((u - a < tol2) || (b - u < tol2))
+                    d = (middle >= x) ? tol1 : - tol1;
+
+                useGolden = false;
+            }
+        }
+
+        if (useGolden)
+        {
+            e = (x >= middle) ? a - x : b - x;
+            d = goldenRatio * e;
+        }
+
+        double u = (std::abs(d) >= tol1) ? x + d : x + ((d >= 0) ? tol1 : - tol1);
+        double fu = this->ProfiledCost(u,signal,tmpM0);
+
+        if (fu <= fx)
+        {
+            if (u >= x)
+                a = x;
+            else
+                b = x;
+
+            v = w; fv = fw;
+            w = x; fw = fx;
+            x = u; fx = fu;
+        }
+        else
+        {
+            if (u < x)
+                a = u;
+            else
+                b = u;
+
+            if ((fu <= fw) || (w == x))
+            {
+                v = w; fv = fw;
+                w = u; fw = fu;
+            }
+            else if ((fu <= fv) || (v == x) || (v == w))
+            {
+                v = u; fv = fu;
+            }
+        }
+    }
+
+    this->ProfiledCost(x,signal,m0Value);
+    return x;
+}
+
+} // end namespace anima
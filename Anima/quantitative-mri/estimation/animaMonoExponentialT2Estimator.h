@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include "AnimaRelaxometryExport.h"
+
+namespace anima
+{
+
+/**
+ * @brief Fast mono-exponential T2 estimator. M0 is profiled out analytically for a given T2, leaving a bracketed
+ * 1D Brent minimization on T2, initialized from a log-linear fit. Optionally, observed magnitudes are iteratively
+ * corrected for the Rician bias induced by a known noise standard deviation. No allocation is performed while
+ * estimating.
+ */
+class ANIMARELAXOMETRY_EXPORT MonoExponentialT2Estimator
+{
+public:
+    MonoExponentialT2Estimator();
+    ~MonoExponentialT2Estimator() {}
+
+    void SetEchoTimes(const std::vector <double> &echoTimes);
+    unsigned int GetNumberOfEchoes() const {return m_EchoTimes.size();}
+
+    void SetT2LowerBound(double val) {m_T2LowerBound = val;}
+    void SetT2UpperBound(double val) {m_T2UpperBound = val;}
+    void SetM0LowerBound(double val) {m_M0LowerBound = val;}
+    void SetM0UpperBound(double val) {m_M0UpperBound = val;}
+    void SetRelativeTolerance(double val) {m_RelativeTolerance = val;}
+
+    //! Rician noise standard deviation used for bias correction, no correction if zero
+    void SetRicianNoiseSigma(double val) {m_RicianNoiseSigma = val;}
+    void SetNumberOfBiasCorrectionIterations(unsigned int val) {m_NumberOfBiasCorrectionIterations = val;}
+
+    /**
+     * Estimates T2 and M0 for one echo train. workBuffer has to hold at least GetNumberOfEchoes() values,
+     * it is only used for Rician bias correction.
+     */
+    void Estimate(const double *signal, double &t2Value, double &m0Value, double *workBuffer) const;
+
+    //! Rician mean of a magnitude signal of noise free amplitude nu and noise standard deviation sigma
+    static double RicianMean(double nu, double sigma);
+
+protected:
+    //! Weighted log-linear fit of log(signal) = log(M0) - TE / T2, returns T2 clamped to bounds
+    double LogLinearInitialization(const double *signal) const;
+
+    //! Residual sum of squares for a given T2, with optimal M0 computed in closed form
+    double ProfiledCost(double t2Value, const double *signal, double &m0Value) const;
+
+    //! Brent minimization of the profiled cost on [m_T2LowerBound, m_T2UpperBound] starting from initT2
+    double MinimizeProfiledCost(const double *signal, double initT2, double &m0Value) const;
+
+private:
+    std::vector <double> m_EchoTimes;
+
+    double m_T2LowerBound, m_T2UpperBound;
+    double m_M0LowerBound, m_M0UpperBound;
+    double m_RelativeTolerance;
+
+    double m_RicianNoiseSigma;
+    unsigned int m_NumberOfBiasCorrectionIterations;
+};
+
+} // end namespace anima
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <animaMaskedImageToImageFilter.h>
+#include <animaMonoExponentialT2Estimator.h>
 #include <itkVectorImage.h>
 #include <itkImage.h>
 
@@ -43,6 +44,11 @@ public:
     itkSetMacro(T2UpperBoundValue, double);
     itkSetMacro(AverageSignalThreshold, double);
 
+    //! Use the former joint T2/M0 BOBYQA optimization instead of the profiled estimator (for validation)
+    itkSetMacro(UseBOBYQAOptimizer, bool);
+    //! Rician noise standard deviation for bias correction of the profiled estimator (0: no correction)
+    itkSetMacro(RicianNoiseSigma, double);
+
 protected:
     T2RelaxometryEstimationImageFilter()
     : Superclass()
@@ -59,14 +65,21 @@ protected:
         m_TRValue = 1;
         m_M0UpperBoundValue = 5000;
         m_T2UpperBoundValue = 1000;
+
+        m_UseBOBYQAOptimizer = false;
+        m_RicianNoiseSigma = 0;
     }
 
     virtual ~T2RelaxometryEstimationImageFilter() {}
 
     void CheckComputationMask() ITK_OVERRIDE;
 
+    void BeforeThreadedGenerateData() ITK_OVERRIDE;
     void ThreadedGenerateData(const OutputImageRegionType &outputRegionForThread, itk::ThreadIdType threadId) ITK_OVERRIDE;
 
+    //! Profiled estimation, one closed form M0 and bracketed T2 solve per voxel
+    void ProfiledThreadedGenerateData(const OutputImageRegionType &outputRegionForThread);
+
 private:
     T2RelaxometryEstimationImageFilter(const Self&); //purposely not implemented
     void operator=(const Self&); //purposely not implemented
@@ -83,6 +96,10 @@ private:
     double m_M0UpperBoundValue;
     double m_T2UpperBoundValue;
 
+    bool m_UseBOBYQAOptimizer;
+    double m_RicianNoiseSigma;
+    anima::MonoExponentialT2Estimator m_ProfiledEstimator;
+
     static double myfunc(const std::vector<double> &x, std::vector<double> &grad, void *my_func_data);
     
 };
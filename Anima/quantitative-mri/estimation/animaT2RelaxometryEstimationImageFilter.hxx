@@ -56,11 +56,33 @@ T2RelaxometryEstimationImageFilter <TInputImage,TOutputImage>
     this->SetComputationMask(maskImage);
 }
 
+template <typename TInputImage, typename TOutputImage>
+void
+T2RelaxometryEstimationImageFilter <TInputImage,TOutputImage>
+::BeforeThreadedGenerateData()
+{
+    Superclass::BeforeThreadedGenerateData();
+
+    m_ProfiledEstimator.SetEchoTimes(m_EchoTime);
+    m_ProfiledEstimator.SetT2LowerBound(1.0e-4);
+    m_ProfiledEstimator.SetT2UpperBound(m_T2UpperBoundValue);
+    m_ProfiledEstimator.SetM0LowerBound(1.0e-4);
+    m_ProfiledEstimator.SetM0UpperBound(m_M0UpperBoundValue);
+    m_ProfiledEstimator.SetRelativeTolerance(1.0e-4);
+    m_ProfiledEstimator.SetRicianNoiseSigma(m_RicianNoiseSigma);
+}
+
 template <typename TInputImage, typename TOutputImage>
 void
 T2RelaxometryEstimationImageFilter <TInputImage,TOutputImage>
 ::ThreadedGenerateData(const OutputImageRegionType &outputRegionForThread, itk::ThreadIdType threadId)
 {
+    if (!m_UseBOBYQAOptimizer)
+    {
+        this->ProfiledThreadedGenerateData(outputRegionForThread);
+        return;
+    }
+
     typedef itk::ImageRegionConstIterator <InputImageType> ImageIteratorType;
     typedef itk::ImageRegionIterator <OutputImageType> OutImageIteratorType;
 
@@ -174,6 +196,67 @@ T2RelaxometryEstimationImageFilter <TInputImage,TOutputImage>
     }
 }
 
+template <typename TInputImage, typename TOutputImage>
+void
+T2RelaxometryEstimationImageFilter <TInputImage,TOutputImage>
+::ProfiledThreadedGenerateData(const OutputImageRegionType &outputRegionForThread)
+{
+    typedef itk::ImageRegionConstIterator <InputImageType> ImageIteratorType;
+    typedef itk::ImageRegionIterator <OutputImageType> OutImageIteratorType;
+    typedef itk::ImageRegionIterator <MaskImageType> MaskIteratorType;
+
+    unsigned int numInputs = this->GetNumberOfIndexedInputs();
+
+    std::vector <ImageIteratorType> inIterators(numInputs);
+    for (unsigned int i = 0;i < numInputs;++i)
+        inIterators[i] = ImageIteratorType(this->GetInput(i),outputRegionForThread);
+
+    MaskIteratorType maskItr(this->GetComputationMask(),outputRegionForThread);
+    OutImageIteratorType outT2Iterator(this->GetOutput(0),outputRegionForThread);
+    OutImageIteratorType outM0Iterator(this->GetOutput(1),outputRegionForThread);
+
+    OutImageIteratorType t1MapItr;
+    if (m_T1Map)
+        t1MapItr = OutImageIteratorType(m_T1Map,outputRegionForThread);
+
+    // Echo train and estimator work buffers, allocated once for the whole region
+    std::vector <double> signal(numInputs);
+    std::vector <double> workBuffer(numInputs);
+
+    while (!maskItr.IsAtEnd())
+    {
+        double t2Value = 0;
+        double m0Value = 0;
+
+        if (maskItr.Get() != 0)
+        {
+            for (unsigned int i = 0;i < numInputs;++i)
+                signal[i] = inIterators[i].Get();
+
+            m_ProfiledEstimator.Estimate(signal.data(),t2Value,m0Value,workBuffer.data());
+
+            double t1Value = 1;
+            if (m_T1Map)
+                t1Value = t1MapItr.Get();
+
+            m0Value /= (1.0 - std::exp(- m_TRValue / t1Value));
+        }
+
+        outT2Iterator.Set(t2Value);
+        outM0Iterator.Set(m0Value);
+
+        ++maskItr;
+        ++outT2Iterator;
+        ++outM0Iterator;
+
+        for (unsigned int i = 0;i < numInputs;++i)
+            ++inIterators[i];
+
+        if (m_T1Map)
+            ++t1MapItr;
+    }
+}
+
 template <typename TInputImage, typename TOutputImage>
 double
 T2RelaxometryEstimationImageFilter <TInputImage,TOutputImage>::myfunc(const std::vector<double> &x, std::vector<double> &grad, void *data)
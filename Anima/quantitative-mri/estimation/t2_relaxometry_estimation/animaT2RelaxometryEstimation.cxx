@@ -25,6 +25,8 @@ int main(int argc, char **argv)
 
     TCLAP::ValueArg<std::string> echoSpacingArg("e","echo-spacing","Spacing between two successive echoes (default: 10), or a file containing the echo times for each acquisition",false,"10","Spacing between echoes",cmd);
     TCLAP::ValueArg<double> backgroundSignalThresholdArg("t","signal-thr","Background signal threshold (default: 10)",false,10,"Background signal threshold",cmd);
+    TCLAP::ValueArg<double> ricianSigmaArg("","rician-sigma","Rician noise standard deviation for bias correction (default: 0, no correction)",false,0,"Rician noise sigma",cmd);
+    TCLAP::SwitchArg bobyqaArg("","bobyqa","Use joint T2/M0 BOBYQA optimization instead of profiled estimation",cmd,false);
     
     TCLAP::ValueArg<unsigned int> nbpArg("T","numberofthreads","Number of threads to run on (default : all cores)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
 
@@ -108,6 +110,8 @@ int main(int argc, char **argv)
     }
     
     mainFilter->SetAverageSignalThreshold(backgroundSignalThresholdArg.getValue());
+    mainFilter->SetRicianNoiseSigma(ricianSigmaArg.getValue());
+    mainFilter->SetUseBOBYQAOptimizer(bobyqaArg.isSet());
     mainFilter->SetNumberOfThreads(nbpArg.getValue());
     
     itk::TimeProbe tmpTime;
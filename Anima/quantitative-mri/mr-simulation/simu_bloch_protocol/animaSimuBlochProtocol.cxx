@@ -0,0 +1,91 @@
+#include <tclap/CmdLine.h>
+
+#include <itkImage.h>
+#include <itkTimeProbe.h>
+
+#include <animaImageWriteService.h>
+#include "animaSimuBlochProtocolImageFilter.h"
+
+int main(int argc, char *argv[])
+{
+    TCLAP::CmdLine cmd("SimuBlochProtocol: Simulator of a multi-contrast protocol in a single pass\nINRIA / IRISA - VisAGeS Team", ' ',ANIMA_VERSION);
+
+    TCLAP::ValueArg<std::string> t1MapArg("","t1","Input T1 map",true,"","T1 map",cmd);
+    TCLAP::ValueArg<std::string> m0ImageArg("","m0","Input M0 image",true,"","M0 image",cmd);
+    TCLAP::ValueArg<std::string> t2MapArg("","t2","Input T2 map (required for SE, IRSE, CGRE)",false,"","T2 map",cmd);
+    TCLAP::ValueArg<std::string> t2sMapArg("","t2s","Input T2* map (required for GRE, SPGRE, CGRE, IRGRE)",false,"","T2* map",cmd);
+    TCLAP::ValueArg<std::string> b1ImageArg("","b1","Input B1 image (used for SPGRE)",false,"","B1 image",cmd);
+
+    TCLAP::ValueArg<std::string> protocolArg("p","protocol","Protocol file: one sequence per line as <SE|GRE|SPGRE|CGRE|IRSE|IRGRE> <output image> [tr=..] [te=..] [ti=..] [fa=..] (times in ms, flip angle in degrees)",true,"","protocol file",cmd);
+    TCLAP::ValueArg<std::string> compressionArg("","compression","Output images compression: none, fast or standard (default: standard)",false,"standard","output compression",cmd);
+    TCLAP::ValueArg<unsigned int> nbpArg("T","numberofthreads","Number of threads to run on (default : all cores)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
+
+    try
+    {
+        cmd.parse(argc,argv);
+    }
+    catch (TCLAP::ArgException& e)
+    {
+        std::cerr << "Error: " << e.error() << "for argument " << e.argId() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    typedef itk::Image <float, 3> ImageType;
+    typedef anima::SimuBlochProtocolImageFilter <ImageType> FilterType;
+
+    FilterType::Pointer filter = FilterType::New();
+    std::vector <std::string> outputNames;
+
+    try
+    {
+        anima::ImageWriteService::GetInstance().SetCompressionMode(anima::getImageCompressionModeFromString(compressionArg.getValue()));
+
+        std::vector <anima::BlochSequenceParameters> sequences = FilterType::ReadProtocolFile(protocolArg.getValue(),outputNames);
+        if (sequences.size() == 0)
+        {
+            std::cerr << "No sequence found in protocol file " << protocolArg.getValue() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        for (unsigned int i = 0;i < sequences.size();++i)
+            filter->AddSequence(sequences[i]);
+
+        // Tissue maps are read once for the whole protocol
+        filter->SetInputM0(anima::readImage <ImageType> (m0ImageArg.getValue()));
+        filter->SetInputT1(anima::readImage <ImageType> (t1MapArg.getValue()));
+
+        if (t2MapArg.getValue() != "")
+            filter->SetInputT2(anima::readImage <ImageType> (t2MapArg.getValue()));
+
+        if (t2sMapArg.getValue() != "")
+            filter->SetInputT2s(anima::readImage <ImageType> (t2sMapArg.getValue()));
+
+        if (b1ImageArg.getValue() != "")
+            filter->SetInputB1(anima::readImage <ImageType> (b1ImageArg.getValue()));
+
+        filter->SetNumberOfThreads(nbpArg.getValue());
+
+        itk::TimeProbe tmpTimer;
+        tmpTimer.Start();
+
+        filter->Update();
+
+        tmpTimer.Stop();
+        std::cout << "Simulated " << sequences.size() << " contrasts in " << tmpTimer.GetTotal() << " s" << std::endl;
+
+        for (unsigned int i = 0;i < outputNames.size();++i)
+        {
+            std::cout << "Writing simulated image to: " << outputNames[i] << std::endl;
+            anima::queueImageForWriting(outputNames[i],filter->GetOutput(i));
+        }
+
+        anima::waitForPendingImageWrites();
+    }
+    catch (itk::ExceptionObject &e)
+    {
+        std::cerr << e << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
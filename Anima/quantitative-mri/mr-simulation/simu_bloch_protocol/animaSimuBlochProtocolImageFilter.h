@@ -0,0 +1,93 @@
+#pragma once
+
+#include <itkImageToImageFilter.h>
+#include <string>
+#include <vector>
+
+namespace anima
+{
+
+enum BlochSequenceType
+{
+    SpinEchoSequence = 0,
+    GradientEchoSequence,
+    SpoiledGradientEchoSequence,
+    CoherentGradientEchoSequence,
+    InversionRecoverySpinEchoSequence,
+    InversionRecoveryGradientEchoSequence
+};
+
+//! Parameters of one sequence of a protocol, times in ms, flip angle in degrees
+struct BlochSequenceParameters
+{
+    BlochSequenceType Type;
+    double TR, TE, TI, FA;
+};
+
+/**
+ * @brief Simulates several MR contrasts (one output per sequence) in a single pass over tissue maps.
+ * Inputs 0 and 1 are the M0 and T1 maps, T2, T2* and B1 maps are set depending on the sequences used.
+ * Exponential terms are computed once per voxel for each distinct delay and shared among sequences.
+ */
+template <class TImage>
+class SimuBlochProtocolImageFilter :
+        public itk::ImageToImageFilter <TImage, TImage>
+{
+public:
+    /** Standard class typedefs. */
+    typedef SimuBlochProtocolImageFilter Self;
+    typedef itk::ImageToImageFilter <TImage, TImage> Superclass;
+    typedef itk::SmartPointer <Self> Pointer;
+    typedef itk::SmartPointer <const Self> ConstPointer;
+
+    typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+    typedef typename TImage::ConstPointer ImageConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self)
+
+    /** Run-time type information (and related methods). */
+    itkTypeMacro(SimuBlochProtocolImageFilter, ImageToImageFilter)
+
+    void SetInputM0(const TImage *m0) {this->SetNthInput(0, const_cast <TImage *> (m0));}
+    void SetInputT1(const TImage *t1) {this->SetNthInput(1, const_cast <TImage *> (t1));}
+    void SetInputT2(const TImage *t2) {m_T2Map = t2; this->Modified();}
+    void SetInputT2s(const TImage *t2s) {m_T2StarMap = t2s; this->Modified();}
+    void SetInputB1(const TImage *b1) {m_B1Map = b1; this->Modified();}
+
+    //! Adds a sequence to the protocol, each sequence adds one output
+    void AddSequence(const BlochSequenceParameters &sequence);
+    unsigned int GetNumberOfSequences() {return m_Sequences.size();}
+
+    //! Reads a protocol file, one sequence per line: type (SE, GRE, SPGRE, CGRE, IRSE, IRGRE) followed by key=value timings (tr, te, ti, fa)
+    static std::vector <BlochSequenceParameters> ReadProtocolFile(const std::string &fileName, std::vector <std::string> &outputNames);
+
+protected:
+    SimuBlochProtocolImageFilter();
+    virtual ~SimuBlochProtocolImageFilter() {}
+
+    void BeforeThreadedGenerateData() ITK_OVERRIDE;
+    void ThreadedGenerateData(const OutputImageRegionType &outputRegionForThread,
+                              itk::ThreadIdType threadId) ITK_OVERRIDE;
+
+    //! Returns the index of delay in delays, adding it if not present
+    unsigned int RegisterDelay(double delay, std::vector <double> &delays);
+
+private:
+    SimuBlochProtocolImageFilter(const Self &); //purposely not implemented
+    void operator=(const Self &); //purposely not implemented
+
+    std::vector <BlochSequenceParameters> m_Sequences;
+
+    ImageConstPointer m_T2Map, m_T2StarMap, m_B1Map;
+
+    // Distinct delays used in exp(-delay/T1), exp(-delay/T2), exp(-delay/T2*)
+    std::vector <double> m_T1Delays, m_T2Delays, m_T2StarDelays;
+
+    // For each sequence, indexes of its delays in the above tables
+    std::vector <unsigned int> m_TRIndexes, m_TIIndexes, m_TEIndexes;
+};
+
+} // end of namespace anima
+
+#include "animaSimuBlochProtocolImageFilter.hxx"
@@ -0,0 +1,344 @@
+#pragma once
+#include "animaSimuBlochProtocolImageFilter.h"
+
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkExceptionObject.h>
+
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdlib>
+
+namespace anima
+{
+
+template <class TImage>
+SimuBlochProtocolImageFilter <TImage>::SimuBlochProtocolImageFilter()
+{
+    this->SetNumberOfRequiredInputs(2);
+    this->SetNumberOfRequiredOutputs(0);
+}
+
+template <class TImage>
+void
+SimuBlochProtocolImageFilter <TImage>::AddSequence(const BlochSequenceParameters &sequence)
+{
+    unsigned int outputIndex = m_Sequences.size();
+    m_Sequences.push_back(sequence);
+
+    this->SetNumberOfRequiredOutputs(m_Sequences.size());
+    this->SetNthOutput(outputIndex, this->MakeOutput(outputIndex));
+    this->Modified();
+}
+
+template <class TImage>
+std::vector <BlochSequenceParameters>
+SimuBlochProtocolImageFilter <TImage>::ReadProtocolFile(const std::string &fileName, std::vector <std::string> &outputNames)
+{
+    std::ifstream protocolFile(fileName.c_str());
+    if (!protocolFile.is_open())
+    {
+        std::string errStr = "Unable to read protocol file: ";
+        errStr += fileName;
+        throw itk::ExceptionObject(__FILE__, __LINE__,errStr,ITK_LOCATION);
+    }
+
+    std::vector <BlochSequenceParameters> sequences;
+    outputNames.clear();
+
+    std::string line;
+    while (std::getline(protocolFile,line))
+    {
+        if (line.empty() || (line[0] == '#'))
+            continue;
+
+        std::istringstream lineStream(line);
+        std::string typeName, outputName;
+        if (!(lineStream >> typeName >> outputName))
+            continue;
+
+        // Default timings are those of the single sequence simulation tools
+        BlochSequenceParameters sequence;
+        sequence.TI = 0;
+        sequence.FA = 90;
+        if (typeName == "SE")
+        {
+            sequence.Type = SpinEchoSequence;
+            sequence.TR = 500;
+            sequence.TE = 8.4;
+        }
+        else if (typeName == "GRE")
+        {
+            sequence.Type = GradientEchoSequence;
+            sequence.TR = 120;
+            sequence.TE = 8;
+        }
+        else if (typeName == "SPGRE")
+        {
+            sequence.Type = SpoiledGradientEchoSequence;
+            sequence.TR = 35;
+            sequence.TE = 6;
+            sequence.FA = 40;
+        }
+        else if (typeName == "CGRE")
+        {
+            sequence.Type = CoherentGradientEchoSequence;
+            sequence.TR = 40;
+            sequence.TE = 15;
+            sequence.FA = 25;
+        }
+        else if (typeName == "IRSE")
+        {
+            sequence.Type = InversionRecoverySpinEchoSequence;
+            sequence.TR = 2400;
+            sequence.TE = 20;
+            sequence.TI = 1200;
+        }
+        else if (typeName == "IRGRE")
+        {
+            sequence.Type = InversionRecoveryGradientEchoSequence;
+            sequence.TR = 1900;
+            sequence.TE = 2.98;
+            sequence.TI = 900;
+        }
+        else
+        {
+            std::string errStr = "Unknown sequence type in protocol file: ";
+            errStr += typeName;
+            throw itk::ExceptionObject(__FILE__, __LINE__,errStr,ITK_LOCATION);
+        }
+
+        std::string timing;
+        while (lineStream >> timing)
+        {
+            std::size_t equalPos = timing.find('=');
+            if (equalPos == std::string::npos)
+                continue;
+
+            std::string key = timing.substr(0,equalPos);
+            double value = std::atof(timing.substr(equalPos + 1).c_str());
+
+            if (key == "tr")
+                sequence.TR = value;
+            else if (key == "te")
+                sequence.TE = value;
+            else if (key == "ti")
+                sequence.TI = value;
+            else if (key == "fa")
+                sequence.FA = value;
+        }
+
+        if ((sequence.TR < 0) || (sequence.TE < 0) || (sequence.TE >= sequence.TR))
+        {
+            std::string errStr = "Invalid timings (TR, TE >= 0 and TE < TR required) for output ";
+            errStr += outputName;
+            throw itk::ExceptionObject(__FILE__, __LINE__,errStr,ITK_LOCATION);
+        }
+
+        sequences.push_back(sequence);
+        outputNames.push_back(outputName);
+    }
+
+    return sequences;
+}
+
+template <class TImage>
+unsigned int
+SimuBlochProtocolImageFilter <TImage>::RegisterDelay(double delay, std::vector <double> &delays)
+{
+    for (unsigned int i = 0;i < delays.size();++i)
+    {
+        if (delays[i] == delay)
+            return i;
+    }
+
+    delays.push_back(delay);
+    return delays.size() - 1;
+}
+
+template <class TImage>
+void
+SimuBlochProtocolImageFilter <TImage>::BeforeThreadedGenerateData()
+{
+    Superclass::BeforeThreadedGenerateData();
+
+    typename TImage::RegionType referenceRegion = this->GetInput(0)->GetLargestPossibleRegion();
+    if ((this->GetInput(1)->GetLargestPossibleRegion() != referenceRegion)
+            || (m_T2Map && (m_T2Map->GetLargestPossibleRegion() != referenceRegion))
+            || (m_T2StarMap && (m_T2StarMap->GetLargestPossibleRegion() != referenceRegion))
+            || (m_B1Map && (m_B1Map->GetLargestPossibleRegion() != referenceRegion)))
+        throw itk::ExceptionObject(__FILE__, __LINE__,"Input maps do not have the same size",ITK_LOCATION);
+
+    m_T1Delays.clear();
+    m_T2Delays.clear();
+    m_T2StarDelays.clear();
+
+    unsigned int numSequences = m_Sequences.size();
+    m_TRIndexes.resize(numSequences);
+    m_TIIndexes.resize(numSequences);
+    m_TEIndexes.resize(numSequences);
+
+    for (unsigned int i = 0;i < numSequences;++i)
+    {
+        const BlochSequenceParameters &sequence = m_Sequences[i];
+        m_TRIndexes[i] = this->RegisterDelay(sequence.TR,m_T1Delays);
+        m_TIIndexes[i] = this->RegisterDelay(sequence.TI,m_T1Delays);
+
+        bool spinEcho = (sequence.Type == SpinEchoSequence) || (sequence.Type == InversionRecoverySpinEchoSequence);
+        if (spinEcho)
+        {
+            if (!m_T2Map)
+                throw itk::ExceptionObject(__FILE__, __LINE__,"T2 map required for spin echo sequences",ITK_LOCATION);
+
+            m_TEIndexes[i] = this->RegisterDelay(sequence.TE,m_T2Delays);
+        }
+        else
+        {
+            if (!m_T2StarMap)
+                throw itk::ExceptionObject(__FILE__, __LINE__,"T2* map required for gradient echo sequences",ITK_LOCATION);
+
+            m_TEIndexes[i] = this->RegisterDelay(sequence.TE,m_T2StarDelays);
+        }
+
+        if ((sequence.Type == CoherentGradientEchoSequence) && (!m_T2Map))
+            throw itk::ExceptionObject(__FILE__, __LINE__,"T2 map required for coherent gradient echo sequences",ITK_LOCATION);
+    }
+}
+
+template <class TImage>
+void
+SimuBlochProtocolImageFilter <TImage>::ThreadedGenerateData(const OutputImageRegionType &outputRegionForThread,
+                                                           itk::ThreadIdType threadId)
+{
+    typedef itk::ImageRegionConstIterator <TImage> InputIteratorType;
+    typedef itk::ImageRegionIterator <TImage> OutputIteratorType;
+
+    unsigned int numSequences = m_Sequences.size();
+
+    InputIteratorType m0Itr(this->GetInput(0),outputRegionForThread);
+    InputIteratorType t1Itr(this->GetInput(1),outputRegionForThread);
+    InputIteratorType t2Itr, t2StarItr, b1Itr;
+    if (m_T2Map)
+        t2Itr = InputIteratorType(m_T2Map,outputRegionForThread);
+    if (m_T2StarMap)
+        t2StarItr = InputIteratorType(m_T2StarMap,outputRegionForThread);
+    if (m_B1Map)
+        b1Itr = InputIteratorType(m_B1Map,outputRegionForThread);
+
+    std::vector <OutputIteratorType> outItrs(numSequences);
+    for (unsigned int i = 0;i < numSequences;++i)
+        outItrs[i] = OutputIteratorType(this->GetOutput(i),outputRegionForThread);
+
+    // Shared exponential tables, filled once per voxel
+    std::vector <double> t1Exponentials(m_T1Delays.size());
+    std::vector <double> t2Exponentials(m_T2Delays.size());
+    std::vector <double> t2StarExponentials(m_T2StarDelays.size());
+
+    // Flip angle terms do not depend on the voxel without B1 map
+    std::vector <double> sinFA(numSequences), cosFA(numSequences);
+    for (unsigned int i = 0;i < numSequences;++i)
+    {
+        sinFA[i] = std::sin(M_PI * m_Sequences[i].FA / 180.0);
+        cosFA[i] = std::cos(M_PI * m_Sequences[i].FA / 180.0);
+    }
+
+    while (!m0Itr.IsAtEnd())
+    {
+        double m0Value = m0Itr.Get();
+        double t1Value = t1Itr.Get();
+        double t2Value = m_T2Map ? t2Itr.Get() : 0;
+        double t2StarValue = m_T2StarMap ? t2StarItr.Get() : 0;
+        double b1Value = m_B1Map ? b1Itr.Get() : 1;
+
+        bool validT1 = (t1Value > 0);
+        bool validT2 = (t2Value > 0);
+        bool validT2Star = (t2StarValue > 0);
+
+        if (validT1)
+        {
+            for (unsigned int i = 0;i < m_T1Delays.size();++i)
+                t1Exponentials[i] = std::exp(- m_T1Delays[i] / t1Value);
+        }
+
+        if (validT2)
+        {
+            for (unsigned int i = 0;i < m_T2Delays.size();++i)
+                t2Exponentials[i] = std::exp(- m_T2Delays[i] / t2Value);
+        }
+
+        if (validT2Star)
+        {
+            for (unsigned int i = 0;i < m_T2StarDelays.size();++i)
+                t2StarExponentials[i] = std::exp(- m_T2StarDelays[i] / t2StarValue);
+        }
+
+        for (unsigned int i = 0;i < numSequences;++i)
+        {
+            double signalValue = 0;
+            double e1TR = t1Exponentials[m_TRIndexes[i]];
+            double e1TI = t1Exponentials[m_TIIndexes[i]];
+
+            switch (m_Sequences[i].Type)
+            {
+                case SpinEchoSequence:
+                    if (validT1 && validT2)
+                        signalValue = m0Value * (1.0 - e1TR) * t2Exponentials[m_TEIndexes[i]];
+                    break;
+
+                case GradientEchoSequence:
+                    if (validT1 && validT2Star)
+                        signalValue = m0Value * (1.0 - e1TR) * t2StarExponentials[m_TEIndexes[i]];
+                    break;
+
+                case SpoiledGradientEchoSequence:
+                    if (validT1 && validT2Star)
+                    {
+                        double sinValue = sinFA[i];
+                        double cosValue = cosFA[i];
+                        if (m_B1Map)
+                        {
+                            sinValue = std::sin(M_PI * b1Value * m_Sequences[i].FA / 180.0);
+                            cosValue = std::cos(M_PI * b1Value * m_Sequences[i].FA / 180.0);
+                        }
+
+                        signalValue = m0Value * (1.0 - e1TR) * sinValue / (1.0 - e1TR * cosValue) * t2StarExponentials[m_TEIndexes[i]];
+                    }
+                    break;
+
+                case CoherentGradientEchoSequence:
+                    if (validT1 && validT2 && validT2Star)
+                    {
+                        double t1t2Ratio = t1Value / t2Value;
+                        signalValue = m0Value * sinFA[i] / (1.0 + t1t2Ratio - cosFA[i] * (t1t2Ratio - 1.0)) * t2StarExponentials[m_TEIndexes[i]];
+                    }
+                    break;
+
+                case InversionRecoverySpinEchoSequence:
+                    if (validT1 && validT2)
+                        signalValue = m0Value * std::abs(1.0 - 2.0 * e1TI + e1TR) * t2Exponentials[m_TEIndexes[i]];
+                    break;
+
+                case InversionRecoveryGradientEchoSequence:
+                default:
+                    if (validT1 && validT2Star)
+                        signalValue = m0Value * std::abs(1.0 - 2.0 * e1TI + e1TR) * t2StarExponentials[m_TEIndexes[i]];
+                    break;
+            }
+
+            outItrs[i].Set(signalValue);
+            ++outItrs[i];
+        }
+
+        ++m0Itr;
+        ++t1Itr;
+        if (m_T2Map)
+            ++t2Itr;
+        if (m_T2StarMap)
+            ++t2StarItr;
+        if (m_B1Map)
+            ++b1Itr;
+    }
+}
+
+} // end of namespace anima
@@ -131,6 +131,15 @@ protected:
     virtual void ResampleImages(TransformType *currentTransform, InputImagePointer &refImage, InputImagePointer &movingImage);
     virtual bool ComposeAddOnWithTransform(TransformPointer &computedTransform, TransformType *addOn);
 
+    //! Updates two independent block matchers concurrently, each one using half of the threads
+    void UpdateBlockMatchersConcurrently(BlockMatcherType *forwardMatcher, BlockMatcherType *reverseMatcher);
+
+    //! Agregates the block matches of a block matcher into an add-on transform
+    TransformPointer AgregateBlockMatches(BlockMatcherType *matcher);
+
+    //! Fused in-place combination of symmetric velocity fields: S_0 = factor * (S_0 - S_1)
+    void CombineSymmetricVelocityFields(SVFTransformType *forwardAddOn, SVFTransformType *reverseAddOn, double factor);
+
 private:
     BaseBMRegistrationMethod(const Self&); //purposely not implemented
     void operator=(const Self&); //purposely not implemented
@@ -6,6 +6,11 @@
 #include <animaSmoothingRecursiveYvvGaussianImageFilter.h>
 
 #include <animaVelocityUtils.h>
+#include <animaBalooSVFTransformAgregator.h>
+#include <animaDenseSVFTransformAgregator.h>
+
+#include <exception>
+#include <thread>
 
 namespace anima
 {
@@ -333,4 +338,109 @@ BaseBMRegistrationMethod <TInputImageType>
     os << indent << "Maximum Iterations: " << m_MaximumIterations << std::endl;
 }
 
+template <typename TInputImageType>
+void
+BaseBMRegistrationMethod <TInputImageType>
+::UpdateBlockMatchersConcurrently(BlockMatcherType *forwardMatcher, BlockMatcherType *reverseMatcher)
+{
+    unsigned int numThreads = this->GetNumberOfThreads();
+    if (numThreads < 2)
+    {
+        forwardMatcher->SetNumberOfThreads(1);
+        reverseMatcher->SetNumberOfThreads(1);
+        forwardMatcher->Update();
+        reverseMatcher->Update();
+        return;
+    }
+
+    forwardMatcher->SetNumberOfThreads(numThreads - numThreads / 2);
+    reverseMatcher->SetNumberOfThreads(numThreads / 2);
+
+    // Reverse matching runs in its own thread, exceptions are passed back to the caller
+    std::exception_ptr reverseException;
+    std::thread reverseThread([reverseMatcher, &reverseException]()
+    {
+        try
+        {
+            reverseMatcher->Update();
+        }
+        catch (...)
+        {
+            reverseException = std::current_exception();
+        }
+    });
+
+    std::exception_ptr forwardException;
+    try
+    {
+        forwardMatcher->Update();
+    }
+    catch (...)
+    {
+        forwardException = std::current_exception();
+    }
+
+    reverseThread.join();
+
+    if (forwardException)
+        std::rethrow_exception(forwardException);
+
+    if (reverseException)
+        std::rethrow_exception(reverseException);
+}
+
+template <typename TInputImageType>
+typename BaseBMRegistrationMethod <TInputImageType>::TransformPointer
+BaseBMRegistrationMethod <TInputImageType>
+::AgregateBlockMatches(BlockMatcherType *matcher)
+{
+    m_Agregator->SetInputRegions(matcher->GetBlockRegions());
+    m_Agregator->SetInputOrigins(matcher->GetBlockPositions());
+
+    if (m_Agregator->GetOutputTransformType() == AgregatorType::SVF)
+    {
+        typedef anima::BalooSVFTransformAgregator<InputImageType::ImageDimension> SVFAgregatorType;
+        SVFAgregatorType *tmpAgreg = dynamic_cast <SVFAgregatorType *> (m_Agregator);
+
+        if (tmpAgreg)
+            tmpAgreg->SetBlockDamWeights(matcher->GetBlockDamWeights());
+        else
+        {
+            typedef anima::DenseSVFTransformAgregator<InputImageType::ImageDimension> SVFAgregatorType;
+            SVFAgregatorType *tmpDenseAgreg = dynamic_cast <SVFAgregatorType *> (m_Agregator);
+
+            tmpDenseAgreg->SetBlockDamWeights(matcher->GetBlockDamWeights());
+        }
+    }
+
+    m_Agregator->SetInputWeights(matcher->GetBlockWeights());
+    m_Agregator->SetInputTransforms(matcher->GetBlockTransformPointers());
+
+    TransformPointer addOn = m_Agregator->GetOutput();
+    return addOn;
+}
+
+template <typename TInputImageType>
+void
+BaseBMRegistrationMethod <TInputImageType>
+::CombineSymmetricVelocityFields(SVFTransformType *forwardAddOn, SVFTransformType *reverseAddOn, double factor)
+{
+    typedef typename SVFTransformType::VectorFieldType VelocityFieldType;
+    typedef typename VelocityFieldType::PixelType VectorType;
+    typedef typename VectorType::ValueType VectorValueType;
+
+    VelocityFieldType *forwardField = const_cast <VelocityFieldType *> (forwardAddOn->GetParametersAsVectorField());
+    const VelocityFieldType *reverseField = reverseAddOn->GetParametersAsVectorField();
+
+    // Both fields share the agregator geometry, buffers are processed as flat arrays in a single pass
+    unsigned int numValues = forwardField->GetLargestPossibleRegion().GetNumberOfPixels() * VectorType::Dimension;
+    VectorValueType *forwardBuffer = forwardField->GetBufferPointer()->GetDataPointer();
+    const VectorValueType *reverseBuffer = reverseField->GetBufferPointer()->GetDataPointer();
+
+    for (unsigned int i = 0;i < numValues;++i)
+        forwardBuffer[i] = factor * (forwardBuffer[i] - reverseBuffer[i]);
+
+    forwardField->Modified();
+}
+
 } // end namespace anima
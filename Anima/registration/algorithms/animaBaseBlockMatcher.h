@@ -119,6 +119,9 @@ protected:
 
     virtual void InitializeBlocks();
 
+    //! Called once before threaded matching, e.g. to set up read-only data shared by all metrics
+    virtual void BeforeMatching() {}
+
     virtual MetricPointer SetupMetric() = 0;
     virtual double ComputeBlockWeight(double val, unsigned int block) = 0;
     virtual BaseInputTransformPointer GetNewBlockTransform(PointType &blockCenter) = 0;
@@ -151,6 +151,8 @@ BaseBlockMatcher <TInputImageType>
     if ((m_ForceComputeBlocks) || (m_BlockTransformPointers.size() == 0))
         this->InitializeBlocks();
 
+    this->BeforeMatching();
+
     m_HighestProcessedBlock = 0;
     itk::MultiThreader::Pointer threadWorker = itk::MultiThreader::New();
     ThreadedMatchData *tmpStr = new ThreadedMatchData;
@@ -26,8 +26,11 @@ public:
 
     itkNewMacro(Self)
 
+    //! Optional block matcher for the reverse direction, if set both directions are matched concurrently
+    void SetReverseBlockMatcher(BlockMatcherType *matcher) {m_ReverseBlockMatcher = matcher;}
+
 protected:
-    KissingSymmetricBMRegistrationMethod() {}
+    KissingSymmetricBMRegistrationMethod() {m_ReverseBlockMatcher = 0;}
     virtual ~KissingSymmetricBMRegistrationMethod() {}
 
     virtual void PerformOneIteration(InputImageType *refImage, InputImageType *movingImage, TransformPointer &addOn) ITK_OVERRIDE;
@@ -35,6 +38,8 @@ protected:
 private:
     KissingSymmetricBMRegistrationMethod(const Self&); //purposely not implemented
     void operator=(const Self&); //purposely not implemented
+
+    BlockMatcherType *m_ReverseBlockMatcher;
 };
 
 } // end namespace anima
@@ -1,12 +1,6 @@
 #pragma once
 #include "animaKissingSymmetricBMRegistrationMethod.h"
 
-#include <animaBalooSVFTransformAgregator.h>
-#include <animaDenseSVFTransformAgregator.h>
-
-#include <itkMultiplyImageFilter.h>
-#include <itkSubtractImageFilter.h>
-
 namespace anima
 {
 
@@ -15,113 +9,71 @@ void
 KissingSymmetricBMRegistrationMethod <TInputImageType>
 ::PerformOneIteration(InputImageType *refImage, InputImageType *movingImage, TransformPointer &addOn)
 {
-    itk::TimeProbe tmpTime;
-    tmpTime.Start();
+    TransformPointer usualAddOn, reverseAddOn;
 
     this->GetBlockMatcher()->SetForceComputeBlocks(true);
     this->GetBlockMatcher()->SetReferenceImage(refImage);
     this->GetBlockMatcher()->SetMovingImage(movingImage);
-    this->GetBlockMatcher()->SetNumberOfThreads(this->GetNumberOfThreads());
-    this->GetBlockMatcher()->Update();
 
-    tmpTime.Stop();
+    if (m_ReverseBlockMatcher)
+    {
+        m_ReverseBlockMatcher->SetForceComputeBlocks(true);
+        m_ReverseBlockMatcher->SetReferenceImage(movingImage);
+        m_ReverseBlockMatcher->SetMovingImage(refImage);
 
-    if (this->GetVerboseProgression())
-        std::cout << "Matching performed in " << tmpTime.GetTotal() << std::endl;
+        // Both directions are independent until their combination, match them concurrently
+        itk::TimeProbe tmpTime;
+        tmpTime.Start();
 
-    this->GetAgregator()->SetInputRegions(this->GetBlockMatcher()->GetBlockRegions());
-    this->GetAgregator()->SetInputOrigins(this->GetBlockMatcher()->GetBlockPositions());
+        this->UpdateBlockMatchersConcurrently(this->GetBlockMatcher(),m_ReverseBlockMatcher);
 
-    if (this->GetAgregator()->GetOutputTransformType() == AgregatorType::SVF)
-    {
-        typedef anima::BalooSVFTransformAgregator<InputImageType::ImageDimension> SVFAgregatorType;
-        SVFAgregatorType *tmpAgreg = dynamic_cast <SVFAgregatorType *> (this->GetAgregator());
+        tmpTime.Stop();
 
-        if (tmpAgreg)
-            tmpAgreg->SetBlockDamWeights(this->GetBlockMatcher()->GetBlockDamWeights());
-        else
-        {
-            typedef anima::DenseSVFTransformAgregator<InputImageType::ImageDimension> SVFAgregatorType;
-            SVFAgregatorType *tmpDenseAgreg = dynamic_cast <SVFAgregatorType *> (this->GetAgregator());
+        if (this->GetVerboseProgression())
+            std::cout << "Forward and reverse matching performed in " << tmpTime.GetTotal() << std::endl;
 
-            tmpDenseAgreg->SetBlockDamWeights(this->GetBlockMatcher()->GetBlockDamWeights());
-        }
+        usualAddOn = this->AgregateBlockMatches(this->GetBlockMatcher());
+        reverseAddOn = this->AgregateBlockMatches(m_ReverseBlockMatcher);
     }
+    else
+    {
+        itk::TimeProbe tmpTime;
+        tmpTime.Start();
 
-    this->GetAgregator()->SetInputWeights(this->GetBlockMatcher()->GetBlockWeights());
-    this->GetAgregator()->SetInputTransforms(this->GetBlockMatcher()->GetBlockTransformPointers());
+        this->GetBlockMatcher()->SetNumberOfThreads(this->GetNumberOfThreads());
+        this->GetBlockMatcher()->Update();
 
-    TransformPointer usualAddOn = this->GetAgregator()->GetOutput();
+        tmpTime.Stop();
 
-    itk::TimeProbe tmpTimeReverse;
-    tmpTimeReverse.Start();
+        if (this->GetVerboseProgression())
+            std::cout << "Matching performed in " << tmpTime.GetTotal() << std::endl;
 
-    this->GetBlockMatcher()->SetReferenceImage(movingImage);
-    this->GetBlockMatcher()->SetMovingImage(refImage);
-    this->GetBlockMatcher()->Update();
+        usualAddOn = this->AgregateBlockMatches(this->GetBlockMatcher());
 
-    tmpTimeReverse.Stop();
+        itk::TimeProbe tmpTimeReverse;
+        tmpTimeReverse.Start();
 
-    if (this->GetVerboseProgression())
-        std::cout << "Matching performed in " << tmpTimeReverse.GetTotal() << std::endl;
+        this->GetBlockMatcher()->SetReferenceImage(movingImage);
+        this->GetBlockMatcher()->SetMovingImage(refImage);
+        this->GetBlockMatcher()->Update();
 
-    this->GetAgregator()->SetInputRegions(this->GetBlockMatcher()->GetBlockRegions());
-    this->GetAgregator()->SetInputOrigins(this->GetBlockMatcher()->GetBlockPositions());
+        tmpTimeReverse.Stop();
 
-    if (this->GetAgregator()->GetOutputTransformType() == AgregatorType::SVF)
-    {
-        typedef anima::BalooSVFTransformAgregator<InputImageType::ImageDimension> SVFAgregatorType;
-        SVFAgregatorType *tmpAgreg = dynamic_cast <SVFAgregatorType *> (this->GetAgregator());
+        if (this->GetVerboseProgression())
+            std::cout << "Matching performed in " << tmpTimeReverse.GetTotal() << std::endl;
 
-        if (tmpAgreg)
-            tmpAgreg->SetBlockDamWeights(this->GetBlockMatcher()->GetBlockDamWeights());
-        else
-        {
-            typedef anima::DenseSVFTransformAgregator<InputImageType::ImageDimension> SVFAgregatorType;
-            SVFAgregatorType *tmpDenseAgreg = dynamic_cast <SVFAgregatorType *> (this->GetAgregator());
-
-            tmpDenseAgreg->SetBlockDamWeights(this->GetBlockMatcher()->GetBlockDamWeights());
-        }
+        reverseAddOn = this->AgregateBlockMatches(this->GetBlockMatcher());
     }
 
-    this->GetAgregator()->SetInputWeights(this->GetBlockMatcher()->GetBlockWeights());
-    this->GetAgregator()->SetInputTransforms(this->GetBlockMatcher()->GetBlockTransformPointers());
-
-    TransformPointer reverseAddOn = this->GetAgregator()->GetOutput();
-
     if (this->GetAgregator()->GetOutputTransformType() == AgregatorType::SVF)
     {
         // Add update to current velocity field (cf. Vercauteren et al, 2008)
         // First compute the SVF from two asymmetric ones: S = 0.25 * (S_0 - S_1)
         // It's only a quarter since we are computing the half power of the transform between the two images
-        typedef typename SVFTransformType::VectorFieldType VelocityFieldType;
-
-        typedef itk::MultiplyImageFilter <VelocityFieldType,itk::Image <float,InputImageType::ImageDimension>,VelocityFieldType> MultiplyFilterType;
-        typedef itk::SubtractImageFilter <VelocityFieldType,VelocityFieldType,VelocityFieldType> SubtractFilterType;
-
         SVFTransformType *usualAddOnCast = dynamic_cast <SVFTransformType *> (usualAddOn.GetPointer());
         SVFTransformType *reverseAddOnCast = dynamic_cast <SVFTransformType *> (reverseAddOn.GetPointer());
 
-        typename SubtractFilterType::Pointer subFilter = SubtractFilterType::New();
-        subFilter->SetInput1(usualAddOnCast->GetParametersAsVectorField());
-        subFilter->SetInput2(reverseAddOnCast->GetParametersAsVectorField());
-        subFilter->SetNumberOfThreads(this->GetNumberOfThreads());
-        subFilter->InPlaceOn();
-
-        subFilter->Update();
-
-        typename MultiplyFilterType::Pointer multiplyFilter = MultiplyFilterType::New();
-        multiplyFilter->SetInput(subFilter->GetOutput());
-        multiplyFilter->SetConstant(0.25);
-        multiplyFilter->SetNumberOfThreads(this->GetNumberOfThreads());
-        multiplyFilter->InPlaceOn();
-
-        multiplyFilter->Update();
-
-        typename VelocityFieldType::Pointer addonSVF = multiplyFilter->GetOutput();
-        addonSVF->DisconnectPipeline();
-
-        usualAddOnCast->SetParametersAsVectorField(addonSVF);
+        this->CombineSymmetricVelocityFields(usualAddOnCast,reverseAddOnCast,0.25);
     }
     else
     {
@@ -1,9 +1,6 @@
 #pragma once
 #include "animaSymmetricBMRegistrationMethod.h"
 
-#include <animaBalooSVFTransformAgregator.h>
-#include <animaDenseSVFTransformAgregator.h>
-
 namespace anima
 {
 
@@ -12,112 +9,37 @@ void
 SymmetricBMRegistrationMethod <TInputImageType>
 ::PerformOneIteration(InputImageType *refImage, InputImageType *movingImage, TransformPointer &addOn)
 {
-    itk::TimeProbe tmpTime;
-    tmpTime.Start();
-
     this->GetBlockMatcher()->SetForceComputeBlocks(false);
     this->GetBlockMatcher()->SetReferenceImage(this->GetFixedImage());
     this->GetBlockMatcher()->SetMovingImage(movingImage);
-    this->GetBlockMatcher()->SetNumberOfThreads(this->GetNumberOfThreads());
-    this->GetBlockMatcher()->Update();
-
-    tmpTime.Stop();
-
-    if (this->GetVerboseProgression())
-        std::cout << "Matching performed in " << tmpTime.GetTotal() << std::endl;
-
-    this->GetAgregator()->SetInputRegions(this->GetBlockMatcher()->GetBlockRegions());
-    this->GetAgregator()->SetInputOrigins(this->GetBlockMatcher()->GetBlockPositions());
-
-    if (this->GetAgregator()->GetOutputTransformType() == AgregatorType::SVF)
-    {
-        typedef anima::BalooSVFTransformAgregator<InputImageType::ImageDimension> SVFAgregatorType;
-        SVFAgregatorType *tmpAgreg = dynamic_cast <SVFAgregatorType *> (this->GetAgregator());
-
-        if (tmpAgreg)
-            tmpAgreg->SetBlockDamWeights(this->GetBlockMatcher()->GetBlockDamWeights());
-        else
-        {
-            typedef anima::DenseSVFTransformAgregator<InputImageType::ImageDimension> SVFAgregatorType;
-            SVFAgregatorType *tmpDenseAgreg = dynamic_cast <SVFAgregatorType *> (this->GetAgregator());
-
-            tmpDenseAgreg->SetBlockDamWeights(this->GetBlockMatcher()->GetBlockDamWeights());
-        }
-    }
-
-    this->GetAgregator()->SetInputWeights(this->GetBlockMatcher()->GetBlockWeights());
-    this->GetAgregator()->SetInputTransforms(this->GetBlockMatcher()->GetBlockTransformPointers());
-
-    TransformPointer usualAddOn = this->GetAgregator()->GetOutput();
-
-    itk::TimeProbe tmpTimeReverse;
-    tmpTimeReverse.Start();
 
     m_ReverseBlockMatcher->SetForceComputeBlocks(false);
     m_ReverseBlockMatcher->SetReferenceImage(this->GetMovingImage());
     m_ReverseBlockMatcher->SetMovingImage(refImage);
-    m_ReverseBlockMatcher->SetNumberOfThreads(this->GetNumberOfThreads());
-    m_ReverseBlockMatcher->Update();
-
-    tmpTimeReverse.Stop();
 
-    if (this->GetVerboseProgression())
-        std::cout << "Matching performed in " << tmpTimeReverse.GetTotal() << std::endl;
-
-    this->GetAgregator()->SetInputRegions(m_ReverseBlockMatcher->GetBlockRegions());
-    this->GetAgregator()->SetInputOrigins(m_ReverseBlockMatcher->GetBlockPositions());
-
-    if (this->GetAgregator()->GetOutputTransformType() == AgregatorType::SVF)
-    {
-        typedef anima::BalooSVFTransformAgregator<InputImageType::ImageDimension> SVFAgregatorType;
-        SVFAgregatorType *tmpAgreg = dynamic_cast <SVFAgregatorType *> (this->GetAgregator());
+    // Both directions are independent until their combination, match them concurrently
+    itk::TimeProbe tmpTime;
+    tmpTime.Start();
 
-        if (tmpAgreg)
-            tmpAgreg->SetBlockDamWeights(m_ReverseBlockMatcher->GetBlockDamWeights());
-        else
-        {
-            typedef anima::DenseSVFTransformAgregator<InputImageType::ImageDimension> SVFAgregatorType;
-            SVFAgregatorType *tmpDenseAgreg = dynamic_cast <SVFAgregatorType *> (this->GetAgregator());
+    this->UpdateBlockMatchersConcurrently(this->GetBlockMatcher(),m_ReverseBlockMatcher);
 
-            tmpDenseAgreg->SetBlockDamWeights(m_ReverseBlockMatcher->GetBlockDamWeights());
-        }
-    }
+    tmpTime.Stop();
 
-    this->GetAgregator()->SetInputWeights(m_ReverseBlockMatcher->GetBlockWeights());
-    this->GetAgregator()->SetInputTransforms(m_ReverseBlockMatcher->GetBlockTransformPointers());
+    if (this->GetVerboseProgression())
+        std::cout << "Forward and reverse matching performed in " << tmpTime.GetTotal() << std::endl;
 
-    TransformPointer reverseAddOn = this->GetAgregator()->GetOutput();
+    TransformPointer usualAddOn = this->AgregateBlockMatches(this->GetBlockMatcher());
+    TransformPointer reverseAddOn = this->AgregateBlockMatches(m_ReverseBlockMatcher);
 
     if (this->GetAgregator()->GetOutputTransformType() == AgregatorType::SVF)
     {
         // Add update to current velocity field (cf. Vercauteren et al, 2008)
         // First compute the SVF from two asymmetric ones: S = 0.5 * (S_0 - S_1)
         // It's 0.5 since we are computing the full transform between the two images
-        typedef typename SVFTransformType::VectorFieldType VelocityFieldType;
-
-        typedef typename itk::ImageRegionConstIterator <VelocityFieldType> VelocityFieldConstIterator;
-        typedef typename itk::ImageRegionIterator <VelocityFieldType> VelocityFieldIterator;
-
         SVFTransformType *usualAddOnCast = dynamic_cast <SVFTransformType *> (usualAddOn.GetPointer());
         SVFTransformType *reverseAddOnCast = dynamic_cast <SVFTransformType *> (reverseAddOn.GetPointer());
 
-        typename VelocityFieldType::Pointer usualAddOnSVF = const_cast <VelocityFieldType *> (usualAddOnCast->GetParametersAsVectorField());
-
-        VelocityFieldIterator usualAddOnItr(usualAddOnSVF,usualAddOnSVF->GetLargestPossibleRegion());
-
-        VelocityFieldConstIterator reverseAddOnItr(reverseAddOnCast->GetParametersAsVectorField(),
-                                                   reverseAddOnCast->GetParametersAsVectorField()->GetLargestPossibleRegion());
-
-        typedef typename VelocityFieldType::PixelType VectorType;
-        VectorType tmpVec;
-        while (!usualAddOnItr.IsAtEnd())
-        {
-            tmpVec = 0.5 * (usualAddOnItr.Get() - reverseAddOnItr.Get());
-            usualAddOnItr.Set(tmpVec);
-
-            ++usualAddOnItr;
-            ++reverseAddOnItr;
-        }
+        this->CombineSymmetricVelocityFields(usualAddOnCast,reverseAddOnCast,0.5);
     }
     else
     {
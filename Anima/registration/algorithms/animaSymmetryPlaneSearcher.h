@@ -0,0 +1,125 @@
+#pragma once
+
+#include <itkObject.h>
+#include <itkImage.h>
+#include <itkVector.h>
+#include <itkMultiThreader.h>
+
+#include <animaSymmetryPlaneTransform.h>
+#include <animaSparseImageMatchCostFunction.h>
+
+#include <vector>
+
+namespace anima
+{
+
+/**
+ * @brief Global search of the symmetry plane of a 3D image, to be run on a low resolution image.
+ *
+ * Plane normals are sampled uniformly on a half sphere. For each normal, the plane offset is found
+ * as the maximum of the self-convolution of the image projection on the normal (i.e. the reflection
+ * correlation of that projection), the full reflection correlation being then computed on a sparse
+ * voxel sample. The best distinct normals are used as starting points for a local optimization of
+ * the reflection correlation. Results are parameters of a SymmetryPlaneTransform centered on the
+ * rotation center.
+ */
+template <typename TImageType>
+class SymmetryPlaneSearcher : public itk::Object
+{
+public:
+    /** Standard class typedefs. */
+    typedef SymmetryPlaneSearcher Self;
+    typedef itk::Object Superclass;
+    typedef itk::SmartPointer <Self> Pointer;
+    typedef itk::SmartPointer <const Self> ConstPointer;
+
+    itkNewMacro(Self)
+
+    /** Run-time type information (and related methods) */
+    itkTypeMacro(SymmetryPlaneSearcher, itk::Object)
+
+    typedef TImageType ImageType;
+    typedef typename ImageType::PointType PointType;
+    typedef anima::SymmetryPlaneTransform <double> TransformType;
+    typedef typename TransformType::ParametersType ParametersType;
+    typedef anima::SparseImageMatchCostFunction <ImageType, double> CostFunctionType;
+    typedef itk::Vector <double, 3> NormalType;
+
+    void SetInputImage(const ImageType *image) {m_InputImage = image;}
+    void SetRotationCenter(const PointType &center) {m_RotationCenter = center;}
+
+    itkSetMacro(NumberOfThreads, unsigned int)
+    itkSetMacro(NumberOfSampledNormals, unsigned int)
+    itkSetMacro(NumberOfProfileBins, unsigned int)
+    itkSetMacro(NumberOfStarts, unsigned int)
+    itkSetMacro(MinimalStartsAngle, double)
+    itkSetMacro(MaximumNumberOfSamples, unsigned int)
+
+    itkSetMacro(SearchRadius, double)
+    itkSetMacro(SearchAngleRadius, double)
+    itkSetMacro(FinalRadius, double)
+    itkSetMacro(OptimizerMaxIterations, unsigned int)
+
+    void Update();
+
+    const ParametersType &GetOptimalParameters() const {return m_OptimalParameters;}
+    itkGetConstMacro(OptimalValue, double)
+
+protected:
+    SymmetryPlaneSearcher();
+    virtual ~SymmetryPlaneSearcher() {}
+
+    struct ThreadedScoringData
+    {
+        Self *Searcher;
+    };
+
+    //! Uniform (Fibonacci) sampling of normals on the upper half sphere
+    void SampleNormals();
+
+    static ITK_THREAD_RETURN_TYPE ThreadedScoring(void *arg);
+    void ScoreNormals(unsigned int threadId, unsigned int numThreads);
+
+    //! Best plane offset along a normal from the self-convolution of the sample projection profile
+    double ComputeBestOffset(const NormalType &normal, std::vector <double> &profile, std::vector <double> &convolution);
+
+    //! Reflection correlation of the plane n.(x - center) = offset
+    double ComputeReflectionCorrelation(const NormalType &normal, double offset);
+
+    //! Local optimization from a starting plane, returns the final correlation
+    double RefinePlane(ParametersType &parameters);
+
+    ParametersType GetParametersFromPlane(const NormalType &normal, double offset);
+
+private:
+    SymmetryPlaneSearcher(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+
+    typename ImageType::ConstPointer m_InputImage;
+    PointType m_RotationCenter;
+
+    unsigned int m_NumberOfThreads;
+    unsigned int m_NumberOfSampledNormals;
+    unsigned int m_NumberOfProfileBins;
+    unsigned int m_NumberOfStarts;
+    double m_MinimalStartsAngle;
+    unsigned int m_MaximumNumberOfSamples;
+
+    double m_SearchRadius;
+    double m_SearchAngleRadius;
+    double m_FinalRadius;
+    unsigned int m_OptimizerMaxIterations;
+
+    typename CostFunctionType::Pointer m_CostFunction;
+
+    std::vector <NormalType> m_Normals;
+    std::vector <double> m_NormalOffsets;
+    std::vector <double> m_NormalScores;
+
+    ParametersType m_OptimalParameters;
+    double m_OptimalValue;
+};
+
+} // end namespace anima
+
+#include "animaSymmetryPlaneSearcher.hxx"
@@ -0,0 +1,287 @@
+#pragma once
+#include "animaSymmetryPlaneSearcher.h"
+
+#include <animaNewuoaOptimizer.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace anima
+{
+
+template <typename TImageType>
+SymmetryPlaneSearcher <TImageType>
+::SymmetryPlaneSearcher()
+{
+    m_RotationCenter.Fill(0);
+
+    m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    m_NumberOfSampledNormals = 2000;
+    m_NumberOfProfileBins = 128;
+    m_NumberOfStarts = 4;
+    m_MinimalStartsAngle = 15;
+    m_MaximumNumberOfSamples = 20000;
+
+    m_SearchRadius = 2;
+    m_SearchAngleRadius = 5;
+    m_FinalRadius = 0.001;
+    m_OptimizerMaxIterations = 100;
+
+    m_OptimalParameters.SetSize(TransformType::ParametersDimension);
+    m_OptimalParameters.Fill(0);
+    m_OptimalValue = 0;
+}
+
+template <typename TImageType>
+void
+SymmetryPlaneSearcher <TImageType>
+::Update()
+{
+    if (!m_InputImage)
+        itkExceptionMacro("No input image for symmetry plane search");
+
+    m_CostFunction = CostFunctionType::New();
+    m_CostFunction->SetFixedImage(m_InputImage);
+    m_CostFunction->SetMovingImage(m_InputImage);
+    m_CostFunction->SetMaximumNumberOfSamples(m_MaximumNumberOfSamples);
+    m_CostFunction->SetUseCorrelation(true);
+    m_CostFunction->Initialize();
+
+    this->SampleNormals();
+
+    unsigned int numNormals = m_Normals.size();
+    m_NormalOffsets.resize(numNormals);
+    m_NormalScores.resize(numNormals);
+
+    itk::MultiThreader::Pointer threadWorker = itk::MultiThreader::New();
+    ThreadedScoringData *tmpStr = new ThreadedScoringData;
+    tmpStr->Searcher = this;
+
+    threadWorker->SetNumberOfThreads(m_NumberOfThreads);
+    threadWorker->SetSingleMethod(this->ThreadedScoring,tmpStr);
+    threadWorker->SingleMethodExecute();
+
+    delete tmpStr;
+
+    // Starting points: best scores, sufficiently apart from each other
+    std::vector <unsigned int> sortedNormals(numNormals);
+    for (unsigned int i = 0;i < numNormals;++i)
+        sortedNormals[i] = i;
+
+    std::sort(sortedNormals.begin(),sortedNormals.end(),
+              [this] (unsigned int a, unsigned int b) {return m_NormalScores[a] > m_NormalScores[b];});
+
+    double minimalCosine = std::cos(m_MinimalStartsAngle * M_PI / 180.0);
+    std::vector <unsigned int> startNormals;
+    for (unsigned int i = 0;(i < numNormals) && (startNormals.size() < m_NumberOfStarts);++i)
+    {
+        const NormalType &candidate = m_Normals[sortedNormals[i]];
+        bool isDistinct = true;
+        for (unsigned int j = 0;j < startNormals.size();++j)
+        {
+            if (std::abs(candidate * m_Normals[startNormals[j]]) > minimalCosine)
+            {
+                isDistinct = false;
+                break;
+            }
+        }
+
+        if (isDistinct)
+            startNormals.push_back(sortedNormals[i]);
+    }
+
+    m_OptimalValue = - 1.0;
+    for (unsigned int i = 0;i < startNormals.size();++i)
+    {
+        ParametersType startParameters = this->GetParametersFromPlane(m_Normals[startNormals[i]],m_NormalOffsets[startNormals[i]]);
+        double startValue = this->RefinePlane(startParameters);
+
+        if (startValue > m_OptimalValue)
+        {
+            m_OptimalValue = startValue;
+            m_OptimalParameters = startParameters;
+        }
+    }
+
+    m_CostFunction = 0;
+}
+
+template <typename TImageType>
+void
+SymmetryPlaneSearcher <TImageType>
+::SampleNormals()
+{
+    m_Normals.resize(m_NumberOfSampledNormals);
+    double goldenAngle = M_PI * (3.0 - std::sqrt(5.0));
+
+    for (unsigned int i = 0;i < m_NumberOfSampledNormals;++i)
+    {
+        double zValue = (i + 0.5) / m_NumberOfSampledNormals;
+        double radius = std::sqrt(1.0 - zValue * zValue);
+        double angle = goldenAngle * i;
+
+        m_Normals[i][0] = radius * std::cos(angle);
+        m_Normals[i][1] = radius * std::sin(angle);
+        m_Normals[i][2] = zValue;
+    }
+}
+
+template <typename TImageType>
+ITK_THREAD_RETURN_TYPE
+SymmetryPlaneSearcher <TImageType>
+::ThreadedScoring(void *arg)
+{
+    itk::MultiThreader::ThreadInfoStruct *threadArgs = (itk::MultiThreader::ThreadInfoStruct *)arg;
+    ThreadedScoringData *data = (ThreadedScoringData *)threadArgs->UserData;
+
+    data->Searcher->ScoreNormals(threadArgs->ThreadID,threadArgs->NumberOfThreads);
+    return ITK_THREAD_RETURN_VALUE;
+}
+
+template <typename TImageType>
+void
+SymmetryPlaneSearcher <TImageType>
+::ScoreNormals(unsigned int threadId, unsigned int numThreads)
+{
+    unsigned int numNormals = m_Normals.size();
+    unsigned int startNormal = (unsigned int)((unsigned long)threadId * numNormals / numThreads);
+    unsigned int endNormal = (unsigned int)((unsigned long)(threadId + 1) * numNormals / numThreads);
+
+    std::vector <double> profile(m_NumberOfProfileBins);
+    std::vector <double> convolution(2 * m_NumberOfProfileBins - 1);
+
+    for (unsigned int i = startNormal;i < endNormal;++i)
+    {
+        m_NormalOffsets[i] = this->ComputeBestOffset(m_Normals[i],profile,convolution);
+        m_NormalScores[i] = this->ComputeReflectionCorrelation(m_Normals[i],m_NormalOffsets[i]);
+    }
+}
+
+template <typename TImageType>
+double
+SymmetryPlaneSearcher <TImageType>
+::ComputeBestOffset(const NormalType &normal, std::vector <double> &profile, std::vector <double> &convolution)
+{
+    const std::vector <PointType> &samplePoints = m_CostFunction->GetSamplePoints();
+    const std::vector <double> &sampleValues = m_CostFunction->GetSampleValues();
+    unsigned int numSamples = samplePoints.size();
+    unsigned int numBins = profile.size();
+
+    double minProjection = 0, maxProjection = 0;
+    for (unsigned int i = 0;i < numSamples;++i)
+    {
+        double projection = 0;
+        for (unsigned int j = 0;j < 3;++j)
+            projection += normal[j] * (samplePoints[i][j] - m_RotationCenter[j]);
+
+        minProjection = std::min(minProjection,projection);
+        maxProjection = std::max(maxProjection,projection);
+    }
+
+    double binWidth = (maxProjection - minProjection) / numBins;
+    if (binWidth <= 0)
+        return 0;
+
+    std::fill(profile.begin(),profile.end(),0.0);
+    for (unsigned int i = 0;i < numSamples;++i)
+    {
+        if (sampleValues[i] <= 0)
+            continue;
+
+        double projection = 0;
+        for (unsigned int j = 0;j < 3;++j)
+            projection += normal[j] * (samplePoints[i][j] - m_RotationCenter[j]);
+
+        unsigned int bin = std::min(numBins - 1,(unsigned int)std::floor((projection - minProjection) / binWidth));
+        profile[bin] += sampleValues[i];
+    }
+
+    // Self-convolution: bins i and j are mirrored with respect to the offset of bin k = i + j
+    std::fill(convolution.begin(),convolution.end(),0.0);
+    for (unsigned int i = 0;i < numBins;++i)
+    {
+        if (profile[i] == 0)
+            continue;
+
+        for (unsigned int j = 0;j < numBins;++j)
+            convolution[i + j] += profile[i] * profile[j];
+    }
+
+    unsigned int bestBin = std::max_element(convolution.begin(),convolution.end()) - convolution.begin();
+    return minProjection + (bestBin + 1) * binWidth / 2.0;
+}
+
+template <typename TImageType>
+double
+SymmetryPlaneSearcher <TImageType>
+::ComputeReflectionCorrelation(const NormalType &normal, double offset)
+{
+    typename CostFunctionType::MatrixType reflectionMatrix;
+    typename CostFunctionType::OffsetType reflectionOffset;
+
+    double planeDistance = offset;
+    for (unsigned int i = 0;i < 3;++i)
+        planeDistance += normal[i] * m_RotationCenter[i];
+
+    for (unsigned int i = 0;i < 3;++i)
+    {
+        for (unsigned int j = 0;j < 3;++j)
+            reflectionMatrix(i,j) = (i == j) - 2.0 * normal[i] * normal[j];
+
+        reflectionOffset[i] = 2.0 * planeDistance * normal[i];
+    }
+
+    return m_CostFunction->Evaluate(reflectionMatrix,reflectionOffset);
+}
+
+template <typename TImageType>
+typename SymmetryPlaneSearcher <TImageType>::ParametersType
+SymmetryPlaneSearcher <TImageType>
+::GetParametersFromPlane(const NormalType &normal, double offset)
+{
+    // Normal is (cos(phi) cos(theta), sin(phi) cos(theta), sin(theta))
+    ParametersType parameters(TransformType::ParametersDimension);
+    parameters[0] = std::asin(std::max(-1.0,std::min(1.0,normal[2])));
+    parameters[1] = std::atan2(normal[1],normal[0]);
+    parameters[2] = offset;
+
+    return parameters;
+}
+
+template <typename TImageType>
+double
+SymmetryPlaneSearcher <TImageType>
+::RefinePlane(ParametersType &parameters)
+{
+    typename TransformType::Pointer trsf = TransformType::New();
+    trsf->SetRotationCenter(m_RotationCenter);
+    trsf->SetParameters(parameters);
+    m_CostFunction->SetTransform(trsf);
+
+    anima::NewuoaOptimizer::Pointer optimizer = anima::NewuoaOptimizer::New();
+    optimizer->SetRhoBegin(m_SearchRadius);
+    optimizer->SetRhoEnd(m_FinalRadius);
+    optimizer->SetNumberSamplingPoints(TransformType::ParametersDimension + 2);
+    optimizer->SetMaximumIteration(m_OptimizerMaxIterations);
+    optimizer->SetMaximize(true);
+
+    anima::NewuoaOptimizer::ScalesType tmpScales(TransformType::ParametersDimension);
+    tmpScales[0] = m_SearchRadius * 180.0 / (m_SearchAngleRadius * M_PI);
+    tmpScales[1] = tmpScales[0];
+
+    double meanSpacing = 0;
+    for (unsigned int i = 0;i < ImageType::ImageDimension;++i)
+        meanSpacing += m_InputImage->GetSpacing()[i];
+
+    tmpScales[2] = ImageType::ImageDimension / meanSpacing;
+    optimizer->SetScales(tmpScales);
+
+    optimizer->SetCostFunction(m_CostFunction);
+    optimizer->SetInitialPosition(parameters);
+    optimizer->StartOptimization();
+
+    parameters = optimizer->GetCurrentPosition();
+    return m_CostFunction->GetValue(parameters);
+}
+
+} // end namespace anima
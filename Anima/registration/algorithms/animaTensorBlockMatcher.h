@@ -1,5 +1,6 @@
 #pragma once
 #include <animaBaseAffineBlockMatcher.h>
+#include <animaVectorModelLinearInterpolateImageFunction.h>
 
 namespace anima
 {
@@ -34,12 +35,16 @@ public:
     typedef typename Superclass::BaseInputTransformPointer BaseInputTransformPointer;
     typedef typename Superclass::OptimizerPointer OptimizerPointer;
 
+    typedef anima::VectorModelLinearInterpolateImageFunction<InputImageType,double> InterpolatorType;
+    typedef typename InterpolatorType::Pointer InterpolatorPointer;
+
     bool GetMaximizedMetric();
     void SetSimilarityType(SimilarityDefinition val) {m_SimilarityType = val;}
 
     void SetModelRotationType(ModelRotationType val) {m_ModelRotationType = val;}
 
 protected:
+    virtual void BeforeMatching();
     virtual MetricPointer SetupMetric();
     virtual double ComputeBlockWeight(double val, unsigned int block);
 
@@ -48,6 +53,9 @@ protected:
 private:
     SimilarityDefinition m_SimilarityType;
     ModelRotationType m_ModelRotationType;
+
+    //! Moving image interpolator, shared by all metrics: its buffer offsets and non-zero mask are computed once per matching
+    InterpolatorPointer m_Interpolator;
 };
 
 } // end namespace anima
@@ -7,8 +7,6 @@
 #include <animaTensorMeanSquaresImageToImageMetric.h>
 #include <animaBaseOrientedModelImageToImageMetric.h>
 
-#include <animaVectorModelLinearInterpolateImageFunction.h>
-
 namespace anima
 {
 
@@ -31,6 +29,15 @@ TensorBlockMatcher<TInputImageType>
     return true;
 }
 
+template <typename TInputImageType>
+void
+TensorBlockMatcher<TInputImageType>
+::BeforeMatching()
+{
+    m_Interpolator = InterpolatorType::New();
+    m_Interpolator->SetInputImage(this->GetMovingImage());
+}
+
 template <typename TInputImageType>
 typename TensorBlockMatcher<TInputImageType>::MetricPointer
 TensorBlockMatcher<TInputImageType>
@@ -83,14 +90,10 @@ TensorBlockMatcher<TInputImageType>
     else
         baseMetric->SetModelRotation((typename BaseMetricType::ModelReorientationType)m_ModelRotationType);
 
-    typedef anima::VectorModelLinearInterpolateImageFunction<InputImageType,double> LocalInterpolatorType;
-    typename LocalInterpolatorType::Pointer interpolator = LocalInterpolatorType::New();
-
-    baseMetric->SetInterpolator(interpolator);
+    baseMetric->SetInterpolator(m_Interpolator);
 
     baseMetric->SetFixedImage(this->GetReferenceImage());
     baseMetric->SetMovingImage(this->GetMovingImage());
-    interpolator->SetInputImage(this->GetMovingImage());
 
     return metric;
 }
@@ -135,11 +138,18 @@ TensorBlockMatcher<TInputImageType>
                                                                  InputImageType::ImageDimension > TensorGeneralizedMetricType;
 
 
+    typedef anima::TensorMeanSquaresImageToImageMetric <typename InputImageType::IOPixelType,
+                                                         typename InputImageType::IOPixelType,
+                                                         InputImageType::ImageDimension > TensorMeanSquaresMetricType;
+
     if ((m_SimilarityType == TensorGeneralizedCorrelation)||(m_SimilarityType == TensorOrientedGeneralizedCorrelation))
         ((TensorGeneralizedMetricType *)metric.GetPointer())->PreComputeFixedValues();
 
     if (m_SimilarityType == TensorCorrelation)
         ((TensorCorrelationMetricType *)metric.GetPointer())->PreComputeFixedValues();
+
+    if (m_SimilarityType == TensorMeanSquares)
+        ((TensorMeanSquaresMetricType *)metric.GetPointer())->PreComputeFixedValues();
 }
 
 } // end namespace anima
@@ -209,6 +209,20 @@ PyramidalDenseSVFMatchingBridge<ImageDimension>::Update()
         mainMatcher->SetUseTransformationDam(m_UseTransformationDam);
         mainMatcher->SetDamDistance(m_DamDistance * meanSpacing / 2.0);
 
+        // Symmetric methods match both directions concurrently, each with its own matcher
+        if (m_SymmetryType != Asymmetric)
+        {
+            reverseMatcher = new BlockMatcherType;
+            reverseMatcher->SetBlockPercentageKept(GetPercentageKept());
+            reverseMatcher->SetBlockSize(GetBlockSize());
+            reverseMatcher->SetBlockSpacing(GetBlockSpacing());
+            reverseMatcher->SetBlockVarianceThreshold(GetStDevThreshold() * GetStDevThreshold());
+            reverseMatcher->SetBlockGenerationMask(maskGenerationImage);
+            reverseMatcher->SetUseTransformationDam(m_UseTransformationDam);
+            reverseMatcher->SetDamDistance(m_DamDistance * meanSpacing / 2.0);
+            reverseMatcher->SetVerbose(m_Verbose);
+        }
+
         switch (m_SymmetryType)
         {
             case Asymmetric:
@@ -222,17 +236,6 @@ PyramidalDenseSVFMatchingBridge<ImageDimension>::Update()
             {
                 typedef typename anima::SymmetricBMRegistrationMethod <InputImageType> BlockMatchRegistrationType;
                 typename BlockMatchRegistrationType::Pointer tmpReg = BlockMatchRegistrationType::New();
-
-                reverseMatcher = new BlockMatcherType;
-                reverseMatcher->SetBlockPercentageKept(GetPercentageKept());
-                reverseMatcher->SetBlockSize(GetBlockSize());
-                reverseMatcher->SetBlockSpacing(GetBlockSpacing());
-                reverseMatcher->SetBlockVarianceThreshold(GetStDevThreshold() * GetStDevThreshold());
-                reverseMatcher->SetBlockGenerationMask(maskGenerationImage);
-                reverseMatcher->SetUseTransformationDam(m_UseTransformationDam);
-                reverseMatcher->SetDamDistance(m_DamDistance * meanSpacing / 2.0);
-                reverseMatcher->SetVerbose(m_Verbose);
-
                 tmpReg->SetReverseBlockMatcher(reverseMatcher);
                 m_bmreg = tmpReg;
                 break;
@@ -241,7 +244,9 @@ PyramidalDenseSVFMatchingBridge<ImageDimension>::Update()
             case Kissing:
             {
                 typedef typename anima::KissingSymmetricBMRegistrationMethod <InputImageType> BlockMatchRegistrationType;
-                m_bmreg = BlockMatchRegistrationType::New();
+                typename BlockMatchRegistrationType::Pointer tmpReg = BlockMatchRegistrationType::New();
+                tmpReg->SetReverseBlockMatcher(reverseMatcher);
+                m_bmreg = tmpReg;
                 break;
             }
         }
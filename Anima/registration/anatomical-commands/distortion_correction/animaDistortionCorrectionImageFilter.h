@@ -50,6 +50,9 @@ protected:
 
     virtual const itk::ImageRegionSplitterBase* GetImageRegionSplitter() const ITK_OVERRIDE;
 
+    //! Computes the displacement along one line from forward and backward cumulated intensities (exact piecewise linear inverse)
+    void ComputeLineField(const double *forwardCumulated, const double *backwardCumulated, unsigned int lengthLine, double *lineField);
+
 private:
     unsigned int m_Direction;
     double m_FieldSmoothingSigma;
@@ -1,18 +1,13 @@
 #pragma once
 #include "animaDistortionCorrectionImageFilter.h"
 
-#include <itkVariableLengthVector.h>
-#include <itkImageRegionIterator.h>
-#include <itkImageRegionConstIterator.h>
-#include <itkImageLinearIteratorWithIndex.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
 
 #include <animaSmoothingRecursiveYvvGaussianImageFilter.h>
-#include <animaCubicInterpolation.h>
 
+#include <algorithm>
 #include <vector>
 #include <cstddef>
-#include <iterator>
-#include <iostream>
 
 namespace anima
 {
@@ -65,106 +60,149 @@ template< typename TInputImage >
 void DistortionCorrectionImageFilter < TInputImage >
 ::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, itk::ThreadIdType threadId)
 {
-    InputImagePointer  forwardImage = this->GetInput(0);
-    InputImagePointer  backwardImage = this->GetInput(1);
+    const TInputImage *forwardImage = this->GetInput(0);
+    const TInputImage *backwardImage = this->GetInput(1);
+    OutputImageType *outputImage = this->GetOutput();
+
+    const PixelType *forwardBuffer = forwardImage->GetBufferPointer();
+    const PixelType *backwardBuffer = backwardImage->GetBufferPointer();
+    PixelType *outputBuffer = outputImage->GetBufferPointer();
+    unsigned int vectorLength = outputImage->GetNumberOfComponentsPerPixel();
+
+    unsigned int lengthLine = outputRegionForThread.GetSize()[m_Direction];
+    std::ptrdiff_t inputStride = forwardImage->GetOffsetTable()[m_Direction];
+    std::ptrdiff_t outputStride = outputImage->GetOffsetTable()[m_Direction];
+
+    // Line starts are enumerated over the region collapsed along the distortion direction
+    OutputImageRegionType lineStartsRegion = outputRegionForThread;
+    lineStartsRegion.SetSize(m_Direction,1);
+    itk::ImageRegionConstIteratorWithIndex <OutputImageType> lineStartsIt(outputImage,lineStartsRegion);
+
+    // Lines are gathered by batches into contiguous scratch buffers, allocated once per thread
+    const unsigned int batchSize = 8;
+    std::vector <double> forwardCumulatedLines(batchSize * lengthLine);
+    std::vector <double> backwardCumulatedLines(batchSize * lengthLine);
+    std::vector <std::ptrdiff_t> outputLineOffsets(batchSize);
+    std::vector <double> lineField(lengthLine);
 
-    typedef itk::ImageLinearConstIteratorWithIndex< TInputImage > ConstIteratorType;
-    typedef itk::ImageLinearIteratorWithIndex< OutputImageType > IteratorType;
-
-    ConstIteratorType forwardIt (forwardImage, outputRegionForThread);
-    ConstIteratorType backwardIt (backwardImage, outputRegionForThread);
-    IteratorType outputIt (this->GetOutput(), outputRegionForThread);
-
-    forwardIt.SetDirection(m_Direction);
-    backwardIt.SetDirection(m_Direction);
-    outputIt.SetDirection(m_Direction);
-
-    unsigned int lengthLine = outputRegionForThread.GetSize()[ this->m_Direction ];
-
-    double step = 0;
     double epsilon = 0.0001;
-    itk::VariableLengthVector< PixelType > fillVectorField(3);
-    itk::VariableLengthVector< PixelType > fillScaledVectorField(3);
-    fillVectorField.Fill(0);
-    fillScaledVectorField.Fill(0);
-
-    std::vector<double> forwardScale;
-    std::vector<double> backwardScale;
-    std::vector<double> middleScale;
-    std::vector<double> differenceForwardBackward;
-    std::vector<double> differenceForwardBackwardResampled;
-
-    while (!forwardIt.IsAtEnd())
-    {
-        // Compute Cumulative sum
-        std::vector<double> forwardCumulatedLine;
-        std::vector<double> backwardCumulatedLine;
 
-        forwardCumulatedLine.push_back(forwardIt.Get());
-        backwardCumulatedLine.push_back(backwardIt.Get());
-
-        ++forwardIt;
-        ++backwardIt;
-
-        while (!forwardIt.IsAtEndOfLine())
+    while (!lineStartsIt.IsAtEnd())
+    {
+        unsigned int numLinesInBatch = 0;
+        while ((numLinesInBatch < batchSize) && (!lineStartsIt.IsAtEnd()))
         {
+            typename OutputImageType::IndexType lineStart = lineStartsIt.GetIndex();
+            const PixelType *forwardLine = forwardBuffer + forwardImage->ComputeOffset(lineStart);
+            const PixelType *backwardLine = backwardBuffer + backwardImage->ComputeOffset(lineStart);
+            outputLineOffsets[numLinesInBatch] = outputImage->ComputeOffset(lineStart);
+
+            // Cumulative sums computed in place in scratch buffers
+            double *forwardCumulated = forwardCumulatedLines.data() + numLinesInBatch * lengthLine;
+            double *backwardCumulated = backwardCumulatedLines.data() + numLinesInBatch * lengthLine;
+
+            forwardCumulated[0] = forwardLine[0];
+            backwardCumulated[0] = backwardLine[0];
+            for (unsigned int i = 1;i < lengthLine;++i)
+            {
+                forwardCumulated[i] = forwardCumulated[i - 1] + forwardLine[i * inputStride] + epsilon;
+                backwardCumulated[i] = backwardCumulated[i - 1] + backwardLine[i * inputStride] + epsilon;
+            }
 
-            forwardCumulatedLine.push_back(forwardCumulatedLine.back() + forwardIt.Get() + epsilon);
-            backwardCumulatedLine.push_back(backwardCumulatedLine.back() + backwardIt.Get() + epsilon);
-
-            ++forwardIt;
-            ++backwardIt;
-
+            ++numLinesInBatch;
+            ++lineStartsIt;
         }
 
-        double forwMax = forwardCumulatedLine.back();
-        double forwMin = forwardCumulatedLine.front();
-        double backMax = backwardCumulatedLine.back();
-        double backMin = backwardCumulatedLine.front();
-
-        for (int i=0; i<lengthLine; i++)
-            backwardCumulatedLine[i]-= backMin;
-        for (int i=0; i<lengthLine; i++)
-            backwardCumulatedLine[i]*= (forwMax - forwMin)/(backMax - backMin);
-        for (int i=0; i<lengthLine; i++)
-            backwardCumulatedLine[i]+= forwMin;
+        for (unsigned int l = 0;l < numLinesInBatch;++l)
+        {
+            double *forwardCumulated = forwardCumulatedLines.data() + l * lengthLine;
+            double *backwardCumulated = backwardCumulatedLines.data() + l * lengthLine;
 
-        step = (forwMax - forwMin)/(10*forwardCumulatedLine.size());
+            // Backward cumulated line is rescaled to the forward one range
+            double forwMin = forwardCumulated[0];
+            double forwMax = forwardCumulated[lengthLine - 1];
+            double backMin = backwardCumulated[0];
+            double backMax = backwardCumulated[lengthLine - 1];
 
-        InverseCubicInterpolator(forwardCumulatedLine, forwardScale, step);
-        InverseCubicInterpolator(backwardCumulatedLine, backwardScale, step);
+            if ((backMax <= backMin) || (forwMax <= forwMin))
+            {
+                // Flat line, nothing to match: identity mapping
+                std::fill(lineField.begin(),lineField.end(),0.0);
+            }
+            else
+            {
+                double scaleFactor = (forwMax - forwMin) / (backMax - backMin);
+                for (unsigned int i = 0;i < lengthLine;++i)
+                    backwardCumulated[i] = (backwardCumulated[i] - backMin) * scaleFactor + forwMin;
+                backwardCumulated[lengthLine - 1] = forwMax;
 
-        differenceForwardBackward.resize(forwardScale.size());
-        middleScale.resize(forwardScale.size());
+                this->ComputeLineField(forwardCumulated,backwardCumulated,lengthLine,lineField.data());
+            }
 
-        for (int i=0; i< differenceForwardBackward.size(); i++)
-        {
-            differenceForwardBackward[i] = (forwardScale[i] - backwardScale[i])/2;
-            middleScale[i] = (forwardScale[i] + backwardScale[i])/2;
+            PixelType *outputLine = outputBuffer + outputLineOffsets[l] * vectorLength;
+            for (unsigned int i = 0;i < lengthLine;++i)
+            {
+                PixelType *outputValue = outputLine + i * outputStride * vectorLength;
+                for (unsigned int j = 0;j < 3;++j)
+                    outputValue[j] = m_ReferenceGeometry(j,m_Direction) * lineField[i];
+            }
         }
+    }
+}
 
-        CubicInterpolator<double>(differenceForwardBackward, middleScale, differenceForwardBackwardResampled, lengthLine);
+template< typename TInputImage >
+void DistortionCorrectionImageFilter < TInputImage >
+::ComputeLineField(const double *forwardCumulated, const double *backwardCumulated, unsigned int lengthLine, double *lineField)
+{
+    // Positions f(c) and b(c) at which cumulated intensities reach a level c are piecewise linear in c,
+    // their breakpoints being the cumulated values. Walking merged breakpoints gives the exact mapping
+    // from middle position m = (f + b) / 2 to half difference (f - b) / 2, sampled at integer positions
+    lineField[0] = 0;
+    if (lengthLine < 2)
+        return;
+
+    unsigned int forwardSegment = 0;
+    unsigned int backwardSegment = 0;
+    double previousMiddle = 0;
+    double previousDifference = 0;
+
+    unsigned int pos = 1;
+    while ((pos < lengthLine - 1) && (forwardSegment < lengthLine - 1) && (backwardSegment < lengthLine - 1))
+    {
+        double level = std::min(forwardCumulated[forwardSegment + 1],backwardCumulated[backwardSegment + 1]);
 
-        unsigned int pos = 0;
+        double forwardDelta = forwardCumulated[forwardSegment + 1] - forwardCumulated[forwardSegment];
+        double forwardPosition = forwardSegment + 1;
+        if (forwardDelta > 0)
+            forwardPosition = forwardSegment + (level - forwardCumulated[forwardSegment]) / forwardDelta;
 
-        while (!outputIt.IsAtEndOfLine())
-        {
-            fillVectorField[m_Direction] = differenceForwardBackwardResampled[pos];
+        double backwardDelta = backwardCumulated[backwardSegment + 1] - backwardCumulated[backwardSegment];
+        double backwardPosition = backwardSegment + 1;
+        if (backwardDelta > 0)
+            backwardPosition = backwardSegment + (level - backwardCumulated[backwardSegment]) / backwardDelta;
 
-            for (unsigned int i = 0;i < 3;++i)
-            {
-                fillScaledVectorField[i] = m_ReferenceGeometry(i,m_Direction) * fillVectorField[m_Direction];
-            }
+        double middle = (forwardPosition + backwardPosition) / 2.0;
+        double difference = (forwardPosition - backwardPosition) / 2.0;
 
-            outputIt.Set(fillScaledVectorField);
-            ++outputIt;
-            pos++;
+        while ((pos < lengthLine - 1) && (pos <= middle))
+        {
+            double t = (pos - previousMiddle) / (middle - previousMiddle);
+            lineField[pos] = previousDifference + t * (difference - previousDifference);
+            ++pos;
         }
 
-        forwardIt.NextLine();
-        backwardIt.NextLine();
-        outputIt.NextLine();
+        if (forwardCumulated[forwardSegment + 1] <= level)
+            ++forwardSegment;
+        if (backwardCumulated[backwardSegment + 1] <= level)
+            ++backwardSegment;
+
+        previousMiddle = middle;
+        previousDifference = difference;
     }
+
+    // Both mappings end at the last position
+    for (;pos < lengthLine;++pos)
+        lineField[pos] = 0;
 }
 
 template< typename TInputImage >
@@ -163,6 +163,18 @@ void PyramidalBlockMatchingBridge<ImageDimension>::Update()
             std::cout << "Image size: " << refImage->GetLargestPossibleRegion().GetSize() << std::endl;
         }
 
+        // Symmetric methods match both directions concurrently, each with its own matcher
+        if (m_SymmetryType != Asymmetric)
+        {
+            reverseMatcher = new BlockMatcherType;
+            reverseMatcher->SetBlockPercentageKept(GetPercentageKept());
+            reverseMatcher->SetBlockSize(GetBlockSize());
+            reverseMatcher->SetBlockSpacing(GetBlockSpacing());
+            reverseMatcher->SetBlockVarianceThreshold(GetStDevThreshold() * GetStDevThreshold());
+            reverseMatcher->SetVerbose(m_Verbose);
+            reverseMatcher->SetBlockGenerationMask(maskGenerationImage);
+        }
+
         // Init bm registration method
         switch (m_SymmetryType)
         {
@@ -177,15 +189,6 @@ void PyramidalBlockMatchingBridge<ImageDimension>::Update()
             {
                 typedef typename anima::SymmetricBMRegistrationMethod <InputImageType> BlockMatchRegistrationType;
                 typename BlockMatchRegistrationType::Pointer tmpReg = BlockMatchRegistrationType::New();
-
-                reverseMatcher = new BlockMatcherType;
-                reverseMatcher->SetBlockPercentageKept(GetPercentageKept());
-                reverseMatcher->SetBlockSize(GetBlockSize());
-                reverseMatcher->SetBlockSpacing(GetBlockSpacing());
-                reverseMatcher->SetBlockVarianceThreshold(GetStDevThreshold() * GetStDevThreshold());
-                reverseMatcher->SetVerbose(m_Verbose);
-                reverseMatcher->SetBlockGenerationMask(maskGenerationImage);
-
                 tmpReg->SetReverseBlockMatcher(reverseMatcher);
                 m_bmreg = tmpReg;
                 break;
@@ -195,7 +198,9 @@ void PyramidalBlockMatchingBridge<ImageDimension>::Update()
             default:
             {
                 typedef typename anima::KissingSymmetricBMRegistrationMethod <InputImageType> BlockMatchRegistrationType;
-                m_bmreg = BlockMatchRegistrationType::New();
+                typename BlockMatchRegistrationType::Pointer tmpReg = BlockMatchRegistrationType::New();
+                tmpReg->SetReverseBlockMatcher(reverseMatcher);
+                m_bmreg = tmpReg;
                 break;
             }
         }
@@ -289,6 +294,7 @@ void PyramidalBlockMatchingBridge<ImageDimension>::Update()
         }
 
         agreg->SetVerboseAgregation(m_Verbose);
+        agreg->SetNumberOfThreads(GetNumberOfThreads());
         m_bmreg->SetAgregator(agreg);
 
         switch (GetTransform())
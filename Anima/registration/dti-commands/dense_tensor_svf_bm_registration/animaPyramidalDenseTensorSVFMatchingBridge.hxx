@@ -182,6 +182,19 @@ PyramidalDenseTensorSVFMatchingBridge<ImageDimension>::Update()
         mainMatcher->SetUseTransformationDam(m_UseTransformationDam);
         mainMatcher->SetDamDistance(m_DamDistance * meanSpacing / 2.0);
 
+        // Symmetric methods match both directions concurrently, each with its own matcher
+        if (m_SymmetryType != Asymmetric)
+        {
+            reverseMatcher = new BlockMatcherType;
+            reverseMatcher->SetBlockPercentageKept(GetPercentageKept());
+            reverseMatcher->SetBlockSize(GetBlockSize());
+            reverseMatcher->SetBlockSpacing(GetBlockSpacing());
+            reverseMatcher->SetBlockVarianceThreshold(GetStDevThreshold() * GetStDevThreshold());
+            reverseMatcher->SetBlockGenerationMask(maskGenerationImage);
+            reverseMatcher->SetUseTransformationDam(m_UseTransformationDam);
+            reverseMatcher->SetDamDistance(m_DamDistance * meanSpacing / 2.0);
+        }
+
         switch (m_SymmetryType)
         {
             case Asymmetric:
@@ -195,15 +208,6 @@ PyramidalDenseTensorSVFMatchingBridge<ImageDimension>::Update()
             {
                 typedef typename anima::SymmetricBMRegistrationMethod <InputImageType> BlockMatchRegistrationType;
                 typename BlockMatchRegistrationType::Pointer tmpReg = BlockMatchRegistrationType::New();
-                reverseMatcher = new BlockMatcherType;
-                reverseMatcher->SetBlockPercentageKept(GetPercentageKept());
-                reverseMatcher->SetBlockSize(GetBlockSize());
-                reverseMatcher->SetBlockSpacing(GetBlockSpacing());
-                reverseMatcher->SetBlockVarianceThreshold(GetStDevThreshold() * GetStDevThreshold());
-                reverseMatcher->SetBlockGenerationMask(maskGenerationImage);
-                reverseMatcher->SetUseTransformationDam(m_UseTransformationDam);
-                reverseMatcher->SetDamDistance(m_DamDistance * meanSpacing / 2.0);
-
                 tmpReg->SetReverseBlockMatcher(reverseMatcher);
                 m_bmreg = tmpReg;
                 break;
@@ -212,7 +216,9 @@ PyramidalDenseTensorSVFMatchingBridge<ImageDimension>::Update()
             case Kissing:
             {
                 typedef typename anima::KissingSymmetricBMRegistrationMethod <InputImageType> BlockMatchRegistrationType;
-                m_bmreg = BlockMatchRegistrationType::New();
+                typename BlockMatchRegistrationType::Pointer tmpReg = BlockMatchRegistrationType::New();
+                tmpReg->SetReverseBlockMatcher(reverseMatcher);
+                m_bmreg = tmpReg;
                 break;
             }
         }
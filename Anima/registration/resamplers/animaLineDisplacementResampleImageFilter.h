@@ -0,0 +1,112 @@
+#pragma once
+
+#include <itkImageToImageFilter.h>
+#include <itkImage.h>
+#include <itkVector.h>
+#include <itkTimeStamp.h>
+#include <vnl/vnl_matrix.h>
+
+#include <vector>
+
+namespace anima
+{
+
+/**
+ * @brief Applies a displacement field acting along a single image axis (e.g. a phase encoding distortion)
+ * to all volumes of a series at once.
+ *
+ * Input 0 is the forward series, optional input 1 is a backward series resampled with the opposite field,
+ * the output then being the average of both corrected series. Each line along the displacement axis is
+ * handled independently: the field is optionally inverted exactly by monotone 1D inversion, its Jacobian
+ * is a 1D derivative, and linear interpolation weights are computed once per line for all volumes.
+ */
+template <typename TImageType>
+class LineDisplacementResampleImageFilter :
+        public itk::ImageToImageFilter <TImageType, TImageType>
+{
+public:
+    /** Standard class typedefs. */
+    typedef LineDisplacementResampleImageFilter Self;
+    typedef itk::ImageToImageFilter <TImageType, TImageType> Superclass;
+    typedef itk::SmartPointer <Self> Pointer;
+    typedef itk::SmartPointer <const Self> ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self)
+
+    /** Run-time type information (and related methods) */
+    itkTypeMacro(LineDisplacementResampleImageFilter, itk::ImageToImageFilter)
+
+    itkStaticConstMacro(ImageDimension, unsigned int, TImageType::ImageDimension);
+    itkStaticConstMacro(SpaceDimension, unsigned int, TImageType::ImageDimension - 1);
+
+    typedef TImageType ImageType;
+    typedef typename ImageType::PixelType PixelType;
+    typedef itk::Image <itk::Vector <double, SpaceDimension>, SpaceDimension> VectorFieldType;
+    typedef typename VectorFieldType::Pointer VectorFieldPointer;
+
+    void SetForwardImage(const ImageType *image) {this->SetNthInput(0, const_cast <ImageType *> (image)); m_DisplacementAxisChecked = false;}
+    void SetBackwardImage(const ImageType *image) {this->SetNthInput(1, const_cast <ImageType *> (image));}
+
+    //! Sets the displacement field, in physical coordinates, on the grid of the series volumes
+    void SetDisplacementField(VectorFieldType *field) {m_DisplacementField = field; m_DisplacementAxisChecked = false; this->Modified();}
+
+    itkSetMacro(ReverseField, bool)
+    itkSetMacro(InvertField, bool)
+    itkSetMacro(ScaleIntensitiesWithJacobian, bool)
+
+    //! Checks if a field lies on the volume grid of geometryImage and only displaces along one axis, returned in axis
+    static bool IsLineDisplacementField(const VectorFieldType *field, const ImageType *geometryImage, unsigned int &axis);
+
+    //! Checks the displacement field against the forward image, the detected axis is cached until either changes
+    bool CheckDisplacementField();
+
+    //! Field actually applied to the forward series (after reversion and inversion), in physical coordinates
+    VectorFieldPointer GetAppliedDisplacementField();
+
+protected:
+    LineDisplacementResampleImageFilter();
+    virtual ~LineDisplacementResampleImageFilter() {}
+
+    void GenerateInputRequestedRegion() ITK_OVERRIDE;
+    void EnlargeOutputRequestedRegion(itk::DataObject *output) ITK_OVERRIDE;
+    void GenerateData() ITK_OVERRIDE;
+
+    //! Converts the input field to displacements in voxels along the displacement axis
+    void ComputeLineDisplacements();
+
+    //! Inverse of the spatial voxel to physical matrix of geometryImage, false if it is singular
+    static bool ComputePhysicalToVoxelMatrix(const ImageType *geometryImage, vnl_matrix <double> &physicalToVoxel);
+
+    static ITK_THREAD_RETURN_TYPE ThreadedResampleCallback(void *arg);
+    void ResampleLines(unsigned int threadId, unsigned int numThreads);
+
+    //! Inverts the line mapping i -> i + displacements[i], result in inverseDisplacements
+    void InvertLine(const double *displacements, double *inverseDisplacements, unsigned int lineSize);
+
+    //! Computes buffer offsets (-1 outside), interpolation weights and Jacobians of one line for a displacement scale
+    void ComputeLineWeights(const double *displacements, double scale, unsigned int lineSize, unsigned int lineStride,
+                            int *firstOffsets, int *secondOffsets, double *weights, double *jacobians);
+
+private:
+    LineDisplacementResampleImageFilter(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+
+    VectorFieldPointer m_DisplacementField;
+    bool m_ReverseField;
+    bool m_InvertField;
+    bool m_ScaleIntensitiesWithJacobian;
+
+    unsigned int m_DisplacementAxis;
+    bool m_DisplacementAxisChecked;
+    bool m_IsLineDisplacementField;
+    itk::TimeStamp m_DisplacementAxisCheckTime;
+
+    //! Displacements in voxels along the displacement axis, as read and as applied
+    std::vector <double> m_LineDisplacements;
+    std::vector <double> m_AppliedLineDisplacements;
+};
+
+} // end namespace anima
+
+#include "animaLineDisplacementResampleImageFilter.hxx"
@@ -0,0 +1,425 @@
+#pragma once
+#include "animaLineDisplacementResampleImageFilter.h"
+
+#include <itkImageSource.h>
+#include <vnl/vnl_matrix.h>
+#include <vnl/algo/vnl_matrix_inverse.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace anima
+{
+
+template <typename TImageType>
+LineDisplacementResampleImageFilter <TImageType>
+::LineDisplacementResampleImageFilter()
+{
+    m_ReverseField = false;
+    m_InvertField = false;
+    m_ScaleIntensitiesWithJacobian = true;
+    m_DisplacementAxis = 0;
+    m_DisplacementAxisChecked = false;
+    m_IsLineDisplacementField = false;
+
+    this->SetNumberOfRequiredInputs(1);
+}
+
+template <typename TImageType>
+bool
+LineDisplacementResampleImageFilter <TImageType>
+::ComputePhysicalToVoxelMatrix(const ImageType *geometryImage, vnl_matrix <double> &physicalToVoxel)
+{
+    vnl_matrix <double> voxelToPhysical(SpaceDimension,SpaceDimension);
+    for (unsigned int i = 0;i < SpaceDimension;++i)
+        for (unsigned int j = 0;j < SpaceDimension;++j)
+            voxelToPhysical(i,j) = geometryImage->GetDirection()(i,j) * geometryImage->GetSpacing()[j];
+
+    vnl_matrix_inverse <double> voxelToPhysicalInverter(voxelToPhysical);
+    if (voxelToPhysicalInverter.rank() < SpaceDimension)
+        return false;
+
+    physicalToVoxel = voxelToPhysicalInverter.inverse();
+    return true;
+}
+
+template <typename TImageType>
+bool
+LineDisplacementResampleImageFilter <TImageType>
+::IsLineDisplacementField(const VectorFieldType *field, const ImageType *geometryImage, unsigned int &axis)
+{
+    typename ImageType::SizeType imageSize = geometryImage->GetLargestPossibleRegion().GetSize();
+    typename VectorFieldType::SizeType fieldSize = field->GetLargestPossibleRegion().GetSize();
+
+    // The field has to lie on the volume grid: same size, origin, spacing and orientation
+    const double geometryTolerance = 1.0e-4;
+    for (unsigned int i = 0;i < SpaceDimension;++i)
+    {
+        if (imageSize[i] != fieldSize[i])
+            return false;
+
+        double imageSpacing = geometryImage->GetSpacing()[i];
+        if (std::abs(imageSpacing - field->GetSpacing()[i]) > geometryTolerance * imageSpacing)
+            return false;
+
+        if (std::abs(geometryImage->GetOrigin()[i] - field->GetOrigin()[i]) > geometryTolerance * imageSpacing)
+            return false;
+
+        for (unsigned int j = 0;j < SpaceDimension;++j)
+        {
+            if (std::abs(geometryImage->GetDirection()(i,j) - field->GetDirection()(i,j)) > geometryTolerance)
+                return false;
+        }
+    }
+
+    // Displacements are expressed in voxel coordinates of the volumes
+    vnl_matrix <double> physicalToVoxel;
+    if (!ComputePhysicalToVoxelMatrix(geometryImage,physicalToVoxel))
+        return false;
+
+    std::vector <double> maxAbsDisplacements(SpaceDimension,0);
+    unsigned int numVoxels = field->GetLargestPossibleRegion().GetNumberOfPixels();
+    const typename VectorFieldType::PixelType *fieldBuffer = field->GetBufferPointer();
+
+    for (unsigned int k = 0;k < numVoxels;++k)
+    {
+        for (unsigned int i = 0;i < SpaceDimension;++i)
+        {
+            double voxelDisplacement = 0;
+            for (unsigned int j = 0;j < SpaceDimension;++j)
+                voxelDisplacement += physicalToVoxel(i,j) * fieldBuffer[k][j];
+
+            maxAbsDisplacements[i] = std::max(maxAbsDisplacements[i],std::abs(voxelDisplacement));
+        }
+    }
+
+    axis = 0;
+    for (unsigned int i = 1;i < SpaceDimension;++i)
+    {
+        if (maxAbsDisplacements[i] > maxAbsDisplacements[axis])
+            axis = i;
+    }
+
+    const double voxelTolerance = 1.0e-4;
+    for (unsigned int i = 0;i < SpaceDimension;++i)
+    {
+        if ((i != axis) && (maxAbsDisplacements[i] > voxelTolerance))
+            return false;
+    }
+
+    return true;
+}
+
+template <typename TImageType>
+bool
+LineDisplacementResampleImageFilter <TImageType>
+::CheckDisplacementField()
+{
+    const ImageType *forwardImage = this->GetInput(0);
+    if (!m_DisplacementField || !forwardImage)
+        return false;
+
+    // Detected axis is kept as long as neither the field nor the volume grid changed
+    unsigned long checkTime = m_DisplacementAxisCheckTime.GetMTime();
+    if (m_DisplacementAxisChecked && (checkTime > m_DisplacementField->GetMTime()) && (checkTime > forwardImage->GetMTime()))
+        return m_IsLineDisplacementField;
+
+    m_IsLineDisplacementField = IsLineDisplacementField(m_DisplacementField,forwardImage,m_DisplacementAxis);
+    m_DisplacementAxisChecked = true;
+    m_DisplacementAxisCheckTime.Modified();
+
+    return m_IsLineDisplacementField;
+}
+
+template <typename TImageType>
+void
+LineDisplacementResampleImageFilter <TImageType>
+::GenerateInputRequestedRegion()
+{
+    Superclass::GenerateInputRequestedRegion();
+
+    for (unsigned int i = 0;i < this->GetNumberOfIndexedInputs();++i)
+    {
+        ImageType *input = const_cast <ImageType *> (this->GetInput(i));
+        if (input)
+            input->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template <typename TImageType>
+void
+LineDisplacementResampleImageFilter <TImageType>
+::EnlargeOutputRequestedRegion(itk::DataObject *output)
+{
+    Superclass::EnlargeOutputRequestedRegion(output);
+    output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <typename TImageType>
+void
+LineDisplacementResampleImageFilter <TImageType>
+::ComputeLineDisplacements()
+{
+    const ImageType *forwardImage = this->GetInput(0);
+
+    if (!m_DisplacementField)
+        throw itk::ExceptionObject(__FILE__, __LINE__,"No displacement field set",ITK_LOCATION);
+
+    if (!this->CheckDisplacementField())
+        throw itk::ExceptionObject(__FILE__, __LINE__,"Displacement field is not on the image grid or does not act along a single axis",ITK_LOCATION);
+
+    vnl_matrix <double> physicalToVoxel;
+    if (!ComputePhysicalToVoxelMatrix(forwardImage,physicalToVoxel))
+        throw itk::ExceptionObject(__FILE__, __LINE__,"Image grid is degenerate, voxel to physical matrix is not invertible",ITK_LOCATION);
+
+    unsigned int numVoxels = m_DisplacementField->GetLargestPossibleRegion().GetNumberOfPixels();
+    const typename VectorFieldType::PixelType *fieldBuffer = m_DisplacementField->GetBufferPointer();
+
+    m_LineDisplacements.resize(numVoxels);
+    m_AppliedLineDisplacements.resize(numVoxels);
+
+    for (unsigned int k = 0;k < numVoxels;++k)
+    {
+        double voxelDisplacement = 0;
+        for (unsigned int j = 0;j < SpaceDimension;++j)
+            voxelDisplacement += physicalToVoxel(m_DisplacementAxis,j) * fieldBuffer[k][j];
+
+        m_LineDisplacements[k] = m_ReverseField ? - voxelDisplacement : voxelDisplacement;
+    }
+}
+
+template <typename TImageType>
+void
+LineDisplacementResampleImageFilter <TImageType>
+::GenerateData()
+{
+    this->AllocateOutputs();
+
+    const ImageType *forwardImage = this->GetInput(0);
+    const ImageType *backwardImage = this->GetInput(1);
+
+    if (backwardImage)
+    {
+        for (unsigned int i = 0;i < SpaceDimension;++i)
+        {
+            if (backwardImage->GetLargestPossibleRegion().GetSize()[i] != forwardImage->GetLargestPossibleRegion().GetSize()[i])
+                throw itk::ExceptionObject(__FILE__, __LINE__,"Forward and backward volumes have different sizes",ITK_LOCATION);
+        }
+    }
+
+    this->ComputeLineDisplacements();
+
+    typename itk::ImageSource <TImageType>::ThreadStruct str;
+    str.Filter = this;
+
+    this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
+    this->GetMultiThreader()->SetSingleMethod(this->ThreadedResampleCallback,&str);
+    this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template <typename TImageType>
+ITK_THREAD_RETURN_TYPE
+LineDisplacementResampleImageFilter <TImageType>
+::ThreadedResampleCallback(void *arg)
+{
+    itk::MultiThreader::ThreadInfoStruct *threadInfo = (itk::MultiThreader::ThreadInfoStruct *)(arg);
+    typedef typename itk::ImageSource <TImageType>::ThreadStruct ThreadStruct;
+    ThreadStruct *str = (ThreadStruct *)(threadInfo->UserData);
+
+    Self *filterPtr = dynamic_cast <Self *> (str->Filter.GetPointer());
+    filterPtr->ResampleLines(threadInfo->ThreadID,threadInfo->NumberOfThreads);
+
+    return ITK_THREAD_RETURN_VALUE;
+}
+
+template <typename TImageType>
+void
+LineDisplacementResampleImageFilter <TImageType>
+::ResampleLines(unsigned int threadId, unsigned int numThreads)
+{
+    const ImageType *forwardImage = this->GetInput(0);
+    const ImageType *backwardImage = this->GetInput(1);
+    ImageType *outputImage = this->GetOutput();
+
+    typename ImageType::SizeType imageSize = forwardImage->GetLargestPossibleRegion().GetSize();
+    unsigned int numForwardVolumes = imageSize[SpaceDimension];
+    unsigned int numBackwardVolumes = 0;
+    if (backwardImage)
+        numBackwardVolumes = std::min(numForwardVolumes,(unsigned int)backwardImage->GetLargestPossibleRegion().GetSize()[SpaceDimension]);
+
+    unsigned int lineSize = imageSize[m_DisplacementAxis];
+    unsigned int lineStride = 1;
+    for (unsigned int i = 0;i < m_DisplacementAxis;++i)
+        lineStride *= imageSize[i];
+
+    unsigned int volumeSize = m_LineDisplacements.size();
+    unsigned int numLines = volumeSize / lineSize;
+
+    unsigned int startLine = (unsigned int)((unsigned long)threadId * numLines / numThreads);
+    unsigned int endLine = (unsigned int)((unsigned long)(threadId + 1) * numLines / numThreads);
+
+    const PixelType *forwardBuffer = forwardImage->GetBufferPointer();
+    const PixelType *backwardBuffer = backwardImage ? backwardImage->GetBufferPointer() : 0;
+    PixelType *outputBuffer = outputImage->GetBufferPointer();
+
+    // Per line scratch, allocated once per thread
+    std::vector <double> lineDisplacements(lineSize), appliedDisplacements(lineSize);
+    std::vector <int> forwardFirstOffsets(lineSize), forwardSecondOffsets(lineSize);
+    std::vector <int> backwardFirstOffsets(lineSize), backwardSecondOffsets(lineSize);
+    std::vector <double> forwardWeights(lineSize), forwardJacobians(lineSize);
+    std::vector <double> backwardWeights(lineSize), backwardJacobians(lineSize);
+
+    for (unsigned int l = startLine;l < endLine;++l)
+    {
+        unsigned int lineStart = (l / lineStride) * lineStride * lineSize + (l % lineStride);
+
+        for (unsigned int i = 0;i < lineSize;++i)
+            lineDisplacements[i] = m_LineDisplacements[lineStart + i * lineStride];
+
+        if (m_InvertField)
+            this->InvertLine(lineDisplacements.data(),appliedDisplacements.data(),lineSize);
+        else
+            appliedDisplacements = lineDisplacements;
+
+        for (unsigned int i = 0;i < lineSize;++i)
+            m_AppliedLineDisplacements[lineStart + i * lineStride] = appliedDisplacements[i];
+
+        this->ComputeLineWeights(appliedDisplacements.data(),1.0,lineSize,lineStride,forwardFirstOffsets.data(),
+                                 forwardSecondOffsets.data(),forwardWeights.data(),forwardJacobians.data());
+
+        if (numBackwardVolumes > 0)
+            this->ComputeLineWeights(appliedDisplacements.data(),-1.0,lineSize,lineStride,backwardFirstOffsets.data(),
+                                     backwardSecondOffsets.data(),backwardWeights.data(),backwardJacobians.data());
+
+        // Weights are shared by all volumes of the series
+        for (unsigned int t = 0;t < numForwardVolumes;++t)
+        {
+            unsigned int volumeOffset = t * volumeSize + lineStart;
+            const PixelType *forwardLine = forwardBuffer + volumeOffset;
+            PixelType *outputLine = outputBuffer + volumeOffset;
+
+            for (unsigned int i = 0;i < lineSize;++i)
+            {
+                double value = 0;
+                if (forwardFirstOffsets[i] >= 0)
+                    value = forwardJacobians[i] * ((1.0 - forwardWeights[i]) * forwardLine[forwardFirstOffsets[i]] +
+                                                   forwardWeights[i] * forwardLine[forwardSecondOffsets[i]]);
+
+                outputLine[i * lineStride] = value;
+            }
+
+            if (t >= numBackwardVolumes)
+                continue;
+
+            // Two input series: average forward and backward corrections
+            const PixelType *backwardLine = backwardBuffer + volumeOffset;
+            for (unsigned int i = 0;i < lineSize;++i)
+            {
+                double value = 0;
+                if (backwardFirstOffsets[i] >= 0)
+                    value = backwardJacobians[i] * ((1.0 - backwardWeights[i]) * backwardLine[backwardFirstOffsets[i]] +
+                                                    backwardWeights[i] * backwardLine[backwardSecondOffsets[i]]);
+
+                outputLine[i * lineStride] = 0.5 * (outputLine[i * lineStride] + value);
+            }
+        }
+    }
+}
+
+template <typename TImageType>
+void
+LineDisplacementResampleImageFilter <TImageType>
+::InvertLine(const double *displacements, double *inverseDisplacements, unsigned int lineSize)
+{
+    if (lineSize < 2)
+    {
+        for (unsigned int i = 0;i < lineSize;++i)
+            inverseDisplacements[i] = - displacements[i];
+
+        return;
+    }
+
+    // The mapping f(i) = i + u(i) is piecewise linear and monotone for a valid distortion,
+    // its inverse is found by walking segments once. Outside of the line, end segments are extrapolated
+    unsigned int segment = 0;
+    for (unsigned int j = 0;j < lineSize;++j)
+    {
+        while ((segment < lineSize - 2) && (segment + 1 + displacements[segment + 1] < j))
+            ++segment;
+
+        double startValue = segment + displacements[segment];
+        double endValue = segment + 1 + displacements[segment + 1];
+
+        double position = segment;
+        if (endValue > startValue)
+            position += (j - startValue) / (endValue - startValue);
+
+        inverseDisplacements[j] = position - j;
+    }
+}
+
+template <typename TImageType>
+void
+LineDisplacementResampleImageFilter <TImageType>
+::ComputeLineWeights(const double *displacements, double scale, unsigned int lineSize, unsigned int lineStride,
+                     int *firstOffsets, int *secondOffsets, double *weights, double *jacobians)
+{
+    for (unsigned int i = 0;i < lineSize;++i)
+    {
+        double position = i + scale * displacements[i];
+
+        // Jacobian of the 1D mapping, central differences clamped at line ends as in the generic resampler
+        unsigned int before = (i > 0) ? i - 1 : 0;
+        unsigned int after = (i < lineSize - 1) ? i + 1 : lineSize - 1;
+        double jacobian = 1.0;
+        if (m_ScaleIntensitiesWithJacobian && (after != before))
+        {
+            jacobian = 1.0 + scale * (displacements[after] - displacements[before]) / (after - before);
+            if (jacobian < 0)
+                jacobian = 0;
+        }
+
+        jacobians[i] = jacobian;
+
+        if ((position < 0) || (position > lineSize - 1))
+        {
+            firstOffsets[i] = -1;
+            secondOffsets[i] = -1;
+            weights[i] = 0;
+            continue;
+        }
+
+        unsigned int firstIndex = std::floor(position);
+        unsigned int secondIndex = std::min(firstIndex + 1,lineSize - 1);
+
+        firstOffsets[i] = firstIndex * lineStride;
+        secondOffsets[i] = secondIndex * lineStride;
+        weights[i] = position - firstIndex;
+    }
+}
+
+template <typename TImageType>
+typename LineDisplacementResampleImageFilter <TImageType>::VectorFieldPointer
+LineDisplacementResampleImageFilter <TImageType>
+::GetAppliedDisplacementField()
+{
+    const ImageType *forwardImage = this->GetInput(0);
+
+    VectorFieldPointer appliedField = VectorFieldType::New();
+    appliedField->Initialize();
+    appliedField->SetRegions(m_DisplacementField->GetLargestPossibleRegion());
+    appliedField->CopyInformation(m_DisplacementField);
+    appliedField->Allocate();
+
+    typename VectorFieldType::PixelType axisVector;
+    for (unsigned int i = 0;i < SpaceDimension;++i)
+        axisVector[i] = forwardImage->GetDirection()(i,m_DisplacementAxis) * forwardImage->GetSpacing()[m_DisplacementAxis];
+
+    typename VectorFieldType::PixelType *fieldBuffer = appliedField->GetBufferPointer();
+    for (unsigned int k = 0;k < m_AppliedLineDisplacements.size();++k)
+        fieldBuffer[k] = axisVector * m_AppliedLineDisplacements[k];
+
+    return appliedField;
+}
+
+} // end namespace anima
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <animaOrientedModelBaseResampleImageFilter.h>
+#include <animaMCMLinearInterpolateImageFunction.h>
+#include <animaMCMImage.h>
+
+namespace anima
+{
+
+/**
+ * @brief Resampling of multi-compartment model images. Each compartment is re-oriented through its own parameters
+ * (finite strain or PPD), using the re-orientation matrix computed once per voxel for all compartments.
+ * Default interpolation is MCM aware (see anima::MCMLinearInterpolateImageFunction).
+ */
+template <typename TImageType, typename TInterpolatorPrecisionType=float>
+class MCMResampleImageFilter :
+        public OrientedModelBaseResampleImageFilter <TImageType,TInterpolatorPrecisionType>
+{
+public:
+    /** Standard class typedefs. */
+    typedef MCMResampleImageFilter Self;
+
+    typedef OrientedModelBaseResampleImageFilter <TImageType,TInterpolatorPrecisionType> Superclass;
+    typedef itk::SmartPointer<Self> Pointer;
+    typedef itk::SmartPointer<const Self>  ConstPointer;
+
+    typedef typename Superclass::InputPixelType InputPixelType;
+    typedef typename Superclass::InputImageType InputImageType;
+    typedef typename Superclass::ContinuousIndexType ContinuousIndexType;
+    itkStaticConstMacro(ImageDimension, unsigned int,InputImageType::ImageDimension);
+
+    typedef anima::MCMImage <typename InputImageType::InternalPixelType, ImageDimension> MCMImageType;
+    typedef typename MCMImageType::MCMPointer MCMPointer;
+
+    typedef anima::MCMLinearInterpolateImageFunction <InputImageType, TInterpolatorPrecisionType> MCMInterpolatorType;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self)
+
+    /** Run-time type information (and related methods) */
+    itkTypeMacro(MCMResampleImageFilter, OrientedModelBaseResampleImageFilter)
+
+protected:
+    MCMResampleImageFilter()
+    {
+        m_MCMInterpolator = 0;
+    }
+
+    virtual ~MCMResampleImageFilter() {}
+
+    virtual void GenerateOutputInformation() ITK_OVERRIDE;
+    virtual void BeforeThreadedGenerateData() ITK_OVERRIDE;
+    virtual void InitializeInterpolator() ITK_OVERRIDE;
+
+    //! Uses the MCM interpolator workspaces when the interpolator is MCM aware
+    virtual bool InterpolateModel(const ContinuousIndexType &index, InputPixelType &value, itk::ThreadIdType threadId) ITK_OVERRIDE;
+
+    virtual void ReorientInterpolatedModel(const InputPixelType &interpolatedModel, vnl_matrix <double> &modelOrientationMatrix,
+                                           InputPixelType &rotatedModel, itk::ThreadIdType threadId) ITK_OVERRIDE;
+
+    //! Description model of the input image
+    MCMPointer &GetInputDescriptionModel();
+
+private:
+    MCMResampleImageFilter(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+
+    //! Set to the interpolator if it is MCM aware, null otherwise
+    MCMInterpolatorType *m_MCMInterpolator;
+
+    // Work variables
+    std::vector <MCMPointer> m_WorkModels;
+    std::vector <typename MCMInterpolatorType::WorkspaceType> m_InterpolationWorkspaces;
+};
+
+} // end namespace anima
+
+#include "animaMCMResampleImageFilter.hxx"
@@ -0,0 +1,95 @@
+#pragma once
+#include <animaMCMResampleImageFilter.h>
+
+namespace anima
+{
+
+template <typename TImageType, typename TInterpolatorPrecisionType>
+typename MCMResampleImageFilter<TImageType, TInterpolatorPrecisionType>::MCMPointer &
+MCMResampleImageFilter<TImageType, TInterpolatorPrecisionType>
+::GetInputDescriptionModel()
+{
+    const MCMImageType *input = dynamic_cast <const MCMImageType *> (this->GetInput(0));
+    if (!input)
+        itkExceptionMacro("MCM resampling requires an MCM image as input");
+
+    MCMPointer &descriptionModel = const_cast <MCMImageType *> (input)->GetDescriptionModel();
+    if (!descriptionModel)
+        itkExceptionMacro("Input MCM image has no description model");
+
+    return descriptionModel;
+}
+
+template <typename TImageType, typename TInterpolatorPrecisionType>
+void
+MCMResampleImageFilter<TImageType, TInterpolatorPrecisionType>
+::InitializeInterpolator()
+{
+    typename MCMInterpolatorType::Pointer tmpInterpolator = MCMInterpolatorType::New();
+    this->SetInterpolator(tmpInterpolator.GetPointer());
+}
+
+template <typename TImageType, typename TInterpolatorPrecisionType>
+void
+MCMResampleImageFilter<TImageType, TInterpolatorPrecisionType>
+::GenerateOutputInformation()
+{
+    this->Superclass::GenerateOutputInformation();
+
+    MCMImageType *output = dynamic_cast <MCMImageType *> (this->GetOutput());
+    if (output)
+        output->SetDescriptionModel(this->GetInputDescriptionModel());
+}
+
+template <typename TImageType, typename TInterpolatorPrecisionType>
+void
+MCMResampleImageFilter<TImageType, TInterpolatorPrecisionType>
+::BeforeThreadedGenerateData()
+{
+    this->Superclass::BeforeThreadedGenerateData();
+
+    m_MCMInterpolator = dynamic_cast <MCMInterpolatorType *> (this->GetInterpolator());
+
+    MCMPointer &descriptionModel = this->GetInputDescriptionModel();
+    m_WorkModels.resize(this->GetNumberOfThreads());
+    m_InterpolationWorkspaces.resize(this->GetNumberOfThreads());
+
+    for (unsigned int i = 0;i < this->GetNumberOfThreads();++i)
+        m_WorkModels[i] = descriptionModel->Clone();
+}
+
+template <typename TImageType, typename TInterpolatorPrecisionType>
+bool
+MCMResampleImageFilter<TImageType, TInterpolatorPrecisionType>
+::InterpolateModel(const ContinuousIndexType &index, InputPixelType &value, itk::ThreadIdType threadId)
+{
+    if (!m_MCMInterpolator)
+        return this->Superclass::InterpolateModel(index,value,threadId);
+
+    if (!this->GetInterpolator()->IsInsideBuffer(index))
+    {
+        value.Fill(0.0);
+        return false;
+    }
+
+    return m_MCMInterpolator->EvaluateAtContinuousIndex(index,value,m_InterpolationWorkspaces[threadId]);
+}
+
+template <typename TImageType, typename TInterpolatorPrecisionType>
+void
+MCMResampleImageFilter<TImageType, TInterpolatorPrecisionType>
+::ReorientInterpolatedModel(const InputPixelType &interpolatedModel, vnl_matrix <double> &modelOrientationMatrix,
+                            InputPixelType &rotatedModel, itk::ThreadIdType threadId)
+{
+    MCMPointer &workModel = m_WorkModels[threadId];
+
+    // Compartments re-orient their own parameters: rotation matrix if finite strain, Jacobian for PPD
+    workModel->SetModelVector(interpolatedModel);
+    workModel->Reorient(modelOrientationMatrix,!this->GetFiniteStrainReorientation());
+
+    typename MCMImageType::MCMType::ModelOutputVectorType &modelVector = workModel->GetModelVector();
+    for (unsigned int i = 0;i < modelVector.GetSize();++i)
+        rotatedModel[i] = modelVector[i];
+}
+
+} // end of namespace anima
@@ -4,6 +4,7 @@
 #include <animaMaskedImageToImageFilter.h>
 #include <itkVectorImage.h>
 #include <itkInterpolateImageFunction.h>
+#include <animaVectorModelLinearInterpolateImageFunction.h>
 
 #include <itkMatrixOffsetTransformBase.h>
 
@@ -30,6 +31,7 @@ public:
 
     typedef itk::InterpolateImageFunction<InputImageType, TInterpolatorPrecisionType> InterpolatorType;
     typedef typename InterpolatorType::Pointer  InterpolatorPointer;
+    typedef anima::VectorModelLinearInterpolateImageFunction <InputImageType, TInterpolatorPrecisionType> VectorModelInterpolatorType;
 
     typedef typename InterpolatorType::ContinuousIndexType ContinuousIndexType;
     typedef typename InterpolatorType::PointType PointType;
@@ -83,6 +85,7 @@ protected:
     {
         m_Transform = 0;
         m_Interpolator = 0;
+        m_VectorModelInterpolator = 0;
 
         m_FiniteStrainReorientation = true;
     }
@@ -130,6 +133,10 @@ protected:
         zeroPixel = itk::NumericTraits <T>::ZeroValue();
     }
 
+    /** Interpolates the input model at index into value (sized to the output vector length), zero if outside.
+     * Uses the allocation free path of vector model interpolators when available. Returns false for zero models. */
+    virtual bool InterpolateModel(const ContinuousIndexType &index, InputPixelType &value, itk::ThreadIdType threadId);
+
     void LinearThreadedGenerateData(const OutputImageRegionType &outputRegionForThread, itk::ThreadIdType threadId);
     void NonLinearThreadedGenerateData(const OutputImageRegionType &outputRegionForThread, itk::ThreadIdType threadId);
 
@@ -166,6 +173,8 @@ private:
     TransformPointer m_Transform;
     bool m_FiniteStrainReorientation;
     InterpolatorPointer m_Interpolator;
+    //! Set to m_Interpolator if it is a vector model linear interpolator, null otherwise
+    VectorModelInterpolatorType *m_VectorModelInterpolator;
 
     SpacingType m_OutputSpacing;
     OriginPointType m_OutputOrigin;
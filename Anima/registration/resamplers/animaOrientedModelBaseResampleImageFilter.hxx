@@ -3,7 +3,6 @@
 
 #include <itkImageRegionConstIteratorWithIndex.h>
 #include <itkImageRegionIteratorWithIndex.h>
-#include <animaVectorModelLinearInterpolateImageFunction.h>
 
 #include <animaBaseTensorTools.h>
 #include <animaLinearTransformEstimationTools.h>
@@ -16,9 +15,7 @@ void
 OrientedModelBaseResampleImageFilter<TImageType, TInterpolatorPrecisionType>
 ::InitializeInterpolator()
 {
-    typedef anima::VectorModelLinearInterpolateImageFunction <InputImageType,TInterpolatorPrecisionType> InterpolatorType;
-
-    typename InterpolatorType::Pointer tmpInterpolator = InterpolatorType::New();
+    typename VectorModelInterpolatorType::Pointer tmpInterpolator = VectorModelInterpolatorType::New();
     this->SetInterpolator(tmpInterpolator.GetPointer());
 }
 
@@ -75,6 +72,7 @@ OrientedModelBaseResampleImageFilter<TImageType, TInterpolatorPrecisionType>
         this->InitializeInterpolator();
 
     m_Interpolator->SetInputImage(this->GetInput(0));
+    m_VectorModelInterpolator = dynamic_cast <VectorModelInterpolatorType *> (m_Interpolator.GetPointer());
 
     if (!m_Transform->IsLinear())
     {
@@ -94,6 +92,24 @@ OrientedModelBaseResampleImageFilter<TImageType, TInterpolatorPrecisionType>
         this->NonLinearThreadedGenerateData(outputRegionForThread,threadId);
 }
 
+template <typename TImageType, typename TInterpolatorPrecisionType>
+bool
+OrientedModelBaseResampleImageFilter<TImageType, TInterpolatorPrecisionType>
+::InterpolateModel(const ContinuousIndexType &index, InputPixelType &value, itk::ThreadIdType threadId)
+{
+    if (!m_Interpolator->IsInsideBuffer(index))
+    {
+        this->InitializeZeroPixel(value);
+        return false;
+    }
+
+    if (m_VectorModelInterpolator)
+        return m_VectorModelInterpolator->EvaluateAtContinuousIndex(index,value);
+
+    value = m_Interpolator->EvaluateAtContinuousIndex(index);
+    return !isZero(value);
+}
+
 template <typename TImageType, typename TInterpolatorPrecisionType>
 void
 OrientedModelBaseResampleImageFilter<TImageType, TInterpolatorPrecisionType>
@@ -128,12 +144,7 @@ OrientedModelBaseResampleImageFilter<TImageType, TInterpolatorPrecisionType>
         if (lastDimensionUseless)
             index[ImageDimension - 1] = 0;
 
-        if (m_Interpolator->IsInsideBuffer(index))
-            tmpRes = m_Interpolator->EvaluateAtContinuousIndex(index);
-        else
-            this->InitializeZeroPixel(tmpRes);
-
-        if (!isZero(tmpRes))
+        if (this->InterpolateModel(index,tmpRes,threadId))
         {
             this->ReorientInterpolatedModel(tmpRes,parametersRotationMatrix,resRotated,threadId);
             outputItr.Set(resRotated);
@@ -173,12 +184,7 @@ OrientedModelBaseResampleImageFilter<TImageType, TInterpolatorPrecisionType>
 
         this->GetInput(0)->TransformPhysicalPointToContinuousIndex(tmpPoint,index);
 
-        if (m_Interpolator->IsInsideBuffer(index))
-            tmpRes = m_Interpolator->EvaluateAtContinuousIndex(index);
-        else
-            this->InitializeZeroPixel(tmpRes);
-
-        if (!isZero(tmpRes))
+        if (this->InterpolateModel(index,tmpRes,threadId))
         {
             this->ComputeLocalJacobianMatrix(tmpInd,orientationMatrix);
             this->ComputeRotationParametersFromReorientationMatrix(orientationMatrix,parametersRotationMatrix);
@@ -7,6 +7,7 @@
 
 #include <rpiDisplacementFieldTransform.h>
 #include <animaResampleImageFilter.h>
+#include <animaLineDisplacementResampleImageFilter.h>
 #include <animaReadWriteFunctions.h>
 
 void ApplyGeometryToVectorField(itk::Image <itk::Vector <double,3>, 3> *vectorField,
@@ -89,6 +90,40 @@ int main(int ac, const char** av)
     if (fieldInVoxelCoordinates.isSet())
         ApplyGeometryToVectorField(appliedField,forwardImage);
     
+    typedef anima::LineDisplacementResampleImageFilter <Image4DType> LineResampleFilterType;
+    LineResampleFilterType::Pointer lineResampler = LineResampleFilterType::New();
+    lineResampler->SetForwardImage(forwardImage);
+    lineResampler->SetDisplacementField(appliedField);
+
+    if (lineResampler->CheckDisplacementField())
+    {
+        // Field along a single axis (phase encoding): all volumes are corrected together, line by line
+        lineResampler->SetReverseField(reverseFieldArg.isSet());
+        lineResampler->SetInvertField(inverseFieldArg.isSet());
+        lineResampler->SetScaleIntensitiesWithJacobian(true);
+        lineResampler->SetNumberOfThreads(nbpArg.getValue());
+
+        if (backwardArg.getValue() != "")
+            lineResampler->SetBackwardImage(anima::readImage<Image4DType> (backwardArg.getValue()));
+
+        try
+        {
+            lineResampler->Update();
+        }
+        catch (itk::ExceptionObject &e)
+        {
+            std::cerr << e << std::endl;
+            return 1;
+        }
+
+        anima::writeImage<Image4DType> (outArg.getValue(),lineResampler->GetOutput());
+
+        if (outVecArg.getValue() != "")
+            anima::writeImage<VectorFieldType>(outVecArg.getValue(),lineResampler->GetAppliedDisplacementField());
+
+        return 0;
+    }
+
     if (reverseFieldArg.isSet())
     {
         // Take the opposite of the input field
@@ -0,0 +1,161 @@
+#include <tclap/CmdLine.h>
+
+#include <animaTransformSeriesReader.h>
+#include <itkNearestNeighborInterpolateImageFunction.h>
+#include <animaMCMLinearInterpolateImageFunction.h>
+
+#include <animaMCMFileReader.h>
+#include <animaMCMFileWriter.h>
+#include <animaMCMResampleImageFilter.h>
+
+int main(int ac, const char** av)
+{
+    std::string descriptionMessage;
+    descriptionMessage += "Resampler tool to apply a series of transformations to a multi-compartment model image. ";
+    descriptionMessage += "Input transform is an XML file describing all transforms to apply. ";
+    descriptionMessage += "Such a file should look like this:\n";
+    descriptionMessage += "<TransformationList>\n";
+    descriptionMessage += "<Transformation>\n";
+    descriptionMessage += "<Type>linear</Type> (it can be svf or dense too)\n";
+    descriptionMessage += "<Path>FileName</Path>\n";
+    descriptionMessage += "<Inversion>0</Inversion>\n";
+    descriptionMessage += "</Transformation>\n";
+    descriptionMessage += "...\n";
+    descriptionMessage += "</TransformationList>\n\n";
+    descriptionMessage += "INRIA / IRISA - VisAGeS Team";
+
+    TCLAP::CmdLine cmd(descriptionMessage, ' ',ANIMA_VERSION);
+
+    TCLAP::ValueArg<std::string> inArg("i","input","Input MCM image (.mcm)",true,"","input image",cmd);
+    TCLAP::ValueArg<std::string> trArg("t","trsf","Transformations XML list",true,"","transformations list",cmd);
+    TCLAP::ValueArg<std::string> outArg("o","output","Output resampled MCM image (.mcm)",true,"","output image",cmd);
+    TCLAP::ValueArg<std::string> geomArg("g","geometry","Geometry image",true,"","geometry image",cmd);
+
+    TCLAP::SwitchArg ppdArg("P","ppd","Use PPD re-orientation scheme (default: no)",cmd,false);
+    TCLAP::SwitchArg invertArg("I","invert","Invert the transformation series",cmd,false);
+    TCLAP::SwitchArg nearestArg("N","nearest","Use nearest neighbor interpolation",cmd,false);
+
+    TCLAP::ValueArg<unsigned int> reductionItArg("r","reduction-iter","Number of fascicle reduction iterations in interpolation (default: 3)",false,3,"reduction iterations",cmd);
+    TCLAP::ValueArg<unsigned int> nbpArg("p","numberofthreads","Number of threads to run on (default: all cores)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
+
+    try
+    {
+        cmd.parse(ac,av);
+    }
+    catch (TCLAP::ArgException& e)
+    {
+        std::cerr << "Error: " << e.error() << "for argument " << e.argId() << std::endl;
+        return(1);
+    }
+
+    const    unsigned int    Dimension = 3;
+    typedef  float           PixelType;
+
+    typedef anima::MCMImage <PixelType, Dimension> ImageType;
+    typedef anima::TransformSeriesReader <double, Dimension> TransformSeriesReaderType;
+    typedef TransformSeriesReaderType::OutputTransformType TransformType;
+
+    typedef anima::MCMFileReader <PixelType, Dimension> ReaderType;
+    typedef anima::MCMFileWriter <PixelType, Dimension> WriterType;
+
+    ReaderType reader;
+    reader.SetFileName(inArg.getValue());
+
+    try
+    {
+        reader.Update();
+    }
+    catch (itk::ExceptionObject &e)
+    {
+        std::cerr << e << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    itk::ImageIOBase::Pointer imageIO = itk::ImageIOFactory::CreateImageIO(geomArg.getValue().c_str(),
+                                                                           itk::ImageIOFactory::ReadMode);
+
+    if( !imageIO )
+    {
+        std::cerr << "Itk could not find suitable IO factory for the input" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Now that we found the appropriate ImageIO class, ask it to read the meta data from the image file.
+    imageIO->SetFileName(geomArg.getValue());
+    imageIO->ReadImageInformation();
+
+    TransformSeriesReaderType *trReader = new TransformSeriesReaderType;
+    trReader->SetInput(trArg.getValue());
+    trReader->SetInvertTransform(invertArg.isSet());
+
+    try
+    {
+        trReader->Update();
+    }
+    catch (itk::ExceptionObject &e)
+    {
+        std::cerr << e << std::endl;
+        return -1;
+    }
+
+    TransformType::Pointer trsf = trReader->GetOutputTransform();
+
+    itk::InterpolateImageFunction <ImageType>::Pointer interpolator;
+
+    if (nearestArg.isSet())
+        interpolator = itk::NearestNeighborInterpolateImageFunction<ImageType>::New();
+    else
+    {
+        typedef anima::MCMLinearInterpolateImageFunction <ImageType> MCMInterpolatorType;
+        MCMInterpolatorType::Pointer mcmInterpolator = MCMInterpolatorType::New();
+        mcmInterpolator->SetNumberOfReductionIterations(reductionItArg.getValue());
+        interpolator = mcmInterpolator;
+    }
+
+    typedef anima::MCMResampleImageFilter <ImageType, double> ResampleFilterType;
+
+    ResampleFilterType::Pointer resample = ResampleFilterType::New();
+
+    resample->SetTransform(trsf);
+    resample->SetFiniteStrainReorientation(!ppdArg.isSet());
+    resample->SetInterpolator(interpolator.GetPointer());
+    resample->SetNumberOfThreads(nbpArg.getValue());
+
+    ImageType::DirectionType directionMatrix;
+    ImageType::PointType origin;
+    ImageType::SpacingType spacing;
+    ImageType::RegionType largestRegion;
+
+    for (unsigned int i = 0;i < Dimension;++i)
+    {
+        origin[i] = imageIO->GetOrigin(i);
+        spacing[i] = imageIO->GetSpacing(i);
+        largestRegion.SetIndex(i,0);
+        largestRegion.SetSize(i,imageIO->GetDimensions(i));
+
+        for (unsigned int j = 0;j < Dimension;++j)
+            directionMatrix(i,j) = imageIO->GetDirection(j)[i];
+    }
+
+    resample->SetOutputLargestPossibleRegion(largestRegion);
+    resample->SetOutputOrigin(origin);
+    resample->SetOutputSpacing(spacing);
+    resample->SetOutputDirection(directionMatrix);
+
+    resample->SetInput(reader.GetModelVectorImage());
+
+    std::cout << "Applying transform... " << std::flush;
+    resample->Update();
+    std::cout << "Done..." << std::endl;
+
+    ImageType::Pointer outputImage = resample->GetOutput();
+    outputImage->DisconnectPipeline();
+
+    WriterType writer;
+    writer.SetInputImage(outputImage);
+    writer.SetFileName(outArg.getValue());
+
+    writer.Update();
+
+    return 0;
+}
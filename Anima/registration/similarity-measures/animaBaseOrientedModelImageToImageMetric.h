@@ -7,6 +7,12 @@
 #include <itkExceptionObject.h>
 #include <itkSpatialObject.h>
 
+#include <animaVectorModelLinearInterpolateImageFunction.h>
+
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_vector.h>
+#include <vector>
+
 namespace anima
 {
 template <class TFixedImage,  class TMovingImage>
@@ -57,6 +63,10 @@ public:
     CoordinateRepresentationType > InterpolatorType;
 
     typedef typename InterpolatorType::Pointer         InterpolatorPointer;
+    typedef typename InterpolatorType::ContinuousIndexType ContinuousIndexType;
+
+    typedef anima::VectorModelLinearInterpolateImageFunction <MovingImageType,
+    CoordinateRepresentationType> VectorModelInterpolatorType;
 
     /**  Type for the mask of the fixed image. Only pixels that are "inside"
      this mask will be considered for the computation of the metric */
@@ -103,7 +113,15 @@ public:
     itkGetConstObjectMacro( Transform, TransformType )
 
     /** Connect the Interpolator. */
-    itkSetObjectMacro( Interpolator, InterpolatorType )
+    virtual void SetInterpolator(InterpolatorType *interpolator)
+    {
+        if (m_Interpolator == interpolator)
+            return;
+
+        m_Interpolator = interpolator;
+        m_VectorModelInterpolator = dynamic_cast <VectorModelInterpolatorType *> (interpolator);
+        this->Modified();
+    }
 
     /** Get a pointer to the Interpolator.  */
     itkGetConstObjectMacro( Interpolator, InterpolatorType )
@@ -166,6 +184,21 @@ protected:
     virtual ~BaseOrientedModelImageToImageMetric();
     void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
 
+    /**
+     * Interpolates moving values (scaled log-tensor vectors) at the transformed fixed points into the rows of m_MovingValues,
+     * rows are zero outside of the moving image. PPD reorientation is applied on each row, finite strain reorientation
+     * is left to ComputeMovingMoments. Returns the number of points inside the moving image
+     */
+    unsigned int GatherMovingValues(const std::vector <InputPointType> &fixedPoints) const;
+
+    /**
+     * Computes from m_MovingValues the sum of moving values, their Gram matrix and cross products with fixed values
+     * (crossProducts(j,k) = sum_i fixed_ij moving_ik), in one pass over the block buffer.
+     * Finite strain reorientation is then applied once on these moments through m_TensorRotationOperator
+     */
+    void ComputeMovingMoments(const vnl_matrix <double> &fixedValues, vnl_vector <double> &movingSum,
+                              vnl_matrix <double> &movingGram, vnl_matrix <double> &crossProducts) const;
+
     mutable unsigned long       m_NumberOfPixelsCounted;
 
     FixedImageConstPointer      m_FixedImage;
@@ -173,8 +206,16 @@ protected:
 
     mutable TransformPointer    m_Transform;
     mutable vnl_matrix <double> m_OrientationMatrix;
+
     InterpolatorPointer         m_Interpolator;
 
+    //! Finite strain reorientation as a linear operator on scaled log-tensor vectors, updated with transform parameters
+    mutable vnl_matrix <double> m_TensorRotationOperator;
+
+    //! Block buffer of interpolated moving values (one row per fixed point) and their inside moving image flags
+    mutable vnl_matrix <double> m_MovingValues;
+    mutable std::vector <bool> m_InsidePoints;
+
     FixedImageMaskConstPointer  m_FixedImageMask;
     MovingImageMaskConstPointer m_MovingImageMask;
 
@@ -184,6 +225,9 @@ private:
 
     FixedImageRegionType        m_FixedImageRegion;
 
+    //! Set to m_Interpolator if it is a vector model linear interpolator, null otherwise
+    VectorModelInterpolatorType *m_VectorModelInterpolator;
+
     ModelReorientationType m_ModelRotation;
 };
 
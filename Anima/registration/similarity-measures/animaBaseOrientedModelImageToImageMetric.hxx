@@ -2,6 +2,8 @@
 #include "animaBaseOrientedModelImageToImageMetric.h"
 
 #include <animaBaseTensorTools.h>
+#include <vnl/vnl_vector_fixed.h>
+#include <algorithm>
 
 namespace anima
 {
@@ -17,6 +19,7 @@ BaseOrientedModelImageToImageMetric<TFixedImage,TMovingImage>
     m_MovingImage   = 0; // has to be provided by the user.
     m_Transform     = 0; // has to be provided by the user.
     m_Interpolator  = 0; // has to be provided by the user.
+    m_VectorModelInterpolator = 0;
     m_NumberOfPixelsCounted = 0; // initialize to zero
 
     m_ModelRotation = FINITE_STRAIN;
@@ -58,6 +61,7 @@ BaseOrientedModelImageToImageMetric<TFixedImage,TMovingImage>
         {
             vnl_matrix <double> tmpMat(FixedImageDimension, FixedImageDimension);
             anima::ExtractRotationFromJacobianMatrix(jacMatrix,m_OrientationMatrix,tmpMat);
+            anima::GetTensorRotationOperator(m_OrientationMatrix,m_TensorRotationOperator,true);
         }
         else
             m_OrientationMatrix = jacMatrix;
@@ -65,6 +69,139 @@ BaseOrientedModelImageToImageMetric<TFixedImage,TMovingImage>
 }
 
 
+template <class TFixedImage, class TMovingImage>
+unsigned int
+BaseOrientedModelImageToImageMetric<TFixedImage,TMovingImage>
+::GatherMovingValues(const std::vector <InputPointType> &fixedPoints) const
+{
+    unsigned int numPoints = fixedPoints.size();
+    unsigned int vectorSize = m_MovingImage->GetNumberOfComponentsPerPixel();
+
+    if ((m_MovingValues.rows() != numPoints)||(m_MovingValues.cols() != vectorSize))
+        m_MovingValues.set_size(numPoints,vectorSize);
+
+    m_InsidePoints.resize(numPoints);
+
+    const unsigned int tensorDimension = 3;
+    typedef itk::Matrix <double,tensorDimension,tensorDimension> TensorType;
+    TensorType tensor, rotatedTensor, eigenVectors;
+    vnl_vector_fixed <double,tensorDimension> eigenValues;
+    vnl_matrix <double> ppdOrientationMatrix(tensorDimension,tensorDimension);
+    double sqrt2 = std::sqrt(2.0);
+
+    typename InterpolatorType::OutputType genericValue;
+    OutputPointType transformedPoint;
+    ContinuousIndexType transformedIndex;
+    unsigned int numInside = 0;
+
+    for (unsigned int i = 0;i < numPoints;++i)
+    {
+        double *movingValue = m_MovingValues[i];
+        transformedPoint = m_Transform->TransformPoint(fixedPoints[i]);
+        m_Interpolator->GetInputImage()->TransformPhysicalPointToContinuousIndex(transformedPoint,transformedIndex);
+
+        m_InsidePoints[i] = m_Interpolator->IsInsideBuffer(transformedIndex);
+        if (!m_InsidePoints[i])
+        {
+            std::fill(movingValue,movingValue + vectorSize,0.0);
+            continue;
+        }
+
+        ++numInside;
+
+        if (m_VectorModelInterpolator)
+            m_VectorModelInterpolator->EvaluateAtContinuousIndex(transformedIndex,movingValue);
+        else
+        {
+            genericValue = m_Interpolator->EvaluateAtContinuousIndex(transformedIndex);
+            for (unsigned int j = 0;j < vectorSize;++j)
+                movingValue[j] = genericValue[j];
+        }
+
+        if (m_ModelRotation != PPD)
+            continue;
+
+        unsigned int pos = 0;
+        for (unsigned int j = 0;j < tensorDimension;++j)
+            for (unsigned int k = 0;k <= j;++k)
+            {
+                tensor(j,k) = movingValue[pos];
+                if (j != k)
+                {
+                    tensor(j,k) /= sqrt2;
+                    tensor(k,j) = tensor(j,k);
+                }
+
+                ++pos;
+            }
+
+        anima::ComputeSymmetric3x3EigenAnalysis(tensor,eigenValues,eigenVectors);
+        anima::ExtractPPDRotationFromJacobianMatrix(m_OrientationMatrix,ppdOrientationMatrix,eigenVectors);
+        anima::RotateSymmetricMatrix(tensor,ppdOrientationMatrix,rotatedTensor,tensorDimension);
+
+        pos = 0;
+        for (unsigned int j = 0;j < tensorDimension;++j)
+            for (unsigned int k = 0;k <= j;++k)
+            {
+                movingValue[pos] = rotatedTensor(j,k);
+                if (j != k)
+                    movingValue[pos] *= sqrt2;
+
+                ++pos;
+            }
+    }
+
+    return numInside;
+}
+
+template <class TFixedImage, class TMovingImage>
+void
+BaseOrientedModelImageToImageMetric<TFixedImage,TMovingImage>
+::ComputeMovingMoments(const vnl_matrix <double> &fixedValues, vnl_vector <double> &movingSum,
+                       vnl_matrix <double> &movingGram, vnl_matrix <double> &crossProducts) const
+{
+    unsigned int numPoints = m_MovingValues.rows();
+    unsigned int vectorSize = m_MovingValues.cols();
+
+    movingSum.set_size(vectorSize);
+    movingSum.fill(0.0);
+    movingGram.set_size(vectorSize,vectorSize);
+    movingGram.fill(0.0);
+    crossProducts.set_size(vectorSize,vectorSize);
+    crossProducts.fill(0.0);
+
+    for (unsigned int i = 0;i < numPoints;++i)
+    {
+        if (!m_InsidePoints[i])
+            continue;
+
+        const double *movingValue = m_MovingValues[i];
+        const double *fixedValue = fixedValues[i];
+
+        for (unsigned int j = 0;j < vectorSize;++j)
+        {
+            movingSum[j] += movingValue[j];
+
+            for (unsigned int k = j;k < vectorSize;++k)
+                movingGram(j,k) += movingValue[j] * movingValue[k];
+
+            for (unsigned int k = 0;k < vectorSize;++k)
+                crossProducts(j,k) += fixedValue[j] * movingValue[k];
+        }
+    }
+
+    for (unsigned int j = 0;j < vectorSize;++j)
+        for (unsigned int k = j + 1;k < vectorSize;++k)
+            movingGram(k,j) = movingGram(j,k);
+
+    if (m_ModelRotation != FINITE_STRAIN)
+        return;
+
+    movingSum = m_TensorRotationOperator * movingSum;
+    movingGram = m_TensorRotationOperator * movingGram * m_TensorRotationOperator.transpose();
+    crossProducts = crossProducts * m_TensorRotationOperator.transpose();
+}
+
 /**
  * Initialize
  */
@@ -118,7 +255,9 @@ BaseOrientedModelImageToImageMetric<TFixedImage,TMovingImage>
                           <<"FixedImageRegion does not overlap the fixed image buffered region" );
     }
 
-    m_Interpolator->SetInputImage( m_MovingImage );
+    // Interpolators may be shared between metrics (and threads), only set them up once
+    if (m_Interpolator->GetInputImage() != m_MovingImage.GetPointer())
+        m_Interpolator->SetInputImage( m_MovingImage );
 
     // If there are any observers on the metric, call them to give the
     // user code a chance to set parameters on the metric
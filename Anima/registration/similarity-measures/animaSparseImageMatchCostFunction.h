@@ -0,0 +1,103 @@
+#pragma once
+
+#include <itkSingleValuedCostFunction.h>
+#include <itkMatrixOffsetTransformBase.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkImage.h>
+
+#include <vector>
+
+namespace anima
+{
+
+/**
+ * @brief Image matching cost function evaluated on a sparse regular sample of the fixed image.
+ *
+ * Fixed points and values are computed once, moving values outside of the moving image are taken as zero.
+ * The criterion is either the mean squared difference or the correlation coefficient between fixed
+ * and transformed moving values. Evaluate() only reads data and may be called concurrently for
+ * different linear transforms, GetValue() goes through the transform set by SetTransform().
+ */
+template <typename TImageType, typename TScalarType = double>
+class SparseImageMatchCostFunction :
+        public itk::SingleValuedCostFunction
+{
+public:
+    /** Standard class typedefs. */
+    typedef SparseImageMatchCostFunction Self;
+    typedef itk::SingleValuedCostFunction Superclass;
+    typedef itk::SmartPointer <Self> Pointer;
+    typedef itk::SmartPointer <const Self> ConstPointer;
+
+    itkNewMacro(Self)
+
+    /** Run-time type information (and related methods). */
+    itkTypeMacro(SparseImageMatchCostFunction, itk::SingleValuedCostFunction)
+
+    itkStaticConstMacro(ImageDimension, unsigned int, TImageType::ImageDimension);
+
+    typedef Superclass::MeasureType MeasureType;
+    typedef Superclass::DerivativeType DerivativeType;
+    typedef Superclass::ParametersType ParametersType;
+
+    typedef TImageType ImageType;
+    typedef typename ImageType::RegionType RegionType;
+    typedef typename ImageType::PointType PointType;
+
+    typedef itk::MatrixOffsetTransformBase <TScalarType, ImageDimension, ImageDimension> TransformType;
+    typedef typename TransformType::MatrixType MatrixType;
+    typedef typename TransformType::OffsetType OffsetType;
+
+    typedef itk::LinearInterpolateImageFunction <ImageType, double> InterpolatorType;
+
+    virtual MeasureType GetValue(const ParametersType &parameters) const ITK_OVERRIDE;
+    virtual void GetDerivative(const ParametersType &parameters, DerivativeType &derivative) const ITK_OVERRIDE;
+
+    unsigned int GetNumberOfParameters() const ITK_OVERRIDE;
+
+    //! Sets fixed image and sampled region (default: the whole image)
+    void SetFixedImage(const ImageType *image);
+    void SetFixedImageRegion(const RegionType &region) {m_FixedImageRegion = region; m_UseFixedImageRegion = true;}
+    void SetMovingImage(const ImageType *image);
+
+    void SetTransform(TransformType *trsf) {m_Transform = trsf;}
+
+    itkSetMacro(MaximumNumberOfSamples, unsigned int)
+    itkSetMacro(UseCorrelation, bool)
+    itkGetConstMacro(UseCorrelation, bool)
+
+    //! Computes the regular sparse sample of the fixed image, to be called before any evaluation
+    void Initialize();
+
+    //! Cost value for moving point = matrix * fixed point + offset
+    double Evaluate(const MatrixType &matrix, const OffsetType &offset) const;
+
+    const std::vector <PointType> &GetSamplePoints() const {return m_SamplePoints;}
+    const std::vector <double> &GetSampleValues() const {return m_SampleValues;}
+
+protected:
+    SparseImageMatchCostFunction();
+    virtual ~SparseImageMatchCostFunction() {}
+
+private:
+    SparseImageMatchCostFunction(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+
+    typename ImageType::ConstPointer m_FixedImage;
+    typename InterpolatorType::Pointer m_Interpolator;
+    typename TransformType::Pointer m_Transform;
+
+    RegionType m_FixedImageRegion;
+    bool m_UseFixedImageRegion;
+
+    unsigned int m_MaximumNumberOfSamples;
+    bool m_UseCorrelation;
+
+    std::vector <PointType> m_SamplePoints;
+    std::vector <double> m_SampleValues;
+    double m_SumFixed, m_VarFixed;
+};
+
+} // end namespace anima
+
+#include "animaSparseImageMatchCostFunction.hxx"
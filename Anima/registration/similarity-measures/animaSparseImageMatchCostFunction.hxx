@@ -0,0 +1,196 @@
+#pragma once
+#include "animaSparseImageMatchCostFunction.h"
+
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkContinuousIndex.h>
+
+#include <cmath>
+
+namespace anima
+{
+
+template <typename TImageType, typename TScalarType>
+SparseImageMatchCostFunction <TImageType, TScalarType>
+::SparseImageMatchCostFunction()
+{
+    m_UseFixedImageRegion = false;
+    m_MaximumNumberOfSamples = 20000;
+    m_UseCorrelation = false;
+
+    m_SumFixed = 0;
+    m_VarFixed = 0;
+
+    m_Interpolator = InterpolatorType::New();
+}
+
+template <typename TImageType, typename TScalarType>
+void
+SparseImageMatchCostFunction <TImageType, TScalarType>
+::SetFixedImage(const ImageType *image)
+{
+    m_FixedImage = image;
+}
+
+template <typename TImageType, typename TScalarType>
+void
+SparseImageMatchCostFunction <TImageType, TScalarType>
+::SetMovingImage(const ImageType *image)
+{
+    m_Interpolator->SetInputImage(image);
+}
+
+template <typename TImageType, typename TScalarType>
+unsigned int
+SparseImageMatchCostFunction <TImageType, TScalarType>
+::GetNumberOfParameters() const
+{
+    if (m_Transform.IsNull())
+        return 0;
+
+    return m_Transform->GetNumberOfParameters();
+}
+
+template <typename TImageType, typename TScalarType>
+void
+SparseImageMatchCostFunction <TImageType, TScalarType>
+::Initialize()
+{
+    if (!m_FixedImage)
+        itkExceptionMacro("Fixed image has not been assigned");
+
+    if (!m_UseFixedImageRegion)
+        m_FixedImageRegion = m_FixedImage->GetLargestPossibleRegion();
+
+    // Regular grid sample: same stride along all non flat dimensions
+    unsigned int numVoxels = m_FixedImageRegion.GetNumberOfPixels();
+    unsigned int numSampledDimensions = 0;
+    for (unsigned int i = 0;i < ImageDimension;++i)
+    {
+        if (m_FixedImageRegion.GetSize()[i] > 1)
+            ++numSampledDimensions;
+    }
+
+    unsigned int stride = 1;
+    if ((m_MaximumNumberOfSamples > 0) && (numVoxels > m_MaximumNumberOfSamples) && (numSampledDimensions > 0))
+        stride = (unsigned int)std::ceil(std::pow((double)numVoxels / m_MaximumNumberOfSamples,1.0 / numSampledDimensions));
+
+    m_SamplePoints.clear();
+    m_SampleValues.clear();
+    m_SumFixed = 0;
+    double sumSquared = 0;
+
+    typedef itk::ImageRegionConstIteratorWithIndex <ImageType> FixedIteratorType;
+    FixedIteratorType fixedItr(m_FixedImage,m_FixedImageRegion);
+    PointType fixedPoint;
+
+    while (!fixedItr.IsAtEnd())
+    {
+        typename ImageType::IndexType index = fixedItr.GetIndex();
+        bool isSampled = true;
+        for (unsigned int i = 0;i < ImageDimension;++i)
+        {
+            if ((index[i] - m_FixedImageRegion.GetIndex()[i]) % stride != 0)
+            {
+                isSampled = false;
+                break;
+            }
+        }
+
+        if (isSampled)
+        {
+            m_FixedImage->TransformIndexToPhysicalPoint(index,fixedPoint);
+            double fixedValue = fixedItr.Get();
+
+            m_SamplePoints.push_back(fixedPoint);
+            m_SampleValues.push_back(fixedValue);
+
+            m_SumFixed += fixedValue;
+            sumSquared += fixedValue * fixedValue;
+        }
+
+        ++fixedItr;
+    }
+
+    m_VarFixed = 0;
+    if (m_SampleValues.size() > 0)
+        m_VarFixed = sumSquared - m_SumFixed * m_SumFixed / m_SampleValues.size();
+}
+
+template <typename TImageType, typename TScalarType>
+typename SparseImageMatchCostFunction <TImageType, TScalarType>::MeasureType
+SparseImageMatchCostFunction <TImageType, TScalarType>
+::GetValue(const ParametersType &parameters) const
+{
+    if (m_Transform.IsNull())
+        itkExceptionMacro("Transform has not been assigned");
+
+    m_Transform->SetParameters(parameters);
+    return this->Evaluate(m_Transform->GetMatrix(),m_Transform->GetOffset());
+}
+
+template <typename TImageType, typename TScalarType>
+void
+SparseImageMatchCostFunction <TImageType, TScalarType>
+::GetDerivative(const ParametersType &parameters, DerivativeType &derivative) const
+{
+    itkExceptionMacro("Derivative not implemented yet...");
+}
+
+template <typename TImageType, typename TScalarType>
+double
+SparseImageMatchCostFunction <TImageType, TScalarType>
+::Evaluate(const MatrixType &matrix, const OffsetType &offset) const
+{
+    unsigned int numSamples = m_SamplePoints.size();
+    if (numSamples == 0)
+        return 0;
+
+    const ImageType *movingImage = m_Interpolator->GetInputImage();
+
+    double sumMoving = 0;
+    double sumSquaredMoving = 0;
+    double sumCross = 0;
+    double sumSquaredDiffs = 0;
+
+    PointType movingPoint;
+    itk::ContinuousIndex <double, ImageDimension> movingIndex;
+
+    for (unsigned int i = 0;i < numSamples;++i)
+    {
+        for (unsigned int j = 0;j < ImageDimension;++j)
+        {
+            movingPoint[j] = offset[j];
+            for (unsigned int k = 0;k < ImageDimension;++k)
+                movingPoint[j] += matrix(j,k) * m_SamplePoints[i][k];
+        }
+
+        movingImage->TransformPhysicalPointToContinuousIndex(movingPoint,movingIndex);
+
+        double movingValue = 0;
+        if (m_Interpolator->IsInsideBuffer(movingIndex))
+            movingValue = m_Interpolator->EvaluateAtContinuousIndex(movingIndex);
+
+        if (m_UseCorrelation)
+        {
+            sumMoving += movingValue;
+            sumSquaredMoving += movingValue * movingValue;
+            sumCross += movingValue * m_SampleValues[i];
+        }
+        else
+        {
+            double diff = movingValue - m_SampleValues[i];
+            sumSquaredDiffs += diff * diff;
+        }
+    }
+
+    if (!m_UseCorrelation)
+        return sumSquaredDiffs / numSamples;
+
+    double varMoving = sumSquaredMoving - sumMoving * sumMoving / numSamples;
+    if ((varMoving <= 0) || (m_VarFixed <= 0))
+        return 0;
+
+    return (sumCross - m_SumFixed * sumMoving / numSamples) / std::sqrt(varMoving * m_VarFixed);
+}
+
+} // end namespace anima
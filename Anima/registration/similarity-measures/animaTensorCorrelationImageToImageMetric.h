@@ -66,7 +66,8 @@ private:
     double m_LogEpsilon;
 
     std::vector <InputPointType> m_FixedImagePoints;
-    std::vector <PixelType> m_FixedImageValues;
+    //! Fixed values, one row per fixed point
+    vnl_matrix <double> m_FixedImageValues;
 };
 
 } // end namespace anima
@@ -44,75 +44,35 @@ TensorCorrelationImageToImageMetric<TFixedImagePixelType,TMovingImagePixelType,I
 
     this->SetTransformParameters( parameters );
 
-    unsigned int vectorSize = m_FixedImageValues[0].GetSize();
-    PixelType movingValue;
-
-    OutputPointType transformedPoint;
-    ContinuousIndexType transformedIndex;
-
+    unsigned int vectorSize = m_FixedImageValues.cols();
     unsigned int tensorDimension = floor((std::sqrt((float)(8 * vectorSize + 1)) - 1) / 2.0);
 
-    vnl_matrix <double> tmpMat(tensorDimension, tensorDimension);
-    vnl_matrix <double> ppdOrientationMatrix(tensorDimension, tensorDimension);
-    typedef itk::Matrix <double, 3, 3> EigVecMatrixType;
-    typedef vnl_vector_fixed <double,3> EigValVectorType;
-    itk::SymmetricEigenAnalysis < EigVecMatrixType, EigValVectorType, EigVecMatrixType> eigenComputer(3);
-    EigVecMatrixType eigVecs;
-    EigValVectorType eigVals;
-
-    vnl_matrix <double> currentTensor(tensorDimension, tensorDimension);
-    double mST = 0, mRS = 0, mSS = 0;
-
-    double movingDenominator = 0;
-    double measureNumerator = 0;
+    this->GatherMovingValues(m_FixedImagePoints);
 
-    for (unsigned int i = 0;i < this->m_NumberOfPixelsCounted;++i)
-    {
-        transformedPoint = this->m_Transform->TransformPoint( m_FixedImagePoints[i] );
-        this->m_Interpolator->GetInputImage()->TransformPhysicalPointToContinuousIndex(transformedPoint,transformedIndex);
+    vnl_vector <double> movingSum;
+    vnl_matrix <double> movingGram, crossProducts;
+    this->ComputeMovingMoments(m_FixedImageValues,movingSum,movingGram,crossProducts);
 
-        if( this->m_Interpolator->IsInsideBuffer( transformedIndex ) )
+    double mST = 0, mRS = 0, mSS = 0;
+    unsigned int pos_internal = 0;
+    for (unsigned int j = 0;j < tensorDimension;++j)
+        for (unsigned int k = 0;k <= j;++k)
         {
-            movingValue = this->m_Interpolator->EvaluateAtContinuousIndex( transformedIndex );
-
-            if (this->GetModelRotation() != Superclass::NONE)
-            {
-                // Rotating tensor
-                anima::GetTensorFromVectorRepresentation(movingValue,tmpMat,tensorDimension,true);
-
-                if (this->GetModelRotation() == Superclass::FINITE_STRAIN)
-                    anima::RotateSymmetricMatrix(tmpMat,this->m_OrientationMatrix,currentTensor);
-                else
-                {
-                    eigenComputer.ComputeEigenValuesAndVectors(tmpMat,eigVals,eigVecs);
-                    anima::ExtractPPDRotationFromJacobianMatrix(this->m_OrientationMatrix,ppdOrientationMatrix,eigVecs);
-                    anima::RotateSymmetricMatrix(tmpMat,ppdOrientationMatrix,currentTensor);
-                }
-
-                anima::GetVectorRepresentation(currentTensor,movingValue,vectorSize,true);
-            }
-
-            unsigned int pos_internal = 0;
-            for (unsigned int j = 0;j < tensorDimension;++j)
-                for (unsigned int k = 0;k <= j;++k)
-                {
-                    if (i == j)
-                        mST += movingValue[pos_internal] * m_LogEpsilon;
+            if (j == k)
+                mST += movingSum[pos_internal] * m_LogEpsilon;
 
-                    mRS += m_FixedImageValues[i][pos_internal] * movingValue[pos_internal];
-                    mSS += movingValue[pos_internal] * movingValue[pos_internal];
+            mRS += crossProducts(pos_internal,pos_internal);
+            mSS += movingGram(pos_internal,pos_internal);
 
-                    ++pos_internal;
-                }
+            ++pos_internal;
         }
-    }
 
-    movingDenominator = mSS - mST * mST;
+    double movingDenominator = mSS - mST * mST;
 
     if (movingDenominator == 0)
         return 0;
 
-    measureNumerator = mRS - mST * m_FixedTProduct;
+    double measureNumerator = mRS - mST * m_FixedTProduct;
 
     double measure = measureNumerator * measureNumerator / (m_FixedDenominator * movingDenominator);
 
@@ -153,7 +113,7 @@ TensorCorrelationImageToImageMetric<TFixedImagePixelType,TMovingImagePixelType,I
     typename FixedImageType::IndexType index;
 
     m_FixedImagePoints.resize(this->m_NumberOfPixelsCounted);
-    m_FixedImageValues.resize(this->m_NumberOfPixelsCounted);
+    m_FixedImageValues.set_size(this->m_NumberOfPixelsCounted,vectorSize);
 
     InputPointType inputPoint;
 
@@ -166,7 +126,8 @@ TensorCorrelationImageToImageMetric<TFixedImagePixelType,TMovingImagePixelType,I
 
         m_FixedImagePoints[pos] = inputPoint;
         fixedValue = ti.Get();
-        m_FixedImageValues[pos] = fixedValue;
+        for (unsigned int i = 0;i < vectorSize;++i)
+            m_FixedImageValues(pos,i) = fixedValue[i];
 
         unsigned int pos_internal = 0;
         for (unsigned int i = 0;i < tensorDimension;++i)
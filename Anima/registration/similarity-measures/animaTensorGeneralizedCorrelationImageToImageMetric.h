@@ -72,7 +72,8 @@ private:
     CovarianceType m_FixedHalfInvCovarianceMatrix;
 
     std::vector <InputPointType> m_FixedImagePoints;
-    std::vector <PixelType> m_FixedImageValues;
+    //! Fixed values, one row per fixed point
+    vnl_matrix <double> m_FixedImageValues;
 };
 
 } // end namespace anima
@@ -32,7 +32,6 @@ TensorGeneralizedCorrelationImageToImageMetric<TFixedImagePixelType,TMovingImage
 ::GetValue( const TransformParametersType & parameters ) const
 {
     FixedImageConstPointer fixedImage = this->m_FixedImage;
-    MovingImageConstPointer movingImage = this->m_Interpolator->GetInputImage();
 
     if( !fixedImage )
         itkExceptionMacro( << "Fixed image has not been assigned" );
@@ -43,68 +42,18 @@ TensorGeneralizedCorrelationImageToImageMetric<TFixedImagePixelType,TMovingImage
     this->SetTransformParameters( parameters );
 
     unsigned int vectorSize = m_FixedMean.GetSize();
-
-    vnl_matrix <double> Sigma_YY(vectorSize,vectorSize);
-    Sigma_YY.fill(0);
-
-    vnl_matrix <double> Sigma_XY(vectorSize,vectorSize);
-    Sigma_XY.fill(0);
-
-    PixelType movingMean(vectorSize);
-    movingMean.Fill(0);
-
-    OutputPointType transformedPoint;
-    ContinuousIndexType transformedIndex;
-    PixelType movingValue(vectorSize);
-
     unsigned int tensorDimension = 3;
     vnl_matrix <double> tmpMat(tensorDimension, tensorDimension);
-    vnl_matrix <double> currentTensor(tensorDimension, tensorDimension);
-    vnl_matrix <double> ppdOrientationMatrix(tensorDimension, tensorDimension);
-    typedef itk::Matrix <double, 3, 3> EigVecMatrixType;
-    typedef vnl_vector_fixed <double,3> EigValVectorType;
-    itk::SymmetricEigenAnalysis < EigVecMatrixType, EigValVectorType, EigVecMatrixType> eigenComputer(3);
-    EigVecMatrixType eigVecs;
-    EigValVectorType eigVals;
-
-    for (unsigned int i = 0;i < this->m_NumberOfPixelsCounted;++i)
-    {
-        transformedPoint = this->m_Transform->TransformPoint( m_FixedImagePoints[i] );
-        movingImage->TransformPhysicalPointToContinuousIndex(transformedPoint,transformedIndex);
 
-        if( this->m_Interpolator->IsInsideBuffer( transformedIndex ) )
-        {
-            movingValue = this->m_Interpolator->EvaluateAtContinuousIndex( transformedIndex );
+    this->GatherMovingValues(m_FixedImagePoints);
 
-            if (this->GetModelRotation() != Superclass::NONE)
-            {
-                // Rotating tensor
-                anima::GetTensorFromVectorRepresentation(movingValue,tmpMat,tensorDimension,true);
-
-                if (this->GetModelRotation() == Superclass::FINITE_STRAIN)
-                    anima::RotateSymmetricMatrix(tmpMat,this->m_OrientationMatrix,currentTensor);
-                else
-                {
-                    eigenComputer.ComputeEigenValuesAndVectors(tmpMat,eigVals,eigVecs);
-                    anima::ExtractPPDRotationFromJacobianMatrix(this->m_OrientationMatrix,ppdOrientationMatrix,eigVecs);
-                    anima::RotateSymmetricMatrix(tmpMat,ppdOrientationMatrix,currentTensor);
-                }
-
-                anima::GetVectorRepresentation(currentTensor,movingValue,vectorSize,true);
-            }
+    vnl_vector <double> movingSum;
+    vnl_matrix <double> Sigma_YY, Sigma_XY;
+    this->ComputeMovingMoments(m_FixedImageValues,movingSum,Sigma_YY,Sigma_XY);
 
-            for (unsigned int j = 0;j < vectorSize;++j)
-            {
-                movingMean[j] += movingValue[j];
-
-                for (unsigned int k = 0;k < vectorSize;++k)
-                    Sigma_XY(j,k) += m_FixedImageValues[i][j] * movingValue[k];
-
-                for (unsigned int k = j;k < vectorSize;++k)
-                    Sigma_YY(j,k) += movingValue[j] * movingValue[k];
-            }
-        }
-    }
+    PixelType movingMean(vectorSize);
+    for (unsigned int j = 0;j < vectorSize;++j)
+        movingMean[j] = movingSum[j];
 
     for (unsigned int j = 0;j < vectorSize;++j)
         for (unsigned int k = j;k < vectorSize;++k)
@@ -226,7 +175,7 @@ TensorGeneralizedCorrelationImageToImageMetric<TFixedImagePixelType,TMovingImage
     this->m_NumberOfPixelsCounted = this->GetFixedImageRegion().GetNumberOfPixels();
 
     m_FixedImagePoints.resize(this->m_NumberOfPixelsCounted);
-    m_FixedImageValues.resize(this->m_NumberOfPixelsCounted);
+    m_FixedImageValues.set_size(this->m_NumberOfPixelsCounted,vectorSize);
 
     InputPointType inputPoint;
 
@@ -236,7 +185,9 @@ TensorGeneralizedCorrelationImageToImageMetric<TFixedImagePixelType,TMovingImage
         fixedImage->TransformIndexToPhysicalPoint( ti.GetIndex(), inputPoint );
 
         m_FixedImagePoints[pos] = inputPoint;
-        m_FixedImageValues[pos] = ti.Get();
+        PixelType fixedValue = ti.Get();
+        for (unsigned int i = 0;i < vectorSize;++i)
+            m_FixedImageValues(pos,i) = fixedValue[i];
 
         for (unsigned int i = 0;i < vectorSize;++i)
         {
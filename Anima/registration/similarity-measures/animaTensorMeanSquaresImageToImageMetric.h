@@ -49,6 +49,9 @@ public:
     /**  Get the value for single valued optimizers. */
     MeasureType GetValue(const TransformParametersType & parameters) const ITK_OVERRIDE;
 
+    //! Caches fixed points and values of the fixed image region, required before GetValue
+    void PreComputeFixedValues();
+
 protected:
     TensorMeanSquaresImageToImageMetric();
     virtual ~TensorMeanSquaresImageToImageMetric() {}
@@ -56,6 +59,12 @@ protected:
 private:
     TensorMeanSquaresImageToImageMetric(const Self&); //purposely not implemented
     void operator=(const Self&); //purposely not implemented
+
+    std::vector <InputPointType> m_FixedImagePoints;
+
+    //! Fixed values, one row per fixed point, and their squared norms
+    vnl_matrix <double> m_FixedImageValues;
+    std::vector <double> m_FixedSquaredNorms;
 };
 
 } // end namespace anima
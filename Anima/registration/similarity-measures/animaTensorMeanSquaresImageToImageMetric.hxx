@@ -30,83 +30,81 @@ TensorMeanSquaresImageToImageMetric<TFixedImagePixelType,TMovingImagePixelType,I
         itkExceptionMacro( << "Fixed image has not been assigned" );
     }
 
-    typedef  itk::ImageRegionConstIteratorWithIndex<FixedImageType> FixedIteratorType;
+    if (m_FixedImagePoints.size() == 0)
+    {
+        itkExceptionMacro( << "Fixed values have not been precomputed, PreComputeFixedValues() must be called after Initialize()" );
+    }
 
-    FixedIteratorType ti( fixedImage, this->GetFixedImageRegion() );
+    this->SetTransformParameters( parameters );
+
+    this->m_NumberOfPixelsCounted = this->GatherMovingValues(m_FixedImagePoints);
+
+    if( !this->m_NumberOfPixelsCounted )
+    {
+        itkExceptionMacro(<<"All the points mapped to outside of the moving image");
+    }
 
-    typename FixedImageType::IndexType index;
+    vnl_vector <double> movingSum;
+    vnl_matrix <double> movingGram, crossProducts;
+    this->ComputeMovingMoments(m_FixedImageValues,movingSum,movingGram,crossProducts);
 
+    // sum_i |R m_i - f_i|^2 over points inside the moving image, from moments
     MeasureType measure = itk::NumericTraits< MeasureType >::Zero;
+    for (unsigned int j = 0;j < movingGram.rows();++j)
+        measure += movingGram(j,j) - 2.0 * crossProducts(j,j);
 
-    this->m_NumberOfPixelsCounted = 0;
+    for (unsigned int i = 0;i < m_FixedImagePoints.size();++i)
+    {
+        if (this->m_InsidePoints[i])
+            measure += m_FixedSquaredNorms[i];
+    }
 
-    this->SetTransformParameters( parameters );
+    measure /= this->m_NumberOfPixelsCounted;
+
+    return measure;
+}
+
+template < class TFixedImagePixelType, class TMovingImagePixelType, unsigned int ImageDimension >
+void
+TensorMeanSquaresImageToImageMetric<TFixedImagePixelType,TMovingImagePixelType,ImageDimension>
+::PreComputeFixedValues()
+{
+    FixedImageConstPointer fixedImage = this->m_FixedImage;
+
+    if( !fixedImage )
+    {
+        itkExceptionMacro( << "Fixed image has not been assigned" );
+    }
 
     unsigned int vectorSize = fixedImage->GetNumberOfComponentsPerPixel();
-    ContinuousIndexType transformedIndex;
-    OutputPointType transformedPoint, inputPoint;
-
-    unsigned int tensorDimension = 3;
-    vnl_matrix <double> tmpMat(tensorDimension, tensorDimension);
-    vnl_matrix <double> currentTensor(tensorDimension, tensorDimension);
-    vnl_matrix <double> ppdOrientationMatrix(tensorDimension, tensorDimension);
-    typedef itk::Matrix <double, 3, 3> EigVecMatrixType;
-    typedef vnl_vector_fixed <double,3> EigValVectorType;
-    itk::SymmetricEigenAnalysis < EigVecMatrixType, EigValVectorType, EigVecMatrixType> eigenComputer(3);
-    EigVecMatrixType eigVecs;
-    EigValVectorType eigVals;
+    unsigned int numPixels = this->GetFixedImageRegion().GetNumberOfPixels();
+
+    typedef itk::ImageRegionConstIteratorWithIndex<FixedImageType> FixedIteratorType;
+    FixedIteratorType ti( fixedImage, this->GetFixedImageRegion() );
 
+    m_FixedImagePoints.resize(numPixels);
+    m_FixedImageValues.set_size(numPixels,vectorSize);
+    m_FixedSquaredNorms.resize(numPixels);
+
+    InputPointType inputPoint;
+    PixelType fixedValue;
+    unsigned int pos = 0;
     while(!ti.IsAtEnd())
     {
-        index = ti.GetIndex();
-        fixedImage->TransformIndexToPhysicalPoint(index,inputPoint);
-
-        transformedPoint = this->m_Transform->TransformPoint( inputPoint );
-        this->m_Interpolator->GetInputImage()->TransformPhysicalPointToContinuousIndex(transformedPoint,transformedIndex);
+        fixedImage->TransformIndexToPhysicalPoint( ti.GetIndex(), inputPoint );
+        m_FixedImagePoints[pos] = inputPoint;
 
-        if( this->m_Interpolator->IsInsideBuffer( transformedIndex ) )
+        fixedValue = ti.Get();
+        m_FixedSquaredNorms[pos] = 0;
+        for (unsigned int i = 0;i < vectorSize;++i)
         {
-            PixelType movingValue = this->m_Interpolator->EvaluateAtContinuousIndex(transformedIndex);
-
-            if (this->GetModelRotation() != Superclass::NONE)
-            {
-                // Rotating tensor
-                anima::GetTensorFromVectorRepresentation(movingValue,tmpMat,tensorDimension,true);
-
-                if (this->GetModelRotation() == Superclass::FINITE_STRAIN)
-                    anima::RotateSymmetricMatrix(tmpMat,this->m_OrientationMatrix,currentTensor);
-                else
-                {
-                    eigenComputer.ComputeEigenValuesAndVectors(tmpMat,eigVals,eigVecs);
-                    anima::ExtractPPDRotationFromJacobianMatrix(this->m_OrientationMatrix,ppdOrientationMatrix,eigVecs);
-                    anima::RotateSymmetricMatrix(tmpMat,ppdOrientationMatrix,currentTensor);
-                }
-
-                anima::GetVectorRepresentation(currentTensor,movingValue,vectorSize,true);
-            }
-
-            const PixelType fixedValue = ti.Get();
-            this->m_NumberOfPixelsCounted++;
-            for (unsigned int i = 0;i < vectorSize;++i)
-            {
-                const double diff = movingValue[i] - fixedValue[i];
-                measure += diff * diff;
-            }
+            m_FixedImageValues(pos,i) = fixedValue[i];
+            m_FixedSquaredNorms[pos] += fixedValue[i] * fixedValue[i];
         }
 
         ++ti;
+        ++pos;
     }
-
-    if( !this->m_NumberOfPixelsCounted )
-    {
-        itkExceptionMacro(<<"All the points mapped to outside of the moving image");
-    }
-    else
-    {
-        measure /= this->m_NumberOfPixelsCounted;
-    }
-
-    return measure;
 }
 
 } // end namespace anima
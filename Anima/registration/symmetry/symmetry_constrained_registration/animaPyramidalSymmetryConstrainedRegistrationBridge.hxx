@@ -12,6 +12,7 @@
 #include <animaNewuoaOptimizer.h>
 #include <animaMatrixOperations.h>
 #include <animaResampleImageFilter.h>
+#include <animaSparseImageMatchCostFunction.h>
 
 #include <itkMeanSquaresImageToImageMetric.h>
 #include <itkMutualInformationHistogramImageToImageMetric.h>
@@ -100,11 +101,6 @@ void PyramidalSymmetryConstrainedRegistrationBridge<ScalarType>::Update()
         std::cout << "Processing pyramid level " << i << std::endl;
         std::cout << "Image size: " << m_ReferencePyramid->GetOutput(i)->GetLargestPossibleRegion().GetSize() << std::endl;
 
-        // Init matcher
-        typename RegistrationType::Pointer reg = RegistrationType::New();
-
-        reg->SetNumberOfThreads(this->GetNumberOfThreads());
-
         typedef anima::NewuoaOptimizer OptimizerType;
 
         typename OptimizerType::Pointer optimizer = OptimizerType::New();
@@ -135,6 +131,41 @@ void PyramidalSymmetryConstrainedRegistrationBridge<ScalarType>::Update()
 
         optimizer->SetScales(tmpScales);
 
+        InputImageRegionType workRegion = m_ReferencePyramid->GetOutput(i)->GetLargestPossibleRegion();
+        if (m_FastRegistration)
+        {
+            // We can work in 2D since the rest should be perfectly ok
+            InputImageRegionType::IndexType centralIndex;
+            m_ReferencePyramid->GetOutput(i)->TransformPhysicalPointToIndex(centralPoint,centralIndex);
+
+            unsigned int baseIndex = centralIndex[indexAbsRefMax];
+            workRegion.SetIndex(indexAbsRefMax,baseIndex);
+            workRegion.SetSize(indexAbsRefMax,1);
+        }
+
+        if (m_Metric == MeanSquares)
+        {
+            // Anima sparse metric, shared with the symmetry plane search
+            typedef anima::SparseImageMatchCostFunction <InputImageType, ScalarType> CostFunctionType;
+            typename CostFunctionType::Pointer costFunction = CostFunctionType::New();
+
+            costFunction->SetFixedImage(m_ReferencePyramid->GetOutput(i));
+            costFunction->SetFixedImageRegion(workRegion);
+            costFunction->SetMovingImage(m_FloatingPyramid->GetOutput(i));
+            costFunction->SetTransform(m_OutputTransform);
+            costFunction->Initialize();
+
+            optimizer->SetCostFunction(costFunction);
+            optimizer->SetInitialPosition(m_OutputTransform->GetParameters());
+            optimizer->StartOptimization();
+
+            m_OutputTransform->SetParameters(optimizer->GetCurrentPosition());
+            continue;
+        }
+
+        typename RegistrationType::Pointer reg = RegistrationType::New();
+        reg->SetNumberOfThreads(this->GetNumberOfThreads());
+
         reg->SetOptimizer(optimizer);
         reg->SetTransform(m_OutputTransform);
 
@@ -189,22 +220,7 @@ void PyramidalSymmetryConstrainedRegistrationBridge<ScalarType>::Update()
 
         reg->SetFixedImage(m_ReferencePyramid->GetOutput(i));
         reg->SetMovingImage(m_FloatingPyramid->GetOutput(i));
-
-        if (m_FastRegistration)
-        {
-            // We can work in 2D since the rest should be perfectly ok
-            InputImageRegionType workRegion = m_ReferencePyramid->GetOutput(i)->GetLargestPossibleRegion();
-            InputImageRegionType::IndexType centralIndex;
-            m_ReferencePyramid->GetOutput(i)->TransformPhysicalPointToIndex(centralPoint,centralIndex);
-
-            unsigned int baseIndex = centralIndex[indexAbsRefMax];
-            workRegion.SetIndex(indexAbsRefMax,baseIndex);
-            workRegion.SetSize(indexAbsRefMax,1);
-
-            reg->SetFixedImageRegion(workRegion);
-        }
-        else
-            reg->SetFixedImageRegion(m_ReferencePyramid->GetOutput(i)->GetLargestPossibleRegion());
+        reg->SetFixedImageRegion(workRegion);
 
         reg->SetInitialTransformParameters(m_OutputTransform->GetParameters());
 
@@ -90,6 +90,9 @@ public:
     double GetFinalRadius(void) {return m_finalRadius;}
     void SetFinalRadius(double finalRadius) {m_finalRadius=finalRadius;}
 
+    bool GetUseGlobalSearch() {return m_UseGlobalSearch;}
+    void SetUseGlobalSearch(bool val) {m_UseGlobalSearch = val;}
+
     int GetNumberOfPyramidLevels() {return m_numberOfPyramidLevels;}
     void SetNumberOfPyramidLevels(int numberOfPyramidLevels) {m_numberOfPyramidLevels=numberOfPyramidLevels;}
 
@@ -148,6 +151,7 @@ protected:
         m_searchAngleRadius = 5;
         m_finalRadius = 0.001;
         m_numberOfPyramidLevels = 3;
+        m_UseGlobalSearch = true;
         this->SetNumberOfThreads(itk::MultiThreader::GetGlobalDefaultNumberOfThreads());
         m_fixedfile = "";
         m_outputRealignTransformFile = "";
@@ -182,6 +186,7 @@ private:
     double m_searchAngleRadius;
     double m_finalRadius;
     int m_numberOfPyramidLevels;
+    bool m_UseGlobalSearch;
     std::string m_fixedfile;
     std::string m_outputRealignTransformFile;
     std::string m_outputTransformFile;
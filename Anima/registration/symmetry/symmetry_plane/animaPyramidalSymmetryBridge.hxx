@@ -17,6 +17,8 @@
 
 #include <animaVectorOperations.h>
 #include <animaResampleImageFilter.h>
+#include <animaSparseImageMatchCostFunction.h>
+#include <animaSymmetryPlaneSearcher.h>
 
 namespace anima
 {
@@ -52,10 +54,31 @@ void PyramidalSymmetryBridge<PixelType,ScalarType>::Update()
 
     typename TransformType::ParametersType initialParams(TransformType::ParametersDimension);
 
-    // Here should come test on orientation matrix -> find the true left/right axis
     for (unsigned int i = 0;i < TransformType::ParametersDimension;++i)
         initialParams[i] = 0;
 
+    if (m_UseGlobalSearch)
+    {
+        // Global search on the coarsest level, makes the result independent of the image orientation
+        typedef anima::SymmetryPlaneSearcher <OutputImageType> SearcherType;
+        typename SearcherType::Pointer searcher = SearcherType::New();
+
+        searcher->SetInputImage(m_ReferencePyramid->GetOutput(0));
+        searcher->SetRotationCenter(centralPoint);
+        searcher->SetNumberOfThreads(this->GetNumberOfThreads());
+        searcher->SetSearchRadius(GetSearchRadius());
+        searcher->SetSearchAngleRadius(GetSearchAngleRadius());
+        searcher->SetFinalRadius(GetFinalRadius());
+        searcher->SetOptimizerMaxIterations(GetOptimizerMaxIterations());
+        searcher->Update();
+
+        for (unsigned int i = 0;i < TransformType::ParametersDimension;++i)
+            initialParams[i] = searcher->GetOptimalParameters()[i];
+
+        std::cout << "Global symmetry plane search: parameters " << initialParams
+                  << ", reflection correlation " << searcher->GetOptimalValue() << std::endl;
+    }
+
     m_OutputTransform->SetParameters(initialParams);
     m_OutputTransform->SetRotationCenter(centralPoint);
 
@@ -65,11 +88,6 @@ void PyramidalSymmetryBridge<PixelType,ScalarType>::Update()
         std::cout << "Processing pyramid level " << i << std::endl;
         std::cout << "Image size: " << m_ReferencePyramid->GetOutput(i)->GetLargestPossibleRegion().GetSize() << std::endl;
 
-        // Init matcher
-        typename RegistrationType::Pointer reg = RegistrationType::New();
-
-        reg->SetNumberOfThreads(GetNumberOfThreads());
-
         typedef itk::SingleValuedNonLinearOptimizer OptimizerType;
         typename OptimizerType::Pointer optimizer;
 
@@ -122,6 +140,29 @@ void PyramidalSymmetryBridge<PixelType,ScalarType>::Update()
 
         optimizer->SetScales(tmpScales);
 
+        if (GetMetric() == MeanSquares)
+        {
+            // Anima sparse metric: reflection mean squares on a regular voxel sample
+            typedef anima::SparseImageMatchCostFunction <OutputImageType, ScalarType> CostFunctionType;
+            typename CostFunctionType::Pointer costFunction = CostFunctionType::New();
+
+            costFunction->SetFixedImage(m_ReferencePyramid->GetOutput(i));
+            costFunction->SetMovingImage(m_FloatingPyramid->GetOutput(i));
+            costFunction->SetTransform(m_OutputTransform);
+            costFunction->Initialize();
+
+            optimizer->SetCostFunction(costFunction);
+            optimizer->SetInitialPosition(m_OutputTransform->GetParameters());
+            optimizer->StartOptimization();
+
+            progress.CompletedPixel();
+            m_OutputTransform->SetParameters(optimizer->GetCurrentPosition());
+            continue;
+        }
+
+        typename RegistrationType::Pointer reg = RegistrationType::New();
+        reg->SetNumberOfThreads(GetNumberOfThreads());
+
         reg->SetOptimizer(optimizer);
         reg->SetTransform(m_OutputTransform);
 
@@ -23,6 +23,8 @@ int main(int ac, const char** av)
     TCLAP::ValueArg<double> searchAngleRadiusArg("","sar","Search angle radius in degrees (rho start for bobyqa, default: 5)",false,5,"optimizer search angle radius",cmd);
     TCLAP::ValueArg<double> finalRadiusArg("","fr","Final radius (rho end for bobyqa, default: 0.001)",false,0.001,"optimizer final radius",cmd);
 
+    TCLAP::SwitchArg noGlobalSearchArg("L","local-search","Only search locally around the image left-right axis (no global plane search)",cmd,false);
+
     TCLAP::ValueArg<unsigned int> numPyramidLevelsArg("p","pyr","Number of pyramid levels (default: 3)",false,3,"number of pyramid levels",cmd);
     TCLAP::ValueArg<unsigned int> numThreadsArg("T","threads","Number of execution threads (default: 0 = all cores)",false,0,"number of threads",cmd);
 
@@ -64,6 +66,7 @@ int main(int ac, const char** av)
     matcher->SetSearchAngleRadius(searchAngleRadiusArg.getValue());
     matcher->SetFinalRadius(finalRadiusArg.getValue());
     matcher->SetNumberOfPyramidLevels(numPyramidLevelsArg.getValue());
+    matcher->SetUseGlobalSearch(!noGlobalSearchArg.isSet());
 
     if (numThreadsArg.getValue() != 0)
         matcher->SetNumberOfThreads(numThreadsArg.getValue());
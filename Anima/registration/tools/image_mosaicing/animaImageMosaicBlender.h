@@ -0,0 +1,76 @@
+#pragma once
+
+#include <itkImage.h>
+#include <itkMatrixOffsetTransformBase.h>
+#include <itkMultiThreader.h>
+
+namespace anima
+{
+
+/**
+ * @brief Accumulates tiles into a mosaic, one tile at a time.
+ * Each tile is resampled (linear interpolation) only over its bounding region in the mosaic geometry,
+ * image and weight sums being updated in the same multi-threaded pass. Weights are either 1 inside the tile
+ * or decrease linearly to the tile borders over a feathering distance (in tile voxels).
+ */
+template <typename TImageType>
+class ImageMosaicBlender
+{
+public:
+    typedef ImageMosaicBlender Self;
+    ImageMosaicBlender();
+    virtual ~ImageMosaicBlender() {}
+
+    typedef TImageType ImageType;
+    typedef typename ImageType::Pointer ImagePointer;
+    typedef typename ImageType::RegionType RegionType;
+    typedef itk::Image <unsigned short, TImageType::ImageDimension> CountImageType;
+    typedef typename CountImageType::Pointer CountImagePointer;
+
+    //! Transform from mosaic to tile coordinates, as used for resampling
+    typedef itk::MatrixOffsetTransformBase <double, TImageType::ImageDimension> MatrixTransformType;
+
+    //! Initializes sum and weight images on the mosaic geometry
+    void SetOutputGeometry(const ImageType *geometry);
+
+    void SetNumberOfThreads(unsigned int val) {m_NumberOfThreads = val;}
+    void SetFeatheringDistance(double val) {m_FeatheringDistance = val;}
+
+    //! Blends a tile in the mosaic, the tile may be released afterwards
+    void AddTile(const ImageType *tile, const MatrixTransformType *trsf);
+
+    //! Sums normalized by weights, recomputed at each call from the untouched accumulators
+    ImageType *GetMosaic();
+
+    //! Number of tiles covering each mosaic voxel
+    CountImageType *GetCoverageImage() {return m_CoverageImage;}
+
+protected:
+    struct ThreadedBlendData
+    {
+        Self *Blender;
+    };
+
+    //! Mosaic region covered by a tile, empty if outside of the mosaic
+    RegionType ComputeTileBoundingRegion(const ImageType *tile, const MatrixTransformType *trsf);
+
+    static ITK_THREAD_RETURN_TYPE ThreadedBlending(void *arg);
+    void BlendTileSlices(unsigned int threadId, unsigned int numThreads);
+
+private:
+    unsigned int m_NumberOfThreads;
+    double m_FeatheringDistance;
+
+    ImagePointer m_SumImage, m_WeightImage;
+    ImagePointer m_MosaicImage;
+    CountImagePointer m_CoverageImage;
+
+    // Current tile information, used by threads
+    const ImageType *m_CurrentTile;
+    const MatrixTransformType *m_CurrentTransform;
+    RegionType m_CurrentRegion;
+};
+
+} // end namespace anima
+
+#include "animaImageMosaicBlender.hxx"
@@ -0,0 +1,321 @@
+#pragma once
+#include "animaImageMosaicBlender.h"
+
+#include <itkContinuousIndex.h>
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionConstIterator.h>
+#include <vnl/vnl_matrix.h>
+#include <vnl/vnl_vector.h>
+#include <vnl/algo/vnl_matrix_inverse.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace anima
+{
+
+template <typename TImageType>
+ImageMosaicBlender <TImageType>
+::ImageMosaicBlender()
+{
+    m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    m_FeatheringDistance = 0;
+
+    m_CurrentTile = 0;
+    m_CurrentTransform = 0;
+}
+
+template <typename TImageType>
+void
+ImageMosaicBlender <TImageType>
+::SetOutputGeometry(const ImageType *geometry)
+{
+    m_SumImage = ImageType::New();
+    m_SumImage->Initialize();
+    m_SumImage->SetRegions(geometry->GetLargestPossibleRegion());
+    m_SumImage->CopyInformation(geometry);
+    m_SumImage->Allocate();
+    m_SumImage->FillBuffer(0.0);
+
+    m_MosaicImage = NULL;
+
+    m_WeightImage = ImageType::New();
+    m_WeightImage->Initialize();
+    m_WeightImage->SetRegions(geometry->GetLargestPossibleRegion());
+    m_WeightImage->CopyInformation(geometry);
+    m_WeightImage->Allocate();
+    m_WeightImage->FillBuffer(0.0);
+
+    m_CoverageImage = CountImageType::New();
+    m_CoverageImage->Initialize();
+    m_CoverageImage->SetRegions(geometry->GetLargestPossibleRegion());
+    m_CoverageImage->CopyInformation(geometry);
+    m_CoverageImage->Allocate();
+    m_CoverageImage->FillBuffer(0);
+}
+
+template <typename TImageType>
+typename ImageMosaicBlender <TImageType>::RegionType
+ImageMosaicBlender <TImageType>
+::ComputeTileBoundingRegion(const ImageType *tile, const MatrixTransformType *trsf)
+{
+    const unsigned int Dimension = TImageType::ImageDimension;
+
+    typename MatrixTransformType::Pointer inverseTrsf = MatrixTransformType::New();
+    trsf->GetInverse(inverseTrsf);
+
+    typename ImageType::IndexType tileStart = tile->GetLargestPossibleRegion().GetIndex();
+    typename ImageType::SizeType tileSize = tile->GetLargestPossibleRegion().GetSize();
+
+    itk::ContinuousIndex <double, Dimension> lowerCorner, upperCorner;
+    lowerCorner.Fill(std::numeric_limits <double>::max());
+    upperCorner.Fill(- std::numeric_limits <double>::max());
+
+    // Tile corners, including the half voxel where interpolation is still defined
+    unsigned int numCorners = 1 << Dimension;
+    for (unsigned int i = 0;i < numCorners;++i)
+    {
+        itk::ContinuousIndex <double, Dimension> corner;
+        unsigned int upper = i;
+        for (unsigned int d = 0;d < Dimension;++d)
+        {
+            corner[d] = (upper & 1) ? tileStart[d] + tileSize[d] - 0.5 : tileStart[d] - 0.5;
+            upper >>= 1;
+        }
+
+        typename ImageType::PointType tmpPoint;
+        tile->TransformContinuousIndexToPhysicalPoint(corner,tmpPoint);
+        tmpPoint = inverseTrsf->TransformPoint(tmpPoint);
+
+        itk::ContinuousIndex <double, Dimension> mosaicIndex;
+        m_SumImage->TransformPhysicalPointToContinuousIndex(tmpPoint,mosaicIndex);
+
+        for (unsigned int d = 0;d < Dimension;++d)
+        {
+            lowerCorner[d] = std::min(lowerCorner[d],mosaicIndex[d]);
+            upperCorner[d] = std::max(upperCorner[d],mosaicIndex[d]);
+        }
+    }
+
+    RegionType boundingRegion;
+    for (unsigned int d = 0;d < Dimension;++d)
+    {
+        long lowerIndex = std::floor(lowerCorner[d]);
+        long upperIndex = std::ceil(upperCorner[d]);
+
+        boundingRegion.SetIndex(d,lowerIndex);
+        boundingRegion.SetSize(d,upperIndex - lowerIndex + 1);
+    }
+
+    if (!boundingRegion.Crop(m_SumImage->GetLargestPossibleRegion()))
+    {
+        for (unsigned int d = 0;d < Dimension;++d)
+            boundingRegion.SetSize(d,0);
+    }
+
+    return boundingRegion;
+}
+
+template <typename TImageType>
+void
+ImageMosaicBlender <TImageType>
+::AddTile(const ImageType *tile, const MatrixTransformType *trsf)
+{
+    m_CurrentRegion = this->ComputeTileBoundingRegion(tile,trsf);
+    if (m_CurrentRegion.GetNumberOfPixels() == 0)
+        return;
+
+    m_CurrentTile = tile;
+    m_CurrentTransform = trsf;
+
+    itk::MultiThreader::Pointer threadWorker = itk::MultiThreader::New();
+    ThreadedBlendData *tmpStr = new ThreadedBlendData;
+    tmpStr->Blender = this;
+
+    threadWorker->SetNumberOfThreads(m_NumberOfThreads);
+    threadWorker->SetSingleMethod(this->ThreadedBlending,tmpStr);
+    threadWorker->SingleMethodExecute();
+
+    delete tmpStr;
+
+    m_CurrentTile = 0;
+    m_CurrentTransform = 0;
+}
+
+template <typename TImageType>
+ITK_THREAD_RETURN_TYPE
+ImageMosaicBlender <TImageType>
+::ThreadedBlending(void *arg)
+{
+    itk::MultiThreader::ThreadInfoStruct *threadArgs = (itk::MultiThreader::ThreadInfoStruct *)arg;
+    ThreadedBlendData *data = (ThreadedBlendData *)threadArgs->UserData;
+
+    data->Blender->BlendTileSlices(threadArgs->ThreadID,threadArgs->NumberOfThreads);
+    return ITK_THREAD_RETURN_VALUE;
+}
+
+template <typename TImageType>
+void
+ImageMosaicBlender <TImageType>
+::BlendTileSlices(unsigned int threadId, unsigned int numThreads)
+{
+    const unsigned int Dimension = TImageType::ImageDimension;
+
+    // Threads process disjoint slabs of the tile bounding region along the last dimension
+    RegionType threadRegion = m_CurrentRegion;
+    unsigned int numSlices = m_CurrentRegion.GetSize()[Dimension - 1];
+    unsigned int startSlice = (unsigned int)((unsigned long)threadId * numSlices / numThreads);
+    unsigned int endSlice = (unsigned int)((unsigned long)(threadId + 1) * numSlices / numThreads);
+    if (startSlice == endSlice)
+        return;
+
+    threadRegion.SetIndex(Dimension - 1,m_CurrentRegion.GetIndex()[Dimension - 1] + startSlice);
+    threadRegion.SetSize(Dimension - 1,endSlice - startSlice);
+
+    // Mosaic index to tile continuous index is affine: c = G * idx + g
+    vnl_matrix <double> mosaicIndexToPhysical(Dimension,Dimension);
+    vnl_matrix <double> tileIndexToPhysical(Dimension,Dimension);
+    for (unsigned int i = 0;i < Dimension;++i)
+    {
+        for (unsigned int j = 0;j < Dimension;++j)
+        {
+            mosaicIndexToPhysical(i,j) = m_SumImage->GetDirection()(i,j) * m_SumImage->GetSpacing()[j];
+            tileIndexToPhysical(i,j) = m_CurrentTile->GetDirection()(i,j) * m_CurrentTile->GetSpacing()[j];
+        }
+    }
+
+    vnl_matrix <double> physicalToTileIndex = vnl_matrix_inverse <double> (tileIndexToPhysical);
+    vnl_matrix <double> transformMatrix = m_CurrentTransform->GetMatrix().GetVnlMatrix();
+
+    vnl_matrix <double> indexMatrix = physicalToTileIndex * transformMatrix * mosaicIndexToPhysical;
+    vnl_vector <double> indexOffset(Dimension);
+    for (unsigned int i = 0;i < Dimension;++i)
+        indexOffset[i] = m_CurrentTransform->GetOffset()[i] - m_CurrentTile->GetOrigin()[i];
+
+    vnl_vector <double> mosaicOrigin(Dimension);
+    for (unsigned int i = 0;i < Dimension;++i)
+        mosaicOrigin[i] = m_SumImage->GetOrigin()[i];
+
+    indexOffset = physicalToTileIndex * (transformMatrix * mosaicOrigin + indexOffset);
+    for (unsigned int i = 0;i < Dimension;++i)
+        indexOffset[i] -= m_CurrentTile->GetLargestPossibleRegion().GetIndex()[i];
+
+    typename ImageType::SizeType tileSize = m_CurrentTile->GetLargestPossibleRegion().GetSize();
+    const typename ImageType::OffsetValueType *tileOffsetTable = m_CurrentTile->GetOffsetTable();
+    const typename ImageType::PixelType *tileBuffer = m_CurrentTile->GetBufferPointer();
+
+    itk::ImageRegionIterator <ImageType> sumItr(m_SumImage,threadRegion);
+    itk::ImageRegionIterator <ImageType> weightItr(m_WeightImage,threadRegion);
+    itk::ImageRegionIterator <CountImageType> coverageItr(m_CoverageImage,threadRegion);
+
+    unsigned int numCorners = 1 << Dimension;
+    std::vector <long> lowerIndexes(Dimension), upperIndexes(Dimension);
+    std::vector <double> upperWeights(Dimension);
+    vnl_vector <double> tileIndex(Dimension);
+
+    while (!sumItr.IsAtEnd())
+    {
+        typename ImageType::IndexType mosaicIndex = sumItr.GetIndex();
+        tileIndex = indexOffset;
+        for (unsigned int i = 0;i < Dimension;++i)
+            for (unsigned int j = 0;j < Dimension;++j)
+                tileIndex[i] += indexMatrix(i,j) * mosaicIndex[j];
+
+        bool isInside = true;
+        double distanceToBorder = std::numeric_limits <double>::max();
+        for (unsigned int i = 0;i < Dimension;++i)
+        {
+            if ((tileIndex[i] < -0.5) || (tileIndex[i] >= tileSize[i] - 0.5))
+            {
+                isInside = false;
+                break;
+            }
+
+            distanceToBorder = std::min(distanceToBorder,std::min(tileIndex[i] + 0.5,tileSize[i] - 0.5 - tileIndex[i]));
+        }
+
+        if (isInside)
+        {
+            // Linear interpolation, neighbors clamped to the tile
+            for (unsigned int i = 0;i < Dimension;++i)
+            {
+                double floorValue = std::floor(tileIndex[i]);
+                upperWeights[i] = tileIndex[i] - floorValue;
+                lowerIndexes[i] = std::max(0L,(long)floorValue);
+                upperIndexes[i] = std::min((long)tileSize[i] - 1,(long)floorValue + 1);
+            }
+
+            double value = 0;
+            for (unsigned int c = 0;c < numCorners;++c)
+            {
+                double cornerWeight = 1.0;
+                long bufferOffset = 0;
+                for (unsigned int i = 0;i < Dimension;++i)
+                {
+                    long cornerIndex = lowerIndexes[i];
+                    if (c & (1 << i))
+                    {
+                        cornerIndex = upperIndexes[i];
+                        cornerWeight *= upperWeights[i];
+                    }
+                    else
+                        cornerWeight *= 1.0 - upperWeights[i];
+
+                    bufferOffset += cornerIndex * tileOffsetTable[i];
+                }
+
+                if (cornerWeight != 0)
+                    value += cornerWeight * tileBuffer[bufferOffset];
+            }
+
+            double weight = 1.0;
+            if (m_FeatheringDistance > 0)
+                weight = std::min(1.0,distanceToBorder / m_FeatheringDistance);
+
+            sumItr.Set(sumItr.Get() + weight * value);
+            weightItr.Set(weightItr.Get() + weight);
+            coverageItr.Set(coverageItr.Get() + 1);
+        }
+
+        ++sumItr;
+        ++weightItr;
+        ++coverageItr;
+    }
+}
+
+template <typename TImageType>
+TImageType *
+ImageMosaicBlender <TImageType>
+::GetMosaic()
+{
+    if (!m_MosaicImage)
+    {
+        m_MosaicImage = ImageType::New();
+        m_MosaicImage->Initialize();
+        m_MosaicImage->SetRegions(m_SumImage->GetLargestPossibleRegion());
+        m_MosaicImage->CopyInformation(m_SumImage);
+        m_MosaicImage->Allocate();
+    }
+
+    itk::ImageRegionConstIterator <ImageType> sumItr(m_SumImage,m_SumImage->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator <ImageType> weightItr(m_WeightImage,m_SumImage->GetLargestPossibleRegion());
+    itk::ImageRegionIterator <ImageType> mosaicItr(m_MosaicImage,m_SumImage->GetLargestPossibleRegion());
+
+    while (!sumItr.IsAtEnd())
+    {
+        if (weightItr.Get() > 0)
+            mosaicItr.Set(sumItr.Get() / weightItr.Get());
+        else
+            mosaicItr.Set(0);
+
+        ++sumItr;
+        ++weightItr;
+        ++mosaicItr;
+    }
+
+    return m_MosaicImage;
+}
+
+} // end namespace anima
@@ -1,11 +1,31 @@
 #include <tclap/CmdLine.h>
 
-#include <animaResampleImageFilter.h>
+#include <animaImageMosaicBlender.h>
 #include <itkTransformFileReader.h>
-#include <itkAddImageFilter.h>
-#include <itkImageRegionIterator.h>
+#include <itkImageFileReader.h>
 #include <animaReadWriteFunctions.h>
 
+//! Reads the k-th tile transform (mosaic to tile), identity if no transform was given
+itk::MatrixOffsetTransformBase <double,3>::Pointer readMosaicTransform(const std::vector <std::string> &trsfNames, unsigned int k)
+{
+    typedef itk::MatrixOffsetTransformBase <double,3> MatrixTransformType;
+    MatrixTransformType::Pointer trsf = MatrixTransformType::New();
+    trsf->SetIdentity();
+
+    if (trsfNames.size() == 0)
+        return trsf;
+
+    itk::TransformFileReader::Pointer reader = itk::TransformFileReader::New();
+    reader->SetFileName(trsfNames[k]);
+    reader->Update();
+
+    const itk::TransformFileReader::TransformListType *trsfList = reader->GetTransformList();
+    itk::TransformFileReader::TransformListType::const_iterator tr_it = trsfList->begin();
+
+    trsf = dynamic_cast <MatrixTransformType *> ((*tr_it).GetPointer());
+    return trsf;
+}
+
 int main(int ac, const char** av)
 {
     std::string descriptionMessage = "Resampler tool for stitching several image into one.\n"
@@ -21,6 +41,8 @@ int main(int ac, const char** av)
     TCLAP::ValueArg<std::string> outMaskArg("O","out-mask","Output mosaic mask",false,"","output mosaic mask",cmd);
     TCLAP::ValueArg<std::string> geomArg("g","geometry","Geometry image",true,"","geometry image",cmd);
 
+    TCLAP::ValueArg<double> featherArg("f","feather","Feathering distance to tile borders in tile voxels (default: 0, plain average)",false,0,"feathering distance",cmd);
+
     TCLAP::ValueArg<unsigned int> nbpArg("p","numberofthreads","Number of threads to run on (default : all cores)",
                                          false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
 
@@ -34,7 +56,6 @@ int main(int ac, const char** av)
         return EXIT_FAILURE;
     }
 
-    // Find out the type of the image in file
     typedef itk::Image <float, 3> ImageType;
     ImageType::Pointer geometryImage = anima::readImage <ImageType> (geomArg.getValue());
 
@@ -52,31 +73,28 @@ int main(int ac, const char** av)
     std::vector <std::string> inputImages = inArg.getValue();
     std::vector <std::string> inputTrsfs = trArg.getValue();
 
-    // Explore images and transforms to get the boundaries of the future image
+    if ((inputTrsfs.size() != 0) && (inputTrsfs.size() != inputImages.size()))
+    {
+        std::cerr << "Error: the number of transforms should match the number of input images" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Explore image headers and transforms to get the boundaries of the future image
+    typedef itk::ImageFileReader <ImageType> ImageReaderType;
     for (unsigned int k = 0;k < inputImages.size();++k)
     {
-        ImageType::Pointer input = anima::readImage <ImageType> (inputImages[k]);
+        ImageReaderType::Pointer headerReader = ImageReaderType::New();
+        headerReader->SetFileName(inputImages[k]);
+        headerReader->UpdateOutputInformation();
+        ImageType *input = headerReader->GetOutput();
 
         ImageType::IndexType lowerCornerIndex = input->GetLargestPossibleRegion().GetIndex();
         ImageType::IndexType upperCornerIndex = lowerCornerIndex + input->GetLargestPossibleRegion().GetSize();
 
-        MatrixTransformPointer trsf = MatrixTransformType::New();
-        trsf->SetIdentity();
-
-        if (inputTrsfs.size() != 0)
-        {
-            itk::TransformFileReader::Pointer reader = itk::TransformFileReader::New();
-            reader->SetFileName(inputTrsfs[k]);
-            reader->Update();
-
-            const itk::TransformFileReader::TransformListType *trsfList = reader->GetTransformList();
-            itk::TransformFileReader::TransformListType::const_iterator tr_it = trsfList->begin();
-
-            trsf = dynamic_cast <MatrixTransformType *> ((*tr_it).GetPointer());
-            MatrixTransformPointer tmpInvert = MatrixTransformType::New();
-            trsf->GetInverse(tmpInvert);
-            trsf = tmpInvert;
-        }
+        MatrixTransformPointer trsf = readMosaicTransform(inputTrsfs,k);
+        MatrixTransformPointer tmpInvert = MatrixTransformType::New();
+        trsf->GetInverse(tmpInvert);
+        trsf = tmpInvert;
 
         unsigned int numCorners = 1 << ImageType::ImageDimension;
         for (unsigned int i = 0;i < numCorners;++i)
@@ -112,8 +130,8 @@ int main(int ac, const char** av)
     }
 
     // Now define output geometry
-    ImageType::Pointer outputImage = ImageType::New();
-    outputImage->Initialize();
+    ImageType::Pointer outputGeometry = ImageType::New();
+    outputGeometry->Initialize();
 
     for (unsigned int i = 0;i < ImageType::ImageDimension;++i)
     {
@@ -123,44 +141,30 @@ int main(int ac, const char** av)
 
     ImageType::PointType origin;
     geometryImage->TransformContinuousIndexToPhysicalPoint(lowerCornerBoundingBox,origin);
-    outputImage->SetOrigin(origin);
-    outputImage->SetSpacing(geometryImage->GetSpacing());
-    outputImage->SetDirection(geometryImage->GetDirection());
+    outputGeometry->SetOrigin(origin);
+    outputGeometry->SetSpacing(geometryImage->GetSpacing());
+    outputGeometry->SetDirection(geometryImage->GetDirection());
 
+    // Origin is at the lower corner, hence the output region starts at index 0
     ImageType::RegionType outputRegion;
     for (unsigned int i = 0;i < ImageType::ImageDimension;++i)
     {
         int lowerIndex = lowerCornerBoundingBox[i];
         int upperIndex = upperCornerBoundingBox[i];
 
-        if (lowerIndex >= 0)
-            outputRegion.SetIndex(i,lowerIndex);
-        else
-            outputRegion.SetIndex(i,0);
-
+        outputRegion.SetIndex(i,0);
         outputRegion.SetSize(i,upperIndex - lowerIndex);
     }
 
-    outputImage->SetRegions(outputRegion);
-    outputImage->Allocate();
-    outputImage->FillBuffer(0.0);
-
-    typedef itk::Image <unsigned short,3> MaskImageType;
-    MaskImageType::Pointer maskImage = MaskImageType::New();
-    maskImage->Initialize();
-    maskImage->SetOrigin(origin);
-    maskImage->SetSpacing(geometryImage->GetSpacing());
-    maskImage->SetDirection(geometryImage->GetDirection());
-    maskImage->SetRegions(outputRegion);
-    maskImage->Allocate();
-    maskImage->FillBuffer(0);
-
-    // Now finally resample images in new geometry and average
-    typedef anima::ResampleImageFilter <ImageType, ImageType> ResampleFilterType;
-    typedef anima::ResampleImageFilter <MaskImageType, ImageType> MaskResampleFilterType;
-    typedef itk::AddImageFilter <ImageType,ImageType,ImageType> AddFilterType;
-    typedef itk::ImageRegionIterator <ImageType> ImageIteratorType;
-    typedef itk::ImageRegionIterator <MaskImageType> MaskImageIteratorType;
+    outputGeometry->SetRegions(outputRegion);
+    geometryImage = 0;
+
+    // Now resample tiles one at a time over their bounding region only, and blend them
+    typedef anima::ImageMosaicBlender <ImageType> BlenderType;
+    BlenderType blender;
+    blender.SetNumberOfThreads(nbpArg.getValue());
+    blender.SetFeatheringDistance(featherArg.getValue());
+    blender.SetOutputGeometry(outputGeometry);
 
     for (unsigned int i = 0;i < inputImages.size();++i)
     {
@@ -171,91 +175,15 @@ int main(int ac, const char** av)
             std::cout << std::endl;
 
         ImageType::Pointer input = anima::readImage <ImageType> (inputImages[i]);
+        MatrixTransformPointer trsf = readMosaicTransform(inputTrsfs,i);
 
-        MatrixTransformPointer trsf = MatrixTransformType::New();
-        trsf->SetIdentity();
-
-        if (inputTrsfs.size() != 0)
-        {
-            itk::TransformFileReader::Pointer reader = itk::TransformFileReader::New();
-            reader->SetFileName(inputTrsfs[i]);
-            reader->Update();
-
-            const itk::TransformFileReader::TransformListType *trsfList = reader->GetTransformList();
-            itk::TransformFileReader::TransformListType::const_iterator tr_it = trsfList->begin();
-
-            trsf = dynamic_cast <MatrixTransformType *> ((*tr_it).GetPointer());
-        }
-
-        ResampleFilterType::Pointer imageResampler = ResampleFilterType::New();
-        imageResampler->SetTransform(trsf);
-        imageResampler->SetSize(outputRegion.GetSize());
-        imageResampler->SetOutputOrigin(origin);
-        imageResampler->SetOutputSpacing(outputImage->GetSpacing());
-        imageResampler->SetOutputDirection(outputImage->GetDirection());
-        imageResampler->SetInput(input);
-        imageResampler->SetNumberOfThreads(nbpArg.getValue());
-        imageResampler->Update();
-
-        AddFilterType::Pointer addFilter = AddFilterType::New();
-        addFilter->SetInput1(outputImage);
-        addFilter->SetInput2(imageResampler->GetOutput());
-        addFilter->SetNumberOfThreads(nbpArg.getValue());
-        addFilter->Update();
-
-        outputImage = addFilter->GetOutput();
-        outputImage->DisconnectPipeline();
-
-        MaskImageType::Pointer tmpMask = MaskImageType::New();
-        tmpMask->Initialize();
-        tmpMask->SetOrigin(input->GetOrigin());
-        tmpMask->SetSpacing(input->GetSpacing());
-        tmpMask->SetDirection(input->GetDirection());
-        tmpMask->SetRegions(input->GetLargestPossibleRegion());
-        tmpMask->Allocate();
-        tmpMask->FillBuffer(1);
-
-        MaskResampleFilterType::Pointer maskImResampler = MaskResampleFilterType::New();
-        maskImResampler->SetTransform(trsf);
-        maskImResampler->SetSize(outputRegion.GetSize());
-        maskImResampler->SetOutputOrigin(origin);
-        maskImResampler->SetOutputSpacing(outputImage->GetSpacing());
-        maskImResampler->SetOutputDirection(outputImage->GetDirection());
-        maskImResampler->SetInput(tmpMask);
-        maskImResampler->SetNumberOfThreads(nbpArg.getValue());
-        maskImResampler->Update();
-
-        MaskImageIteratorType outputMaskItr(maskImage,maskImage->GetLargestPossibleRegion());
-        ImageIteratorType trsfMaskItr(maskImResampler->GetOutput(),maskImage->GetLargestPossibleRegion());
-
-        while (!outputMaskItr.IsAtEnd())
-        {
-            if (trsfMaskItr.Get() > 0)
-                outputMaskItr.Set(outputMaskItr.Get() + 1);
-
-            ++trsfMaskItr;
-            ++outputMaskItr;
-        }
-    }
-
-    // Finally divide by the number of images at each pixel
-    ImageIteratorType outItr(outputImage,outputImage->GetLargestPossibleRegion());
-    MaskImageIteratorType maskItr(maskImage,maskImage->GetLargestPossibleRegion());
-    while (!outItr.IsAtEnd())
-    {
-        if (maskItr.Get() != 0)
-            outItr.Set(outItr.Get() / maskItr.Get());
-        else
-            outItr.Set(0);
-
-        ++outItr;
-        ++maskItr;
+        blender.AddTile(input,trsf);
     }
 
-    anima::writeImage <ImageType> (outArg.getValue(),outputImage);
+    anima::writeImage <ImageType> (outArg.getValue(),blender.GetMosaic());
 
     if (outMaskArg.getValue() != "")
-        anima::writeImage <MaskImageType> (outMaskArg.getValue(),maskImage);
+        anima::writeImage <BlenderType::CountImageType> (outMaskArg.getValue(),blender.GetCoverageImage());
 
     return EXIT_SUCCESS;
 }
@@ -1,6 +1,5 @@
 #include <tclap/CmdLine.h>
 
-#include <itkDisplacementFieldJacobianDeterminantFilter.h>
 #include <animaJacobianMatrixImageFilter.h>
 #include <animaReadWriteFunctions.h>
 #include <animaVelocityUtils.h>
@@ -17,6 +16,7 @@ int main(int ac, const char** av)
     TCLAP::SwitchArg svfArg("S","svf","Compute the exponential of the input SVF",cmd,false);
     TCLAP::SwitchArg noIdArg("N","no-id","Do not add identity to the jacobian matrix",cmd,false);
     TCLAP::SwitchArg detArg("D","det","Simply compute the determinant of the jacobian (-N option ignored in that case)",cmd,false);
+    TCLAP::SwitchArg logDetArg("L","log-det","Simply compute the log-determinant of the jacobian (-N option ignored in that case)",cmd,false);
     TCLAP::ValueArg<unsigned int> nbpArg("p","numberofthreads","Number of threads to run on (default: all cores)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
     
     try
@@ -50,33 +50,23 @@ int main(int ac, const char** av)
         inputField = const_cast <ImageType *> (resTrsf->GetParametersAsVectorField());
     }
 
-    if (detArg.isSet())
-    {
-        typedef itk::DisplacementFieldJacobianDeterminantFilter <ImageType, double> MainFilterType;
-        MainFilterType::Pointer mainFilter = MainFilterType::New();
+    typedef anima::JacobianMatrixImageFilter <PixelType, PixelType, Dimension> MainFilterType;
+    MainFilterType::Pointer mainFilter = MainFilterType::New();
 
-        mainFilter->SetInput(inputField);
-        mainFilter->SetNumberOfThreads(nbpArg.getValue());
-        mainFilter->SetUseImageSpacingOn();
+    mainFilter->SetInput(inputField);
+    mainFilter->SetNumberOfThreads(nbpArg.getValue());
+    mainFilter->SetNeighborhood(neighArg.getValue());
+    mainFilter->SetNoIdentity(noIdArg.isSet());
+    mainFilter->SetComputeDeterminant(detArg.isSet() || logDetArg.isSet());
 
-        mainFilter->Update();
+    mainFilter->Update();
 
-        anima::writeImage <MainFilterType::OutputImageType> (outArg.getValue(),mainFilter->GetOutput());
-    }
+    if (logDetArg.isSet())
+        anima::writeImage <MainFilterType::DeterminantImageType> (outArg.getValue(),mainFilter->GetLogDeterminantImage());
+    else if (detArg.isSet())
+        anima::writeImage <MainFilterType::DeterminantImageType> (outArg.getValue(),mainFilter->GetDeterminantImage());
     else
-    {
-        typedef anima::JacobianMatrixImageFilter <PixelType, PixelType, Dimension> MainFilterType;
-        MainFilterType::Pointer mainFilter = MainFilterType::New();
-
-        mainFilter->SetInput(inputField);
-        mainFilter->SetNumberOfThreads(nbpArg.getValue());
-        mainFilter->SetNeighborhood(neighArg.getValue());
-        mainFilter->SetNoIdentity(noIdArg.isSet());
-
-        mainFilter->Update();
-
         anima::writeImage <MainFilterType::OutputImageType> (outArg.getValue(),mainFilter->GetOutput());
-    }
 
     return 0;
 }
@@ -44,9 +44,6 @@ public:
     void SetOutlierRejectionSigma(double sigma) {m_OutlierRejectionSigma = sigma;}
     double GetOutlierRejectionSigma() {return m_OutlierRejectionSigma;}
 
-    void SetNumberOfThreads(unsigned int num) {m_NumberOfThreads = num;}
-    unsigned int GetNumberOfThreads() {return m_NumberOfThreads;}
-
     void SetBlockDamWeights(WeightImagePointer &damWeights) {m_BlockDamWeights = damWeights;}
     WeightImagePointer &GetBlockDamWeights() {return m_BlockDamWeights;}
 
@@ -70,7 +67,6 @@ protected:
     VelocityFieldSpacingType m_Spacing;
     VelocityFieldDirectionType m_Direction;
 
-    unsigned int m_NumberOfThreads;
     WeightImagePointer m_BlockDamWeights;
 
 private:
@@ -18,8 +18,6 @@ BalooSVFTransformAgregator() : Superclass()
 {
     m_ExtrapolationSigma = 4.0;
     m_OutlierRejectionSigma = 3.0;
-
-    m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 template <unsigned int NDimensions>
@@ -305,7 +303,7 @@ estimateSVFFromAffineTransforms()
 
         MatrixLoggerFilterType *logFilter = new MatrixLoggerFilterType;
         logFilter->SetInput(this->GetInputTransforms());
-        logFilter->SetNumberOfThreads(m_NumberOfThreads);
+        logFilter->SetNumberOfThreads(this->GetNumberOfThreads());
         logFilter->SetUseRigidTransforms(false);
 
         logFilter->Update();
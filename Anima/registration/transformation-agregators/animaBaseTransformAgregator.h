@@ -8,6 +8,9 @@
 #include <itkMatrixOffsetTransformBase.h>
 #include <itkImage.h>
 #include <itkPoint.h>
+#include <itkMultiThreader.h>
+
+#include <animaWeightedPairingsMoments.h>
 
 namespace anima
 {
@@ -16,6 +19,7 @@ template <unsigned int NDimensions = 3>
 class BaseTransformAgregator
 {
 public:
+    typedef BaseTransformAgregator Self;
     typedef double ScalarType;
     typedef double InternalScalarType;
     typedef itk::Transform<InternalScalarType,NDimensions,NDimensions> BaseInputTransformType;
@@ -75,6 +79,9 @@ public:
 
     void SetUpToDate(bool value) {m_UpToDate = value;}
 
+    void SetNumberOfThreads(unsigned int value) {m_NumberOfThreads = value;}
+    unsigned int GetNumberOfThreads() {return m_NumberOfThreads;}
+
     void SetVerboseAgregation(bool value) {m_VerboseAgregation = value;}
     bool GetVerboseAgregation() {return m_VerboseAgregation;}
 
@@ -88,6 +95,30 @@ public:
 protected:
     void SetOutput(BaseOutputTransformType *output);
 
+    typedef itk::MatrixOffsetTransformBase <ScalarType,NDimensions,NDimensions> MatrixTransformType;
+    typedef anima::WeightedPairingsMoments <InternalScalarType,ScalarType,NDimensions> PairingsMomentsType;
+
+    //! Squared distances between transformed origins and transformed points, computed in parallel
+    void ComputeSquaredResiduals(MatrixTransformType *trsf, const std::vector <PointType> &originPoints,
+                                 const std::vector <PointType> &transformedPoints, std::vector <double> &residuals);
+
+    //! Weighted moments of all pairings, accumulated in parallel
+    void ComputePairingsMoments(const std::vector <PointType> &originPoints, const std::vector <PointType> &transformedPoints,
+                                const std::vector <InternalScalarType> &weights, PairingsMomentsType &moments);
+
+    struct ThreadedPairingsData
+    {
+        MatrixTransformType *Transform;
+        const std::vector <PointType> *OriginPoints;
+        const std::vector <PointType> *TransformedPoints;
+        const std::vector <InternalScalarType> *Weights;
+        std::vector <double> *Residuals;
+        std::vector <PairingsMomentsType> *ThreadMoments;
+    };
+
+    static ITK_THREAD_RETURN_TYPE ThreadedResiduals(void *arg);
+    static ITK_THREAD_RETURN_TYPE ThreadedMoments(void *arg);
+
 private:
     std::vector <BaseInputTransformPointer> m_InputTransforms;
     std::vector <PointType> m_InputOrigins;
@@ -95,6 +126,7 @@ private:
 
     bool m_UpToDate;
     bool m_VerboseAgregation;
+    unsigned int m_NumberOfThreads;
 
     typename BaseOutputTransformType::Pointer m_Output;
 
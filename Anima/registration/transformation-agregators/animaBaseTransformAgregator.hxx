@@ -13,6 +13,7 @@ BaseTransformAgregator()
     m_Output = NULL;
     m_UpToDate = false;
     m_VerboseAgregation = true;
+    m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
 
     m_InputTransforms.clear();
     m_InputOrigins.clear();
@@ -92,4 +93,119 @@ SetInputTransforms(std::vector <BaseInputTransformPointer> &inputTransforms)
     m_UpToDate = false;
 }
 
+template <unsigned int NDimensions>
+void
+BaseTransformAgregator <NDimensions>::
+ComputeSquaredResiduals(MatrixTransformType *trsf, const std::vector <PointType> &originPoints,
+                        const std::vector <PointType> &transformedPoints, std::vector <double> &residuals)
+{
+    residuals.resize(originPoints.size());
+
+    ThreadedPairingsData tmpStr;
+    tmpStr.Transform = trsf;
+    tmpStr.OriginPoints = &originPoints;
+    tmpStr.TransformedPoints = &transformedPoints;
+    tmpStr.Weights = NULL;
+    tmpStr.Residuals = &residuals;
+    tmpStr.ThreadMoments = NULL;
+
+    itk::MultiThreader::Pointer threadWorker = itk::MultiThreader::New();
+    threadWorker->SetNumberOfThreads(m_NumberOfThreads);
+    threadWorker->SetSingleMethod(this->ThreadedResiduals,&tmpStr);
+    threadWorker->SingleMethodExecute();
+}
+
+template <unsigned int NDimensions>
+ITK_THREAD_RETURN_TYPE
+BaseTransformAgregator <NDimensions>::
+ThreadedResiduals(void *arg)
+{
+    itk::MultiThreader::ThreadInfoStruct *threadArgs = (itk::MultiThreader::ThreadInfoStruct *)arg;
+    ThreadedPairingsData *data = (ThreadedPairingsData *)threadArgs->UserData;
+
+    unsigned int nbPts = data->OriginPoints->size();
+    unsigned int startIndex = (unsigned int)((unsigned long)threadArgs->ThreadID * nbPts / threadArgs->NumberOfThreads);
+    unsigned int endIndex = (unsigned int)((unsigned long)(threadArgs->ThreadID + 1) * nbPts / threadArgs->NumberOfThreads);
+
+    typename MatrixTransformType::MatrixType matrix = data->Transform->GetMatrix();
+    typename MatrixTransformType::OutputVectorType offset = data->Transform->GetOffset();
+
+    for (unsigned int i = startIndex;i < endIndex;++i)
+    {
+        const PointType &originPoint = (*data->OriginPoints)[i];
+        const PointType &transformedPoint = (*data->TransformedPoints)[i];
+
+        double residualValue = 0;
+        for (unsigned int j = 0;j < NDimensions;++j)
+        {
+            double diffValue = offset[j] - transformedPoint[j];
+            for (unsigned int k = 0;k < NDimensions;++k)
+                diffValue += matrix(j,k) * originPoint[k];
+
+            residualValue += diffValue * diffValue;
+        }
+
+        (*data->Residuals)[i] = residualValue;
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+}
+
+template <unsigned int NDimensions>
+void
+BaseTransformAgregator <NDimensions>::
+ComputePairingsMoments(const std::vector <PointType> &originPoints, const std::vector <PointType> &transformedPoints,
+                       const std::vector <InternalScalarType> &weights, PairingsMomentsType &moments)
+{
+    if (originPoints.size() == 0)
+    {
+        moments.Reset();
+        return;
+    }
+
+    // Each thread accumulates relative to the same reference points, so that partial moments can be merged
+    moments.Reset(originPoints[0],transformedPoints[0]);
+    std::vector <PairingsMomentsType> threadMoments(m_NumberOfThreads,moments);
+
+    ThreadedPairingsData tmpStr;
+    tmpStr.Transform = NULL;
+    tmpStr.OriginPoints = &originPoints;
+    tmpStr.TransformedPoints = &transformedPoints;
+    tmpStr.Weights = &weights;
+    tmpStr.Residuals = NULL;
+    tmpStr.ThreadMoments = &threadMoments;
+
+    itk::MultiThreader::Pointer threadWorker = itk::MultiThreader::New();
+    threadWorker->SetNumberOfThreads(m_NumberOfThreads);
+    threadWorker->SetSingleMethod(this->ThreadedMoments,&tmpStr);
+    threadWorker->SingleMethodExecute();
+
+    for (unsigned int i = 0;i < threadMoments.size();++i)
+        moments.Merge(threadMoments[i]);
+}
+
+template <unsigned int NDimensions>
+ITK_THREAD_RETURN_TYPE
+BaseTransformAgregator <NDimensions>::
+ThreadedMoments(void *arg)
+{
+    itk::MultiThreader::ThreadInfoStruct *threadArgs = (itk::MultiThreader::ThreadInfoStruct *)arg;
+    ThreadedPairingsData *data = (ThreadedPairingsData *)threadArgs->UserData;
+
+    unsigned int nbPts = data->OriginPoints->size();
+    unsigned int startIndex = (unsigned int)((unsigned long)threadArgs->ThreadID * nbPts / threadArgs->NumberOfThreads);
+    unsigned int endIndex = (unsigned int)((unsigned long)(threadArgs->ThreadID + 1) * nbPts / threadArgs->NumberOfThreads);
+
+    PairingsMomentsType &moments = (*data->ThreadMoments)[threadArgs->ThreadID];
+    for (unsigned int i = startIndex;i < endIndex;++i)
+    {
+        if ((*data->Weights)[i] <= 0)
+            continue;
+
+        moments.AddPairing((*data->OriginPoints)[i],(*data->TransformedPoints)[i],(*data->Weights)[i]);
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+}
+
 } // end of namespace anima
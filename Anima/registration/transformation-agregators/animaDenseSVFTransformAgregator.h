@@ -42,8 +42,6 @@ public:
     void SetExtrapolationSigma(double sigma) {m_ExtrapolationSigma = sigma;}
     void SetOutlierRejectionSigma(double sigma) {m_OutlierRejectionSigma = sigma;}
 
-    void SetNumberOfThreads(unsigned int num) {m_NumberOfThreads = num;}
-
     void SetNeighborhoodHalfSize(unsigned int num) {m_NeighborhoodHalfSize = num;}
     void SetDistanceBoundary(double num) {m_DistanceBoundary = num;}
     void SetMEstimateConvergenceThreshold(double num) {m_MEstimateConvergenceThreshold = num;}
@@ -74,7 +72,6 @@ protected:
     VelocityFieldSpacingType m_Spacing;
     VelocityFieldDirectionType m_Direction;
 
-    unsigned int m_NumberOfThreads;
     WeightImagePointer m_BlockDamWeights;
 
 private:
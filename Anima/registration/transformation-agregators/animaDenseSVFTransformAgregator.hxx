@@ -23,8 +23,6 @@ DenseSVFTransformAgregator() : Superclass()
     m_NeighborhoodHalfSize = (unsigned int)floor(m_ExtrapolationSigma * 3);
     m_DistanceBoundary = m_ExtrapolationSigma * 3;
     m_MEstimateConvergenceThreshold = 0.001;
-
-    m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 template <unsigned int NDimensions>
@@ -142,7 +140,7 @@ estimateSVFFromTranslations()
     fieldSmoother->SetConvergenceThreshold(m_MEstimateConvergenceThreshold);
     fieldSmoother->SetMaxNumIterations(100);
 
-    fieldSmoother->SetNumberOfThreads(m_NumberOfThreads);
+    fieldSmoother->SetNumberOfThreads(this->GetNumberOfThreads());
 
     fieldSmoother->Update();
 
@@ -228,7 +226,7 @@ estimateSVFFromRigidTransforms()
     fieldSmoother->SetConvergenceThreshold(m_MEstimateConvergenceThreshold);
     fieldSmoother->SetMaxNumIterations(100);
 
-    fieldSmoother->SetNumberOfThreads(m_NumberOfThreads);
+    fieldSmoother->SetNumberOfThreads(this->GetNumberOfThreads());
 
     fieldSmoother->Update();
 
@@ -345,7 +343,7 @@ estimateSVFFromAffineTransforms()
 
         MatrixLoggerFilterType *logFilter = new MatrixLoggerFilterType;
         logFilter->SetInput(this->GetInputTransforms());
-        logFilter->SetNumberOfThreads(m_NumberOfThreads);
+        logFilter->SetNumberOfThreads(this->GetNumberOfThreads());
         logFilter->SetUseRigidTransforms(false);
 
         logFilter->Update();
@@ -393,7 +391,7 @@ estimateSVFFromAffineTransforms()
     fieldSmoother->SetConvergenceThreshold(m_MEstimateConvergenceThreshold);
     fieldSmoother->SetMaxNumIterations(100);
 
-    fieldSmoother->SetNumberOfThreads(m_NumberOfThreads);
+    fieldSmoother->SetNumberOfThreads(this->GetNumberOfThreads());
 
     fieldSmoother->Update();
 
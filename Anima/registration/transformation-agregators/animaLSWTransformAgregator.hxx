@@ -169,7 +169,8 @@ lswEstimateAnyToAffine()
     unsigned int nbPts = this->GetInputTransforms().size();
 
     std::vector < vnl_matrix <InternalScalarType> > logTransformations(nbPts);
-    vnl_matrix <InternalScalarType> tmpMatrix(NDimensions+1,NDimensions+1,0);
+    vnl_matrix_fixed <InternalScalarType,NDimensions+1,NDimensions+1> tmpMatrix;
+    tmpMatrix.fill(0);
     tmpMatrix(NDimensions,NDimensions) = 1;
     typename BaseMatrixTransformType::MatrixType affinePart;
     itk::Vector <InternalScalarType,NDimensions> offsetPart;
@@ -189,7 +190,7 @@ lswEstimateAnyToAffine()
                     tmpMatrix(j,k) = affinePart(j,k);
             }
 
-            logTransformations[i] = anima::GetLogarithm(tmpMatrix);
+            logTransformations[i] = anima::GetLogarithm(tmpMatrix).as_ref();
             if (std::isnan(logTransformations[i](0,0)))
             {
                 logTransformations[i].fill(0);
@@ -6,11 +6,6 @@
 namespace anima
 {
 
-struct errors_pair_comparator {
-    bool operator() (const std::pair<unsigned int, double> & f, const std::pair<unsigned int, double> & s)
-    {	return f.second < s.second; }
-};
-
 template <unsigned int NDimensions = 3>
 class LTSWTransformAgregator :
 public BaseTransformAgregator <NDimensions>
@@ -78,13 +78,30 @@ ltswEstimateTranslationsToAny()
         transformedPoints[i] = tmpDisp;
     }
 
-    std::vector <PointType> originPointsFiltered = originPoints;
-    std::vector <PointType> transformedPointsFiltered = transformedPoints;
-    std::vector <double> weightsFiltered = weights;
+    // Inliers are tracked with flags, their moments are updated when they enter or leave the trimmed set
+    std::vector <unsigned int> validIndexes;
+    for (unsigned int i = 0;i < nbPts;++i)
+    {
+        if (weights[i] > 0)
+            validIndexes.push_back(i);
+    }
+
+    unsigned int numValid = validIndexes.size();
+    unsigned int numLts = floor(numValid * m_LTSCut);
+    std::vector <bool> inlierFlags(nbPts,false);
+
+    typename Superclass::PairingsMomentsType moments;
+    if (nbPts > 0)
+        moments.Reset(originPoints[0],transformedPoints[0]);
 
-    std::vector < std::pair <unsigned int, double> > residualErrors;
-    PointType tmpOutPoint;
-    itk::Vector <double,3> tmpDiff;
+    for (unsigned int i = 0;i < numValid;++i)
+    {
+        moments.AddPairing(originPoints[validIndexes[i]],transformedPoints[validIndexes[i]],weights[validIndexes[i]]);
+        inlierFlags[validIndexes[i]] = true;
+    }
+
+    std::vector <double> residuals(nbPts);
+    std::vector < std::pair <double, unsigned int> > residualErrors(numValid);
 
     bool continueLoop = true;
     unsigned int numMaxIter = 100;
@@ -99,18 +116,15 @@ ltswEstimateTranslationsToAny()
         switch (this->GetOutputTransformType())
         {
             case Superclass::TRANSLATION:
-                anima::computeTranslationLSWFromTranslations<InternalScalarType,ScalarType,NDimensions>
-                        (originPointsFiltered,transformedPointsFiltered,weightsFiltered,resultTransform);
+                moments.ComputeTranslation(resultTransform);
                 break;
 
             case Superclass::RIGID:
-                anima::computeRigidLSWFromTranslations<InternalScalarType,ScalarType,NDimensions>
-                        (originPointsFiltered,transformedPointsFiltered,weightsFiltered,resultTransform);
+                moments.ComputeRigid(resultTransform);
                 break;
 
             case Superclass::AFFINE:
-                anima::computeAffineLSWFromTranslations<InternalScalarType,ScalarType,NDimensions>
-                        (originPointsFiltered,transformedPointsFiltered,weightsFiltered,resultTransform);
+                moments.ComputeAffine(resultTransform);
                 break;
 
             default:
@@ -124,33 +138,42 @@ ltswEstimateTranslationsToAny()
             break;
 
         resultTransformOld = resultTransform;
-        residualErrors.clear();
-        for (unsigned int i = 0;i < nbPts;++i)
-        {
-            if (weights[i] <= 0)
-                continue;
+        this->ComputeSquaredResiduals(resultTransform.GetPointer(),originPoints,transformedPoints,residuals);
 
-            tmpOutPoint = resultTransform->TransformPoint(originPoints[i]);
-            tmpDiff = tmpOutPoint - transformedPoints[i];
-            residualErrors.push_back(std::make_pair (i,tmpDiff.GetNorm()));
-        }
+        for (unsigned int i = 0;i < numValid;++i)
+            residualErrors[i] = std::make_pair(residuals[validIndexes[i]],validIndexes[i]);
 
-        unsigned int numLts = floor(residualErrors.size() * m_LTSCut);
+        if (numLts < numValid)
+            std::nth_element(residualErrors.begin(),residualErrors.begin() + numLts,residualErrors.end());
 
-        std::vector < std::pair <unsigned int, double> >::iterator begIt = residualErrors.begin();
-        std::vector < std::pair <unsigned int, double> >::iterator sortPart = begIt + numLts;
-
-        std::partial_sort(begIt,sortPart,residualErrors.end(),anima::errors_pair_comparator());
+        unsigned int numChanges = 0;
+        for (unsigned int i = 0;i < numValid;++i)
+        {
+            if ((i < numLts) != inlierFlags[residualErrors[i].second])
+                ++numChanges;
+        }
 
-        originPointsFiltered.resize(numLts);
-        transformedPointsFiltered.resize(numLts);
-        weightsFiltered.resize(numLts);
+        // Incremental updates only pay off while few pairings move in or out
+        bool rebuildMoments = (numChanges > numLts);
+        if (rebuildMoments)
+            moments.Reset();
 
-        for (unsigned int i = 0;i < numLts;++i)
+        for (unsigned int i = 0;i < numValid;++i)
         {
-            originPointsFiltered[i] = originPoints[residualErrors[i].first];
-            transformedPointsFiltered[i] = transformedPoints[residualErrors[i].first];
-            weightsFiltered[i] = weights[residualErrors[i].first];
+            unsigned int index = residualErrors[i].second;
+            bool isInlier = (i < numLts);
+
+            if (rebuildMoments)
+            {
+                if (isInlier)
+                    moments.AddPairing(originPoints[index],transformedPoints[index],weights[index]);
+            }
+            else if (isInlier && !inlierFlags[index])
+                moments.AddPairing(originPoints[index],transformedPoints[index],weights[index]);
+            else if (!isInlier && inlierFlags[index])
+                moments.RemovePairing(originPoints[index],transformedPoints[index],weights[index]);
+
+            inlierFlags[index] = isInlier;
         }
     }
 
@@ -176,7 +199,8 @@ ltswEstimateAnyToAffine()
     std::vector <InternalScalarType> weights = this->GetInputWeights();
 
     std::vector < vnl_matrix <InternalScalarType> > logTransformations(nbPts);
-    vnl_matrix <InternalScalarType> tmpMatrix(NDimensions+1,NDimensions+1,0), tmpLogMatrix(NDimensions+1,NDimensions+1,0);
+    vnl_matrix_fixed <InternalScalarType,NDimensions+1,NDimensions+1> tmpMatrix;
+    tmpMatrix.fill(0);
     tmpMatrix(NDimensions,NDimensions) = 1;
     typename BaseMatrixTransformType::MatrixType affinePart;
     itk::Vector <InternalScalarType, NDimensions> offsetPart;
@@ -196,11 +220,12 @@ ltswEstimateAnyToAffine()
                     tmpMatrix(j,k) = affinePart(j,k);
             }
 
-            logTransformations[i] = anima::GetLogarithm(tmpMatrix);
+            logTransformations[i] = anima::GetLogarithm(tmpMatrix).as_ref();
             if (!std::isfinite(logTransformations[i](0,0)))
             {
                 logTransformations[i].fill(0);
                 this->SetInputWeight(i,0);
+                weights[i] = 0;
             }
         }
         else
@@ -210,9 +235,6 @@ ltswEstimateAnyToAffine()
         }
     }
 
-    std::vector < vnl_matrix <InternalScalarType> > logTransformationsFiltered = logTransformations;
-    std::vector <InternalScalarType> weightsFiltered = weights;
-
     // For LTS
     std::vector < PointType > originPoints(nbPts);
     std::vector < PointType > transformedPoints(nbPts);
@@ -226,7 +248,28 @@ ltswEstimateAnyToAffine()
         transformedPoints[i] = tmpDisp;
     }
 
-    std::vector < std::pair <unsigned int, double> > residualErrors;
+    // Weighted sum of inlier logarithms, updated when pairings enter or leave the trimmed set
+    std::vector <unsigned int> validIndexes;
+    vnl_matrix <InternalScalarType> logSum(NDimensions+1,NDimensions+1,0), logAverage(NDimensions+1,NDimensions+1);
+    double sumWeights = 0;
+    for (unsigned int i = 0;i < nbPts;++i)
+    {
+        if (weights[i] <= 0)
+            continue;
+
+        validIndexes.push_back(i);
+        logSum += weights[i] * logTransformations[i];
+        sumWeights += weights[i];
+    }
+
+    unsigned int numValid = validIndexes.size();
+    unsigned int numLts = floor(numValid * m_LTSCut);
+    std::vector <bool> inlierFlags(nbPts,false);
+    for (unsigned int i = 0;i < numValid;++i)
+        inlierFlags[validIndexes[i]] = true;
+
+    std::vector <double> residuals(nbPts);
+    std::vector < std::pair <double, unsigned int> > residualErrors(numValid);
 
     bool continueLoop = true;
     unsigned int numMaxIter = 100;
@@ -238,45 +281,39 @@ ltswEstimateAnyToAffine()
     {
         ++num_itr;
 
-        anima::computeLogEuclideanAverage<InternalScalarType,ScalarType,NDimensions>(logTransformationsFiltered,weightsFiltered,resultTransform);
+        logAverage = logSum / sumWeights;
+        anima::computeAffineFromLogarithm<InternalScalarType,ScalarType,NDimensions>(logAverage,resultTransform);
         continueLoop = endLTSCondition(resultTransformOld,resultTransform);
 
         if (!continueLoop)
             break;
 
         resultTransformOld = resultTransform;
-        residualErrors.clear();
+        this->ComputeSquaredResiduals(resultTransform.GetPointer(),originPoints,transformedPoints,residuals);
 
-        BaseMatrixTransformType *tmpTrsf = (BaseMatrixTransformType *)resultTransform.GetPointer();
+        for (unsigned int i = 0;i < numValid;++i)
+            residualErrors[i] = std::make_pair(residuals[validIndexes[i]],validIndexes[i]);
 
-        for (unsigned int i = 0;i < nbPts;++i)
-        {
-            if (weights[i] <= 0)
-                continue;
-
-            double tmpDiff = 0;
-            PointType tmpDisp = tmpTrsf->TransformPoint(originPoints[i]);
+        if (numLts < numValid)
+            std::nth_element(residualErrors.begin(),residualErrors.begin() + numLts,residualErrors.end());
 
-            for (unsigned int j = 0;j < NDimensions;++j)
-                tmpDiff += (transformedPoints[i][j] - tmpDisp[j]) * (transformedPoints[i][j] - tmpDisp[j]);
-
-            residualErrors.push_back(std::make_pair (i,tmpDiff));
-        }
-
-        unsigned int numLts = floor(residualErrors.size() * m_LTSCut);
-
-        std::vector < std::pair <unsigned int, double> >::iterator begIt = residualErrors.begin();
-        std::vector < std::pair <unsigned int, double> >::iterator sortPart = begIt + numLts;
-
-        std::partial_sort(begIt,sortPart,residualErrors.end(),anima::errors_pair_comparator());
+        for (unsigned int i = 0;i < numValid;++i)
+        {
+            unsigned int index = residualErrors[i].second;
+            bool isInlier = (i < numLts);
 
-        logTransformationsFiltered.resize(numLts);
-        weightsFiltered.resize(numLts);
+            if (isInlier && !inlierFlags[index])
+            {
+                logSum += weights[index] * logTransformations[index];
+                sumWeights += weights[index];
+            }
+            else if (!isInlier && inlierFlags[index])
+            {
+                logSum -= weights[index] * logTransformations[index];
+                sumWeights -= weights[index];
+            }
 
-        for (unsigned int i = 0;i < numLts;++i)
-        {
-            logTransformationsFiltered[i] = logTransformations[residualErrors[i].first];
-            weightsFiltered[i] = weights[residualErrors[i].first];
+            inlierFlags[index] = isInlier;
         }
     }
 
@@ -77,12 +77,9 @@ mestEstimateTranslationsToAny()
     }
 
     std::vector <double> weightsFiltered = weights;
+    typename Superclass::PairingsMomentsType moments;
 
-    std::vector < double > residualErrors;
-    std::vector < double > mestWeights(nbPts,1);
-
-    PointType tmpOutPoint;
-    itk::Vector <double,3> tmpDiff;
+    std::vector < double > residualErrors(nbPts);
 
     bool continueLoop = true;
     unsigned int numMaxIter = 100;
@@ -95,21 +92,20 @@ mestEstimateTranslationsToAny()
     {
         ++num_itr;
 
+        this->ComputePairingsMoments(originPoints,transformedPoints,weightsFiltered,moments);
+
         switch (this->GetOutputTransformType())
         {
             case Superclass::TRANSLATION:
-                anima::computeTranslationLSWFromTranslations<InternalScalarType,ScalarType,NDimensions>
-                        (originPoints,transformedPoints,weightsFiltered,resultTransform);
+                moments.ComputeTranslation(resultTransform);
                 break;
 
             case Superclass::RIGID:
-                anima::computeRigidLSWFromTranslations<InternalScalarType,ScalarType,NDimensions>
-                        (originPoints,transformedPoints,weightsFiltered,resultTransform);
+                moments.ComputeRigid(resultTransform);
                 break;
 
             case Superclass::AFFINE:
-                anima::computeAffineLSWFromTranslations<InternalScalarType,ScalarType,NDimensions>
-                        (originPoints,transformedPoints,weightsFiltered,resultTransform);
+                moments.ComputeAffine(resultTransform);
                 break;
 
             default:
@@ -123,43 +119,35 @@ mestEstimateTranslationsToAny()
             break;
 
         resultTransformOld = resultTransform;
-        residualErrors.clear();
-        for (unsigned int i = 0;i < nbPts;++i)
-        {
-            if (weights[i] <= 0)
-                continue;
-
-            tmpOutPoint = resultTransform->TransformPoint(originPoints[i]);
-            tmpDiff = tmpOutPoint - transformedPoints[i];
-            double tmpRes = tmpDiff.GetNorm();
-            residualErrors.push_back(tmpRes * tmpRes);
-        }
+        this->ComputeSquaredResiduals(resultTransform.GetPointer(),originPoints,transformedPoints,residualErrors);
 
         if (num_itr == 1)
         {
             // At first iteration, compute factor for M-estimation
             double averageDist = 0;
-            for (unsigned int i = 0;i < residualErrors.size();++i)
+            unsigned int numValid = 0;
+            for (unsigned int i = 0;i < nbPts;++i)
+            {
+                if (weights[i] <= 0)
+                    continue;
+
                 averageDist += residualErrors[i];
+                ++numValid;
+            }
 
-            averageResidualValue = averageDist / residualErrors.size();
+            averageResidualValue = averageDist / numValid;
 
             if (averageResidualValue <= 0)
                 averageResidualValue = 1;
         }
 
-        unsigned int residualIndex = 0;
         for (unsigned int i = 0;i < nbPts;++i)
         {
             if (weights[i] <= 0)
                 continue;
 
-            mestWeights[i] = exp(- residualErrors[residualIndex] / (averageResidualValue * m_MEstimateFactor));
-            ++residualIndex;
+            weightsFiltered[i] = weights[i] * exp(- residualErrors[i] / (averageResidualValue * m_MEstimateFactor));
         }
-
-        for (unsigned int i = 0;i < nbPts;++i)
-            weightsFiltered[i] = weights[i] * mestWeights[i];
     }
 
     this->SetOutput(resultTransform);
@@ -184,7 +172,8 @@ mestEstimateAnyToAffine()
     std::vector <InternalScalarType> weights = this->GetInputWeights();
 
     std::vector < vnl_matrix <InternalScalarType> > logTransformations(nbPts);
-    vnl_matrix <InternalScalarType> tmpMatrix(NDimensions+1,NDimensions+1,0), tmpLogMatrix(NDimensions+1,NDimensions+1,0);
+    vnl_matrix_fixed <InternalScalarType,NDimensions+1,NDimensions+1> tmpMatrix;
+    tmpMatrix.fill(0);
     tmpMatrix(NDimensions,NDimensions) = 1;
     typename BaseMatrixTransformType::MatrixType affinePart;
     itk::Vector <InternalScalarType, NDimensions> offsetPart;
@@ -204,7 +193,7 @@ mestEstimateAnyToAffine()
                     tmpMatrix(j,k) = affinePart(j,k);
             }
 
-            logTransformations[i] = anima::GetLogarithm(tmpMatrix);
+            logTransformations[i] = anima::GetLogarithm(tmpMatrix).as_ref();
             if (!std::isfinite(logTransformations[i](0,0)))
             {
                 logTransformations[i].fill(0);
@@ -233,8 +222,7 @@ mestEstimateAnyToAffine()
         transformedPoints[i] = tmpDisp;
     }
 
-    std::vector < double > residualErrors;
-    std::vector < double > mestWeights(nbPts,1);
+    std::vector < double > residualErrors(nbPts);
 
     bool continueLoop = true;
     unsigned int numMaxIter = 100;
@@ -254,49 +242,35 @@ mestEstimateAnyToAffine()
             break;
 
         resultTransformOld = resultTransform;
-        residualErrors.clear();
-
-        BaseMatrixTransformType *tmpTrsf = (BaseMatrixTransformType *)resultTransform.GetPointer();
-
-        for (unsigned int i = 0;i < nbPts;++i)
-        {
-            if (weights[i] <= 0)
-                continue;
-
-            double tmpDiff = 0;
-            PointType tmpDisp = tmpTrsf->TransformPoint(originPoints[i]);
-
-            for (unsigned int j = 0;j < NDimensions;++j)
-                tmpDiff += (transformedPoints[i][j] - tmpDisp[j]) * (transformedPoints[i][j] - tmpDisp[j]);
-
-            residualErrors.push_back(tmpDiff);
-        }
+        this->ComputeSquaredResiduals(resultTransform.GetPointer(),originPoints,transformedPoints,residualErrors);
 
         if (num_itr == 1)
         {
             // At first iteration, compute factor for M-estimation
             double averageDist = 0;
-            for (unsigned int i = 0;i < residualErrors.size();++i)
+            unsigned int numValid = 0;
+            for (unsigned int i = 0;i < nbPts;++i)
+            {
+                if (weights[i] <= 0)
+                    continue;
+
                 averageDist += residualErrors[i];
+                ++numValid;
+            }
+
+            averageResidualValue = averageDist / numValid;
 
-            averageResidualValue = averageDist / residualErrors.size();
-            
             if (averageResidualValue <= 0)
                 averageResidualValue = 1;
         }
 
-        unsigned int residualIndex = 0;
         for (unsigned int i = 0;i < nbPts;++i)
         {
             if (weights[i] <= 0)
                 continue;
 
-            mestWeights[i] = exp(- residualErrors[residualIndex] / (averageResidualValue * m_MEstimateFactor));
-            ++residualIndex;
+            weightsFiltered[i] = weights[i] * exp(- residualErrors[i] / (averageResidualValue * m_MEstimateFactor));
         }
-
-        for (unsigned int i = 0;i < nbPts;++i)
-            weightsFiltered[i] = weights[i] * mestWeights[i];
     }
 
     this->SetOutput(resultTransform);
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <itkObject.h>
+#include <itkMultiThreader.h>
+#include <itkImage.h>
+#include <itkContinuousIndex.h>
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <limits>
+
+namespace anima
+{
+
+/**
+ * @brief Label statistics engine for segmentation tools. In one threaded pass over the input image, it labels
+ * connected components of non zero voxels (union-find run independently on slabs along the last dimension,
+ * slabs being then stitched along their seams) while accumulating per component volume, bounding box, centroid
+ * and overlap with an optional comparison image, together with foreground volumes and their intersection.
+ * Per label value volumes and intersections with the comparison image (for Dice like measures) are accumulated
+ * on demand. Component labeling may be switched off when only label statistics are needed. Components may then
+ * be written to a label image ordered by decreasing volume.
+ * When a border mask is given, contour statistics are accumulated as well: contact with the border mask
+ * (mask voxels or mask contour). When a structure map is given, a last pass counts for each component the
+ * distinct voxels around it (in its dilation by a radius 1 ball, i.e. face and edge neighbors) and how many
+ * of them lie in the structure map. If the input is already a labeled image, each label value is one component.
+ */
+template <class TImage, class TMaskImage = TImage>
+class LabelStatisticsComputer : public itk::Object
+{
+public:
+    typedef itk::Object Superclass;
+    typedef LabelStatisticsComputer <TImage,TMaskImage> Self;
+    typedef itk::SmartPointer<Self> Pointer;
+    typedef itk::SmartPointer<const Self> ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self)
+
+    /** Run-time type information (and related methods) */
+    itkTypeMacro(LabelStatisticsComputer, itk::Object)
+
+    itkStaticConstMacro(ImageDimension, unsigned int, TImage::ImageDimension);
+
+    static_assert(std::numeric_limits <typename TImage::PixelType>::is_integer,
+                  "LabelStatisticsComputer requires an integral pixel type");
+
+    typedef TImage ImageType;
+    typedef typename ImageType::Pointer ImagePointer;
+    typedef typename ImageType::ConstPointer ImageConstPointer;
+    typedef typename ImageType::RegionType RegionType;
+    typedef typename ImageType::IndexType IndexType;
+    typedef typename ImageType::PixelType PixelType;
+
+    typedef TMaskImage MaskImageType;
+    typedef typename MaskImageType::ConstPointer MaskImageConstPointer;
+    typedef typename MaskImageType::PixelType MaskPixelType;
+
+    typedef itk::Image <unsigned int, ImageDimension> LabelImageType;
+    typedef typename LabelImageType::Pointer LabelImagePointer;
+
+    typedef itk::ContinuousIndex <double, ImageDimension> ContinuousIndexType;
+
+    struct ComponentStatistics
+    {
+        //! Volume in voxels
+        unsigned int volume;
+        //! Bounding box, as first and last voxel index along each dimension
+        IndexType minimum, maximum;
+        //! Centroid in voxel coordinates
+        ContinuousIndexType centroid;
+        //! Number of voxels of the component that are non zero in the comparison image
+        unsigned int overlap;
+        //! True if a voxel of the component lies on the border mask (or its contour)
+        bool touchesBorder;
+        //! Number of component voxels having a face neighbor outside of the component
+        unsigned int contourSize;
+        //! Number of distinct voxels outside of the component in its radius 1 ball dilation (needs a structure map)
+        unsigned int neighborSize;
+        //! Number of those outside voxels that are in the structure map
+        unsigned int structureNeighborSize;
+    };
+
+    void SetInputImage(const ImageType *image) {m_InputImage = image;}
+
+    //! Optional image compared to the input (overlap of components, label intersections)
+    void SetComparisonImage(const ImageType *image) {m_ComparisonImage = image;}
+
+    //! Optional, mask whose voxels (or contour voxels) mark components as touching the border
+    void SetBorderMask(const MaskImageType *mask) {m_BorderMask = mask;}
+
+    //! Optional, structure map against which voxels around components are checked
+    void SetStructureMap(const MaskImageType *map) {m_StructureMap = map;}
+
+    itkSetMacro(ComputeComponents, bool)
+    itkGetMacro(ComputeComponents, bool)
+
+    //! Accumulate volumes and comparison intersections per label value (off by default)
+    itkSetMacro(ComputeLabelStatistics, bool)
+    itkGetMacro(ComputeLabelStatistics, bool)
+
+    //! Use face, edge and vertex neighbors instead of face neighbors only
+    itkSetMacro(FullyConnected, bool)
+    itkGetMacro(FullyConnected, bool)
+
+    //! If true, each label value of the input is one component, whether connected or not
+    itkSetMacro(LabeledImage, bool)
+    itkGetMacro(LabeledImage, bool)
+
+    //! If true, only voxels of the border mask having a face neighbor outside of it mark components
+    itkSetMacro(UseBorderMaskContour, bool)
+    itkGetMacro(UseBorderMaskContour, bool)
+
+    itkSetMacro(NumberOfThreads, unsigned int)
+    itkGetMacro(NumberOfThreads, unsigned int)
+
+    void Update();
+
+    //! Components are numbered from 1, by raster order of their first voxel
+    unsigned int GetNumberOfComponents() {return m_ComponentStatistics.size();}
+    const ComponentStatistics &GetComponentStatistics(unsigned int component) {return m_ComponentStatistics[component - 1];}
+
+    //! Number of components having at least minimalOverlap voxels in the comparison image
+    unsigned int GetNumberOfOverlappingComponents(unsigned int minimalOverlap = 1);
+
+    //! Label values present in the input image (0 excluded), sorted, needs ComputeLabelStatistics
+    const std::vector <PixelType> &GetLabelValues() {return m_LabelValues;}
+
+    //! Number of voxels with value label in the input image, in the comparison image, and in both, needs ComputeLabelStatistics
+    double GetLabelVolume(PixelType label);
+    double GetComparisonLabelVolume(PixelType label);
+    double GetLabelIntersection(PixelType label);
+
+    //! Non zero voxel counts in the input, the comparison image, and both
+    double GetForegroundVolume() {return m_ForegroundVolume;}
+    double GetComparisonForegroundVolume() {return m_ComparisonForegroundVolume;}
+    double GetForegroundIntersection() {return m_ForegroundIntersection;}
+
+    //! Physical volume of a voxel, a 4th dimension is not physical but temporal
+    double GetVoxelVolume();
+
+    //! Component index (from 1) of each voxel, 0 for the background
+    LabelImageType *GetLabelImage() {return m_LabelImage;}
+
+    /**
+     * Components image, labels ordered by decreasing volume (ties by raster order),
+     * components with less than minimalVolume voxels are removed
+     */
+    ImagePointer GetComponentsImage(unsigned int minimalVolume = 0);
+
+    static ITK_THREAD_RETURN_TYPE ThreadLabelStatistics(void *arg);
+
+protected:
+    LabelStatisticsComputer() : Superclass()
+    {
+        m_ComputeComponents = true;
+        m_ComputeLabelStatistics = false;
+        m_FullyConnected = false;
+        m_LabeledImage = false;
+        m_UseBorderMaskContour = true;
+        m_NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+        m_InputImage = NULL;
+        m_ComparisonImage = NULL;
+        m_BorderMask = NULL;
+        m_StructureMap = NULL;
+
+        m_ForegroundVolume = 0;
+        m_ComparisonForegroundVolume = 0;
+        m_ForegroundIntersection = 0;
+    }
+
+    virtual ~LabelStatisticsComputer() {}
+
+    //! Per slab data, component labels are local to the slab until stitching
+    struct SlabData
+    {
+        RegionType region;
+        std::vector <unsigned int> parents;
+        std::vector <ComponentStatistics> componentStatistics;
+        //! Slab label of each input value, for labeled images
+        std::map <PixelType, unsigned int> valueLabels;
+        std::map <PixelType, double> labelVolumes, comparisonLabelVolumes, labelIntersections;
+        double foregroundVolume, comparisonForegroundVolume, foregroundIntersection;
+        //! Outside neighbor counts of each component, from voxels of the slab
+        std::vector <unsigned int> neighborSizes, structureNeighborSizes;
+        unsigned int labelOffset;
+    };
+
+    enum ThreadPass
+    {
+        LABELING_PASS = 0,
+        FINALIZING_PASS,
+        NEIGHBORS_PASS,
+        OUTPUT_PASS
+    };
+
+    struct LabelStatisticsThreadStruct
+    {
+        Pointer Filter;
+        ThreadPass pass;
+        ImageType *output;
+    };
+
+    void SplitRegion(unsigned int numPieces);
+    void ComputeBackwardOffsets();
+    void ComputeFaceOffsets();
+    void ComputeDilationOffsets();
+
+    //! Global label merges across slabs, by seam neighbors or by label value for labeled images
+    void StitchSlabs(std::vector <unsigned int> &globalParents);
+    void MergeLabelValues(std::vector <unsigned int> &globalParents);
+
+    //! Labels a slab and accumulates its statistics
+    void ProcessSlab(unsigned int slabIndex);
+
+    //! Replaces slab labels by global component indexes in the label image
+    void FinalizeSlab(unsigned int slabIndex);
+
+    //! Counts, for voxels of a slab, the distinct components having them in their dilation but not inside them
+    void CountOutsideNeighbors(unsigned int slabIndex);
+
+    //! Writes output labels of a slab to the output
+    void RelabelSlab(unsigned int slabIndex, ImageType *output);
+
+    //! Face neighbor statistics of a component voxel, linearIndex is in the input buffer
+    void AddContourVoxel(ComponentStatistics &statistics, const IndexType &index, long linearIndex, PixelType value);
+
+    //! Union-find helpers, the root is always the smallest label
+    static unsigned int FindRoot(std::vector <unsigned int> &parents, unsigned int label);
+    static void MergeLabels(std::vector <unsigned int> &parents, unsigned int firstLabel, unsigned int secondLabel);
+
+    static void AddVoxel(ComponentStatistics &statistics, const IndexType &index, bool overlapping);
+    static void MergeStatistics(ComponentStatistics &statistics, const ComponentStatistics &addedStatistics);
+
+    static bool CompareVolumes(const std::pair <unsigned int, unsigned int> &first,
+                               const std::pair <unsigned int, unsigned int> &second);
+
+private:
+    LabelStatisticsComputer(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+
+    ImageConstPointer m_InputImage;
+    ImageConstPointer m_ComparisonImage;
+    MaskImageConstPointer m_BorderMask;
+    MaskImageConstPointer m_StructureMap;
+
+    bool m_ComputeComponents;
+    bool m_ComputeLabelStatistics;
+    bool m_FullyConnected;
+    bool m_LabeledImage;
+    bool m_UseBorderMaskContour;
+    unsigned int m_NumberOfThreads;
+
+    //! Neighbors before a voxel in raster order
+    std::vector < itk::Offset <ImageDimension> > m_BackwardOffsets;
+
+    //! Face neighbors, and their offsets in the input buffer
+    std::vector < itk::Offset <ImageDimension> > m_FaceOffsets;
+    std::vector <long> m_FaceLinearOffsets;
+
+    //! Radius 1 ball neighbors (face and edge neighbors), and their offsets in the label image buffer
+    std::vector < itk::Offset <ImageDimension> > m_DilationOffsets;
+    std::vector <long> m_DilationLinearOffsets;
+
+    std::vector <SlabData> m_Slabs;
+    LabelImagePointer m_LabelImage;
+
+    //! Final component index (from 1) of each global provisional label
+    std::vector <unsigned int> m_ComponentIndexes;
+    std::vector <ComponentStatistics> m_ComponentStatistics;
+
+    //! Output label of each component, used when writing the components image
+    std::vector <unsigned int> m_OutputLabels;
+
+    std::vector <PixelType> m_LabelValues;
+    std::map <PixelType, double> m_LabelVolumes, m_ComparisonLabelVolumes, m_LabelIntersections;
+    double m_ForegroundVolume, m_ComparisonForegroundVolume, m_ForegroundIntersection;
+};
+
+} // end namespace anima
+
+#include "animaLabelStatisticsComputer.hxx"
@@ -0,0 +1,950 @@
+#pragma once
+#include "animaLabelStatisticsComputer.h"
+
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+
+#include <algorithm>
+
+namespace anima
+{
+
+template <class TImage, class TMaskImage>
+unsigned int
+LabelStatisticsComputer<TImage,TMaskImage>
+::FindRoot(std::vector <unsigned int> &parents, unsigned int label)
+{
+    while (parents[label] != label)
+    {
+        // Path halving
+        parents[label] = parents[parents[label]];
+        label = parents[label];
+    }
+
+    return label;
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::MergeLabels(std::vector <unsigned int> &parents, unsigned int firstLabel, unsigned int secondLabel)
+{
+    unsigned int firstRoot = FindRoot(parents,firstLabel);
+    unsigned int secondRoot = FindRoot(parents,secondLabel);
+
+    if (firstRoot < secondRoot)
+        parents[secondRoot] = firstRoot;
+    else if (secondRoot < firstRoot)
+        parents[firstRoot] = secondRoot;
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::AddVoxel(ComponentStatistics &statistics, const IndexType &index, bool overlapping)
+{
+    if (statistics.volume == 0)
+    {
+        statistics.minimum = index;
+        statistics.maximum = index;
+    }
+
+    ++statistics.volume;
+    for (unsigned int i = 0;i < ImageDimension;++i)
+    {
+        statistics.minimum[i] = std::min(statistics.minimum[i],index[i]);
+        statistics.maximum[i] = std::max(statistics.maximum[i],index[i]);
+        statistics.centroid[i] += index[i];
+    }
+
+    if (overlapping)
+        ++statistics.overlap;
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::MergeStatistics(ComponentStatistics &statistics, const ComponentStatistics &addedStatistics)
+{
+    statistics.volume += addedStatistics.volume;
+    for (unsigned int i = 0;i < ImageDimension;++i)
+    {
+        statistics.minimum[i] = std::min(statistics.minimum[i],addedStatistics.minimum[i]);
+        statistics.maximum[i] = std::max(statistics.maximum[i],addedStatistics.maximum[i]);
+        statistics.centroid[i] += addedStatistics.centroid[i];
+    }
+
+    statistics.overlap += addedStatistics.overlap;
+    statistics.touchesBorder = statistics.touchesBorder || addedStatistics.touchesBorder;
+    statistics.contourSize += addedStatistics.contourSize;
+    statistics.neighborSize += addedStatistics.neighborSize;
+    statistics.structureNeighborSize += addedStatistics.structureNeighborSize;
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::AddContourVoxel(ComponentStatistics &statistics, const IndexType &index, long linearIndex, PixelType value)
+{
+    const PixelType *inputBuffer = m_InputImage->GetBufferPointer();
+    const MaskPixelType *borderBuffer = m_BorderMask ? m_BorderMask->GetBufferPointer() : NULL;
+
+    IndexType bufferStart = m_InputImage->GetBufferedRegion().GetIndex();
+    IndexType bufferEnd = m_InputImage->GetBufferedRegion().GetUpperIndex();
+
+    bool onContour = false;
+    bool onBorderContour = false;
+    for (unsigned int i = 0;i < m_FaceOffsets.size();++i)
+    {
+        // Face offsets go by pairs along each dimension
+        unsigned int dimension = i / 2;
+        long neighborIndex = index[dimension] + m_FaceOffsets[i][dimension];
+        if ((neighborIndex < bufferStart[dimension])||(neighborIndex > bufferEnd[dimension]))
+            continue;
+
+        long neighborLinearIndex = linearIndex + m_FaceLinearOffsets[i];
+        if (borderBuffer && (borderBuffer[neighborLinearIndex] == 0))
+            onBorderContour = true;
+
+        PixelType neighborValue = inputBuffer[neighborLinearIndex];
+        bool outsideNeighbor = m_LabeledImage ? (neighborValue != value) : (neighborValue == 0);
+        if (outsideNeighbor)
+            onContour = true;
+    }
+
+    if (onContour)
+        ++statistics.contourSize;
+
+    if (borderBuffer && (borderBuffer[linearIndex] != 0) && (!m_UseBorderMaskContour || onBorderContour))
+        statistics.touchesBorder = true;
+}
+
+template <class TImage, class TMaskImage>
+bool
+LabelStatisticsComputer<TImage,TMaskImage>
+::CompareVolumes(const std::pair <unsigned int, unsigned int> &first,
+                 const std::pair <unsigned int, unsigned int> &second)
+{
+    if (first.first != second.first)
+        return first.first > second.first;
+
+    return first.second < second.second;
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::SplitRegion(unsigned int numPieces)
+{
+    RegionType region = m_InputImage->GetLargestPossibleRegion();
+    unsigned int splitDimension = ImageDimension - 1;
+    unsigned int splitSize = region.GetSize()[splitDimension];
+
+    if (numPieces > splitSize)
+        numPieces = splitSize;
+    if (numPieces == 0)
+        numPieces = 1;
+
+    m_Slabs.resize(numPieces);
+    for (unsigned int i = 0;i < numPieces;++i)
+    {
+        unsigned int startSplit = i * splitSize / numPieces;
+        unsigned int endSplit = (i + 1) * splitSize / numPieces;
+
+        m_Slabs[i].region = region;
+        m_Slabs[i].region.SetIndex(splitDimension,region.GetIndex()[splitDimension] + startSplit);
+        m_Slabs[i].region.SetSize(splitDimension,endSplit - startSplit);
+    }
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::ComputeBackwardOffsets()
+{
+    m_BackwardOffsets.clear();
+
+    unsigned int numOffsets = 1;
+    for (unsigned int i = 0;i < ImageDimension;++i)
+        numOffsets *= 3;
+
+    // A neighbor comes before the voxel in raster order if its last non zero offset is -1
+    for (unsigned int i = 0;i < numOffsets;++i)
+    {
+        itk::Offset <ImageDimension> offset;
+        unsigned int code = i;
+        unsigned int numNonZero = 0;
+        int lastNonZero = 0;
+        for (unsigned int j = 0;j < ImageDimension;++j)
+        {
+            offset[j] = (int)(code % 3) - 1;
+            code /= 3;
+
+            if (offset[j] != 0)
+            {
+                ++numNonZero;
+                lastNonZero = offset[j];
+            }
+        }
+
+        if (lastNonZero != -1)
+            continue;
+
+        if (!m_FullyConnected && (numNonZero != 1))
+            continue;
+
+        m_BackwardOffsets.push_back(offset);
+    }
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::ComputeFaceOffsets()
+{
+    m_FaceOffsets.clear();
+    m_FaceLinearOffsets.clear();
+
+    const typename ImageType::OffsetValueType *offsetTable = m_InputImage->GetOffsetTable();
+    for (unsigned int i = 0;i < ImageDimension;++i)
+    {
+        for (int j = -1;j <= 1;j += 2)
+        {
+            itk::Offset <ImageDimension> offset;
+            offset.Fill(0);
+            offset[i] = j;
+
+            m_FaceOffsets.push_back(offset);
+            m_FaceLinearOffsets.push_back(j * offsetTable[i]);
+        }
+    }
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::ComputeDilationOffsets()
+{
+    m_DilationOffsets.clear();
+    m_DilationLinearOffsets.clear();
+
+    unsigned int numOffsets = 1;
+    for (unsigned int i = 0;i < ImageDimension;++i)
+        numOffsets *= 3;
+
+    // Radius 1 ball as in itk::BinaryBallStructuringElement: neighbors with at most two non zero offsets
+    const typename LabelImageType::OffsetValueType *offsetTable = m_LabelImage->GetOffsetTable();
+    for (unsigned int i = 0;i < numOffsets;++i)
+    {
+        itk::Offset <ImageDimension> offset;
+        unsigned int code = i;
+        unsigned int numNonZero = 0;
+        long linearOffset = 0;
+        for (unsigned int j = 0;j < ImageDimension;++j)
+        {
+            offset[j] = (int)(code % 3) - 1;
+            code /= 3;
+
+            if (offset[j] != 0)
+                ++numNonZero;
+
+            linearOffset += offset[j] * offsetTable[j];
+        }
+
+        if ((numNonZero == 0)||(numNonZero > 2))
+            continue;
+
+        m_DilationOffsets.push_back(offset);
+        m_DilationLinearOffsets.push_back(linearOffset);
+    }
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::MergeLabelValues(std::vector <unsigned int> &globalParents)
+{
+    // Slab labels sharing a label value are one component
+    std::map <PixelType, unsigned int> globalValueLabels;
+    for (unsigned int i = 0;i < m_Slabs.size();++i)
+    {
+        SlabData &slab = m_Slabs[i];
+        typename std::map <PixelType, unsigned int>::iterator valueIt = slab.valueLabels.begin();
+        while (valueIt != slab.valueLabels.end())
+        {
+            unsigned int globalLabel = slab.labelOffset + valueIt->second;
+            typename std::map <PixelType, unsigned int>::iterator globalIt = globalValueLabels.find(valueIt->first);
+            if (globalIt == globalValueLabels.end())
+                globalValueLabels[valueIt->first] = globalLabel;
+            else
+                MergeLabels(globalParents,globalIt->second,globalLabel);
+
+            ++valueIt;
+        }
+
+        slab.valueLabels.clear();
+    }
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::StitchSlabs(std::vector <unsigned int> &globalParents)
+{
+    // First slice of each slab against the last slice of the previous one
+    RegionType largestRegion = m_InputImage->GetLargestPossibleRegion();
+    unsigned int splitDimension = ImageDimension - 1;
+    unsigned int *labelBuffer = m_LabelImage->GetBufferPointer();
+    const typename LabelImageType::OffsetValueType *offsetTable = m_LabelImage->GetOffsetTable();
+
+    std::vector < itk::Offset <ImageDimension> > seamOffsets;
+    std::vector <long> seamLinearOffsets;
+    for (unsigned int i = 0;i < m_BackwardOffsets.size();++i)
+    {
+        if (m_BackwardOffsets[i][splitDimension] != -1)
+            continue;
+
+        long linearOffset = 0;
+        for (unsigned int j = 0;j < ImageDimension;++j)
+            linearOffset += m_BackwardOffsets[i][j] * offsetTable[j];
+
+        seamOffsets.push_back(m_BackwardOffsets[i]);
+        seamLinearOffsets.push_back(linearOffset);
+    }
+
+    for (unsigned int i = 1;i < m_Slabs.size();++i)
+    {
+        RegionType seamRegion = m_Slabs[i].region;
+        if (seamRegion.GetSize()[splitDimension] == 0)
+            continue;
+
+        seamRegion.SetSize(splitDimension,1);
+
+        itk::ImageRegionConstIteratorWithIndex <LabelImageType> seamIt(m_LabelImage,seamRegion);
+        while (!seamIt.IsAtEnd())
+        {
+            unsigned int label = seamIt.Get();
+            if (label != 0)
+            {
+                IndexType index = seamIt.GetIndex();
+                long linearIndex = m_LabelImage->ComputeOffset(index);
+
+                for (unsigned int j = 0;j < seamOffsets.size();++j)
+                {
+                    bool insideImage = true;
+                    for (unsigned int k = 0;k < splitDimension;++k)
+                    {
+                        long neighborIndex = index[k] + seamOffsets[j][k];
+                        if ((neighborIndex < largestRegion.GetIndex()[k]) ||
+                                (neighborIndex >= largestRegion.GetIndex()[k] + (long)largestRegion.GetSize()[k]))
+                        {
+                            insideImage = false;
+                            break;
+                        }
+                    }
+
+                    if (!insideImage)
+                        continue;
+
+                    unsigned int neighborLabel = labelBuffer[linearIndex + seamLinearOffsets[j]];
+                    if (neighborLabel != 0)
+                        MergeLabels(globalParents,m_Slabs[i].labelOffset + label,m_Slabs[i - 1].labelOffset + neighborLabel);
+                }
+            }
+
+            ++seamIt;
+        }
+    }
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::Update()
+{
+    if (!m_InputImage)
+        itkExceptionMacro(<<"No input image to compute label statistics on");
+
+    RegionType largestRegion = m_InputImage->GetLargestPossibleRegion();
+    if (m_ComparisonImage && (m_ComparisonImage->GetLargestPossibleRegion().GetSize() != largestRegion.GetSize()))
+        itkExceptionMacro(<<"Input and comparison images do not have the same size");
+
+    // Contour statistics read masks with the input buffer offsets
+    if (m_BorderMask && (m_BorderMask->GetBufferedRegion() != m_InputImage->GetBufferedRegion()))
+        itkExceptionMacro(<<"Border mask and input image do not have the same size");
+
+    if (m_StructureMap && (m_StructureMap->GetBufferedRegion() != m_InputImage->GetBufferedRegion()))
+        itkExceptionMacro(<<"Structure map and input image do not have the same size");
+
+    itk::MultiThreader::Pointer threaderStatistics = itk::MultiThreader::New();
+    threaderStatistics->SetNumberOfThreads(m_NumberOfThreads);
+    this->SplitRegion(threaderStatistics->GetNumberOfThreads());
+    threaderStatistics->SetNumberOfThreads(m_Slabs.size());
+
+    m_ComponentIndexes.clear();
+    m_ComponentStatistics.clear();
+    m_OutputLabels.clear();
+    m_LabelImage = NULL;
+
+    if (m_ComputeComponents)
+    {
+        this->ComputeBackwardOffsets();
+        this->ComputeFaceOffsets();
+
+        m_LabelImage = LabelImageType::New();
+        m_LabelImage->Initialize();
+        m_LabelImage->SetRegions(largestRegion);
+        m_LabelImage->SetOrigin(m_InputImage->GetOrigin());
+        m_LabelImage->SetSpacing(m_InputImage->GetSpacing());
+        m_LabelImage->SetDirection(m_InputImage->GetDirection());
+        m_LabelImage->Allocate();
+    }
+
+    LabelStatisticsThreadStruct *tmpStr = new LabelStatisticsThreadStruct;
+    tmpStr->Filter = this;
+    tmpStr->pass = LABELING_PASS;
+    tmpStr->output = NULL;
+
+    threaderStatistics->SetSingleMethod(this->ThreadLabelStatistics,tmpStr);
+    threaderStatistics->SingleMethodExecute();
+
+    // Gather foreground and label value statistics
+    unsigned int numSlabs = m_Slabs.size();
+    m_LabelVolumes.clear();
+    m_ComparisonLabelVolumes.clear();
+    m_LabelIntersections.clear();
+    m_ForegroundVolume = 0;
+    m_ComparisonForegroundVolume = 0;
+    m_ForegroundIntersection = 0;
+
+    typedef typename std::map <PixelType, double>::const_iterator LabelMapIterator;
+    for (unsigned int i = 0;i < numSlabs;++i)
+    {
+        SlabData &slab = m_Slabs[i];
+        m_ForegroundVolume += slab.foregroundVolume;
+        m_ComparisonForegroundVolume += slab.comparisonForegroundVolume;
+        m_ForegroundIntersection += slab.foregroundIntersection;
+
+        for (LabelMapIterator labelIt = slab.labelVolumes.begin();labelIt != slab.labelVolumes.end();++labelIt)
+            m_LabelVolumes[labelIt->first] += labelIt->second;
+
+        for (LabelMapIterator labelIt = slab.comparisonLabelVolumes.begin();labelIt != slab.comparisonLabelVolumes.end();++labelIt)
+            m_ComparisonLabelVolumes[labelIt->first] += labelIt->second;
+
+        for (LabelMapIterator labelIt = slab.labelIntersections.begin();labelIt != slab.labelIntersections.end();++labelIt)
+            m_LabelIntersections[labelIt->first] += labelIt->second;
+
+        slab.labelVolumes.clear();
+        slab.comparisonLabelVolumes.clear();
+        slab.labelIntersections.clear();
+    }
+
+    m_LabelValues.clear();
+    for (LabelMapIterator labelIt = m_LabelVolumes.begin();labelIt != m_LabelVolumes.end();++labelIt)
+    {
+        if (labelIt->first != 0)
+            m_LabelValues.push_back(labelIt->first);
+    }
+
+    if (!m_ComputeComponents)
+    {
+        delete tmpStr;
+        m_Slabs.clear();
+        return;
+    }
+
+    // Global labels: slab labels are shifted by the number of labels of previous slabs
+    unsigned int numGlobalLabels = 1;
+    for (unsigned int i = 0;i < numSlabs;++i)
+    {
+        m_Slabs[i].labelOffset = numGlobalLabels - 1;
+        numGlobalLabels += m_Slabs[i].parents.size() - 1;
+    }
+
+    std::vector <unsigned int> globalParents(numGlobalLabels,0);
+    for (unsigned int i = 0;i < numSlabs;++i)
+    {
+        SlabData &slab = m_Slabs[i];
+        for (unsigned int j = 1;j < slab.parents.size();++j)
+            globalParents[slab.labelOffset + j] = slab.labelOffset + FindRoot(slab.parents,j);
+    }
+
+    if (m_LabeledImage)
+        this->MergeLabelValues(globalParents);
+    else
+        this->StitchSlabs(globalParents);
+
+    // Resolve components, roots are the smallest global label of their component
+    m_ComponentIndexes.assign(numGlobalLabels,0);
+    for (unsigned int i = 0;i < numSlabs;++i)
+    {
+        SlabData &slab = m_Slabs[i];
+        for (unsigned int j = 1;j < slab.parents.size();++j)
+        {
+            unsigned int globalLabel = slab.labelOffset + j;
+            unsigned int root = FindRoot(globalParents,globalLabel);
+
+            if (root == globalLabel)
+            {
+                m_ComponentStatistics.push_back(slab.componentStatistics[j]);
+                m_ComponentIndexes[globalLabel] = m_ComponentStatistics.size();
+                continue;
+            }
+
+            unsigned int component = m_ComponentIndexes[root];
+            m_ComponentIndexes[globalLabel] = component;
+            MergeStatistics(m_ComponentStatistics[component - 1],slab.componentStatistics[j]);
+        }
+
+        slab.parents.clear();
+        slab.componentStatistics.clear();
+    }
+
+    for (unsigned int i = 0;i < m_ComponentStatistics.size();++i)
+    {
+        for (unsigned int j = 0;j < ImageDimension;++j)
+            m_ComponentStatistics[i].centroid[j] /= m_ComponentStatistics[i].volume;
+    }
+
+    // Slab labels to component indexes in the label image
+    tmpStr->pass = FINALIZING_PASS;
+    threaderStatistics->SetSingleMethod(this->ThreadLabelStatistics,tmpStr);
+    threaderStatistics->SingleMethodExecute();
+
+    m_ComponentIndexes.clear();
+
+    if (m_StructureMap)
+    {
+        // Outside neighbors need final component indexes on both sides of slab seams
+        this->ComputeDilationOffsets();
+
+        tmpStr->pass = NEIGHBORS_PASS;
+        threaderStatistics->SetSingleMethod(this->ThreadLabelStatistics,tmpStr);
+        threaderStatistics->SingleMethodExecute();
+
+        for (unsigned int i = 0;i < numSlabs;++i)
+        {
+            SlabData &slab = m_Slabs[i];
+            for (unsigned int j = 1;j < slab.neighborSizes.size();++j)
+            {
+                m_ComponentStatistics[j - 1].neighborSize += slab.neighborSizes[j];
+                m_ComponentStatistics[j - 1].structureNeighborSize += slab.structureNeighborSizes[j];
+            }
+
+            slab.neighborSizes.clear();
+            slab.structureNeighborSizes.clear();
+        }
+    }
+
+    delete tmpStr;
+}
+
+template <class TImage, class TMaskImage>
+ITK_THREAD_RETURN_TYPE
+LabelStatisticsComputer<TImage,TMaskImage>
+::ThreadLabelStatistics(void *arg)
+{
+    itk::MultiThreader::ThreadInfoStruct *threadArgs = (itk::MultiThreader::ThreadInfoStruct *)arg;
+
+    unsigned int nbThread = threadArgs->ThreadID;
+
+    LabelStatisticsThreadStruct *tmpStr = (LabelStatisticsThreadStruct *)threadArgs->UserData;
+
+    switch (tmpStr->pass)
+    {
+        case LABELING_PASS:
+            tmpStr->Filter->ProcessSlab(nbThread);
+            break;
+
+        case FINALIZING_PASS:
+            tmpStr->Filter->FinalizeSlab(nbThread);
+            break;
+
+        case NEIGHBORS_PASS:
+            tmpStr->Filter->CountOutsideNeighbors(nbThread);
+            break;
+
+        case OUTPUT_PASS:
+        default:
+            tmpStr->Filter->RelabelSlab(nbThread,tmpStr->output);
+            break;
+    }
+
+    return NULL;
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::ProcessSlab(unsigned int slabIndex)
+{
+    SlabData &slab = m_Slabs[slabIndex];
+    RegionType region = slab.region;
+
+    slab.labelVolumes.clear();
+    slab.comparisonLabelVolumes.clear();
+    slab.labelIntersections.clear();
+    slab.foregroundVolume = 0;
+    slab.comparisonForegroundVolume = 0;
+    slab.foregroundIntersection = 0;
+
+    ComponentStatistics emptyStatistics;
+    emptyStatistics.volume = 0;
+    emptyStatistics.minimum.Fill(0);
+    emptyStatistics.maximum.Fill(0);
+    emptyStatistics.centroid.Fill(0);
+    emptyStatistics.overlap = 0;
+    emptyStatistics.touchesBorder = false;
+    emptyStatistics.contourSize = 0;
+    emptyStatistics.neighborSize = 0;
+    emptyStatistics.structureNeighborSize = 0;
+
+    // Label 0 is the background
+    slab.parents.assign(1,0);
+    slab.componentStatistics.assign(1,emptyStatistics);
+    slab.valueLabels.clear();
+
+    bool computeContours = m_BorderMask.IsNotNull();
+
+    unsigned int *labelBuffer = NULL;
+    std::vector <long> backwardLinearOffsets(m_BackwardOffsets.size(),0);
+    if (m_ComputeComponents)
+    {
+        labelBuffer = m_LabelImage->GetBufferPointer();
+        const typename LabelImageType::OffsetValueType *offsetTable = m_LabelImage->GetOffsetTable();
+        for (unsigned int i = 0;i < m_BackwardOffsets.size();++i)
+        {
+            for (unsigned int j = 0;j < ImageDimension;++j)
+                backwardLinearOffsets[i] += m_BackwardOffsets[i][j] * offsetTable[j];
+        }
+    }
+
+    typedef itk::ImageRegionConstIteratorWithIndex <ImageType> InputIteratorType;
+    typedef itk::ImageRegionConstIterator <ImageType> ComparisonIteratorType;
+
+    InputIteratorType inputIt(m_InputImage,region);
+    ComparisonIteratorType comparisonIt;
+    if (m_ComparisonImage)
+        comparisonIt = ComparisonIteratorType(m_ComparisonImage,region);
+
+    IndexType regionStart = region.GetIndex();
+    IndexType regionEnd = region.GetUpperIndex();
+
+    while (!inputIt.IsAtEnd())
+    {
+        PixelType pixelValue = inputIt.Get();
+        PixelType comparisonValue = 0;
+
+        if (pixelValue != 0)
+            ++slab.foregroundVolume;
+
+        if (m_ComputeLabelStatistics)
+            ++slab.labelVolumes[pixelValue];
+
+        if (m_ComparisonImage)
+        {
+            comparisonValue = comparisonIt.Get();
+
+            if (comparisonValue != 0)
+                ++slab.comparisonForegroundVolume;
+
+            if ((pixelValue != 0)&&(comparisonValue != 0))
+                ++slab.foregroundIntersection;
+
+            if (m_ComputeLabelStatistics)
+            {
+                ++slab.comparisonLabelVolumes[comparisonValue];
+
+                if (comparisonValue == pixelValue)
+                    ++slab.labelIntersections[pixelValue];
+            }
+
+            ++comparisonIt;
+        }
+
+        if (m_ComputeComponents)
+        {
+            IndexType index = inputIt.GetIndex();
+            long linearIndex = m_LabelImage->ComputeOffset(index);
+            unsigned int label = 0;
+
+            if ((pixelValue != 0)&&(m_LabeledImage))
+            {
+                typename std::map <PixelType, unsigned int>::iterator valueIt = slab.valueLabels.find(pixelValue);
+                if (valueIt != slab.valueLabels.end())
+                    label = valueIt->second;
+            }
+            else if (pixelValue != 0)
+            {
+                for (unsigned int i = 0;i < m_BackwardOffsets.size();++i)
+                {
+                    // Neighbors outside of the slab are handled when stitching slabs
+                    bool insideSlab = true;
+                    for (unsigned int j = 0;j < ImageDimension;++j)
+                    {
+                        long neighborIndex = index[j] + m_BackwardOffsets[i][j];
+                        if ((neighborIndex < regionStart[j])||(neighborIndex > regionEnd[j]))
+                        {
+                            insideSlab = false;
+                            break;
+                        }
+                    }
+
+                    if (!insideSlab)
+                        continue;
+
+                    unsigned int neighborLabel = labelBuffer[linearIndex + backwardLinearOffsets[i]];
+                    if (neighborLabel == 0)
+                        continue;
+
+                    if (label == 0)
+                        label = neighborLabel;
+                    else if (neighborLabel != label)
+                        MergeLabels(slab.parents,label,neighborLabel);
+                }
+            }
+
+            if (pixelValue != 0)
+            {
+                if (label == 0)
+                {
+                    label = slab.parents.size();
+                    slab.parents.push_back(label);
+                    slab.componentStatistics.push_back(emptyStatistics);
+
+                    if (m_LabeledImage)
+                        slab.valueLabels[pixelValue] = label;
+                }
+
+                AddVoxel(slab.componentStatistics[label],index,comparisonValue != 0);
+
+                if (computeContours)
+                    this->AddContourVoxel(slab.componentStatistics[label],index,m_InputImage->ComputeOffset(index),pixelValue);
+            }
+
+            labelBuffer[linearIndex] = label;
+        }
+
+        ++inputIt;
+    }
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::FinalizeSlab(unsigned int slabIndex)
+{
+    SlabData &slab = m_Slabs[slabIndex];
+
+    itk::ImageRegionIterator <LabelImageType> labelIt(m_LabelImage,slab.region);
+    while (!labelIt.IsAtEnd())
+    {
+        unsigned int label = labelIt.Get();
+        if (label != 0)
+            labelIt.Set(m_ComponentIndexes[slab.labelOffset + label]);
+
+        ++labelIt;
+    }
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::CountOutsideNeighbors(unsigned int slabIndex)
+{
+    SlabData &slab = m_Slabs[slabIndex];
+    unsigned int numComponents = m_ComponentStatistics.size();
+    slab.neighborSizes.assign(numComponents + 1,0);
+    slab.structureNeighborSizes.assign(numComponents + 1,0);
+
+    const unsigned int *labelBuffer = m_LabelImage->GetBufferPointer();
+    RegionType largestRegion = m_LabelImage->GetLargestPossibleRegion();
+    IndexType imageStart = largestRegion.GetIndex();
+    IndexType imageEnd = largestRegion.GetUpperIndex();
+
+    // Each voxel is counted once per component around it, whatever the number of its neighbors in that component
+    std::vector <unsigned int> neighborComponents;
+    neighborComponents.reserve(m_DilationOffsets.size());
+
+    itk::ImageRegionConstIteratorWithIndex <LabelImageType> labelIt(m_LabelImage,slab.region);
+    itk::ImageRegionConstIterator <MaskImageType> structureIt(m_StructureMap,slab.region);
+
+    while (!labelIt.IsAtEnd())
+    {
+        unsigned int component = labelIt.Get();
+        IndexType index = labelIt.GetIndex();
+        long linearIndex = m_LabelImage->ComputeOffset(index);
+
+        neighborComponents.clear();
+        for (unsigned int i = 0;i < m_DilationOffsets.size();++i)
+        {
+            bool insideImage = true;
+            for (unsigned int j = 0;j < ImageDimension;++j)
+            {
+                long neighborIndex = index[j] + m_DilationOffsets[i][j];
+                if ((neighborIndex < imageStart[j])||(neighborIndex > imageEnd[j]))
+                {
+                    insideImage = false;
+                    break;
+                }
+            }
+
+            if (!insideImage)
+                continue;
+
+            unsigned int neighborComponent = labelBuffer[linearIndex + m_DilationLinearOffsets[i]];
+            if ((neighborComponent == 0)||(neighborComponent == component))
+                continue;
+
+            if (std::find(neighborComponents.begin(),neighborComponents.end(),neighborComponent) == neighborComponents.end())
+                neighborComponents.push_back(neighborComponent);
+        }
+
+        bool inStructure = (structureIt.Get() != 0);
+        for (unsigned int i = 0;i < neighborComponents.size();++i)
+        {
+            ++slab.neighborSizes[neighborComponents[i]];
+            if (inStructure)
+                ++slab.structureNeighborSizes[neighborComponents[i]];
+        }
+
+        ++labelIt;
+        ++structureIt;
+    }
+}
+
+template <class TImage, class TMaskImage>
+void
+LabelStatisticsComputer<TImage,TMaskImage>
+::RelabelSlab(unsigned int slabIndex, ImageType *output)
+{
+    SlabData &slab = m_Slabs[slabIndex];
+
+    itk::ImageRegionConstIterator <LabelImageType> labelIt(m_LabelImage,slab.region);
+    itk::ImageRegionIterator <ImageType> outputIt(output,slab.region);
+
+    while (!labelIt.IsAtEnd())
+    {
+        unsigned int label = labelIt.Get();
+        outputIt.Set(static_cast <PixelType> (m_OutputLabels[label]));
+
+        ++labelIt;
+        ++outputIt;
+    }
+}
+
+template <class TImage, class TMaskImage>
+typename LabelStatisticsComputer<TImage,TMaskImage>::ImagePointer
+LabelStatisticsComputer<TImage,TMaskImage>
+::GetComponentsImage(unsigned int minimalVolume)
+{
+    if (!m_LabelImage)
+        itkExceptionMacro(<<"Components were not computed");
+
+    unsigned int numComponents = m_ComponentStatistics.size();
+    std::vector < std::pair <unsigned int, unsigned int> > componentVolumes(numComponents);
+    for (unsigned int i = 0;i < numComponents;++i)
+        componentVolumes[i] = std::make_pair(m_ComponentStatistics[i].volume,i + 1);
+
+    std::sort(componentVolumes.begin(),componentVolumes.end(),CompareVolumes);
+
+    m_OutputLabels.assign(numComponents + 1,0);
+    unsigned int outputLabel = 1;
+    for (unsigned int i = 0;i < numComponents;++i)
+    {
+        if (componentVolumes[i].first < minimalVolume)
+            break;
+
+        m_OutputLabels[componentVolumes[i].second] = outputLabel;
+        ++outputLabel;
+    }
+
+    ImagePointer output = ImageType::New();
+    output->Initialize();
+    output->SetRegions(m_InputImage->GetLargestPossibleRegion());
+    output->SetOrigin(m_InputImage->GetOrigin());
+    output->SetSpacing(m_InputImage->GetSpacing());
+    output->SetDirection(m_InputImage->GetDirection());
+    output->Allocate();
+
+    LabelStatisticsThreadStruct *tmpStr = new LabelStatisticsThreadStruct;
+    tmpStr->Filter = this;
+    tmpStr->pass = OUTPUT_PASS;
+    tmpStr->output = output;
+
+    itk::MultiThreader::Pointer threaderRelabel = itk::MultiThreader::New();
+    threaderRelabel->SetNumberOfThreads(m_Slabs.size());
+    threaderRelabel->SetSingleMethod(this->ThreadLabelStatistics,tmpStr);
+    threaderRelabel->SingleMethodExecute();
+
+    delete tmpStr;
+
+    return output;
+}
+
+template <class TImage, class TMaskImage>
+unsigned int
+LabelStatisticsComputer<TImage,TMaskImage>
+::GetNumberOfOverlappingComponents(unsigned int minimalOverlap)
+{
+    unsigned int numOverlapping = 0;
+    for (unsigned int i = 0;i < m_ComponentStatistics.size();++i)
+    {
+        if (m_ComponentStatistics[i].overlap >= minimalOverlap)
+            ++numOverlapping;
+    }
+
+    return numOverlapping;
+}
+
+template <class TImage, class TMaskImage>
+double
+LabelStatisticsComputer<TImage,TMaskImage>
+::GetLabelVolume(PixelType label)
+{
+    typename std::map <PixelType, double>::const_iterator labelIt = m_LabelVolumes.find(label);
+    if (labelIt == m_LabelVolumes.end())
+        return 0;
+
+    return labelIt->second;
+}
+
+template <class TImage, class TMaskImage>
+double
+LabelStatisticsComputer<TImage,TMaskImage>
+::GetComparisonLabelVolume(PixelType label)
+{
+    typename std::map <PixelType, double>::const_iterator labelIt = m_ComparisonLabelVolumes.find(label);
+    if (labelIt == m_ComparisonLabelVolumes.end())
+        return 0;
+
+    return labelIt->second;
+}
+
+template <class TImage, class TMaskImage>
+double
+LabelStatisticsComputer<TImage,TMaskImage>
+::GetLabelIntersection(PixelType label)
+{
+    typename std::map <PixelType, double>::const_iterator labelIt = m_LabelIntersections.find(label);
+    if (labelIt == m_LabelIntersections.end())
+        return 0;
+
+    return labelIt->second;
+}
+
+template <class TImage, class TMaskImage>
+double
+LabelStatisticsComputer<TImage,TMaskImage>
+::GetVoxelVolume()
+{
+    typename ImageType::SpacingType spacing = m_InputImage->GetSpacing();
+    double voxelVolume = spacing[0];
+    for (unsigned int i = 1;i < std::min((unsigned int)ImageDimension,(unsigned int)3);++i)
+        voxelVolume *= spacing[i];
+
+    return voxelVolume;
+}
+
+} // end namespace anima
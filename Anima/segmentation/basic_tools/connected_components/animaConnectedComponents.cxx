@@ -1,12 +1,9 @@
-#include <itkConnectedComponentImageFilter.h>
-#include <itkRelabelComponentImageFilter.h>
 #include <itkImageFileReader.h>
-#include <itkImageFileWriter.h>
-#include <itkImageRegionIterator.h>
 
 #include <tclap/CmdLine.h>
 
 #include <animaReadWriteFunctions.h>
+#include <animaLabelStatisticsComputer.h>
 
 struct arguments
 {
@@ -21,23 +18,17 @@ void
 connectedComponent(const arguments &args)
 {
     typedef itk::Image <unsigned short,Dimension> ImageType;
+    typedef anima::LabelStatisticsComputer <ImageType> LabelStatisticsComputerType;
 
-    typedef itk::ConnectedComponentImageFilter <ImageType,ImageType> MainFilterType;
-    typedef itk::RelabelComponentImageFilter <ImageType,ImageType> RelabelComponentFilterType;
-
-    typename MainFilterType::Pointer mainFilter = MainFilterType::New();
-    mainFilter->SetInput(anima::readImage<ImageType>(args.input));
-    mainFilter->SetFullyConnected(args.full);
+    typename LabelStatisticsComputerType::Pointer statisticsComputer = LabelStatisticsComputerType::New();
+    statisticsComputer->SetInputImage(anima::readImage<ImageType>(args.input));
+    statisticsComputer->SetFullyConnected(args.full);
     if(args.pthread > 0)
-        mainFilter->SetNumberOfThreads(args.pthread);
-    mainFilter->Update();
+        statisticsComputer->SetNumberOfThreads(args.pthread);
+    statisticsComputer->Update();
 
     // Compute Image Spacing, 4th dimension is not physical but temporal
-    typename ImageType::SpacingType spacing = mainFilter->GetInput(0)->GetSpacing();
-    typename ImageType::SpacingValueType spacingTot = spacing[0];
-    for (unsigned int i = 1;i < std::min(Dimension,(unsigned int)3);++i)
-        spacingTot *= spacing[i];
-
+    double spacingTot = statisticsComputer->GetVoxelVolume();
 
     // Compute minsize in voxels
     double minSizeInVoxelD = args.min / spacingTot;
@@ -46,14 +37,15 @@ connectedComponent(const arguments &args)
     minSizeInVoxel++; // to have strickly superior sizes
     double diff = minSizeInVoxelD-minSizeInVoxelD_floor;
 
-    typename RelabelComponentFilterType::Pointer relabelFilter = RelabelComponentFilterType::New();
-    relabelFilter->SetInput( mainFilter->GetOutput() );
-    relabelFilter->SetMinimumObjectSize(minSizeInVoxel);
-    if(args.pthread > 0)
-        relabelFilter->SetNumberOfThreads(args.pthread);
-    relabelFilter->Update();
+    unsigned int numObjects = statisticsComputer->GetNumberOfComponents();
+    unsigned int numKeptObjects = 0;
+    for (unsigned int i = 1;i <= numObjects;++i)
+    {
+        if (statisticsComputer->GetComponentStatistics(i).volume >= minSizeInVoxel)
+            ++numKeptObjects;
+    }
 
-    std::cout << "Original number of objects: " << relabelFilter->GetOriginalNumberOfObjects() <<std::endl;
+    std::cout << "Original number of objects: " << numObjects <<std::endl;
     std::cout << "Total image spacing: " << spacingTot << std::endl;
     std::cout << "Connected components minimum size: " << args.min << " mm3 --> " << "process on " << minSizeInVoxel-1 << " voxel(s)" << std::endl;
     if(diff>0.000001)
@@ -61,10 +53,10 @@ connectedComponent(const arguments &args)
         std::cout << "-- Warning: operation is not complete, " << (double)(minSizeInVoxel-1)*spacingTot << " mm3 is/are removed ("  << minSizeInVoxel-1  << " voxel(s)) "
               << "instead of " << args.min << " mm3 (" << minSizeInVoxelD << " voxel(s))" << std::endl;
     }
-    std::cout << "Number of objects after cleaning too small ones: " << relabelFilter->GetNumberOfObjects() << std::endl;
+    std::cout << "Number of objects after cleaning too small ones: " << numKeptObjects << std::endl;
     std::cout << std::endl;
 
-    anima::writeImage<ImageType>(args.output, relabelFilter->GetOutput());
+    anima::writeImage<ImageType>(args.output, statisticsComputer->GetComponentsImage(minSizeInVoxel));
 }
 
 void
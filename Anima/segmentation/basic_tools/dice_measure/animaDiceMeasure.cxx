@@ -1,8 +1,9 @@
 #include <itkImageFileReader.h>
-#include <itkImageRegionConstIterator.h>
 #include <tclap/CmdLine.h>
 #include <fstream>
 
+#include <animaLabelStatisticsComputer.h>
+
 int main(int argc, char * *argv)
 {
     TCLAP::CmdLine cmd("INRIA / IRISA - VisAGeS Team", ' ', ANIMA_VERSION);
@@ -30,71 +31,34 @@ int main(int argc, char * *argv)
 
     typedef itk::Image <unsigned short, 3> ImageType;
     typedef itk::ImageFileReader <ImageType> ImageReaderType;
-    typedef itk::ImageRegionConstIterator <ImageType> ImageIteratorType;
+    typedef anima::LabelStatisticsComputer <ImageType> LabelStatisticsComputerType;
 
     ImageReaderType::Pointer refRead = ImageReaderType::New();
     refRead->SetFileName(refArg.getValue());
     refRead->Update();
 
-    ImageIteratorType refIt (refRead->GetOutput(), refRead->GetOutput()->GetLargestPossibleRegion());
-
-    std::vector <unsigned int> usefulLabels;
-
-    while (!refIt.IsAtEnd())
-    {
-        if (refIt.Get() != 0)
-        {
-            bool isAlreadyIn = false;
-            for (unsigned int i = 0; i < usefulLabels.size(); ++i)
-            {
-                if (refIt.Get() == usefulLabels[i])
-                {
-                    isAlreadyIn = true;
-                    break;
-                }
-            }
-
-            if (!isAlreadyIn)
-                usefulLabels.push_back(refIt.Get());
-        }
-
-        ++refIt;
-    }
-
-    std::sort(usefulLabels.begin(), usefulLabels.end());
-
-    std::map <unsigned int, unsigned int> labelBackMap;
-
-    labelBackMap[0] = 0;
-    for (unsigned int i = 0; i < usefulLabels.size(); ++i)
-    {
-        labelBackMap[usefulLabels[i]] = i+1;
-    }
-
-    refIt.GoToBegin();
-
     ImageReaderType::Pointer testRead = ImageReaderType::New();
     testRead->SetFileName(testArg.getValue());
     testRead->Update();
 
-    ImageIteratorType testIt (testRead->GetOutput(), testRead->GetOutput()->GetLargestPossibleRegion());
+    // Label cardinals and intersections in a single threaded pass
+    LabelStatisticsComputerType::Pointer statisticsComputer = LabelStatisticsComputerType::New();
+    statisticsComputer->SetInputImage(refRead->GetOutput());
+    statisticsComputer->SetComparisonImage(testRead->GetOutput());
+    statisticsComputer->SetComputeComponents(false);
+    statisticsComputer->SetComputeLabelStatistics(true);
+    statisticsComputer->Update();
+
+    std::vector <ImageType::PixelType> usefulLabels = statisticsComputer->GetLabelValues();
 
     unsigned int numLabels = usefulLabels.size();
     std::vector <double> cardRef(numLabels+1, 0), cardTest(numLabels+1, 0), cardInter(numLabels+1, 0);
 
-    while(!testIt.IsAtEnd())
+    for (unsigned int i = 0; i < numLabels; ++i)
     {
-        unsigned int testVal = testIt.Get();
-        unsigned int refVal = refIt.Get();
-
-        cardTest[labelBackMap[testVal]]++;
-        cardRef[labelBackMap[refVal]]++;
-
-        if (testVal == refVal)
-            cardInter[labelBackMap[testVal]]++;
-
-        ++testIt;
-        ++refIt;
+        cardRef[i+1] = statisticsComputer->GetLabelVolume(usefulLabels[i]);
+        cardTest[i+1] = statisticsComputer->GetComparisonLabelVolume(usefulLabels[i]);
+        cardInter[i+1] = statisticsComputer->GetLabelIntersection(usefulLabels[i]);
     }
 
 
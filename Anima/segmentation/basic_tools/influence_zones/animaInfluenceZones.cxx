@@ -2,7 +2,6 @@
 #include <iostream>
 #include <string>
 
-#include <itkSignedDanielssonDistanceMapImageFilter.h>
 #include <itkRegionalMaximaImageFilter.h>
 #include <itkConnectedComponentImageFilter.h>
 #include <itkGrayscaleDilateImageFilter.h>
@@ -10,6 +9,7 @@
 #include <itkImageRegionIterator.h>
 
 #include <animaReadWriteFunctions.h>
+#include <animaDistanceTransformImageFilter.h>
 
 int main(int argc, char **argv)
 {
@@ -37,10 +37,11 @@ int main(int argc, char **argv)
 
     InputImageType::Pointer inputImage = anima::readImage <InputImageType> (inArg.getValue());
 
-    typedef itk::SignedDanielssonDistanceMapImageFilter <InputImageType, DistanceImageType, OutputImageType> DistanceMapFilterType;
+    typedef anima::DistanceTransformImageFilter <InputImageType, DistanceImageType> DistanceMapFilterType;
     DistanceMapFilterType::Pointer distanceMap = DistanceMapFilterType::New();
     distanceMap->SetInput(inputImage);
-    distanceMap->InsideIsPositiveOn();
+    distanceMap->SetSignedDistance(true);
+    distanceMap->SetInsideIsPositive(true);
     distanceMap->SetUseImageSpacing(true);
     distanceMap->SetNumberOfThreads(numThreadsArg.getValue());
 
@@ -67,11 +68,12 @@ int main(int argc, char **argv)
     ccFilter->SetFullyConnected(true);
     ccFilter->SetNumberOfThreads(numThreadsArg.getValue());
 
-    typedef itk::SignedDanielssonDistanceMapImageFilter <OutputImageType, DistanceImageType, OutputImageType> VoronoiMapFilterType;
+    // Only nearest labels are used, square roots of distances are not needed
+    typedef anima::DistanceTransformImageFilter <OutputImageType, DistanceImageType> VoronoiMapFilterType;
     VoronoiMapFilterType::Pointer voronoiFilter = VoronoiMapFilterType::New();
     voronoiFilter->SetInput(ccFilter->GetOutput());
     voronoiFilter->SetUseImageSpacing(true);
-    voronoiFilter->InsideIsPositiveOff();
+    voronoiFilter->SetSquaredDistance(true);
     voronoiFilter->SetNumberOfThreads(numThreadsArg.getValue());
 
     voronoiFilter->Update();
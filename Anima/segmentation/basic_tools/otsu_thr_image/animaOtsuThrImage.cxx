@@ -1,7 +1,10 @@
 #include <tclap/CmdLine.h>
 
-#include <itkOtsuMultipleThresholdsImageFilter.h>
+#include <itkOtsuMultipleThresholdsCalculator.h>
+#include <itkThresholdLabelerImageFilter.h>
+#include <itkHistogram.h>
 
+#include <animaImageHistogramsComputer.h>
 #include <animaReadWriteFunctions.h>
 
 #include <iostream>
@@ -15,6 +18,8 @@ int main(int argc, char **argv)
     TCLAP::ValueArg<std::string> outputArg("o","outputimage","Output image",true,"","Output image",cmd);
 
     TCLAP::ValueArg<unsigned long> nbThresholds("n", "nbThresholds", "Number of thresholds (default : 1)",false,1,"Number of thresholds",cmd);
+    TCLAP::ValueArg<unsigned int> nbBinsArg("b", "nbBins", "Number of histogram bins (default : 128)",false,128,"Number of bins",cmd);
+    TCLAP::ValueArg<unsigned int> nbThreadsArg("T","numberofthreads","Number of threads to run on (default : all cores)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
 
     try
     {
@@ -29,17 +34,49 @@ int main(int argc, char **argv)
     typedef itk::Image<double,3> DoubleImageType;
     typedef itk::Image<unsigned short,3> USImageType;
     
-    typedef itk::OtsuMultipleThresholdsImageFilter <DoubleImageType, USImageType> OtsuMultipleThresholdsImageFilterType;
+    typedef anima::ImageHistogramsComputer <DoubleImageType> HistogramsComputerType;
+    typedef itk::Statistics::Histogram <double> HistogramType;
+    typedef itk::OtsuMultipleThresholdsCalculator <HistogramType> OtsuCalculatorType;
+    typedef itk::ThresholdLabelerImageFilter <DoubleImageType, USImageType> ThresholdLabelerType;
 
     DoubleImageType::Pointer inputImage = anima::readImage <DoubleImageType> (inputArg.getValue());
 
-    OtsuMultipleThresholdsImageFilterType::Pointer otsuMultipleThrFilter = OtsuMultipleThresholdsImageFilterType::New();
-    otsuMultipleThrFilter->SetInput(inputImage);
-    otsuMultipleThrFilter->SetNumberOfThresholds(nbThresholds.getValue());
+    // Multithreaded histogram, then Otsu thresholds computed on it
+    HistogramsComputerType::Pointer histogramsComputer = HistogramsComputerType::New();
+    histogramsComputer->AddInputImage(inputImage);
+    histogramsComputer->SetNumberOfBins(nbBinsArg.getValue());
+    histogramsComputer->SetNumberOfThreads(nbThreadsArg.getValue());
+
+    ThresholdLabelerType::Pointer labelerFilter = ThresholdLabelerType::New();
 
     try
     {
-        otsuMultipleThrFilter->Update();
+        histogramsComputer->Update();
+
+        const HistogramsComputerType::HistogramType &bins = histogramsComputer->GetHistogram(0,1);
+        unsigned int numBins = bins.size();
+
+        HistogramType::Pointer histogram = HistogramType::New();
+        HistogramType::SizeType histogramSize(1);
+        histogramSize[0] = numBins;
+        HistogramType::MeasurementVectorType lowerBound(1), upperBound(1);
+        lowerBound[0] = histogramsComputer->GetMinimum(0,1);
+        upperBound[0] = histogramsComputer->GetMaximum(0,1);
+
+        histogram->SetMeasurementVectorSize(1);
+        histogram->Initialize(histogramSize,lowerBound,upperBound);
+        for (unsigned int i = 0;i < numBins;++i)
+            histogram->SetFrequency(i,bins[i]);
+
+        OtsuCalculatorType::Pointer otsuCalculator = OtsuCalculatorType::New();
+        otsuCalculator->SetInputHistogram(histogram);
+        otsuCalculator->SetNumberOfThresholds(nbThresholds.getValue());
+        otsuCalculator->Compute();
+
+        labelerFilter->SetInput(inputImage);
+        labelerFilter->SetRealThresholds(otsuCalculator->GetOutput());
+        labelerFilter->SetNumberOfThreads(nbThreadsArg.getValue());
+        labelerFilter->Update();
     }
     catch (itk::ExceptionObject &e)
     {
@@ -47,7 +84,7 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
-    anima::writeImage <USImageType> (outputArg.getValue(),otsuMultipleThrFilter->GetOutput());
+    anima::writeImage <USImageType> (outputArg.getValue(),labelerFilter->GetOutput());
     
     return EXIT_SUCCESS;
 }
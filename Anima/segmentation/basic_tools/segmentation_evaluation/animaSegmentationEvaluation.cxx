@@ -0,0 +1,289 @@
+#include <tclap/CmdLine.h>
+
+#include <animaReadWriteFunctions.h>
+#include <animaLabelStatisticsComputer.h>
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+struct EvaluationResults
+{
+    std::string reference, test;
+    double referenceVolume, testVolume;
+    double dice, jaccard;
+    unsigned int referenceLesions, testLesions;
+    unsigned int detectedLesions, truePositiveLesions, falsePositiveLesions;
+    double lesionSensitivity, lesionPPV, lesionF1;
+};
+
+typedef itk::Image <unsigned short,3> ImageType;
+typedef anima::LabelStatisticsComputer <ImageType> LabelStatisticsComputerType;
+
+void
+evaluatePair(const std::string &refFile, const std::string &testFile, bool fullyConnected,
+             unsigned int minimalOverlap, unsigned int numThreads, EvaluationResults &results)
+{
+    ImageType::Pointer refImage = anima::readImage <ImageType> (refFile);
+    ImageType::Pointer testImage = anima::readImage <ImageType> (testFile);
+
+    // Reference lesions and their overlap with the test segmentation, voxel-wise overlap comes along
+    LabelStatisticsComputerType::Pointer refStatistics = LabelStatisticsComputerType::New();
+    refStatistics->SetInputImage(refImage);
+    refStatistics->SetComparisonImage(testImage);
+    refStatistics->SetFullyConnected(fullyConnected);
+    refStatistics->SetNumberOfThreads(numThreads);
+    refStatistics->Update();
+
+    // Test lesions and their overlap with the reference
+    LabelStatisticsComputerType::Pointer testStatistics = LabelStatisticsComputerType::New();
+    testStatistics->SetInputImage(testImage);
+    testStatistics->SetComparisonImage(refImage);
+    testStatistics->SetFullyConnected(fullyConnected);
+    testStatistics->SetNumberOfThreads(numThreads);
+    testStatistics->Update();
+
+    results.reference = refFile;
+    results.test = testFile;
+
+    double voxelVolume = refStatistics->GetVoxelVolume();
+    double cardRef = refStatistics->GetForegroundVolume();
+    double cardTest = refStatistics->GetComparisonForegroundVolume();
+    double cardInter = refStatistics->GetForegroundIntersection();
+
+    results.referenceVolume = cardRef * voxelVolume;
+    results.testVolume = cardTest * voxelVolume;
+
+    // Two empty segmentations are considered as a perfect match
+    results.dice = 1.0;
+    results.jaccard = 1.0;
+    if (cardRef + cardTest > 0)
+    {
+        results.dice = 2.0 * cardInter / (cardRef + cardTest);
+        results.jaccard = cardInter / (cardRef + cardTest - cardInter);
+    }
+
+    results.referenceLesions = refStatistics->GetNumberOfComponents();
+    results.testLesions = testStatistics->GetNumberOfComponents();
+    results.detectedLesions = refStatistics->GetNumberOfOverlappingComponents(minimalOverlap);
+    results.truePositiveLesions = testStatistics->GetNumberOfOverlappingComponents(minimalOverlap);
+    results.falsePositiveLesions = results.testLesions - results.truePositiveLesions;
+
+    results.lesionSensitivity = 0;
+    if (results.referenceLesions > 0)
+        results.lesionSensitivity = static_cast <double> (results.detectedLesions) / results.referenceLesions;
+
+    results.lesionPPV = 0;
+    if (results.testLesions > 0)
+        results.lesionPPV = static_cast <double> (results.truePositiveLesions) / results.testLesions;
+
+    results.lesionF1 = 0;
+    if (results.lesionSensitivity + results.lesionPPV > 0)
+        results.lesionF1 = 2.0 * results.lesionSensitivity * results.lesionPPV / (results.lesionSensitivity + results.lesionPPV);
+}
+
+std::string
+quoteCSV(const std::string &field)
+{
+    // Fields are always quoted, embedded quotes are doubled
+    std::string quotedField = "\"";
+    for (unsigned int i = 0;i < field.size();++i)
+    {
+        if (field[i] == '"')
+            quotedField += '"';
+        quotedField += field[i];
+    }
+
+    quotedField += '"';
+    return quotedField;
+}
+
+std::string
+escapeJSON(const std::string &value)
+{
+    std::ostringstream escapedValue;
+    for (unsigned int i = 0;i < value.size();++i)
+    {
+        unsigned char character = value[i];
+        switch (character)
+        {
+            case '"':
+                escapedValue << "\\\"";
+                break;
+            case '\\':
+                escapedValue << "\\\\";
+                break;
+            case '\b':
+                escapedValue << "\\b";
+                break;
+            case '\f':
+                escapedValue << "\\f";
+                break;
+            case '\n':
+                escapedValue << "\\n";
+                break;
+            case '\r':
+                escapedValue << "\\r";
+                break;
+            case '\t':
+                escapedValue << "\\t";
+                break;
+            default:
+                if (character < 0x20)
+                {
+                    char unicodeValue[7];
+                    std::sprintf(unicodeValue,"\\u%04x",character);
+                    escapedValue << unicodeValue;
+                }
+                else
+                    escapedValue << value[i];
+                break;
+        }
+    }
+
+    return escapedValue.str();
+}
+
+void
+writeCSV(std::ostream &outStream, const std::vector <EvaluationResults> &results)
+{
+    outStream << "Reference,Test,ReferenceVolume,TestVolume,Dice,Jaccard,ReferenceLesions,TestLesions,"
+              << "DetectedLesions,TruePositiveLesions,FalsePositiveLesions,LesionSensitivity,LesionPPV,LesionF1" << std::endl;
+
+    for (unsigned int i = 0;i < results.size();++i)
+    {
+        const EvaluationResults &res = results[i];
+        outStream << quoteCSV(res.reference) << "," << quoteCSV(res.test) << "," << res.referenceVolume << "," << res.testVolume << ","
+                  << res.dice << "," << res.jaccard << "," << res.referenceLesions << "," << res.testLesions << ","
+                  << res.detectedLesions << "," << res.truePositiveLesions << "," << res.falsePositiveLesions << ","
+                  << res.lesionSensitivity << "," << res.lesionPPV << "," << res.lesionF1 << std::endl;
+    }
+}
+
+void
+writeJSON(std::ostream &outStream, const std::vector <EvaluationResults> &results)
+{
+    outStream << "[" << std::endl;
+    for (unsigned int i = 0;i < results.size();++i)
+    {
+        const EvaluationResults &res = results[i];
+        outStream << "  {" << std::endl;
+        outStream << "    \"Reference\": \"" << escapeJSON(res.reference) << "\"," << std::endl;
+        outStream << "    \"Test\": \"" << escapeJSON(res.test) << "\"," << std::endl;
+        outStream << "    \"ReferenceVolume\": " << res.referenceVolume << "," << std::endl;
+        outStream << "    \"TestVolume\": " << res.testVolume << "," << std::endl;
+        outStream << "    \"Dice\": " << res.dice << "," << std::endl;
+        outStream << "    \"Jaccard\": " << res.jaccard << "," << std::endl;
+        outStream << "    \"ReferenceLesions\": " << res.referenceLesions << "," << std::endl;
+        outStream << "    \"TestLesions\": " << res.testLesions << "," << std::endl;
+        outStream << "    \"DetectedLesions\": " << res.detectedLesions << "," << std::endl;
+        outStream << "    \"TruePositiveLesions\": " << res.truePositiveLesions << "," << std::endl;
+        outStream << "    \"FalsePositiveLesions\": " << res.falsePositiveLesions << "," << std::endl;
+        outStream << "    \"LesionSensitivity\": " << res.lesionSensitivity << "," << std::endl;
+        outStream << "    \"LesionPPV\": " << res.lesionPPV << "," << std::endl;
+        outStream << "    \"LesionF1\": " << res.lesionF1 << std::endl;
+        outStream << "  }";
+        if (i + 1 < results.size())
+            outStream << ",";
+        outStream << std::endl;
+    }
+
+    outStream << "]" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    TCLAP::CmdLine cmd("Evaluates test segmentations against references: volumes, Dice, Jaccard and lesion-wise detection. INRIA / IRISA - VisAGeS Team", ' ',ANIMA_VERSION);
+
+    TCLAP::ValueArg<std::string> refArg("r","reffile","Reference segmentation",false,"","reference image",cmd);
+    TCLAP::ValueArg<std::string> testArg("t","testfile","Test segmentation",false,"","test image",cmd);
+    TCLAP::ValueArg<std::string> listArg("l","list","Text file listing one reference and test segmentation pair per line",false,"","pairs list",cmd);
+
+    TCLAP::ValueArg<std::string> outArg("o","out-file","Output file (default: standard output)",false,"","output file",cmd);
+    TCLAP::SwitchArg jsonArg("J","json","Output results as JSON instead of CSV",cmd,false);
+
+    TCLAP::SwitchArg fullConnectArg("F","full-connect","Use 26-connectivity instead of 6-connectivity for lesions",cmd,false);
+    TCLAP::ValueArg<unsigned int> minOverlapArg("m","min-overlap","Minimal number of overlapping voxels for a lesion to be detected (default: 1)",false,1,"minimal overlap",cmd);
+    TCLAP::ValueArg<unsigned int> nbpArg("T","numberofthreads","Number of threads to run on (default : all cores)",false,itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),"number of threads",cmd);
+
+    try
+    {
+        cmd.parse(argc,argv);
+    }
+    catch (TCLAP::ArgException& e)
+    {
+        std::cerr << "Error: " << e.error() << "for argument " << e.argId() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector < std::pair <std::string, std::string> > pairs;
+    if (listArg.getValue() != "")
+    {
+        std::ifstream listFile(listArg.getValue().c_str());
+        if (!listFile.is_open())
+        {
+            std::cerr << "Can not open file: " << listArg.getValue() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::string line;
+        while (std::getline(listFile,line))
+        {
+            std::istringstream lineStream(line);
+            std::string refFile, testFile;
+            if (!(lineStream >> refFile >> testFile))
+                continue;
+
+            pairs.push_back(std::make_pair(refFile,testFile));
+        }
+    }
+
+    if ((refArg.getValue() != "") && (testArg.getValue() != ""))
+        pairs.push_back(std::make_pair(refArg.getValue(),testArg.getValue()));
+
+    if (pairs.size() == 0)
+    {
+        std::cerr << "No reference and test segmentation pair to evaluate" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector <EvaluationResults> results(pairs.size());
+
+    try
+    {
+        for (unsigned int i = 0;i < pairs.size();++i)
+        {
+            evaluatePair(pairs[i].first,pairs[i].second,fullConnectArg.isSet(),minOverlapArg.getValue(),
+                         nbpArg.getValue(),results[i]);
+        }
+    }
+    catch (itk::ExceptionObject &e)
+    {
+        std::cerr << e << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream outFile;
+    std::ostream *outStream = &std::cout;
+    if (outArg.getValue() != "")
+    {
+        outFile.open(outArg.getValue().c_str(), std::ios::out | std::ios::trunc);
+        if (!outFile.is_open())
+        {
+            std::cerr << "Can not open file: " << outArg.getValue() << " to store results" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        outStream = &outFile;
+    }
+
+    if (jsonArg.isSet())
+        writeJSON(*outStream,results);
+    else
+        writeCSV(*outStream,results);
+
+    if (outFile.is_open())
+        outFile.close();
+
+    return EXIT_SUCCESS;
+}
@@ -1,14 +1,15 @@
 #include <tclap/CmdLine.h>
 
-#include <itkTimeProbe.h>
 #include <animaReadWriteFunctions.h>
-#include "animaRemoveTouchingBorderFilter.h"
+#include <animaLabelStatisticsComputer.h>
+
+#include <fstream>
 
 int main(int argc, const char** argv)
 {
     const unsigned int Dimension = 3;
     typedef itk::Image <unsigned char,Dimension> ImageType;
-    typedef itk::ImageRegionConstIterator <ImageType> ImageIterator;
+    typedef anima::LabelStatisticsComputer <ImageType> LabelStatisticsComputerType;
 
     // Parsing arguments
     TCLAP::CmdLine cmd("INRIA / IRISA - VisAGeS Team", ' ',ANIMA_VERSION);
@@ -28,23 +29,13 @@ int main(int argc, const char** argv)
         return EXIT_FAILURE;
     }
 
-    ImageType::Pointer inputImage = anima::readImage <ImageType> (inArg.getValue());
-
-    ImageIterator inputIt(inputImage,inputImage->GetLargestPossibleRegion());
-
-    unsigned int cpt=0;
-    while(!inputIt.IsAtEnd())
-    {
-        if(inputIt.Get() != 0)
-            ++cpt;
-
-        ++inputIt;
-    }
+    LabelStatisticsComputerType::Pointer statisticsComputer = LabelStatisticsComputerType::New();
+    statisticsComputer->SetInputImage(anima::readImage <ImageType> (inArg.getValue()));
+    statisticsComputer->SetComputeComponents(false);
+    statisticsComputer->Update();
 
-    ImageType::SpacingType spacing = inputImage->GetSpacing();
-    ImageType::SpacingValueType spacingTot = spacing[0];
-    for (unsigned int i = 1; i < 3;++i)
-        spacingTot *= spacing[i];
+    double cpt = statisticsComputer->GetForegroundVolume();
+    double spacingTot = statisticsComputer->GetVoxelVolume();
 
     std::ofstream oFileOut;
     if (outArg.getValue() != "")
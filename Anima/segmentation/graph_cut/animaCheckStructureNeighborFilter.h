@@ -5,13 +5,8 @@
 #include <itkImageToImageFilter.h>
 #include <itkImageRegionIterator.h>
 #include <itkImageRegionConstIterator.h>
-#include <itkRelabelComponentImageFilter.h>
-#include <itkConnectedComponentImageFilter.h>
-#include <itkGrayscaleDilateImageFilter.h>
-#include <itkBinaryBallStructuringElement.h>
-#include <itkBinaryImageToLabelMapFilter.h>
-#include <itkLabelMapToLabelImageFilter.h>
-#include <itkLabelContourImageFilter.h>
+
+#include <animaLabelStatisticsComputer.h>
 
 namespace anima
 {
@@ -19,7 +14,8 @@ namespace anima
  * Intensity rules may not be enough to discard false positives, therefore we also use localization information.
  * Considering that MS lesions are typically located in WM, we remove the detected ones that do not sufficiently achieve this condition.
  * This filter take two entries: a lesion mask and a white matter map.
- *
+ * A lesion is kept if the ratio of its contour faces whose outside neighbor is in the map is at least Ratio.
+ * Components and their contour statistics are computed in a single threaded labeling pass (see anima::LabelStatisticsComputer).
  */
 template<typename TInput, typename TMask, typename TOutput = TInput>
 class CheckStructureNeighborFilter :
@@ -58,14 +54,9 @@ public:
     typedef typename OutputImageType::PixelType OutputPixelType;
     typedef typename itk::ImageRegionIterator <OutputImageType> OutputIteratorType;
 
-    typedef int 	PixelTypeInt;
-    typedef itk::Image <PixelTypeInt,3> ImageTypeInt;
-    typedef itk::ImageRegionIterator <ImageTypeInt> ImageIteratorTypeInt;
-
-    typedef typename itk::ConnectedComponentImageFilter <InputImageType,ImageTypeInt> ConnectedComponentFilterType;
-    typedef itk::LabelContourImageFilter<ImageTypeInt,ImageTypeInt> LabelContourFilterType;
-    typedef itk::BinaryBallStructuringElement<PixelTypeInt, 3> StructuringElementType;
-    typedef itk::GrayscaleDilateImageFilter <ImageTypeInt,ImageTypeInt,StructuringElementType> DilateFilterType;
+    typedef anima::LabelStatisticsComputer <InputImageType,MaskImageType> ComponentsComputerType;
+    typedef typename ComponentsComputerType::LabelImageType LabelImageType;
+    typedef itk::ImageRegionConstIterator <LabelImageType> LabelConstIteratorType;
 
     /** The mri images.*/
     void SetInputClassification(const TInput* image);
@@ -47,92 +47,47 @@ void
 CheckStructureNeighborFilter< TInput, TMask, TOutput >
 ::GenerateData()
 {
-    bool fullyConnected = false;
-
-    // Create labeled map
-    typename ConnectedComponentFilterType::Pointer ConnectedComponentFilter = ConnectedComponentFilterType::New();
-    ConnectedComponentFilter->SetInput( this->GetInputClassification() );
-    ConnectedComponentFilter->SetNumberOfThreads(this->GetNumberOfThreads());
-    ConnectedComponentFilter->SetCoordinateTolerance(m_Tol);
-    ConnectedComponentFilter->SetDirectionTolerance(m_Tol);
-    ConnectedComponentFilter->SetFullyConnected( fullyConnected );
-
-    unsigned int radius = 1;
-
-    StructuringElementType structuringElement;
-    structuringElement.SetRadius(radius);
-    structuringElement.CreateStructuringElement();
-
-    DilateFilterType::Pointer dilateFilter = DilateFilterType::New();
-    dilateFilter->SetInput(ConnectedComponentFilter->GetOutput());
-    dilateFilter->SetKernel(structuringElement);
-    dilateFilter->SetNumberOfThreads(this->GetNumberOfThreads());
-    dilateFilter->SetCoordinateTolerance(m_Tol);
-    dilateFilter->SetDirectionTolerance(m_Tol);
-    dilateFilter->Update();
-
-    // Find contours
-    typename LabelContourFilterType::Pointer filterLabelContour = LabelContourFilterType::New();
-    filterLabelContour->SetInput(dilateFilter->GetOutput());
-    filterLabelContour->SetFullyConnected( fullyConnected );
-    filterLabelContour->SetNumberOfThreads(this->GetNumberOfThreads());
-    filterLabelContour->SetCoordinateTolerance(m_Tol);
-    filterLabelContour->SetDirectionTolerance(m_Tol);
-    filterLabelContour->Update();
-
-    unsigned int objectCount = ConnectedComponentFilter->GetObjectCount();
-
-    std::vector<unsigned int> nbVoxelContour(objectCount+1,0);
-    std::vector<unsigned int> nbVoxelIntersec(objectCount+1,0);
+    // Single labeling pass, voxels around each lesion (radius 1 ball dilation) and their contact with the map are counted
+    typename ComponentsComputerType::Pointer componentsComputer = ComponentsComputerType::New();
+    componentsComputer->SetInputImage( this->GetInputClassification() );
+    componentsComputer->SetStructureMap( this->GetInputMap() );
+    componentsComputer->SetNumberOfThreads( this->GetNumberOfThreads() );
+    componentsComputer->Update();
+
+    unsigned int objectCount = componentsComputer->GetNumberOfComponents();
     std::vector<bool> enoughContour(objectCount+1,true);
 
-    ImageIteratorTypeInt labelContourIt(filterLabelContour->GetOutput(), filterLabelContour->GetOutput()->GetLargestPossibleRegion());
-    MaskConstIteratorType mapIt(this->GetInputMap(), this->GetInputMap()->GetLargestPossibleRegion());
-    while(!labelContourIt.IsAtEnd())
-    {
-        if(labelContourIt.Get()!=0)
-        {
-            nbVoxelContour[labelContourIt.Get()]++;
-            if(mapIt.Get()!=0)
-            {
-                nbVoxelIntersec[labelContourIt.Get()]++;
-            }
-        }
-        ++labelContourIt;
-        ++mapIt;
-    }
-
     // calculer les ratios
     for(unsigned int i = 1; i < objectCount+1; i++)
     {
-        if(static_cast<float>(nbVoxelIntersec[i])/static_cast<float>(nbVoxelContour[i]) < m_Ratio)
+        const typename ComponentsComputerType::ComponentStatistics &statistics = componentsComputer->GetComponentStatistics(i);
+        if(statistics.neighborSize == 0)
+            continue;
+
+        if(static_cast<float>(statistics.structureNeighborSize)/static_cast<float>(statistics.neighborSize) < m_Ratio)
         {
             enoughContour[i] = false;
         }
     }
 
-
     // Calculer output
     OutputImagePointer output = this->GetOutput();
     output->SetRegions( this->GetInputClassification()->GetLargestPossibleRegion() );
     output->CopyInformation( this->GetInputClassification() );
     output->Allocate();
-    output->FillBuffer(0);
 
-    ImageIteratorTypeInt classifIt(ConnectedComponentFilter->GetOutput(), ConnectedComponentFilter->GetOutput()->GetLargestPossibleRegion());
+    LabelConstIteratorType labelIt(componentsComputer->GetLabelImage(), componentsComputer->GetLabelImage()->GetLargestPossibleRegion());
     OutputIteratorType outputIt(output, output->GetLargestPossibleRegion());
-    while(!classifIt.IsAtEnd())
+    while(!labelIt.IsAtEnd())
     {
+        unsigned int component = labelIt.Get();
         outputIt.Set(0);
-        if(classifIt.Get()!=0)
+        if((component != 0)&&(enoughContour[component]))
         {
-            if(enoughContour[classifIt.Get()]==true)
-            {
-                outputIt.Set(1);
-            }
+            outputIt.Set(1);
         }
         ++outputIt;
-        ++classifIt;
+        ++labelIt;
     }
 }
 
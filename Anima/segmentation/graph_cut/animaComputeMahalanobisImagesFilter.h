@@ -3,17 +3,24 @@
 #include <itkImageToImageFilter.h>
 #include <itkImageRegionIterator.h>
 #include <itkImageRegionConstIterator.h>
-#include <itkChiSquareDistribution.h>
-#include <itkMahalanobisDistanceThresholdImageFunction.h>
 #include <itkGaussianMembershipFunction.h>
-#include <itkRescaleIntensityImageFilter.h>
-#include <animaReadWriteFunctions.h>
+#include <itkMinimumMaximumImageCalculator.h>
+#include <animaImageWriteService.h>
+
+#include <vnl/vnl_matrix.h>
+#include <vnl/algo/vnl_symmetric_eigensystem.h>
+
+#include <cmath>
+#include <algorithm>
 
 namespace anima
 {
 /**
  * @brief Compute the mahalanobis images from the NABT model.
- *
+ * Modalities are rescaled on the fly to [0,255] as unsigned char values, the Cholesky factor of each class
+ * covariance is inverted once before the threaded pass, and each voxel is read once to compute the distances
+ * to all classes, their outlier probabilities (closed form 3 degrees of freedom chi-square CDF) and the
+ * minimum and maximum maps.
  */
 template <typename TInputImage, typename TMaskImage, typename TOutput = TInputImage>
 class ComputeMahalanobisImagesFilter :
@@ -53,14 +60,7 @@ public:
     /** Superclass typedefs. */
     typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
 
-    /**   */
-    typedef unsigned char 	PixelTypeUC;
-    typedef itk::Image <PixelTypeUC,3> ImageTypeUC;
-    typedef ImageTypeUC::Pointer ImagePointerUC;
-    typedef itk::ImageRegionConstIterator <ImageTypeUC> ImageConstIteratorTypeUC;
-
-    /** Define filter types. */
-    typedef typename itk::RescaleIntensityImageFilter<TInputImage,ImageTypeUC> RescaleFilterType;
+    typedef itk::MinimumMaximumImageCalculator<InputImageType> MinMaxCalculatorType;
 
     typedef itk::VariableLengthVector<double> MeasurementVectorType;
     typedef itk::Statistics::GaussianMembershipFunction< MeasurementVectorType > GaussianFunctionType;
@@ -156,6 +156,12 @@ protected:
     void BeforeThreadedGenerateData() ITK_OVERRIDE;
     void ThreadedGenerateData(const OutputImageRegionType &outputRegionForThread, itk::ThreadIdType threadId) ITK_OVERRIDE;
 
+    //! Computes the affine map of an input image to [0,255], as done by itk::RescaleIntensityImageFilter
+    void ComputeRescaleParameters(const InputImageType *image, double &factor, double &offset);
+
+    //! Upper tail of the chi-square distribution with 3 degrees of freedom
+    static double ComputeChiSquareComplementaryCDF(double value);
+
 private:
     ComputeMahalanobisImagesFilter(const Self&); //purposely not implemented
     void operator=(const Self&); //purposely not implemented
@@ -178,9 +184,12 @@ private:
     std::string m_OutputMahaMinimumFilename;
     std::string m_OutputMahaMaximumFilename;
 
-    ImagePointerUC m_InputImage_1_UC;
-    ImagePointerUC m_InputImage_2_UC;
-    ImagePointerUC m_InputImage_3_UC;
+    std::vector<double> m_RescaleFactors;
+    std::vector<double> m_RescaleOffsets;
+
+    //! Per class mean and whitening matrix (inverse Cholesky factor of the covariance)
+    std::vector< std::vector<double> > m_Means;
+    std::vector< vnl_matrix<double> > m_WhiteningMatrices;
 
 
 };
@@ -121,30 +121,67 @@ ComputeMahalanobisImagesFilter <TInputImage, TMaskImage, TOutput>::WriteOutputs(
     if( m_OutputMahaCSFFilename != "" )
     {
         std::cout << "Writing mahalanobis CSF image to: " << m_OutputMahaCSFFilename << std::endl;
-        anima::writeImage<TOutput>(m_OutputMahaCSFFilename, this->GetOutputMahaCSF());
+        anima::queueImageForWriting<TOutput>(m_OutputMahaCSFFilename, this->GetOutputMahaCSF());
     }
     if( m_OutputMahaGMFilename != "" )
     {
         std::cout << "Writing mahalanobis GM image to: " << m_OutputMahaGMFilename << std::endl;
-        anima::writeImage<TOutput>(m_OutputMahaGMFilename, this->GetOutputMahaGM());
+        anima::queueImageForWriting<TOutput>(m_OutputMahaGMFilename, this->GetOutputMahaGM());
     }
     if( m_OutputMahaWMFilename != "" )
     {
         std::cout << "Writing mahalanobis WM image to: " << m_OutputMahaWMFilename << std::endl;
-        anima::writeImage<TOutput>(m_OutputMahaWMFilename, this->GetOutputMahaWM());
+        anima::queueImageForWriting<TOutput>(m_OutputMahaWMFilename, this->GetOutputMahaWM());
     }
     if( m_OutputMahaMinimumFilename != "" )
     {
         std::cout << "Writing minimum mahalanobis image to: " << m_OutputMahaMinimumFilename << std::endl;
-        anima::writeImage<TOutput>(m_OutputMahaMinimumFilename, this->GetOutputMahaMinimum());
+        anima::queueImageForWriting<TOutput>(m_OutputMahaMinimumFilename, this->GetOutputMahaMinimum());
     }
     if( m_OutputMahaMaximumFilename != "" )
     {
         std::cout << "Writing maximum mahalanobis image to: " << m_OutputMahaMaximumFilename << std::endl;
-        anima::writeImage<TOutput>(m_OutputMahaMaximumFilename, this->GetOutputMahaMaximum());
+        anima::queueImageForWriting<TOutput>(m_OutputMahaMaximumFilename, this->GetOutputMahaMaximum());
     }
 }
 
+template <typename TInputImage, typename TMaskImage, typename TOutput>
+void
+ComputeMahalanobisImagesFilter <TInputImage, TMaskImage, TOutput>
+::ComputeRescaleParameters(const InputImageType *image, double &factor, double &offset)
+{
+    double desiredMinimum=0,desiredMaximum=255;
+
+    typename MinMaxCalculatorType::Pointer minMaxCalculator = MinMaxCalculatorType::New();
+    minMaxCalculator->SetImage( image );
+    minMaxCalculator->Compute();
+
+    double inputMinimum = minMaxCalculator->GetMinimum();
+    double inputMaximum = minMaxCalculator->GetMaximum();
+
+    factor = 0;
+    if ( inputMinimum != inputMaximum )
+        factor = ( desiredMaximum - desiredMinimum ) / ( inputMaximum - inputMinimum );
+    else if ( inputMaximum != 0 )
+        factor = ( desiredMaximum - desiredMinimum ) / inputMaximum;
+
+    offset = desiredMinimum - inputMinimum * factor;
+}
+
+template <typename TInputImage, typename TMaskImage, typename TOutput>
+double
+ComputeMahalanobisImagesFilter <TInputImage, TMaskImage, TOutput>
+::ComputeChiSquareComplementaryCDF(double value)
+{
+    if ( value <= 0 )
+        return 1.0;
+
+    // CDF(x) = erf(sqrt(x/2)) - sqrt(2x/pi) exp(-x/2) for 3 degrees of freedom
+    double cdfValue = std::erf( std::sqrt( value / 2.0 ) ) - std::sqrt( 2.0 * value / M_PI ) * std::exp( - value / 2.0 );
+
+    return 1.0 - cdfValue;
+}
+
 template <typename TInputImage, typename TMaskImage, typename TOutput>
 void
 ComputeMahalanobisImagesFilter <TInputImage, TMaskImage, TOutput>
@@ -156,42 +193,97 @@ ComputeMahalanobisImagesFilter <TInputImage, TMaskImage, TOutput>
         exit(-1);
     }
 
-    m_InputImage_1_UC = ImageTypeUC::New();
-    m_InputImage_2_UC = ImageTypeUC::New();
-    m_InputImage_3_UC = ImageTypeUC::New();
+    m_RescaleFactors.resize( m_NbModalities );
+    m_RescaleOffsets.resize( m_NbModalities );
+    this->ComputeRescaleParameters( this->GetInputImage1(), m_RescaleFactors[0], m_RescaleOffsets[0] );
+    this->ComputeRescaleParameters( this->GetInputImage2(), m_RescaleFactors[1], m_RescaleOffsets[1] );
+    this->ComputeRescaleParameters( this->GetInputImage3(), m_RescaleFactors[2], m_RescaleOffsets[2] );
 
-    // Rescale images
-    double desiredMinimum=0,desiredMaximum=255;
+    m_Means.resize( m_NbTissus );
+    m_WhiteningMatrices.resize( m_NbTissus );
+    for(unsigned int i = 0; i < m_NbTissus; i++)
+    {
+        GaussianFunctionType::MeanVectorType mean = (m_GaussianModel[i])->GetMean();
+        GaussianFunctionType::CovarianceMatrixType cov = (m_GaussianModel[i])->GetCovariance();
+
+        if( mean.Size() != m_NbModalities )
+        {
+            std::cout << "Error in mahalanobis filter: model dimension does not correspond to the number of images exiting..."<< std::endl;
+            exit(-1);
+        }
+
+        m_Means[i].resize( m_NbModalities );
+        for(unsigned int j = 0; j < m_NbModalities; j++)
+            m_Means[i][j] = mean[j];
+
+        // Cholesky factor L of the covariance, distance is then |L^-1 (x - mean)|
+        vnl_matrix<double> cholesky( m_NbModalities, m_NbModalities, 0.0 );
+        bool positiveDefinite = true;
+        for(unsigned int j = 0; j < m_NbModalities && positiveDefinite; j++)
+        {
+            for(unsigned int k = 0; k <= j; k++)
+            {
+                double sum = cov[j][k];
+                for(unsigned int l = 0; l < k; l++)
+                    sum -= cholesky(j,l) * cholesky(k,l);
+
+                if( k == j )
+                {
+                    if( sum <= 0 )
+                    {
+                        positiveDefinite = false;
+                        break;
+                    }
+
+                    cholesky(j,j) = std::sqrt( sum );
+                }
+                else
+                    cholesky(j,k) = sum / cholesky(k,k);
+            }
+        }
+
+        vnl_matrix<double> &whitening = m_WhiteningMatrices[i];
+        whitening.set_size( m_NbModalities, m_NbModalities );
+        whitening.fill( 0.0 );
+
+        if( positiveDefinite )
+        {
+            // Inverse of the lower triangular factor by forward substitution
+            for(unsigned int k = 0; k < m_NbModalities; k++)
+            {
+                whitening(k,k) = 1.0 / cholesky(k,k);
+                for(unsigned int j = k + 1; j < m_NbModalities; j++)
+                {
+                    double sum = 0;
+                    for(unsigned int l = k; l < j; l++)
+                        sum -= cholesky(j,l) * whitening(l,k);
+
+                    whitening(j,k) = sum / cholesky(j,j);
+                }
+            }
+        }
+        else
+        {
+            // Degenerate covariance: pseudo-inverse square root from its eigen decomposition
+            vnl_matrix<double> covarianceMatrix( m_NbModalities, m_NbModalities );
+            for(unsigned int j = 0; j < m_NbModalities; j++)
+            {
+                for(unsigned int k = 0; k < m_NbModalities; k++)
+                    covarianceMatrix(j,k) = cov[j][k];
+            }
+
+            vnl_symmetric_eigensystem<double> eigenSystem( covarianceMatrix );
+            for(unsigned int j = 0; j < m_NbModalities; j++)
+            {
+                double eigenValue = eigenSystem.get_eigenvalue(j);
+                if( eigenValue <= 1.0e-12 )
+                    continue;
 
-    typename RescaleFilterType::Pointer rescaleFilter1 = RescaleFilterType::New();
-    rescaleFilter1->SetInput( this->GetInputImage1() );
-    rescaleFilter1->SetOutputMinimum( desiredMinimum );
-    rescaleFilter1->SetOutputMaximum( desiredMaximum );
-    rescaleFilter1->SetNumberOfThreads(this->GetNumberOfThreads());
-    rescaleFilter1->SetCoordinateTolerance(m_Tol);
-    rescaleFilter1->SetDirectionTolerance(m_Tol);
-    rescaleFilter1->UpdateLargestPossibleRegion();
-    m_InputImage_1_UC = rescaleFilter1->GetOutput();
-
-    typename RescaleFilterType::Pointer rescaleFilter2 = RescaleFilterType::New();
-    rescaleFilter2->SetInput( this->GetInputImage2() );
-    rescaleFilter2->SetOutputMinimum( desiredMinimum );
-    rescaleFilter2->SetOutputMaximum( desiredMaximum );
-    rescaleFilter2->SetNumberOfThreads(this->GetNumberOfThreads());
-    rescaleFilter2->SetCoordinateTolerance(m_Tol);
-    rescaleFilter2->SetDirectionTolerance(m_Tol);
-    rescaleFilter2->UpdateLargestPossibleRegion();
-    m_InputImage_2_UC = rescaleFilter2->GetOutput();
-
-    typename RescaleFilterType::Pointer rescaleFilter3 = RescaleFilterType::New();
-    rescaleFilter3->SetInput( this->GetInputImage3() );
-    rescaleFilter3->SetOutputMinimum( desiredMinimum );
-    rescaleFilter3->SetOutputMaximum( desiredMaximum );
-    rescaleFilter3->SetNumberOfThreads(this->GetNumberOfThreads());
-    rescaleFilter3->SetCoordinateTolerance(m_Tol);
-    rescaleFilter3->SetDirectionTolerance(m_Tol);
-    rescaleFilter3->UpdateLargestPossibleRegion();
-    m_InputImage_3_UC = rescaleFilter3->GetOutput();
+                for(unsigned int k = 0; k < m_NbModalities; k++)
+                    whitening(j,k) = eigenSystem.get_eigenvector(j)[k] / std::sqrt( eigenValue );
+            }
+        }
+    }
 }
 
 
@@ -199,13 +291,6 @@ template <typename TInputImage, typename TMaskImage, typename TOutput>
 void
 ComputeMahalanobisImagesFilter <TInputImage, TMaskImage, TOutput>::ThreadedGenerateData(const OutputImageRegionType &outputRegionForThread, itk::ThreadIdType threadId)
 {
-    const unsigned int                         Dimension = 3;
-    typedef double                      PixelComponentType;
-    typedef itk::RGBPixel<PixelComponentType>  PixelType;
-    typedef itk::Image< PixelType, Dimension > ImageType;
-    typedef itk::MahalanobisDistanceThresholdImageFunction< ImageType > FunctionType;
-    typedef FunctionType::IndexType FunctionIndexType;
-
     OutputIteratorType mahaCSFIt(this->GetOutputMahaCSF(), outputRegionForThread );
     OutputIteratorType mahaGMIt(this->GetOutputMahaGM(), outputRegionForThread );
     OutputIteratorType mahaWMIt(this->GetOutputMahaWM(), outputRegionForThread );
@@ -213,41 +298,16 @@ ComputeMahalanobisImagesFilter <TInputImage, TMaskImage, TOutput>::ThreadedGener
     OutputIteratorType mahaMaxiIt(this->GetOutputMahaMaximum(), outputRegionForThread );
     OutputIteratorType mahaMiniIt(this->GetOutputMahaMinimum(), outputRegionForThread );
 
-    ImageType::Pointer image = ImageType::New();
-    image->SetRegions( this->GetMask()->GetLargestPossibleRegion() );
-    image->CopyInformation( this->GetMask() );
-    image->Allocate();
-    itk::ImageRegionIterator<ImageType> itRGB (image, outputRegionForThread);
-
-    ImageConstIteratorTypeUC It1(m_InputImage_1_UC, outputRegionForThread );
-    ImageConstIteratorTypeUC It2(m_InputImage_2_UC, outputRegionForThread );
-    ImageConstIteratorTypeUC It3(m_InputImage_3_UC, outputRegionForThread );
-
-    while(!itRGB.IsAtEnd())
-    {
-        PixelType pix;
-        pix[0] = It1.Get();
-        pix[1] = It2.Get();
-        pix[2] = It3.Get();
-        itRGB.Set(pix);
-        ++It1;
-        ++It2;
-        ++It3;
-        ++itRGB;
-    }
-
-    FunctionType::Pointer function = FunctionType::New();
-    FunctionType::CovarianceMatrixType Covariance( m_NbModalities, m_NbModalities );
-    Covariance.fill( 0.0 );
-
-    FunctionType::MeanVectorType Mean( m_NbModalities );
-    function->SetInputImage( image );
+    std::vector<InputConstIteratorType> inputIterators(m_NbModalities);
+    inputIterators[0] = InputConstIteratorType(this->GetInputImage1(), outputRegionForThread );
+    inputIterators[1] = InputConstIteratorType(this->GetInputImage2(), outputRegionForThread );
+    inputIterators[2] = InputConstIteratorType(this->GetInputImage3(), outputRegionForThread );
 
     MaskConstIteratorType MaskImageIt ( this->GetMask(), outputRegionForThread );
 
-    itk::Statistics::ChiSquareDistribution::Pointer chi = itk::Statistics::ChiSquareDistribution::New();
-    itk::SizeValueType degree = (m_GaussianModel[0])->GetMean().Size();
-    chi->SetDegreesOfFreedom(degree);
+    std::vector<double> centeredValues(m_NbModalities);
+    std::vector<double> sample(m_NbModalities);
+    std::vector<double> outlierProbas(m_NbTissus);
 
     while(!MaskImageIt.IsAtEnd())
     {
@@ -259,59 +319,47 @@ ComputeMahalanobisImagesFilter <TInputImage, TMaskImage, TOutput>::ThreadedGener
 
         if(MaskImageIt.Get()!=0)
         {
-            FunctionIndexType ind;
-            ind[0] = MaskImageIt.GetIndex()[0];
-            ind[1] = MaskImageIt.GetIndex()[1];
-            ind[2] = MaskImageIt.GetIndex()[2];
+            // Values as the unsigned char rescaled images would hold them
+            for(unsigned int j = 0; j < m_NbModalities; j++)
+            {
+                double value = inputIterators[j].Get() * m_RescaleFactors[j] + m_RescaleOffsets[j];
+                value = std::max(0.0, std::min(255.0, value));
+                sample[j] = std::floor(value);
+            }
 
+            double maxProba = 0;
             for(unsigned int i = 0; i < m_NbTissus; i++)
             {
-                GaussianFunctionType::MeanVectorType mean = (m_GaussianModel[i])->GetMean();
-                Mean[0] = mean[0];
-                Mean[1] = mean[1];
-                Mean[2] = mean[2];
-
-                GaussianFunctionType::CovarianceMatrixType cov = (m_GaussianModel[i])->GetCovariance();
-                Covariance[0][0] = cov[0][0]; Covariance[1][0] = cov[1][0]; Covariance[2][0] = cov[2][0];
-                Covariance[0][1] = cov[0][1]; Covariance[1][1] = cov[1][1]; Covariance[2][1] = cov[2][1];
-                Covariance[0][2] = cov[0][2]; Covariance[1][2] = cov[1][2]; Covariance[2][2] = cov[2][2];
-
-                function->SetCovariance( Covariance );
-                function->SetMean( Mean );
-                double distanceD = function->EvaluateDistanceAtIndex( ind );
-                double chiRes = chi->EvaluateCDF(distanceD);
-                double distance = 1-chiRes;
-
-                if(i==0)
-                {
-                    mahaCSFIt.Set(static_cast<OutputPixelType>(distance));
-                }
-                if(i==1)
-                {
-                    mahaGMIt.Set(static_cast<OutputPixelType>(distance));
-                }
-                if(i==2)
-                {
-                    mahaWMIt.Set(static_cast<OutputPixelType>(distance));
-                }
+                for(unsigned int j = 0; j < m_NbModalities; j++)
+                    centeredValues[j] = sample[j] - m_Means[i][j];
 
-
-                if(mahaMaxiIt.Get() < mahaCSFIt.Get())
-                {
-                    mahaMaxiIt.Set(mahaCSFIt.Get());
-                }
-                if(mahaMaxiIt.Get() < mahaGMIt.Get())
-                {
-                    mahaMaxiIt.Set(mahaGMIt.Get());
-                }
-                if(mahaMaxiIt.Get() < mahaWMIt.Get())
+                const vnl_matrix<double> &whitening = m_WhiteningMatrices[i];
+                double squaredDistance = 0;
+                for(unsigned int j = 0; j < m_NbModalities; j++)
                 {
-                    mahaMaxiIt.Set(mahaWMIt.Get());
+                    double whitenedValue = 0;
+                    for(unsigned int k = 0; k < m_NbModalities; k++)
+                        whitenedValue += whitening(j,k) * centeredValues[k];
+
+                    squaredDistance += whitenedValue * whitenedValue;
                 }
-                mahaMiniIt.Set(1.0 - mahaMaxiIt.Get());
+
+                // Chi-square evaluated on the distance itself, as in the original NABT outlier maps
+                outlierProbas[i] = ComputeChiSquareComplementaryCDF(std::sqrt(squaredDistance));
+                if(outlierProbas[i] > maxProba)
+                    maxProba = outlierProbas[i];
             }
+
+            mahaCSFIt.Set(static_cast<OutputPixelType>(outlierProbas[0]));
+            mahaGMIt.Set(static_cast<OutputPixelType>(outlierProbas[1]));
+            mahaWMIt.Set(static_cast<OutputPixelType>(outlierProbas[2]));
+            mahaMaxiIt.Set(static_cast<OutputPixelType>(maxProba));
+            mahaMiniIt.Set(static_cast<OutputPixelType>(1.0 - maxProba));
         }
 
+        for(unsigned int j = 0; j < m_NbModalities; j++)
+            ++inputIterators[j];
+
         ++mahaCSFIt;
         ++mahaGMIt;
         ++mahaWMIt;
@@ -2,7 +2,7 @@
 
 #include <itkImageToImageFilter.h>
 #include <itkVariableSizeMatrix.h>
-#include <animaReadWriteFunctions.h>
+#include <animaImageWriteService.h>
 #include "animaTLinksFilter.h"
 #include "animaGraph3DFilter.h"
 
@@ -139,12 +139,12 @@ GraphCutFilter<TInput, TOutput>
     if( m_OutputFilename != "" )
     {
         std::cout << "Writing graph cut output image to: " << m_OutputFilename << std::endl;
-        anima::writeImage<TOutput>(m_OutputFilename, this->GetOutput());
+        anima::queueImageForWriting<TOutput>(m_OutputFilename, this->GetOutput());
     }
     if( m_OutputBackgroundFilename != "" )
     {
         std::cout << "Writing graph cut output image to: " << m_OutputBackgroundFilename << std::endl;
-        anima::writeImage<TOutput>(m_OutputBackgroundFilename, this->GetOutputBackground());
+        anima::queueImageForWriting<TOutput>(m_OutputBackgroundFilename, this->GetOutputBackground());
     }
 }
 
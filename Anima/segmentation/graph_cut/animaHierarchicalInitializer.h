@@ -9,9 +9,9 @@
 #include <itkListSample.h>
 #include <itkDenseFrequencyContainer2.h>
 #include <itkSampleToHistogramFilter.h>
-#include <itkMinimumMaximumImageCalculator.h>
 #include <itkImageRegionIterator.h>
-#include <itkMaskImageFilter.h>
+
+#include <animaImageHistogramsComputer.h>
 
 
 namespace anima
@@ -69,8 +69,7 @@ public:
     typedef anima::ImageClassifierFilter<InputImageType,InputImageType> ImageClassifierType;
     typedef anima::GaussianREMEstimator<InputImageType,MaskImageType> GaussianREMEstimatorType;
     typedef anima::ClassificationStrategy<InputImageType,MaskImageType> ClassificationStrategyType;
-    typedef itk::MaskImageFilter< InputImageType, InputImageType > MaskFilterType;
-    typedef itk::MinimumMaximumImageCalculator<InputImageType>   MinMaxCalculatorType;
+    typedef anima::ImageHistogramsComputer<InputImageType,InputImageType> HistogramsComputerType;
 
     typedef std::map<double, std::vector<GaussianFunctionType::Pointer> > ModelMap;
     typedef std::map<double, std::vector<double> > ModelMap2;
@@ -128,6 +127,7 @@ public:
      * extraction of the brain are typically classified as CSF.
      * For this reason, a 256-bin histogram is computed for each tissue t ∈ CSF, GM, WM  and sequence s ∈ T2, PD, FLAIR  using the T1-w classification.
      * The histogram is then smoothed using a Gaussian kernel with standard deviation of 5 bins and all modes of the histogram are found.
+     * All histograms are computed at once from the T1-w classification image by a multithreaded anima::ImageHistogramsComputer.
      * For WM and GM where outliers are less important than in CSF, we set the initial μt,s  as the absolute mode of the histogram, but for
      * CSF, we set μCSF,s  as the brightest mode.
      * If this method is employed on FLAIR images, the μt,FLAIR  of all tissues are set to the absolute mode because the outliers have less
@@ -187,6 +187,7 @@ protected:
     std::vector<double> m_Solution1DAlphas;
 
     std::vector<InputImagePointer> m_ImagesClasses;
+    InputImagePointer m_ClassificationImage;
     std::vector< std::vector<double> > m_Stds;
     std::vector< std::vector<double> > m_SelectedMax;
 
@@ -155,6 +155,9 @@ void HierarchicalInitializer<TInputImage,TMaskImage>
     classifier->SetTol(m_Tol);
     classifier->Update();
 
+    m_ClassificationImage = classifier->GetOutput();
+    m_ClassificationImage->DisconnectPipeline();
+
     // creating one image per class (CSF, GM, WM)
     std::vector<InputIteratorType> classesIt;
     for(int i = 0; i < 3; i++)
@@ -206,148 +209,40 @@ void HierarchicalInitializer<TInputImage,TMaskImage>
     m_SelectedMax.resize( 3, std::vector<double>( 3, 0.0 ) );
     m_Stds.resize(3, std::vector<double>( 3, 0.0 ));
 
-    typedef double MeasurementType;
-    const unsigned int MeasurementVectorLength = 1;
-    typedef itk::Vector< MeasurementType , MeasurementVectorLength > MeasurementVectorType;
-    typedef itk::Statistics::ListSample< MeasurementVectorType > ListSampleType;
-    typedef itk::Statistics::DenseFrequencyContainer2 FrequencyContainerType;
-    typedef itk::Statistics::Histogram< MeasurementType,FrequencyContainerType > HistogramType;
-    typedef itk::Statistics::SampleToHistogramFilter<ListSampleType,HistogramType> FilterType;
+    // All modality and class histograms in one go, labels are classes of the T1-w classification
+    typename HistogramsComputerType::Pointer histogramsComputer = HistogramsComputerType::New();
+    for ( unsigned int im = 1; im < m_NumberOfModalities; im++ )
+        histogramsComputer->AddInputImage( m_ImagesVector[ im ] );
+
+    histogramsComputer->SetLabelImage( m_ClassificationImage );
+    histogramsComputer->SetNumberOfLabels( m_ImagesClasses.size() );
+    histogramsComputer->SetMaximalBinWidth( resolution );
+    histogramsComputer->SetNumberOfThreads( this->GetNumberOfThreads() );
+    histogramsComputer->Update();
 
-    InputImagePixelType valMaxInput = std::numeric_limits<InputImagePixelType>::max();
-    InputImagePixelType valMinInput = std::numeric_limits<InputImagePixelType>::min();
+    std::vector<double> smoothedFrequency;
+    std::vector<unsigned int> maxs;
+    const unsigned int localMax = 3;
 
-    // Compute mean values
     for ( unsigned int im = 1; im < m_NumberOfModalities; im++ )
     {
         for ( unsigned int c = 0; c < m_ImagesClasses.size(); c++ )
         {
-            //create the histogram with the selected mask
-            typename MaskFilterType::Pointer maskFilter = MaskFilterType::New();
-            typename MinMaxCalculatorType::Pointer calculator = MinMaxCalculatorType::New();
-            maskFilter->SetDirectionTolerance(m_Tol);
-            maskFilter->SetCoordinateTolerance(m_Tol);
-            maskFilter->SetInput( m_ImagesVector[ im ] );
-            maskFilter->SetMaskImage( m_ImagesClasses[ c ] );
-
-            maskFilter->SetOutsideValue( valMaxInput );
-            maskFilter->Update();
-            calculator->SetImage( maskFilter->GetOutput() );
-            calculator->ComputeMinimum();
-            InputImagePixelType minimumResult = calculator->GetMinimum();
-
-            maskFilter->SetOutsideValue( valMinInput );
-            maskFilter->Update();
-            calculator->SetImage( maskFilter->GetOutput() );
-            calculator->ComputeMaximum();
-            InputImagePixelType maximumResult = calculator->GetMaximum();
-
-            double minV = static_cast<double>(minimumResult);
-            double maxV = static_cast<double>(maximumResult);
-
-            unsigned int bins = static_cast<unsigned int>(std::floor( maxV - minV + 1.0 ));
-
-            ListSampleType::Pointer listSample = ListSampleType::New();
-            listSample->SetMeasurementVectorSize( MeasurementVectorLength );
-
-            InputConstIteratorType tmpIt (m_ImagesVector[im], m_ImagesVector[im]->GetLargestPossibleRegion() );
-            InputIteratorType classesCIt (m_ImagesClasses[ c ], m_ImagesClasses[ c ]->GetLargestPossibleRegion() );
-
-            MeasurementVectorType mv;
-            while (!classesCIt.IsAtEnd())
-            {
-                if(classesCIt.Get()!=0)
-                {
-                    mv[0] = ( MeasurementType ) tmpIt.Get();
-                    listSample->PushBack(mv);
-                }
-                ++classesCIt;
-                ++tmpIt;
-            }
-
-            // creation histo
-            const unsigned int numberOfComponents = 1;
-            HistogramType::SizeType size( numberOfComponents );
-            size.Fill( bins );
-            HistogramType::MeasurementVectorType min( numberOfComponents );
-            HistogramType::MeasurementVectorType max( numberOfComponents );
-            min.Fill( minV );
-            max.Fill( maxV );
+            double binWidth = histogramsComputer->GetBinWidth( im - 1, c + 1 );
+            double totalFrequency = histogramsComputer->GetTotalFrequency( im - 1, c + 1 );
 
-            FilterType::Pointer filter = FilterType::New();
-            filter->SetInput( listSample );
-            filter->SetHistogramSize( size );
-            filter->SetHistogramBinMinimum( min );
-            filter->SetHistogramBinMaximum( max );
-            filter->Update();
+            // Gaussian kernel density with the bandwidth expressed in intensity values
+            double sigma = ( binWidth > 0 ) ? bandwidth / binWidth : 0;
+            HistogramsComputerType::SmoothHistogram( histogramsComputer->GetHistogram( im - 1, c + 1 ), sigma, smoothedFrequency );
 
-            HistogramType::ConstPointer histogram = filter->GetOutput();
-
-            double bins2 = static_cast<double>(bins) / resolution;
-            unsigned int smoothedBins = static_cast<unsigned int>(bins2 + 1);
-
-            HistogramType::SizeType size2(MeasurementVectorLength);
-            size2.Fill(smoothedBins);
-
-            HistogramType::MeasurementVectorType lowerBound;
-            lowerBound.SetSize(smoothedBins);
-            lowerBound.Fill(minV);
-
-            HistogramType::MeasurementVectorType upperBound;
-            upperBound.SetSize(smoothedBins);
-            upperBound.Fill(maxV);
-
-            HistogramType::Pointer smoothed = HistogramType::New();
-            smoothed->SetMeasurementVectorSize(MeasurementVectorLength);
-            smoothed->Initialize(size2, lowerBound, upperBound );
-            smoothed->SetFrequency(0);
-
-            std::vector<double> smoothedFrequency(smoothedBins,0);
-
-            for (unsigned int i = 0; i < bins; ++i)
+            if ( totalFrequency * binWidth > 0 )
             {
-                for (unsigned int j = 0; j < smoothedBins; ++j)
-                {
-                    // Calculate distance in intensity values
-                    double valueI = static_cast<double>(i) / static_cast<double>(bins -1) * (maxV - minV) + minV;
-                    double valueJ = static_cast<double>(j) / static_cast<double>(smoothedBins -1) * (maxV - minV) + minV;
-                    double kvalue = (valueI - valueJ) / bandwidth;
-                    double norm = std::exp( -0.5 * kvalue * kvalue ) / std::sqrt( 2.0 * M_PI );
-                    double value = norm * static_cast<double>(histogram->GetFrequency(i));
-                    smoothedFrequency[j] += value;
-                }
-            }
-
-            for (unsigned int i = 0; i < smoothedBins; i++ )
-            {
-                smoothedFrequency[i]/=(static_cast<double>( histogram->GetTotalFrequency()) * bandwidth);
+                for (unsigned int i = 0; i < smoothedFrequency.size(); i++ )
+                    smoothedFrequency[i] /= ( totalFrequency * binWidth );
             }
 
-            // get maxs
-            std::vector<unsigned int> maxs;
-            const unsigned int localMax = 3;
-            for (unsigned int i = 0; i < smoothedBins; i++ )
-            {
-		int testVal = i - localMax;
-                unsigned int jmin = testVal < 0 ? 0 : testVal;	
-
-                unsigned int jmax = ( i + localMax ) > smoothedBins ? smoothedBins : ( i + localMax );
-
-                bool ismax = true;
-                for (unsigned int j = jmin; j < jmax; j++ )
-                {
-                    if ( (i != j) && (smoothedFrequency[i] <= smoothedFrequency[j]) )
-                    {
-                        ismax = false;
-                        continue;
-                    }
-                }
-
-                if ( ismax && ( smoothedFrequency[i] > 0.001 ) )
-                {
-                    maxs.push_back( i );
-                }
-            }
+            // get maxs, the window is [i - localMax, i + localMax - 1]
+            HistogramsComputerType::FindModes( smoothedFrequency, localMax, localMax - 1, 0.001, maxs );
 
             if(maxs.size()==0)
             {
@@ -362,13 +257,13 @@ void HierarchicalInitializer<TInputImage,TMaskImage>
                 {
                 case - 1: // darker max
                 {
-                    value = ( static_cast<double>(maxs[0]) / static_cast<double>(bins-1) ) * (maxV - minV) + minV;
+                    value = histogramsComputer->GetBinCenter( im - 1, c + 1, maxs[0] );
                     m_SelectedMax[im][c] = value;
                     break;
                 }
                 case 1: // brigther max
                 {
-                    value = ( static_cast<double>(maxs[ maxs.size() - 1 ]) / static_cast<double>(bins-1) ) * (maxV - minV) + minV;
+                    value = histogramsComputer->GetBinCenter( im - 1, c + 1, maxs[ maxs.size() - 1 ] );
                     m_SelectedMax[ im ][ c ] = value;
                     break;
                 }
@@ -385,7 +280,7 @@ void HierarchicalInitializer<TInputImage,TMaskImage>
                             absMaxIndex = i;
                         }
                     }
-                    value = ( static_cast<double>(maxs[ absMaxIndex ]) / static_cast<double>(bins-1) ) * (maxV - minV) + minV;
+                    value = histogramsComputer->GetBinCenter( im - 1, c + 1, maxs[ absMaxIndex ] );
                     m_SelectedMax[ im ][ c ] = value;
                     break;
                 }
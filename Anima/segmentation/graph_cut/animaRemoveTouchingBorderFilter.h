@@ -3,10 +3,7 @@
 #include <itkImageToImageFilter.h>
 #include <itkImageRegionIterator.h>
 #include <itkImageRegionConstIterator.h>
-#include <itkLabelImageToLabelMapFilter.h>
-#include <itkLabelMapToLabelImageFilter.h>
-#include <itkLabelContourImageFilter.h>
-#include <itkConnectedComponentImageFilter.h>
+#include <animaLabelStatisticsComputer.h>
 #include <animaReadWriteFunctions.h>
 
 namespace anima
@@ -16,6 +13,8 @@ namespace anima
  * These effects can cause voxels in the cortex or external CSF to have intensities similar to MS lesions.
  * In order to reduce the number of false positives due to these effects, we remove all candidate lesions
  * that are contiguous to the brain mask border.
+ * Components, their contact with the mask contour and the outputs are computed in one threaded labeling pass and
+ * one relabelling pass (see anima::LabelStatisticsComputer).
  */
 template<typename TInput, typename TMask, typename TOutput>
 class RemoveTouchingBorderFilter :
@@ -53,20 +52,9 @@ public:
     typedef typename OutputImageType::Pointer OutputImagePointer;
     typedef typename itk::ImageRegionIterator< OutputImageType > OutputIteratorType;
 
-    typedef unsigned int PixelTypeInt;
-    typedef itk::Image <PixelTypeInt,3> ImageTypeInt;
-    typedef itk::ImageRegionIterator< ImageTypeInt > ImageIteratorTypeInt;
-
-    typedef itk::LabelImageToLabelMapFilter<ImageTypeInt> LabelImageToLabelMapFilterType;
-    typedef typename LabelImageToLabelMapFilterType::OutputImageType TOutputMap;
-    typedef itk::LabelImageToLabelMapFilter<TInput,TOutputMap> LabelImageToLabelMapFilterType2;
-    
-    typedef itk::LabelMapToLabelImageFilter<TOutputMap, ImageTypeInt> LabelMapToLabelImageFilterType;
-
-    typedef itk::ConnectedComponentImageFilter <InputImageType,ImageTypeInt> ConnectedComponentImageFilterType;
-    typedef itk::ConnectedComponentImageFilter <TMask, ImageTypeInt > ConnectedComponentImageFilterType2;
-
-    typedef itk::LabelContourImageFilter<ImageTypeInt, ImageTypeInt> LabelContourImageFilterType;
+    typedef anima::LabelStatisticsComputer <InputImageType,MaskImageType> ComponentsComputerType;
+    typedef typename ComponentsComputerType::LabelImageType LabelImageType;
+    typedef itk::ImageRegionConstIterator< LabelImageType > LabelConstIteratorType;
     
     /** The mri images.*/
     void SetInputImageSeg(const TInput* image);
@@ -145,8 +133,6 @@ private:
     std::string m_OutputNonTouchingBorderFilename;
     std::string m_OutputTouchingBorderFilename;
 
-    std::vector<int> m_labelsToRemove;
-
     double m_Tol;
 
 };
@@ -88,186 +88,63 @@ void
 RemoveTouchingBorderFilter< TInput, TMask, TOutput >::
 GenerateData()
 {
-    InputImagePointer InputImageSeg = InputImageType::New();
-    InputImageSeg->SetRegions(this->GetInputImageSeg()->GetLargestPossibleRegion());
-    InputImageSeg->CopyInformation(this->GetInputImageSeg());
-    InputImageSeg->Allocate();
-    InputImageSeg->FillBuffer(0);
-
-    // Find labels overlaping mask border
-    InputIteratorType InputImageSegIt(InputImageSeg, InputImageSeg->GetLargestPossibleRegion() );
-    InputConstIteratorType maskSegIt(this->GetInputImageSeg(), this->GetInputImageSeg()->GetLargestPossibleRegion() );
-    
-    while(!maskSegIt.IsAtEnd())
-    {
-        InputImageSegIt.Set(maskSegIt.Get());
-
-        ++maskSegIt;
-        ++InputImageSegIt;
-    }
-
-    // --------------------------- Lesions
-    typename ConnectedComponentImageFilterType::Pointer connectedComponentImageFilter = ConnectedComponentImageFilterType::New();
-    typename LabelImageToLabelMapFilterType::Pointer labelImageToLabelMapFilter = LabelImageToLabelMapFilterType::New();
-    typename LabelImageToLabelMapFilterType2::Pointer labelImageToLabelMapFilter2 = LabelImageToLabelMapFilterType2::New();
-    typename LabelMapToLabelImageFilterType::Pointer labelMapToLabelImageFilter = LabelMapToLabelImageFilterType::New();
-    typename TOutputMap::Pointer labelMap = 0;
-    int originalNumberOfObject = 0;
-    bool connectivity = false;
-    
-    if( !m_LabeledImage )
-    {
-        // Create the labeled image of the input segmentation
-        connectedComponentImageFilter->SetInput( InputImageSeg );
-        connectedComponentImageFilter->SetFullyConnected( connectivity );
-        connectedComponentImageFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
-        connectedComponentImageFilter->Update();
-
-        labelImageToLabelMapFilter->SetInput( connectedComponentImageFilter->GetOutput() );
-        labelImageToLabelMapFilter->SetNumberOfThreads(this->GetNumberOfThreads());
-        labelImageToLabelMapFilter->Update(); // The output of this filter is an itk::LabelMap, which contains itk::LabelObject's
-        originalNumberOfObject = labelImageToLabelMapFilter->GetOutput()->GetNumberOfLabelObjects() ;
-
-        labelMap = labelImageToLabelMapFilter->GetOutput();
-        labelMap->DisconnectPipeline();
-    }
-    else
+    // Single labeling pass, components touching the mask (or its contour) are flagged on the fly
+    typename ComponentsComputerType::Pointer componentsComputer = ComponentsComputerType::New();
+    componentsComputer->SetInputImage( this->GetInputImageSeg() );
+    componentsComputer->SetBorderMask( this->GetMask() );
+    componentsComputer->SetUseBorderMaskContour( !m_NoContour );
+    componentsComputer->SetLabeledImage( m_LabeledImage );
+    componentsComputer->SetNumberOfThreads( this->GetNumberOfThreads() );
+    componentsComputer->Update();
+
+    unsigned int originalNumberOfObject = componentsComputer->GetNumberOfComponents();
+    std::vector<bool> keptComponents( originalNumberOfObject + 1, false );
+    unsigned int numberOfRemovedObjects = 0;
+
+    for ( unsigned int i = 1; i <= originalNumberOfObject; ++i )
     {
-        labelImageToLabelMapFilter2->SetInput( InputImageSeg );
-        labelImageToLabelMapFilter2->SetNumberOfThreads(this->GetNumberOfThreads());
-        labelImageToLabelMapFilter2->Update(); // The output of this filter is an itk::LabelMap, which contains itk::LabelObject's
-        originalNumberOfObject = labelImageToLabelMapFilter2->GetOutput()->GetNumberOfLabelObjects() ;
-
-        labelMap = labelImageToLabelMapFilter2->GetOutput();
-        labelMap->DisconnectPipeline();
-    }
-
-    // Convert a LabelMap to a normal image with different values representing each region
-    labelMapToLabelImageFilter->SetInput( labelMap );
-    labelMapToLabelImageFilter->SetNumberOfThreads(this->GetNumberOfThreads());
-    labelMapToLabelImageFilter->Update();
-
-    // ------------------------------------- Mask bordure
-
-    ImageIteratorTypeInt segLabelIt (labelMapToLabelImageFilter->GetOutput(), labelMapToLabelImageFilter->GetOutput()->GetLargestPossibleRegion() );
-    
-    std::vector<int> labelsToRemove;
-    
-    if(!m_NoContour)
-    {
-        // Get envelop of the mask
-        // Generate connected components
-        typename ConnectedComponentImageFilterType2::Pointer connectedComponentImageFilter2  = ConnectedComponentImageFilterType2::New();
-        connectedComponentImageFilter2->SetInput( this->GetMask() );
-        connectedComponentImageFilter2->SetNumberOfThreads(this->GetNumberOfThreads());
-
-        // Generate contours for each component
-        itk::LabelContourImageFilter<ImageTypeInt, ImageTypeInt>::Pointer labelContourImageFilter = itk::LabelContourImageFilter<ImageTypeInt, ImageTypeInt>::New();
-        labelContourImageFilter->SetInput( connectedComponentImageFilter2->GetOutput() );
-        labelContourImageFilter->SetFullyConnected(true);
-        labelContourImageFilter->SetNumberOfThreads(this->GetNumberOfThreads());
-        labelContourImageFilter->Update();
-
-
-        // Find labels overlaping mask border
-        ImageIteratorTypeInt maskContourIt (labelContourImageFilter->GetOutput(), labelContourImageFilter->GetOutput()->GetLargestPossibleRegion() );
-
-        std::vector<int>::iterator it;
-        while(!maskContourIt.IsAtEnd())
+        if ( componentsComputer->GetComponentStatistics( i ).touchesBorder )
         {
-            if( maskContourIt.Get()!=0 && segLabelIt.Get()!=0 )
-            {
-                it = find (labelsToRemove.begin(), labelsToRemove.end(), segLabelIt.Get());
-                if (it == labelsToRemove.end())
-                {
-                    labelsToRemove.push_back( segLabelIt.Get() );
-                    m_labelsToRemove.push_back( segLabelIt.Get() );
-                }
-            }
-            ++maskContourIt;
-            ++segLabelIt;
+            ++numberOfRemovedObjects;
         }
-    }
-    else
-    {
-        // Find labels overlaping mask border
-        MaskConstIteratorType maskContourIt (this->GetMask(), this->GetMask()->GetLargestPossibleRegion() );
-
-        std::vector<int>::iterator it;
-        while(!maskContourIt.IsAtEnd())
-        {
-            if( maskContourIt.Get()!=0 && segLabelIt.Get()!=0)
-            {
-                it = find (labelsToRemove.begin(), labelsToRemove.end(), segLabelIt.Get());
-                if (it == labelsToRemove.end())
-                {
-                    labelsToRemove.push_back( segLabelIt.Get() );
-                    m_labelsToRemove.push_back( segLabelIt.Get() );
-                }
-            }
-            ++maskContourIt;
-            ++segLabelIt;
-        }
-    }
-
-    
-    // Remove all regions that were marked for removal.
-    for(unsigned int i = 0; i < labelsToRemove.size(); ++i)
-    {
-        labelMap->RemoveLabel(labelsToRemove[i]);
+        else
+            keptComponents[ i ] = true;
     }
 
-    // Convert a LabelMap to a normal image with different values representing each region
-    typename LabelMapToLabelImageFilterType::Pointer labelMapToLabelImageFilter2 = LabelMapToLabelImageFilterType::New();
-    labelMapToLabelImageFilter2->SetInput( labelMap );
-    labelMapToLabelImageFilter2->SetNumberOfThreads(this->GetNumberOfThreads());
-    labelMapToLabelImageFilter2->Update();
-
-    MaskConstIteratorType maskIt (this->GetMask(), this->GetMask()->GetLargestPossibleRegion() );
-    ImageIteratorTypeInt segIt (labelMapToLabelImageFilter2->GetOutput(), labelMapToLabelImageFilter2->GetOutput()->GetLargestPossibleRegion() );
-    maskSegIt.GoToBegin();
-
     OutputImagePointer output = this->GetOutputNonTouchingBorder();
     output->SetRegions(this->GetInputImageSeg()->GetLargestPossibleRegion());
     output->CopyInformation(this->GetInputImageSeg());
     output->Allocate();
-    output->FillBuffer(0);
 
     OutputImagePointer output2 = this->GetOutputTouchingBorder();
     output2->SetRegions(this->GetInputImageSeg()->GetLargestPossibleRegion());
     output2->CopyInformation(this->GetInputImageSeg());
     output2->Allocate();
-    output2->FillBuffer(0);
 
+    // Single relabelling pass
+    LabelConstIteratorType labelIt (componentsComputer->GetLabelImage(), componentsComputer->GetLabelImage()->GetLargestPossibleRegion() );
     OutputIteratorType outIt (output, output->GetLargestPossibleRegion() );
     OutputIteratorType out2It (output2, output2->GetLargestPossibleRegion() );
 
-    while(!maskIt.IsAtEnd())
+    while(!labelIt.IsAtEnd())
     {
-        if( segIt.Get()!=0)
-        {
-            outIt.Set(1);
-        }
-        if( (segIt.Get()==0) && (maskSegIt.Get()!=0))
-        {
-            out2It.Set(1);
-        }
-        ++maskIt;
-        ++segIt;
+        unsigned int component = labelIt.Get();
+        outIt.Set( ( component != 0 ) && keptComponents[ component ] );
+        out2It.Set( ( component != 0 ) && !keptComponents[ component ] );
+
+        ++labelIt;
         ++outIt;
         ++out2It;
-        ++maskSegIt;
     }
 
     if ( m_Verbose )
     {
         std::cout << " -- Rule to erase objects touching mask border: " << std::endl;
         std::cout << "    * Initial number of objects: " << originalNumberOfObject << std::endl;
-        std::cout << "    * Number of rejected objects: " << labelsToRemove.size()  << std::endl;
-        std::cout << "    * Number of objects after clean: " << labelMap->GetNumberOfLabelObjects() << std::endl;
+        std::cout << "    * Number of rejected objects: " << numberOfRemovedObjects  << std::endl;
+        std::cout << "    * Number of objects after clean: " << originalNumberOfObject - numberOfRemovedObjects << std::endl;
         std::cout << std::endl;
     }
-
 }
 
 
@@ -1,7 +1,7 @@
 #include <tclap/CmdLine.h>
 
 #include <itkTimeProbe.h>
-#include <animaReadWriteFunctions.h>
+#include <animaImageWriteService.h>
 #include "animaGcStremMsLesionsSegmentationFilter.h"
 
 int main(int argc, const char** argv)
@@ -100,16 +100,23 @@ int main(int argc, const char** argv)
 
     TCLAP::ValueArg<std::string> outputHyperIntensity1FileArg("","out-hyper-im1","Hyper-intensity map in image 1 filename",false,"","output hyper-intensity filename 1",cmd);
     TCLAP::ValueArg<std::string> outputHyperIntensity2FileArg("","out-hyper-im2","Hyper-intensity map in image 2 filename",false,"","output hyper-intensity filename 2",cmd);
+    TCLAP::ValueArg<std::string> compressionArg("","compression","Output images compression: none, fast or standard (default: standard)",false,"standard","output compression",cmd);
 
     try
     {
         cmd.parse(argc,argv);
+        anima::ImageWriteService::GetInstance().SetCompressionMode(anima::getImageCompressionModeFromString(compressionArg.getValue()));
     }
     catch (TCLAP::ArgException& e)
     {
         std::cerr << "Error: " << e.error() << "for argument " << e.argId() << std::endl;
         return(1);
     }
+    catch (itk::ExceptionObject &e)
+    {
+        std::cerr << e << std::endl;
+        return(1);
+    }
 
     FilterTypeSeg::Pointer segFilter = FilterTypeSeg::New();
 
@@ -238,6 +245,7 @@ int main(int argc, const char** argv)
     {
         segFilter->Update();
         segFilter->WriteOutputs();
+        anima::waitForPendingImageWrites();
     }
     catch (itk::ExceptionObject &e)
     {
@@ -9,6 +9,7 @@
 
 #include <itkMaximumImageFilter.h>
 #include <itkMinimumImageFilter.h>
+#include <itkConnectedComponentImageFilter.h>
 #include <itkRelabelComponentImageFilter.h>
 #include <itkRescaleIntensityImageFilter.h>
 #include <itkImageToImageFilter.h>
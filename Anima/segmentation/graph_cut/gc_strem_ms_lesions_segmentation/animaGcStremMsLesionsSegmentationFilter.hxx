@@ -295,7 +295,7 @@ GcStremMsLesionsSegmentationFilter <TInputImage>::WriteOutputs()
     if( m_OutputLesionFilename != "" )
     {
         std::cout << "Writing Lesion output image to: " << m_OutputLesionFilename << std::endl;
-        anima::writeImage<TOutputImage>(m_OutputLesionFilename, this->GetOutputLesions());
+        anima::queueImageForWriting<TOutputImage>(m_OutputLesionFilename, this->GetOutputLesions());
     }
 
     if( m_LesionSegmentationType!=manualGC )
@@ -304,32 +304,32 @@ GcStremMsLesionsSegmentationFilter <TInputImage>::WriteOutputs()
         if( m_OutputIntensityImage1Filename != "" )
         {
             std::cout << "Writing intensity output image 1 to: " << m_OutputIntensityImage1Filename << std::endl;
-            anima::writeImage<TOutputImage>(m_OutputIntensityImage1Filename, this->GetOutputIntensityImage1());
+            anima::queueImageForWriting<TOutputImage>(m_OutputIntensityImage1Filename, this->GetOutputIntensityImage1());
         }
         if( m_OutputIntensityImage2Filename != "" )
         {
             std::cout << "Writing intensity output image 2 to: " << m_OutputIntensityImage2Filename << std::endl;
-            anima::writeImage<TOutputImage>(m_OutputIntensityImage2Filename, this->GetOutputIntensityImage2());
+            anima::queueImageForWriting<TOutputImage>(m_OutputIntensityImage2Filename, this->GetOutputIntensityImage2());
         }
         if( m_OutputCSFFilename != "" )
         {
             std::cout << "Writing CSF output image to: " << m_OutputCSFFilename << std::endl;
-            anima::writeImage<TOutputImage>(m_OutputCSFFilename, this->GetOutputCSF());
+            anima::queueImageForWriting<TOutputImage>(m_OutputCSFFilename, this->GetOutputCSF());
         }
         if( m_OutputGMFilename != "" )
         {
             std::cout << "Writing GM output image to: " << m_OutputGMFilename << std::endl;
-            anima::writeImage<TOutputImage>(m_OutputGMFilename, this->GetOutputGM());
+            anima::queueImageForWriting<TOutputImage>(m_OutputGMFilename, this->GetOutputGM());
         }
         if( m_OutputWMFilename != "" )
         {
             std::cout << "Writing WM output image to: " << m_OutputWMFilename << std::endl;
-            anima::writeImage<TOutputImage>(m_OutputWMFilename, this->GetOutputWM());
+            anima::queueImageForWriting<TOutputImage>(m_OutputWMFilename, this->GetOutputWM());
         }
         if( m_OutputWholeFilename != "" )
         {
             std::cout << "Writing segmentation output image to: " << m_OutputWholeFilename << std::endl;
-            anima::writeImage<TOutputImage>(m_OutputWholeFilename, this->GetOutputWholeSeg());
+            anima::queueImageForWriting<TOutputImage>(m_OutputWholeFilename, this->GetOutputWholeSeg());
         }
     }
 
@@ -338,7 +338,7 @@ GcStremMsLesionsSegmentationFilter <TInputImage>::WriteOutputs()
         if( m_OutputFuzzyObjectFilename != "" )
         {
             std::cout << "Writing fuzzy object output image to: " << m_OutputFuzzyObjectFilename << std::endl;
-            anima::writeImage<ImageTypeD>(m_OutputFuzzyObjectFilename, this->GetOutputFuzzyObjectImage());
+            anima::queueImageForWriting<ImageTypeD>(m_OutputFuzzyObjectFilename, this->GetOutputFuzzyObjectImage());
         }
     }
 
@@ -347,22 +347,22 @@ GcStremMsLesionsSegmentationFilter <TInputImage>::WriteOutputs()
         if( m_OutputStremFilename != "" )
         {
             std::cout << "Writing strem output image to: " << m_OutputStremFilename << std::endl;
-            anima::writeImage<TOutputImage>(m_OutputStremFilename, this->GetOutputStrem());
+            anima::queueImageForWriting<TOutputImage>(m_OutputStremFilename, this->GetOutputStrem());
         }
         if( m_OutputStremCSFFilename != "" )
         {
             std::cout << "Writing CSF strem output image to: " << m_OutputStremCSFFilename << std::endl;
-            anima::writeImage<TOutputImage>(m_OutputStremCSFFilename, this->GetOutputStremCSF());
+            anima::queueImageForWriting<TOutputImage>(m_OutputStremCSFFilename, this->GetOutputStremCSF());
         }
         if( m_OutputStremGMFilename != "" )
         {
             std::cout << "Writing GM strem output image to: " << m_OutputStremGMFilename << std::endl;
-            anima::writeImage<TOutputImage>(m_OutputStremGMFilename, this->GetOutputStremGM());
+            anima::queueImageForWriting<TOutputImage>(m_OutputStremGMFilename, this->GetOutputStremGM());
         }
         if( m_OutputStremWMFilename != "" )
         {
             std::cout << "Writing WM strem output image to: " << m_OutputStremWMFilename << std::endl;
-            anima::writeImage<TOutputImage>(m_OutputStremWMFilename, this->GetOutputStremWM());
+            anima::queueImageForWriting<TOutputImage>(m_OutputStremWMFilename, this->GetOutputStremWM());
         }
     }
     else
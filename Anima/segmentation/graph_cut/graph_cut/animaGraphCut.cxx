@@ -1,7 +1,7 @@
 #include <tclap/CmdLine.h>
 
 #include <itkTimeProbe.h>
-#include <animaReadWriteFunctions.h>
+#include <animaImageWriteService.h>
 #include "animaGraphCutFilter.h"
 
 int main(int argc, const char** argv)
@@ -29,16 +29,23 @@ int main(int argc, const char** argv)
     TCLAP::ValueArg<std::string> matrixGradArg("","mat","Spectral gradient matrix file",false,"","spectral gradient matrix file",cmd);
 
     TCLAP::ValueArg<std::string> outputGCFileArg("o","out","Output segmentation",true,"","output segmentation",cmd);
+    TCLAP::ValueArg<std::string> compressionArg("","compression","Output images compression: none, fast or standard (default: standard)",false,"standard","output compression",cmd);
 
     try
     {
         cmd.parse(argc,argv);
+        anima::ImageWriteService::GetInstance().SetCompressionMode(anima::getImageCompressionModeFromString(compressionArg.getValue()));
     }
     catch (TCLAP::ArgException& e)
     {
         std::cerr << "Error: " << e.error() << "for argument " << e.argId() << std::endl;
         return(1);
     }
+    catch (itk::ExceptionObject &e)
+    {
+        std::cerr << e << std::endl;
+        return(1);
+    }
 
     const unsigned int Dimension = 3;
     typedef itk::Image <double,Dimension> InputImageTypeD;
@@ -108,6 +115,7 @@ int main(int argc, const char** argv)
     {
         GraphCutFilter->Update();
         GraphCutFilter->WriteOutputs();
+        anima::waitForPendingImageWrites();
     }
     catch (itk::ExceptionObject &e)
     {